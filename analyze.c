@@ -0,0 +1,605 @@
+#include "../include/analyze.h"
+#include "../include/gamelog.h"
+#include "../include/engine.h"
+#include "../include/wire.h"
+#include "../include/arena.h"
+#include "../libs/cJSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define OPENING_SLOTS 4097      // 첫 수 (wire 수 12비트) + pass
+#define LOSS_CAP      64        // 승패가 갈린 수의 손실(ENGINE_WIN 단위)은 평균이 튀지 않게 이만큼으로 센다
+
+typedef struct {
+    char name[GAMELOG_NAME_MAX];   // 빈 문자열이면 빈 칸
+    uint64_t games, wins, losses, draws, unfinished;
+    uint64_t moves;
+    uint64_t exact;                // 최선 수와 점수가 같았던 수 (depth > 0)
+    uint64_t loss;                 // 손실 합 (말 수)
+    uint64_t blunders;
+} PlayerStats;
+
+typedef struct {
+    PlayerStats *slots;
+    size_t mask, count;
+} PlayerTable;
+
+typedef struct {
+    uint64_t red, blue, blocked;
+    uint32_t turn;
+    uint32_t count;                // 0이면 빈 칸
+} PosEntry;
+
+typedef struct {
+    PosEntry *slots;
+    size_t mask, count;
+} PosTable;
+
+typedef struct {
+    uint64_t games, red_wins, blue_wins, draws;
+} OpeningStats;
+
+typedef struct {
+    uint64_t games, positions, illegal;
+    uint64_t red_wins, blue_wins, draws, unfinished;
+} Totals;
+
+/* 스레드 하나의 몫: 연속된 레코드 구간과 그 구간의 통계 (끝나고 0번에 합친다) */
+typedef struct {
+    pthread_t thread;
+    const AnalyzeOptions *opt;
+    const GameLogRecord **recs;
+    size_t nrecs;
+    PlayerTable players;
+    PosTable positions;
+    OpeningStats openings[OPENING_SLOTS];
+    Totals totals;
+    int failed;                    // 메모리 부족
+} Worker;
+
+/* ---- 표 ---- */
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t name_hash(const char *s) {
+    uint64_t h = 14695981039346656037ull;
+    for (; *s; s++) h = (h ^ (unsigned char)*s) * 1099511628211ull;
+    return h;
+}
+
+// 새 이름 n개가 들어갈 자리를 미리 만든다 (player_get이 포인터를 옮기지 않게)
+static int player_reserve(PlayerTable *t, size_t n) {
+    size_t size = t->slots ? t->mask + 1 : 0;
+    if ((t->count + n) * 2 <= size) return 0;
+    size_t new_size = size ? size * 2 : 64;
+    while ((t->count + n) * 2 > new_size) new_size *= 2;
+    PlayerStats *slots = (PlayerStats *)calloc(new_size, sizeof *slots);
+    if (!slots) return -1;
+    for (size_t i = 0; i < size; i++) {
+        if (!t->slots[i].name[0]) continue;
+        size_t j = name_hash(t->slots[i].name) & (new_size - 1);
+        while (slots[j].name[0]) j = (j + 1) & (new_size - 1);
+        slots[j] = t->slots[i];
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->mask = new_size - 1;
+    return 0;
+}
+
+static PlayerStats *player_get(PlayerTable *t, const char *name) {
+    size_t i = name_hash(name) & t->mask;
+    while (t->slots[i].name[0]) {
+        if (strcmp(t->slots[i].name, name) == 0) return &t->slots[i];
+        i = (i + 1) & t->mask;
+    }
+    strncpy(t->slots[i].name, name, GAMELOG_NAME_MAX - 1);
+    t->count++;
+    return &t->slots[i];
+}
+
+static uint64_t pos_hash(uint64_t red, uint64_t blue, uint64_t blocked, uint32_t turn) {
+    return mix64(red ^ mix64(blue ^ mix64(blocked + turn)));
+}
+
+static int pos_add(PosTable *t, uint64_t red, uint64_t blue, uint64_t blocked, uint32_t turn, uint32_t n) {
+    size_t size = t->slots ? t->mask + 1 : 0;
+    if ((t->count + 1) * 2 > size) {
+        size_t new_size = size ? size * 2 : 4096;
+        PosEntry *slots = (PosEntry *)calloc(new_size, sizeof *slots);
+        if (!slots) return -1;
+        for (size_t i = 0; i < size; i++) {
+            const PosEntry *e = &t->slots[i];
+            if (!e->count) continue;
+            size_t j = pos_hash(e->red, e->blue, e->blocked, e->turn) & (new_size - 1);
+            while (slots[j].count) j = (j + 1) & (new_size - 1);
+            slots[j] = *e;
+        }
+        free(t->slots);
+        t->slots = slots;
+        t->mask = new_size - 1;
+    }
+    size_t i = pos_hash(red, blue, blocked, turn) & t->mask;
+    for (;; i = (i + 1) & t->mask) {
+        PosEntry *e = &t->slots[i];
+        if (!e->count) {
+            e->red = red;
+            e->blue = blue;
+            e->blocked = blocked;
+            e->turn = turn;
+            e->count = n;
+            t->count++;
+            return 0;
+        }
+        if (e->red == red && e->blue == blue && e->blocked == blocked && e->turn == turn) {
+            e->count += n;
+            return 0;
+        }
+    }
+}
+
+/* ---- 다시 두기 ---- */
+
+static void analyze_game(Worker *w, const GameLogRecord *rec) {
+    const AnalyzeOptions *opt = w->opt;
+    GameSession g;
+    session_init(&g);
+    g.red = rec->red;
+    g.blue = rec->blue;
+    g.blocked = rec->blocked;
+    // 되살린 게임의 나머지는 앞 레코드가 이미 한 게임으로 셌다: 수와 국면만 더한다
+    int counted = !(rec->flags & GAMELOG_CONTINUED);
+
+    // 0 = Red 승, 1 = Blue 승, 2 = 무승부, -1 = 끝나지 않은 게임
+    int outcome = -1;
+    if (rec->result == GAMELOG_FINISHED) {
+        outcome = rec->score[0] > rec->score[1] ? 0 : rec->score[1] > rec->score[0] ? 1 : 2;
+    }
+    Totals *tot = &w->totals;
+    if (counted) {
+        tot->games++;
+        if (outcome == 0) tot->red_wins++;
+        else if (outcome == 1) tot->blue_wins++;
+        else if (outcome == 2) tot->draws++;
+        else tot->unfinished++;
+    }
+
+    if (player_reserve(&w->players, 2) < 0) {
+        w->failed = 1;
+        return;
+    }
+    PlayerStats *ps[2];
+    for (int i = 0; i < 2; i++) {
+        char name[GAMELOG_NAME_MAX];
+        memcpy(name, rec->name[i], sizeof name);
+        name[GAMELOG_NAME_MAX - 1] = '\0';
+        if (!name[0]) strcpy(name, "?");
+        ps[i] = player_get(&w->players, name);
+        if (!counted) continue;
+        ps[i]->games++;
+        if (outcome < 0) ps[i]->unfinished++;
+        else if (outcome == 2) ps[i]->draws++;
+        else if (outcome == i) ps[i]->wins++;
+        else ps[i]->losses++;
+    }
+
+    const uint16_t *mv = gamelog_moves(rec);
+    if (counted && rec->move_count > 0) {
+        OpeningStats *o = &w->openings[mv[0] == WIRE_MOVE_PASS ? OPENING_SLOTS - 1 : mv[0] & 0xFFF];
+        o->games++;
+        if (outcome == 0) o->red_wins++;
+        else if (outcome == 1) o->blue_wins++;
+        else if (outcome == 2) o->draws++;
+    }
+    for (uint32_t i = 0; i < rec->move_count; i++) {
+        int color = (int)((rec->turn + i) & 1);    // 기록은 보드가 바뀐 사건뿐이라 차례가 번갈아 온다
+        if (pos_add(&w->positions, g.red, g.blue, g.blocked, (uint32_t)color, 1) < 0) {
+            w->failed = 1;
+            return;
+        }
+        GameSession next = g;
+        if (!session_apply(&next, color, mv[i])) {
+            tot->illegal++;
+            return;
+        }
+        tot->positions++;
+        ps[color]->moves++;
+        if (opt->depth > 0) {
+            int best = engine_search(&g, color, opt->depth, NULL);
+            int played = -engine_search(&next, 1 - color, opt->depth - 1, NULL);
+            int loss = best - played;
+            if (loss < 0) loss = 0;
+            if (loss == 0) ps[color]->exact++;
+            if (loss >= opt->blunder) ps[color]->blunders++;
+            ps[color]->loss += (uint64_t)(loss < LOSS_CAP ? loss : LOSS_CAP);
+        }
+        g = next;
+    }
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    for (size_t i = 0; i < w->nrecs && !w->failed; i++) analyze_game(w, w->recs[i]);
+    return NULL;
+}
+
+// 다른 스레드의 결과를 dst에 더한다
+static int worker_merge(Worker *dst, const Worker *src) {
+    for (size_t i = 0; src->players.slots && i <= src->players.mask; i++) {
+        const PlayerStats *s = &src->players.slots[i];
+        if (!s->name[0]) continue;
+        if (player_reserve(&dst->players, 1) < 0) return -1;
+        PlayerStats *d = player_get(&dst->players, s->name);
+        d->games += s->games;
+        d->wins += s->wins;
+        d->losses += s->losses;
+        d->draws += s->draws;
+        d->unfinished += s->unfinished;
+        d->moves += s->moves;
+        d->exact += s->exact;
+        d->loss += s->loss;
+        d->blunders += s->blunders;
+    }
+    for (size_t i = 0; src->positions.slots && i <= src->positions.mask; i++) {
+        const PosEntry *e = &src->positions.slots[i];
+        if (e->count && pos_add(&dst->positions, e->red, e->blue, e->blocked, e->turn, e->count) < 0) return -1;
+    }
+    for (int i = 0; i < OPENING_SLOTS; i++) {
+        dst->openings[i].games += src->openings[i].games;
+        dst->openings[i].red_wins += src->openings[i].red_wins;
+        dst->openings[i].blue_wins += src->openings[i].blue_wins;
+        dst->openings[i].draws += src->openings[i].draws;
+    }
+    dst->totals.games += src->totals.games;
+    dst->totals.positions += src->totals.positions;
+    dst->totals.illegal += src->totals.illegal;
+    dst->totals.red_wins += src->totals.red_wins;
+    dst->totals.blue_wins += src->totals.blue_wins;
+    dst->totals.draws += src->totals.draws;
+    dst->totals.unfinished += src->totals.unfinished;
+    return 0;
+}
+
+/* ---- 출력: 같은 코드로 JSONL 줄 또는 CSV 줄을 만든다 ---- */
+
+typedef struct {
+    int csv;
+    int tables;                    // 지금까지 시작한 표 수 (CSV 표 사이 빈 줄)
+    const char *table;
+    int rows;                      // 이 표에서 쓴 줄 수 (CSV 머리줄은 첫 줄에서)
+    cJSON *obj;
+    char head[512], line[1024];
+    size_t hlen, llen;
+} TableOut;
+
+static void table_begin(TableOut *t, const char *name) {
+    if (t->csv && t->tables > 0) putchar('\n');
+    t->tables++;
+    t->table = name;
+    t->rows = 0;
+}
+
+static void row_begin(TableOut *t) {
+    if (t->csv) {
+        t->hlen = t->llen = 0;
+        return;
+    }
+    arena_begin();
+    t->obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(t->obj, "table", t->table);
+}
+
+static void csv_cell(TableOut *t, const char *key, const char *val, int quote) {
+    const char *sep = t->llen ? "," : "";
+    if (t->rows == 0 && t->hlen < sizeof t->head) {
+        t->hlen += (size_t)snprintf(t->head + t->hlen, sizeof t->head - t->hlen, "%s%s", sep, key);
+    }
+    if (t->llen < sizeof t->line) {
+        t->llen += (size_t)snprintf(t->line + t->llen, sizeof t->line - t->llen, quote ? "%s\"%s\"" : "%s%s", sep, val);
+    }
+}
+
+static void col_str(TableOut *t, const char *key, const char *val) {
+    if (t->csv) {
+        // 이름에 쉼표나 따옴표가 있을 수 있으니 문자열은 따옴표로 감싼다 (따옴표는 빼고)
+        char clean[128];
+        size_t n = 0;
+        for (; *val && n < sizeof clean - 1; val++) {
+            if (*val != '"') clean[n++] = *val;
+        }
+        clean[n] = '\0';
+        csv_cell(t, key, clean, 1);
+    } else {
+        cJSON_AddStringToObject(t->obj, key, val);
+    }
+}
+
+static void col_u64(TableOut *t, const char *key, uint64_t v) {
+    if (t->csv) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "%llu", (unsigned long long)v);
+        csv_cell(t, key, buf, 0);
+    } else {
+        cJSON_AddNumberToObject(t->obj, key, (double)v);
+    }
+}
+
+static void col_f(TableOut *t, const char *key, double v) {
+    if (t->csv) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "%.4f", v);
+        csv_cell(t, key, buf, 0);
+    } else {
+        cJSON_AddNumberToObject(t->obj, key, (double)(long long)(v * 10000 + (v < 0 ? -0.5 : 0.5)) / 10000);
+    }
+}
+
+static void row_end(TableOut *t) {
+    if (t->csv) {
+        if (t->rows == 0) printf("%s\n", t->head);
+        printf("%s\n", t->line);
+    } else {
+        char *s = cJSON_PrintUnformatted(t->obj);
+        if (s) puts(s);
+        cJSON_free(s);
+        cJSON_Delete(t->obj);
+        t->obj = NULL;
+        arena_end();
+    }
+    t->rows++;
+}
+
+static double ratio(uint64_t a, uint64_t b) {
+    return b ? (double)a / (double)b : 0.0;
+}
+
+static void move_name(uint16_t mv, char *buf, size_t len) {
+    if (mv == WIRE_MOVE_PASS) {
+        snprintf(buf, len, "pass");
+        return;
+    }
+    int r1, c1, r2, c2;
+    wire_move_coords(mv, &r1, &c1, &r2, &c2);
+    snprintf(buf, len, "(%d,%d)->(%d,%d)", r1 + 1, c1 + 1, r2 + 1, c2 + 1);
+}
+
+static int by_games(const void *a, const void *b) {
+    const PlayerStats *x = *(const PlayerStats *const *)a, *y = *(const PlayerStats *const *)b;
+    if (x->games != y->games) return x->games < y->games ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+static int by_count(const void *a, const void *b) {
+    const PosEntry *x = *(const PosEntry *const *)a, *y = *(const PosEntry *const *)b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    return 0;
+}
+
+static void print_players(TableOut *t, const Worker *w, int depth) {
+    size_t n = 0;
+    PlayerStats **list = (PlayerStats **)malloc((w->players.count ? w->players.count : 1) * sizeof *list);
+    if (!list) return;
+    for (size_t i = 0; w->players.slots && i <= w->players.mask; i++) {
+        if (w->players.slots[i].name[0]) list[n++] = &w->players.slots[i];
+    }
+    qsort(list, n, sizeof *list, by_games);
+    table_begin(t, "player");
+    for (size_t i = 0; i < n; i++) {
+        const PlayerStats *p = list[i];
+        row_begin(t);
+        col_str(t, "name", p->name);
+        col_u64(t, "games", p->games);
+        col_u64(t, "wins", p->wins);
+        col_u64(t, "losses", p->losses);
+        col_u64(t, "draws", p->draws);
+        col_u64(t, "unfinished", p->unfinished);
+        col_u64(t, "moves", p->moves);
+        if (depth > 0) {
+            col_f(t, "accuracy", 100.0 * ratio(p->exact, p->moves));
+            col_f(t, "avg_loss", ratio(p->loss, p->moves));
+            col_u64(t, "blunders", p->blunders);
+        }
+        row_end(t);
+    }
+    free(list);
+}
+
+static void print_openings(TableOut *t, const Worker *w) {
+    int order[OPENING_SLOTS], n = 0;
+    for (int i = 0; i < OPENING_SLOTS; i++) {
+        if (w->openings[i].games) order[n++] = i;
+    }
+    // 많이 나온 순 (칸 수가 작아서 삽입 정렬)
+    for (int i = 1; i < n; i++) {
+        int v = order[i], j = i;
+        for (; j > 0 && w->openings[order[j - 1]].games < w->openings[v].games; j--) order[j] = order[j - 1];
+        order[j] = v;
+    }
+    table_begin(t, "opening");
+    for (int i = 0; i < n; i++) {
+        const OpeningStats *o = &w->openings[order[i]];
+        uint64_t decided = o->red_wins + o->blue_wins + o->draws;
+        char name[32];
+        move_name(order[i] == OPENING_SLOTS - 1 ? WIRE_MOVE_PASS : (uint16_t)order[i], name, sizeof name);
+        row_begin(t);
+        col_str(t, "move", name);
+        col_u64(t, "games", o->games);
+        col_u64(t, "red_wins", o->red_wins);
+        col_u64(t, "blue_wins", o->blue_wins);
+        col_u64(t, "draws", o->draws);
+        col_f(t, "red_win_rate", ratio(o->red_wins, decided));
+        row_end(t);
+    }
+}
+
+static void print_positions(TableOut *t, const Worker *w, int top) {
+    size_t n = 0;
+    const PosTable *pt = &w->positions;
+    const PosEntry **list = (const PosEntry **)malloc((pt->count ? pt->count : 1) * sizeof *list);
+    if (!list) return;
+    for (size_t i = 0; pt->slots && i <= pt->mask; i++) {
+        if (pt->slots[i].count) list[n++] = &pt->slots[i];
+    }
+    qsort(list, n, sizeof *list, by_count);
+    table_begin(t, "position");
+    for (size_t i = 0; i < n && (int)i < top; i++) {
+        GameSession g;
+        char rows[BOARD_SIZE][BOARD_SIZE + 1], board[BOARD_SIZE * (BOARD_SIZE + 1)];
+        session_init(&g);
+        g.red = list[i]->red;
+        g.blue = list[i]->blue;
+        g.blocked = list[i]->blocked;
+        session_render(&g, rows);
+        // 행을 '/'로 이은 64칸
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            memcpy(board + r * (BOARD_SIZE + 1), rows[r], BOARD_SIZE);
+            board[r * (BOARD_SIZE + 1) + BOARD_SIZE] = r == BOARD_SIZE - 1 ? '\0' : '/';
+        }
+        row_begin(t);
+        col_str(t, "board", board);
+        col_str(t, "turn", list[i]->turn ? "B" : "R");
+        col_u64(t, "count", list[i]->count);
+        row_end(t);
+    }
+    free(list);
+}
+
+/* ---- 실행 ---- */
+
+void analyze_options_init(AnalyzeOptions *opt) {
+    opt->threads = 0;
+    opt->depth = 0;
+    opt->blunder = 4;
+    opt->top = 20;
+    opt->csv = 0;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void worker_free(Worker *w) {
+    free(w->players.slots);
+    free(w->positions.slots);
+}
+
+int analyze_run(const char *path, const AnalyzeOptions *opt) {
+    GameLogReader rd;
+    if (gamelog_reader_open(&rd, path) < 0) {
+        fprintf(stderr, "%s: cannot open game log\n", path);
+        return -1;
+    }
+    double t0 = now_sec();
+
+    // 1) 머리만 훑어 레코드 위치를 모은다 (수는 건너뛴다)
+    size_t nrecs = 0, cap = 1024;
+    uint64_t total_moves = 0;
+    const GameLogRecord **recs = (const GameLogRecord **)malloc(cap * sizeof *recs);
+    const GameLogRecord *rec;
+    while (recs && (rec = gamelog_reader_next(&rd)) != NULL) {
+        if (nrecs == cap) {
+            cap *= 2;
+            const GameLogRecord **bigger = (const GameLogRecord **)realloc(recs, cap * sizeof *recs);
+            if (!bigger) {
+                free(recs);
+                recs = NULL;
+                break;
+            }
+            recs = bigger;
+        }
+        recs[nrecs++] = rec;
+        total_moves += rec->move_count;
+    }
+    int threads = opt->threads;
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    Worker *workers = recs ? (Worker *)calloc((size_t)threads, sizeof *workers) : NULL;
+    if (!workers) {
+        perror("analyze");
+        free(recs);
+        gamelog_reader_close(&rd);
+        return -1;
+    }
+
+    // 2) 수 개수가 고르게 나뉘도록 연속 구간으로 자른다
+    size_t start = 0;
+    uint64_t acc = 0;
+    for (int k = 0; k < threads; k++) {
+        uint64_t goal = total_moves * (uint64_t)(k + 1) / (uint64_t)threads;
+        size_t end = start;
+        while (end < nrecs && (acc < goal || k == threads - 1)) acc += recs[end++]->move_count;
+        workers[k].opt = opt;
+        workers[k].recs = recs + start;
+        workers[k].nrecs = end - start;
+        start = end;
+    }
+    int started = 0;
+    for (int k = 0; k < threads; k++) {
+        if (pthread_create(&workers[k].thread, NULL, worker_main, &workers[k]) != 0) {
+            perror("pthread_create");
+            break;
+        }
+        started++;
+    }
+    for (int k = 0; k < started; k++) pthread_join(workers[k].thread, NULL);
+    // 띄우지 못한 몫은 이 스레드가 한다
+    for (int k = started; k < threads; k++) worker_main(&workers[k]);
+
+    // 3) 0번에 모은다
+    int failed = workers[0].failed;
+    for (int k = 1; k < threads; k++) {
+        failed |= workers[k].failed || worker_merge(&workers[0], &workers[k]) < 0;
+        worker_free(&workers[k]);
+    }
+    double elapsed = now_sec() - t0;
+    const Worker *all = &workers[0];
+    const Totals *tot = &all->totals;
+    if (failed) fprintf(stderr, "analyze: out of memory, results are partial\n");
+
+    TableOut out;
+    memset(&out, 0, sizeof out);
+    out.csv = opt->csv;
+    table_begin(&out, "summary");
+    row_begin(&out);
+    col_u64(&out, "games", tot->games);
+    col_u64(&out, "positions", tot->positions);
+    col_u64(&out, "distinct_positions", all->positions.count);
+    col_u64(&out, "illegal", tot->illegal);
+    col_u64(&out, "red_wins", tot->red_wins);
+    col_u64(&out, "blue_wins", tot->blue_wins);
+    col_u64(&out, "draws", tot->draws);
+    col_u64(&out, "unfinished", tot->unfinished);
+    col_f(&out, "first_move_win_rate", ratio(tot->red_wins, tot->red_wins + tot->blue_wins + tot->draws));
+    col_u64(&out, "threads", (uint64_t)threads);
+    col_u64(&out, "depth", (uint64_t)opt->depth);
+    col_f(&out, "seconds", elapsed);
+    col_f(&out, "positions_per_sec", elapsed > 0 ? (double)tot->positions / elapsed : 0.0);
+    row_end(&out);
+    print_players(&out, all, opt->depth);
+    print_openings(&out, all);
+    print_positions(&out, all, opt->top);
+
+    fprintf(stderr, "analyzed %llu games, %llu positions in %.3f s with %d threads (%.0f positions/s, depth %d)\n",
+            (unsigned long long)tot->games, (unsigned long long)tot->positions, elapsed, threads,
+            elapsed > 0 ? (double)tot->positions / elapsed : 0.0, opt->depth);
+
+    worker_free(&workers[0]);
+    free(workers);
+    free(recs);
+    gamelog_reader_close(&rd);
+    return failed ? -1 : 0;
+}
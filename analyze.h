@@ -0,0 +1,23 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+/*
+ * hw3 analyze: 게임 로그(gamelog.h)를 스레드 수만큼 나눠 모든 게임을 규칙대로 다시 두고
+ * 선수별 성적/정확도, 첫 수별 승률, 자주 나온 국면을 모아 JSONL 또는 CSV로 출력한다.
+ * depth > 0이면 국면마다 engine.h 탐색으로 최선 수와 비교해 손실과 blunder를 센다.
+ * 처리량(positions/s)은 stderr와 summary에 나온다.
+ * 체크포인트에서 되살린 게임의 나머지 레코드(GAMELOG_CONTINUED)는 게임 수, 승패, 첫 수에 세지 않는다.
+ */
+typedef struct {
+    int threads;           // 0이면 코어 수
+    int depth;             // 국면마다 탐색할 깊이 (0이면 탐색 없이 통계만)
+    int blunder;           // 최선 수보다 이만큼(말 수) 이상 나쁘면 blunder
+    int top;               // 출력할 국면 수 (많이 나온 순)
+    int csv;               // 1이면 CSV (표마다 머리줄, 표 사이 빈 줄), 0이면 JSONL
+} AnalyzeOptions;
+
+void analyze_options_init(AnalyzeOptions *opt);
+// 결과는 stdout. 로그를 못 열면 -1
+int analyze_run(const char *path, const AnalyzeOptions *opt);
+
+#endif
@@ -0,0 +1,156 @@
+#include "../include/arena.h"
+#include "../libs/cJSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * 모든 블록 앞에 16바이트 헤더를 붙여 출처를 표시한다.
+ * arena 블록은 free가 no-op이므로 다른 스레드에서 cJSON_Delete 해도 안전하고,
+ * 구간 밖에서 malloc된 블록만 실제로 free 된다.
+ */
+#define ARENA_TAG_HEAP  0x48454150u   /* "HEAP" */
+#define ARENA_TAG_SLAB  0x534c4142u   /* "SLAB" */
+#define ARENA_HDR_SIZE  16
+#define ARENA_ALIGN(n)  (((n) + 15) & ~(size_t)15)
+
+typedef struct ArenaSlab {
+    struct ArenaSlab *next;
+    size_t cap;
+    size_t used;
+    size_t pad;             // data 영역을 16바이트 정렬로 맞춤
+} ArenaSlab;
+
+typedef struct {
+    ArenaSlab *head;        // 현재 bump 중인 slab (리스트 맨 앞)
+    int depth;              // arena_begin 중첩 깊이
+    int registered;         // 스레드 종료 시 정리용 key 등록 여부
+} Arena;
+
+static __thread Arena tls_arena;
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static inline unsigned char *slab_data(ArenaSlab *s) {
+    return (unsigned char *)(s + 1);
+}
+
+static void arena_release_all(void *arg) {
+    Arena *a = (Arena *)arg;
+    ArenaSlab *s = a->head;
+    while (s) {
+        ArenaSlab *next = s->next;
+        free(s);
+        s = next;
+    }
+    a->head = NULL;
+}
+
+static void arena_make_key(void) {
+    pthread_key_create(&arena_key, arena_release_all);
+}
+
+static ArenaSlab *slab_new(size_t cap) {
+    ArenaSlab *s = (ArenaSlab *)malloc(sizeof(ArenaSlab) + cap);
+    if (!s) return NULL;
+    s->next = NULL;
+    s->cap = cap;
+    s->used = 0;
+    return s;
+}
+
+static void *slab_alloc(Arena *a, size_t need) {
+    ArenaSlab *s = a->head;
+    if (!s || s->cap - s->used < need) {
+        // 큰 요청은 전용 slab을 하나 만들어 같은 수명으로 묶는다
+        size_t cap = need > ARENA_SLAB_SIZE ? need : ARENA_SLAB_SIZE;
+        ArenaSlab *ns = slab_new(cap);
+        if (!ns) return NULL;
+        ns->next = s;
+        a->head = ns;
+        s = ns;
+        if (!a->registered) {
+            pthread_once(&arena_key_once, arena_make_key);
+            pthread_setspecific(arena_key, a);
+            a->registered = 1;
+        }
+    }
+    unsigned char *p = slab_data(s) + s->used;
+    s->used += need;
+    return p;
+}
+
+static void arena_reset(Arena *a) {
+    // 기본 크기 slab 하나만 남기고 나머지는 반환
+    ArenaSlab *keep = NULL;
+    ArenaSlab *s = a->head;
+    while (s) {
+        ArenaSlab *next = s->next;
+        if (!keep && s->cap == ARENA_SLAB_SIZE) {
+            keep = s;
+            keep->used = 0;
+            keep->next = NULL;
+        } else {
+            free(s);
+        }
+        s = next;
+    }
+    a->head = keep;
+}
+
+void *arena_alloc(size_t size) {
+    Arena *a = &tls_arena;
+    size_t need = ARENA_HDR_SIZE + ARENA_ALIGN(size);
+    uint32_t *hdr;
+
+    if (a->depth > 0) {
+        hdr = (uint32_t *)slab_alloc(a, need);
+        if (!hdr) return NULL;
+        hdr[0] = ARENA_TAG_SLAB;
+    } else {
+        hdr = (uint32_t *)malloc(need);
+        if (!hdr) return NULL;
+        hdr[0] = ARENA_TAG_HEAP;
+    }
+    return (unsigned char *)hdr + ARENA_HDR_SIZE;
+}
+
+void arena_free(void *ptr) {
+    if (!ptr) return;
+    uint32_t *hdr = (uint32_t *)((unsigned char *)ptr - ARENA_HDR_SIZE);
+    if (hdr[0] == ARENA_TAG_HEAP) {
+        hdr[0] = 0;
+        free(hdr);
+    }
+    // ARENA_TAG_SLAB: reset 때 한꺼번에 반환
+}
+
+void arena_begin(void) {
+    tls_arena.depth++;
+}
+
+void arena_end(void) {
+    Arena *a = &tls_arena;
+    if (a->depth <= 0) return;
+    if (--a->depth == 0) {
+        arena_reset(a);
+    }
+}
+
+size_t arena_bytes_in_use(void) {
+    size_t total = 0;
+    for (ArenaSlab *s = tls_arena.head; s; s = s->next) {
+        total += s->used;
+    }
+    return total;
+}
+
+void arena_install_cjson_hooks(void) {
+    cJSON_Hooks hooks;
+    hooks.malloc_fn = arena_alloc;
+    hooks.free_fn = arena_free;
+    cJSON_InitHooks(&hooks);
+}
@@ -0,0 +1,25 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_SLAB_SIZE (64 * 1024)
+
+// cJSON_InitHooks로 arena 할당기를 설치 (main에서 한 번만 호출)
+void arena_install_cjson_hooks(void);
+
+// 현재 스레드의 메시지 단위 구간 시작/끝
+// arena_begin ~ arena_end 사이의 cJSON 할당은 스레드 로컬 slab에서 나오고,
+// 가장 바깥쪽 arena_end에서 한 번에 reset 된다. (중첩 가능)
+void arena_begin(void);
+void arena_end(void);
+
+// cJSON 훅으로 쓰이는 할당/해제 함수
+// 구간 밖에서의 할당은 일반 malloc으로 처리되어 free까지 살아있다.
+void *arena_alloc(size_t size);
+void arena_free(void *ptr);
+
+// 현재 스레드 arena가 잡고 있는 바이트 수 (디버그용)
+size_t arena_bytes_in_use(void);
+
+#endif
@@ -0,0 +1,300 @@
+#include "../include/bench.h"
+#include "../include/server.h"
+#include "../include/session.h"
+#include "../include/wire.h"
+#include "../include/json.h"
+#include "../include/stats.h"
+#include "../include/arena.h"
+#include "../libs/cJSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define BENCH_CONNECT_TRIES  100    // 서버가 listen할 때까지 20ms씩 다시 접속해 본다
+#define BENCH_RECV_TIMEOUT_S 10     // 이만큼 아무것도 오지 않으면 게임이 멈춘 것으로 보고 실패
+#define BENCH_BUF_SIZE       4096
+
+enum { STAGE_TOTAL, STAGE_RELAY, STAGE_REQUEST, STAGE_THINK, STAGES };
+static const char *const stage_names[STAGES] = { "total", "relay", "request", "think" };
+static const char *const server_stage_names[STATS_HISTS] = {
+    "server_turn", "server_validation", "server_serialization", "server_sendq_delay",
+};
+
+typedef struct Script {
+    pthread_t thread;
+    struct Script *peer;
+    const char *name;
+    int games;                 // 이만큼 game_over를 받으면 끝
+    int fd;
+    char buf[BENCH_BUF_SIZE];
+    size_t len;
+    uint64_t sent_ns;          // 마지막으로 move를 보낸 시각 (상대 스레드가 relay를 잴 때 읽는다)
+    StatsHist stage[STAGES];
+    uint64_t turns, finished;
+    int failed;
+} Script;
+
+typedef struct {
+    const ServerConfig *cfg;
+    int rc;
+} ServerThread;
+
+static void *server_main(void *arg) {
+    ServerThread *st = (ServerThread *)arg;
+    st->rc = server_run_config(st->cfg);
+    return NULL;
+}
+
+static int script_connect(const char *port, int tries) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo("127.0.0.1", port, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (int i = 0; i < tries && fd < 0; i++) {
+        if (i > 0) usleep(20000);
+        fd = socket(res->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    struct timeval tv;
+    tv.tv_sec = BENCH_RECV_TIMEOUT_S;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    return fd;
+}
+
+// 한 줄을 꺼내 파싱한다. *at은 그 줄을 꺼낸 시각. 끊기거나 시간이 지나면 NULL
+static cJSON *script_recv(Script *s, uint64_t *at) {
+    for (;;) {
+        char *nl = (char *)memchr(s->buf, '\n', s->len);
+        if (nl) {
+            *nl = '\0';
+            *at = stats_clock_ns();
+            cJSON *msg = cJSON_Parse(s->buf);
+            size_t used = (size_t)(nl - s->buf) + 1;
+            memmove(s->buf, s->buf + used, s->len - used);
+            s->len -= used;
+            return msg;
+        }
+        if (s->len + 1 >= sizeof s->buf) return NULL;
+        ssize_t n = recv(s->fd, s->buf + s->len, sizeof s->buf - s->len - 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return NULL;
+        s->len += (size_t)n;
+    }
+}
+
+// 둘 수 있는 첫 수 (session_moves는 복제가 먼저라 빈 칸을 채워 나가며 게임이 끝난다)
+static uint16_t first_move(const cJSON *jboard, int color) {
+    char board[BOARD_SIZE][BOARD_SIZE];
+    memset(board, '.', sizeof board);
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        const cJSON *row = cJSON_GetArrayItem(jboard, i);
+        if (cJSON_IsString(row) && strlen(row->valuestring) >= BOARD_SIZE) memcpy(board[i], row->valuestring, BOARD_SIZE);
+    }
+    GameSession g;
+    uint16_t moves[SESSION_MAX_MOVES];
+    session_from_board(&g, board);
+    return session_moves(&g, color, moves) > 0 ? moves[0] : WIRE_MOVE_PASS;
+}
+
+static int script_move(Script *s, const cJSON *msg, int color, uint64_t at) {
+    uint16_t mv = first_move(cJSON_GetObjectItem(msg, "board"), color);
+    int r1 = 0, c1 = 0, r2 = 0, c2 = 0;   // 모두 0이면 pass
+    if (mv != WIRE_MOVE_PASS) {
+        wire_move_coords(mv, &r1, &c1, &r2, &c2);
+        r1++, c1++, r2++, c2++;
+    }
+    cJSON *out = cJSON_CreateObject();
+    cJSON_AddStringToObject(out, "type", "move");
+    cJSON_AddStringToObject(out, "username", s->name);
+    cJSON_AddNumberToObject(out, "sx", r1);
+    cJSON_AddNumberToObject(out, "sy", c1);
+    cJSON_AddNumberToObject(out, "tx", r2);
+    cJSON_AddNumberToObject(out, "ty", c2);
+    uint64_t now = stats_clock_ns();
+    stats_hist_add(&s->stage[STAGE_THINK], now - at);
+    __atomic_store_n(&s->sent_ns, now, __ATOMIC_RELEASE);
+    int rc = send_json(s->fd, out);
+    cJSON_Delete(out);
+    s->turns++;
+    return rc;
+}
+
+static void *script_main(void *arg) {
+    Script *s = (Script *)arg;
+    cJSON *reg = cJSON_CreateObject();
+    cJSON_AddStringToObject(reg, "type", "register");
+    cJSON_AddStringToObject(reg, "username", s->name);
+    s->failed = send_json(s->fd, reg) < 0;
+    cJSON_Delete(reg);
+
+    int color = 0;
+    int awaiting = 0;          // 내 move의 결과를 기다리는 중
+    int relay = 0;             // 상대 수의 결과를 받았다: 다음 your_turn까지가 relay
+    uint64_t sent = 0;         // 이 게임에서 마지막으로 보낸 내 move (total)
+    while (!s->failed && s->finished < (uint64_t)s->games) {
+        uint64_t at = 0;
+        arena_begin();
+        cJSON *msg = script_recv(s, &at);
+        const cJSON *jtype = msg ? cJSON_GetObjectItem(msg, "type") : NULL;
+        if (!cJSON_IsString(jtype)) {
+            s->failed = 1;
+        } else if (strcmp(jtype->valuestring, "your_turn") == 0) {
+            if (sent) stats_hist_add(&s->stage[STAGE_TOTAL], at - sent);
+            if (relay) stats_hist_add(&s->stage[STAGE_RELAY], at - __atomic_load_n(&s->peer->sent_ns, __ATOMIC_ACQUIRE));
+            relay = 0;
+            if (script_move(s, msg, color, at) < 0) s->failed = 1;
+            sent = s->sent_ns;
+            awaiting = 1;
+        } else if (strcmp(jtype->valuestring, "move_ok") == 0 || strcmp(jtype->valuestring, "pass") == 0
+                   || strcmp(jtype->valuestring, "invalid_move") == 0) {
+            if (awaiting) {
+                stats_hist_add(&s->stage[STAGE_REQUEST], at - sent);
+                awaiting = 0;
+                if (jtype->valuestring[0] == 'i') s->failed = 1;   // 규칙대로 고른 수가 거절되면 측정이 어긋난다
+            } else {
+                relay = 1;
+            }
+        } else if (strcmp(jtype->valuestring, "game_start") == 0) {
+            const cJSON *p0 = cJSON_GetArrayItem(cJSON_GetObjectItem(msg, "players"), 0);
+            color = cJSON_IsString(p0) && strcmp(p0->valuestring, s->name) == 0 ? 0 : 1;
+            awaiting = relay = 0;
+            sent = 0;
+        } else if (strcmp(jtype->valuestring, "game_over") == 0) {
+            s->finished++;     // 서버가 둘을 다시 대기열에 넣어 다음 게임이 시작된다
+        } else if (strcmp(jtype->valuestring, "register_nack") == 0) {
+            s->failed = 1;
+        }
+        cJSON_Delete(msg);
+        arena_end();
+    }
+    return NULL;
+}
+
+static void print_json_stage(const char *name, const StatsHist *h, int first) {
+    printf("%s\"%s\":{\"count\":%llu,\"mean\":%.3f,\"p50\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f}",
+           first ? "" : ",", name, (unsigned long long)h->total,
+           h->total ? (double)h->sum / (double)h->total / 1e3 : 0.0,
+           (double)stats_hist_percentile(h, 0.5) / 1e3, (double)stats_hist_percentile(h, 0.99) / 1e3,
+           (double)stats_hist_percentile(h, 0.999) / 1e3, (double)h->max / 1e3);
+}
+
+static void print_csv_stage(const char *name, const StatsHist *h) {
+    printf("%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", name, (unsigned long long)h->total,
+           h->total ? (double)h->sum / (double)h->total / 1e3 : 0.0,
+           (double)stats_hist_percentile(h, 0.5) / 1e3, (double)stats_hist_percentile(h, 0.99) / 1e3,
+           (double)stats_hist_percentile(h, 0.999) / 1e3, (double)h->max / 1e3);
+}
+
+void turn_bench_options_init(TurnBenchOptions *opt) {
+    opt->port = "9900";
+    opt->games = 100;
+    opt->threads = 1;
+    opt->csv = 0;
+}
+
+int turn_bench_run(const TurnBenchOptions *opt) {
+    // 서버는 SO_REUSEPORT로 listen하므로 이미 떠 있는 서버와 포트를 나눠 가질 수 있다: 그러면 잴 수 없다
+    int probe = script_connect(opt->port, 1);
+    if (probe >= 0) {
+        close(probe);
+        fprintf(stderr, "bench turns: port %s is already in use\n", opt->port);
+        return -1;
+    }
+    ServerConfig cfg;
+    server_config_init(&cfg);
+    cfg.port = opt->port;
+    cfg.threads = opt->threads;
+    cfg.resume_grace = 0;
+    Script *s = (Script *)calloc(2, sizeof(Script));
+    StatsHist *server_hist = (StatsHist *)calloc(STATS_HISTS, sizeof(StatsHist));
+    if (!s || !server_hist) {
+        free(s);
+        free(server_hist);
+        return -1;
+    }
+
+    // 서버의 시작/종료 메시지가 결과와 섞이지 않게 그동안 stdout을 stderr로 돌린다
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    stats_on = 1;              // 서버 쪽 단계도 같은 프로세스에서 읽는다
+    ServerThread st;
+    st.cfg = &cfg;
+    st.rc = 0;
+    pthread_t server;
+    int server_started = pthread_create(&server, NULL, server_main, &st) == 0;
+    int ok = server_started;
+
+    for (int i = 0; i < 2; i++) {
+        s[i].peer = &s[1 - i];
+        s[i].name = i == 0 ? "bench-a" : "bench-b";
+        s[i].games = opt->games;
+        s[i].fd = ok ? script_connect(opt->port, BENCH_CONNECT_TRIES) : -1;
+        if (s[i].fd < 0) ok = 0;
+    }
+    uint64_t start = stats_clock_ns();
+    int started = 0;
+    for (int i = 0; ok && i < 2; i++) {
+        if (pthread_create(&s[i].thread, NULL, script_main, &s[i]) != 0) ok = 0;
+        else started++;
+    }
+    for (int i = 0; i < started; i++) pthread_join(s[i].thread, NULL);
+    double secs = (double)(stats_clock_ns() - start) / 1e9;
+    for (int i = 0; i < 2; i++) {
+        if (s[i].fd >= 0) close(s[i].fd);
+        if (s[i].failed || s[i].finished < (uint64_t)opt->games) ok = 0;
+    }
+    stats_collect(server_hist);
+    if (server_started) {
+        server_stop();
+        pthread_join(server, NULL);
+    }
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    if (!ok || st.rc != EXIT_SUCCESS) {
+        fprintf(stderr, "bench turns: failed after %llu games\n", (unsigned long long)s[0].finished);
+        free(s);
+        free(server_hist);
+        return -1;
+    }
+
+    for (int k = 0; k < STAGES; k++) stats_hist_merge(&s[0].stage[k], &s[1].stage[k]);
+    uint64_t turns = s[0].turns + s[1].turns;
+    fprintf(stderr, "bench turns: %d games, %llu turns in %.3f s (%.0f turns/s)\n", opt->games,
+            (unsigned long long)turns, secs, (double)turns / secs);
+    if (opt->csv) {
+        printf("stage,count,mean_us,p50_us,p99_us,p999_us,max_us\n");
+        for (int k = 0; k < STAGES; k++) print_csv_stage(stage_names[k], &s[0].stage[k]);
+        for (int h = 0; h < STATS_HISTS; h++) print_csv_stage(server_stage_names[h], &server_hist[h]);
+    } else {
+        printf("{\"games\":%d,\"turns\":%llu,\"seconds\":%.3f,\"turns_per_sec\":%.1f,\"unit\":\"us\",\"stages\":{",
+               opt->games, (unsigned long long)turns, secs, (double)turns / secs);
+        for (int k = 0; k < STAGES; k++) print_json_stage(stage_names[k], &s[0].stage[k], k == 0);
+        for (int h = 0; h < STATS_HISTS; h++) print_json_stage(server_stage_names[h], &server_hist[h], 0);
+        printf("}}\n");
+    }
+    free(s);
+    free(server_hist);
+    return 0;
+}
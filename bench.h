@@ -0,0 +1,29 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * hw3 bench turns: 한 프로세스 안에서 서버와 스크립트 클라이언트 두 개를 loopback으로 붙여 게임을
+ * 정해진 수만큼 두고, 턴마다 걸린 시간을 단계별로 잰다. 클라이언트는 생각하는 시간 없이
+ * 둘 수 있는 첫 수(복제가 먼저)를 두므로 매번 같은 게임이 되고, 빌드끼리 숫자를 견줄 수 있다.
+ *
+ * 단계 (클라이언트 쪽, 같은 CLOCK_MONOTONIC):
+ *   total    내 move를 보낸 뒤 다음 your_turn을 받을 때까지 (relay + 상대 think + relay)
+ *   relay    상대가 move를 보낸 뒤 내가 your_turn을 받을 때까지 (서버를 한 번 거쳐 오는 시간)
+ *   request  내 move를 보낸 뒤 그 결과(move_ok/pass)를 받을 때까지
+ *   think    your_turn을 받은 뒤 move를 보내기 직전까지 (파싱, 수 선택, 메시지 구성)
+ * 서버 쪽은 stats.h 히스토그램을 같은 프로세스에서 읽는다 (server_turn, validation, serialization, sendq_delay).
+ *
+ * 결과는 stdout에 JSON 한 줄 (단위 us) 또는 CSV. 서버의 시작/종료 메시지는 stderr로 보낸다.
+ */
+typedef struct {
+    const char *port;      // 서버가 listen할 loopback 포트
+    int games;
+    int threads;           // 서버 reactor 수 (기본 1: 두 플레이어가 같은 shard)
+    int csv;
+} TurnBenchOptions;
+
+void turn_bench_options_init(TurnBenchOptions *opt);
+// 서버를 못 띄우거나 게임이 끝까지 가지 못하면 -1
+int turn_bench_run(const TurnBenchOptions *opt);
+
+#endif
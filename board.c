@@ -2,6 +2,7 @@
 
 #include "../libs/rpi-rgb-led-matrix/include/led-matrix-c.h"
 #include "../include/board.h"
+#include "../include/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -77,6 +78,7 @@ int init_led_matrix(int *argc, char ***argv) {
 
 void update_led_matrix(const char board[8][8]) {
     if (!matrix) return;
+    uint64_t t0 = trace_begin();
     struct LedCanvas *canvas = led_matrix_get_canvas(matrix);
     led_canvas_clear(canvas);
     draw_grid(canvas);
@@ -88,6 +90,7 @@ void update_led_matrix(const char board[8][8]) {
         }
     }
     led_matrix_swap_on_vsync(matrix, canvas);
+    trace_end("update_led_matrix", t0);
 }
 
 void close_led_matrix(void) {
@@ -0,0 +1,292 @@
+#include "../include/checkpoint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint32_t state_check(const CheckpointState *st) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ st->gen;
+    h = (h ^ st->red) * 0xff51afd7ed558ccdull;
+    h = (h ^ st->blue) * 0xc4ceb9fe1a85ec53ull;
+    h = (h ^ st->blocked) * 0xff51afd7ed558ccdull;
+    h = (h ^ st->deadline_ms) * 0xc4ceb9fe1a85ec53ull;
+    h = (h ^ ((uint32_t)st->seq << 16 | st->turn << 8 | st->pass_count)) * 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return (uint32_t)h | 1;    // 0으로 채워진 사본은 온전하지 않다
+}
+
+static uint64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+// 온전한 사본 중 최신 것 (없으면 NULL)
+static const CheckpointState *latest_state(const CheckpointSlot *slot) {
+    const CheckpointState *best = NULL;
+    for (int i = 0; i < 2; i++) {
+        const CheckpointState *st = &slot->state[i];
+        if (st->gen == 0 || st->check != state_check(st)) continue;
+        if (!best || st->gen > best->gen) best = st;
+    }
+    return best;
+}
+
+/* ---- 파일 ---- */
+
+static size_t file_size(uint32_t capacity) {
+    return sizeof(CheckpointHeader) + (size_t)capacity * sizeof(CheckpointSlot);
+}
+
+Checkpoint *checkpoint_open(const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(path);
+        close(fd);
+        return NULL;
+    }
+    int fresh = st.st_size == 0;
+    uint32_t capacity = CHECKPOINT_SLOTS;
+    if (!fresh) {
+        // 예전 파일의 용량을 그대로 쓴다 (상수를 바꾼 뒤에도 남은 게임을 읽을 수 있게)
+        CheckpointHeader h;
+        if (pread(fd, &h, sizeof h, 0) != (ssize_t)sizeof h || memcmp(h.magic, CHECKPOINT_MAGIC, sizeof h.magic) != 0
+            || h.version != 2 || h.slot_size != sizeof(CheckpointSlot) || h.capacity == 0
+            || (size_t)st.st_size != file_size(h.capacity)) {
+            fprintf(stderr, "%s: not a checkpoint file\n", path);
+            close(fd);
+            return NULL;
+        }
+        capacity = h.capacity;
+    } else if (ftruncate(fd, (off_t)file_size(capacity)) < 0) {
+        perror(path);
+        close(fd);
+        return NULL;
+    }
+    Checkpoint *ck = (Checkpoint *)calloc(1, sizeof(Checkpoint));
+    uint32_t *free_list = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    void *p = MAP_FAILED;
+    if (ck && free_list) p = mmap(NULL, file_size(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        perror(path);
+        free(free_list);
+        free(ck);
+        close(fd);
+        return NULL;
+    }
+    ck->fd = fd;
+    ck->hdr = (CheckpointHeader *)p;
+    ck->slots = (CheckpointSlot *)(ck->hdr + 1);
+    ck->map_len = file_size(capacity);
+    ck->free_list = free_list;
+    pthread_mutex_init(&ck->lock, NULL);
+    if (fresh) {
+        memcpy(ck->hdr->magic, CHECKPOINT_MAGIC, sizeof ck->hdr->magic);
+        ck->hdr->version = 2;
+        ck->hdr->slot_size = sizeof(CheckpointSlot);
+        ck->hdr->capacity = capacity;
+    }
+    // 낮은 번호부터 나가도록 거꾸로 쌓는다 (쓰는 페이지가 앞쪽에 모인다)
+    for (uint32_t i = capacity; i-- > 0; ) {
+        if (ck->slots[i].game_id == 0) ck->free_list[ck->free_count++] = i;
+    }
+    return ck;
+}
+
+void checkpoint_close(Checkpoint *ck) {
+    if (!ck) return;
+    msync(ck->hdr, ck->map_len, MS_SYNC);
+    munmap(ck->hdr, ck->map_len);
+    close(ck->fd);
+    pthread_mutex_destroy(&ck->lock);
+    free(ck->free_list);
+    free(ck);
+}
+
+void checkpoint_discard(Checkpoint *ck, uint32_t slot) {
+    __atomic_store_n(&ck->slots[slot].game_id, 0u, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&ck->lock);
+    ck->free_list[ck->free_count++] = slot;
+    pthread_mutex_unlock(&ck->lock);
+}
+
+int checkpoint_restore(Checkpoint *ck, void (*fn)(const CheckpointGame *game, void *arg), void *arg) {
+    int restored = 0;
+    uint64_t now = wall_ms();
+    for (uint32_t i = 0; i < ck->hdr->capacity; i++) {
+        CheckpointSlot *slot = &ck->slots[i];
+        if (slot->game_id == 0) continue;
+        const CheckpointState *st = latest_state(slot);
+        // 이름을 쓰다 말았을 수도 있다
+        slot->name[0][REGISTRY_NAME_MAX - 1] = slot->name[1][REGISTRY_NAME_MAX - 1] = '\0';
+        if (!st || !slot->name[0][0] || !slot->name[1][0]) {
+            checkpoint_discard(ck, i);
+            continue;
+        }
+        CheckpointGame game;
+        memset(&game, 0, sizeof game);
+        game.slot = i;
+        game.game_id = slot->game_id;
+        game.name[0] = slot->name[0];
+        game.name[1] = slot->name[1];
+        game.token[0] = slot->token[0];
+        game.token[1] = slot->token[1];
+        session_init(&game.board);
+        game.board.red = st->red;
+        game.board.blue = st->blue;
+        game.board.blocked = st->blocked;
+        game.board.turn = st->turn & 1;
+        game.board.pass_count = st->pass_count & 3;
+        game.board.seq = st->seq;
+        game.timed = st->deadline_ms != 0;
+        if (st->deadline_ms > now) game.turn_ms = (uint32_t)(st->deadline_ms - now);
+        fn(&game, arg);
+        restored++;
+    }
+    return restored;
+}
+
+/* ---- checkpointer ---- */
+
+static inline size_t slot_of(const Checkpointer *w, uint32_t id) {
+    return (size_t)(id * 2654435761u) & w->mask;
+}
+
+// id가 있는 칸, 없으면 -1
+static long find_slot(const Checkpointer *w, uint32_t id) {
+    if (!w->slots) return -1;
+    for (size_t i = slot_of(w, id);; i = (i + 1) & w->mask) {
+        if (!w->slots[i]) return -1;
+        if ((uint32_t)(w->slots[i] >> 32) == id) return (long)i;
+    }
+}
+
+static void insert_slot(Checkpointer *w, uint64_t v) {
+    size_t i = slot_of(w, (uint32_t)(v >> 32));
+    while (w->slots[i]) i = (i + 1) & w->mask;
+    w->slots[i] = v;
+    w->count++;
+}
+
+// 빈 칸 뒤에서 자기 자리를 지나쳐 온 항목을 당겨온다 (tombstone 없이 지우기)
+static void remove_slot(Checkpointer *w, size_t hole) {
+    w->slots[hole] = 0;
+    w->count--;
+    for (size_t i = (hole + 1) & w->mask; w->slots[i]; i = (i + 1) & w->mask) {
+        size_t home = slot_of(w, (uint32_t)(w->slots[i] >> 32));
+        if (((i - home) & w->mask) >= ((i - hole) & w->mask)) {
+            w->slots[hole] = w->slots[i];
+            w->slots[i] = 0;
+            hole = i;
+        }
+    }
+}
+
+static int grow_slots(Checkpointer *w) {
+    size_t old_size = w->slots ? w->mask + 1 : 0;
+    size_t size = old_size ? old_size * 2 : 64;
+    uint64_t *old = w->slots;
+    w->slots = (uint64_t *)calloc(size, sizeof *w->slots);
+    if (!w->slots) {
+        w->slots = old;
+        return -1;
+    }
+    w->mask = size - 1;
+    w->count = 0;
+    for (size_t i = 0; i < old_size; i++) {
+        if (old[i]) insert_slot(w, old[i]);
+    }
+    free(old);
+    return 0;
+}
+
+void checkpointer_init(Checkpointer *w, Checkpoint *ck) {
+    memset(w, 0, sizeof *w);
+    w->ck = ck;
+}
+
+void checkpointer_close(Checkpointer *w) {
+    free(w->slots);
+    w->slots = NULL;
+    w->count = 0;
+}
+
+void checkpointer_adopt(Checkpointer *w, const GameSession *g, uint32_t slot) {
+    if (!w->ck) return;
+    if ((w->count + 1) * 2 > (w->slots ? w->mask + 1 : 0) && grow_slots(w) < 0) {
+        checkpoint_discard(w->ck, slot);
+        return;
+    }
+    insert_slot(w, (uint64_t)g->id << 32 | slot);
+}
+
+void checkpointer_start(Checkpointer *w, const GameSession *g, const char *red, const char *blue,
+                        const uint64_t token[2]) {
+    Checkpoint *ck = w->ck;
+    if (!ck) return;
+    uint32_t slot;
+    pthread_mutex_lock(&ck->lock);
+    int ok = ck->free_count > 0;
+    if (ok) slot = ck->free_list[--ck->free_count];
+    pthread_mutex_unlock(&ck->lock);
+    if (!ok) {
+        static int warned;
+        if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED)) {
+            fprintf(stderr, "checkpoint: all %u slots in use, new games are not saved\n", ck->hdr->capacity);
+        }
+        return;
+    }
+    // 예전 게임의 사본이 되살아나지 않게 지운 뒤에 game_id를 연다
+    CheckpointSlot *s = &ck->slots[slot];
+    memset(s->state, 0, sizeof s->state);
+    memset(s->name, 0, sizeof s->name);
+    strncpy(s->name[0], red, REGISTRY_NAME_MAX - 1);
+    strncpy(s->name[1], blue, REGISTRY_NAME_MAX - 1);
+    s->token[0] = token[0];
+    s->token[1] = token[1];
+    __atomic_store_n(&s->game_id, g->id, __ATOMIC_RELEASE);
+    checkpointer_adopt(w, g, slot);
+}
+
+void checkpointer_save(Checkpointer *w, const GameSession *g, uint32_t turn_ms) {
+    long i = find_slot(w, g->id);
+    if (i < 0) return;
+    CheckpointSlot *s = &w->ck->slots[(uint32_t)w->slots[i]];
+    const CheckpointState *prev = latest_state(s);
+    uint32_t gen = prev ? prev->gen + 1 : 1;
+    // 최신 사본은 건드리지 않고 다른 쪽에 쓴다. check를 마지막에 써서 중간에 죽으면 이 사본은 버려진다
+    CheckpointState *st = &s->state[gen & 1];
+    CheckpointState next;
+    memset(&next, 0, sizeof next);
+    next.red = g->red;
+    next.blue = g->blue;
+    next.blocked = g->blocked;
+    next.gen = gen;
+    next.deadline_ms = turn_ms ? wall_ms() + turn_ms : 0;
+    next.seq = (uint16_t)g->seq;
+    next.turn = (uint8_t)g->turn;
+    next.pass_count = (uint8_t)g->pass_count;
+    uint32_t check = state_check(&next);
+    __atomic_store_n(&st->check, 0u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(st, &next, offsetof(CheckpointState, check));
+    __atomic_store_n(&st->check, check, __ATOMIC_RELEASE);
+}
+
+void checkpointer_finish(Checkpointer *w, const GameSession *g) {
+    long i = find_slot(w, g->id);
+    if (i < 0) return;
+    uint32_t slot = (uint32_t)w->slots[i];
+    remove_slot(w, (size_t)i);
+    checkpoint_discard(w->ck, slot);
+}
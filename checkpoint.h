@@ -0,0 +1,109 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "session.h"
+#include "registry.h"
+
+/*
+ * 진행 중인 게임을 mmap한 파일에 턴마다 남겨 두는 체크포인트 (--checkpoint <path>).
+ * 서버가 죽거나 다시 배포돼도 새 프로세스가 파일을 읽어 세션을 되살리고,
+ * 플레이어가 같은 이름과 resume token으로 register하면 그 자리에 다시 앉는다.
+ *
+ *   파일: [CheckpointHeader 64B] [CheckpointSlot 192B x capacity]
+ *   슬롯: 게임 하나. 이름은 시작할 때 한 번, 보드/차례는 턴마다 state[0], state[1]에 번갈아 쓴다
+ *
+ * 쓰기는 파일을 MAP_SHARED로 매핑한 메모리에 하는 것이 전부라서 write나 fsync 없이
+ * 프로세스가 죽어도 페이지 캐시에 남는다 (기계가 꺼지는 경우까지는 다루지 않는다).
+ * 턴 사본마다 gen과 check(해시)를 두어, 쓰다가 죽은 사본은 버리고 그 전 턴 사본을 쓴다.
+ * 턴 시간은 끝나는 시각(벽시계)으로 남겨서, 되살릴 때 남은 시간만 준다 (멈춰 있던 시간도 지나간다).
+ * 슬롯은 게임이 시작할 때 전역 free list에서 한 번 받고 (락 한 번), 턴마다 쓰는 것은
+ * 게임을 맡은 shard 스레드뿐이라 락이 없다.
+ */
+#define CHECKPOINT_MAGIC          "HW3CKPT1"
+#define CHECKPOINT_SLOTS          65536       // 동시에 남길 수 있는 게임 수 (파일은 sparse로 잡힌다)
+#define CHECKPOINT_RESTORE_MS     30000       // 되살린 게임의 첫 턴에 더 주는 시간 (다시 접속할 시간)
+
+typedef struct {
+    char magic[8];             // CHECKPOINT_MAGIC
+    uint32_t version;          // 2 (1은 턴 시간을 남은 ms로 남겼다)
+    uint32_t slot_size;        // sizeof(CheckpointSlot)
+    uint32_t capacity;
+    uint8_t reserved[44];
+} CheckpointHeader;
+
+// 한 턴의 상태
+typedef struct {
+    uint64_t red, blue, blocked;
+    uint64_t deadline_ms;      // 턴이 끝나는 시각 (UNIX epoch ms, 0이면 타이머 없이 바로 둘 수가 있었음)
+    uint32_t gen;              // 이 슬롯에서 몇 번째로 쓴 사본인지 (1부터, 큰 쪽이 최신)
+    uint16_t seq;
+    uint8_t turn;
+    uint8_t pass_count;
+    uint32_t check;            // 위 필드의 해시, 마지막에 쓴다
+    uint32_t reserved;
+} CheckpointState;
+
+typedef struct {
+    uint32_t game_id;          // 0이면 빈 슬롯
+    uint32_t reserved0;
+    char name[2][REGISTRY_NAME_MAX];   // Red, Blue
+    CheckpointState state[2];
+    uint64_t token[2];         // 자리마다 다시 앉을 때 확인하는 resume token
+    uint8_t reserved[8];
+} CheckpointSlot;
+
+/* ---- 파일 (프로세스에 하나) ---- */
+typedef struct Checkpoint {
+    int fd;
+    CheckpointHeader *hdr;
+    CheckpointSlot *slots;
+    size_t map_len;
+    pthread_mutex_t lock;      // free list
+    uint32_t *free_list;
+    uint32_t free_count;
+} Checkpoint;
+
+// 되살릴 게임 하나
+typedef struct {
+    uint32_t slot;
+    uint32_t game_id;
+    const char *name[2];
+    uint64_t token[2];
+    GameSession board;         // red/blue/blocked, turn, pass_count, seq만 채워진다
+    int timed;                 // 턴 타이머가 걸려 있었는지 (premove를 두려던 턴이면 0)
+    uint32_t turn_ms;          // timed일 때 남은 턴 시간 (이미 지났으면 0)
+} CheckpointGame;
+
+// 파일을 열고(없으면 만든다) 남아 있던 게임들의 슬롯은 쓰는 중으로 둔다. 실패하면 NULL
+Checkpoint *checkpoint_open(const char *path);
+void checkpoint_close(Checkpoint *ck);
+// 남아 있던 게임마다 fn을 부른다 (checkpoint_open 직후, shard 스레드를 띄우기 전에).
+// 온전한 턴 사본이 하나도 없는 슬롯은 비운다. 되살린 게임 수를 돌려준다
+int checkpoint_restore(Checkpoint *ck, void (*fn)(const CheckpointGame *game, void *arg), void *arg);
+// fn이 되살리지 못한 게임의 슬롯을 돌려준다
+void checkpoint_discard(Checkpoint *ck, uint32_t slot);
+
+/* ---- 게임 스레드 쪽 (shard마다 하나, 그 스레드에서만 쓴다) ---- */
+typedef struct Checkpointer {
+    Checkpoint *ck;            // NULL이면 아무것도 하지 않는다
+    uint64_t *slots;           // game id → 슬롯 (id << 32 | 슬롯 번호), open addressing
+    size_t mask, count;
+} Checkpointer;
+
+void checkpointer_init(Checkpointer *w, Checkpoint *ck);
+// 진행 중이던 게임의 슬롯은 그대로 둔다 (다음에 띄울 때 되살린다)
+void checkpointer_close(Checkpointer *w);
+// 새 게임: 슬롯을 받아 이름과 resume token을 남긴다. 슬롯이 다 찼으면 그 게임은 남기지 않는다
+void checkpointer_start(Checkpointer *w, const GameSession *g, const char *red, const char *blue,
+                        const uint64_t token[2]);
+// checkpoint_restore로 되살린 게임을 이 shard가 이어서 쓴다
+void checkpointer_adopt(Checkpointer *w, const GameSession *g, uint32_t slot);
+// 턴이 바뀔 때마다: turn_ms 뒤에 턴이 끝난다 (0이면 타이머 없음)
+void checkpointer_save(Checkpointer *w, const GameSession *g, uint32_t turn_ms);
+// 게임이 끝났다: 슬롯을 비우고 돌려준다
+void checkpointer_finish(Checkpointer *w, const GameSession *g);
+
+#endif
@@ -0,0 +1,183 @@
+#include "../include/checkpoint.h"
+#include "../include/test.h"
+#include "../include/test_game.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * checkpoint.c: 게임을 두면서 턴마다 남기고, 일부는 끝내고, 나머지는 그대로 둔 채 파일을 닫았다가
+ * 다시 열어 되살린 게임이 마지막으로 남긴 턴(보드, 차례, pass, seq)과 이름, token까지
+ * 같고 턴 시간은 남긴 뒤 지난 만큼 줄어 있는지 본다 (이미 지난 턴은 0, 타이머가 없던 턴은 timed가 0). 끝난 게임과 턴을 한 번도 남기지 않은 게임은 되살아나지 않고 슬롯이 돌아와야 하며,
+ * 쓰다 만 최신 사본은 버리고 그 전 턴 사본으로 되살아나야 한다.
+ */
+#define GAMES 100
+
+typedef struct {
+    TestGame t;
+    uint64_t token[2];
+    uint32_t turn_ms;
+    uint64_t saved_ms;             // 마지막으로 남긴 시각
+    GameSession saved, before;     // 마지막으로 남긴 턴, 그 전 턴
+    int saves;
+    int finished;
+    int torn;                      // 최신 사본을 망가뜨렸으면 1 (before로 되살아나야 한다)
+    int restored;
+} Expected;
+
+static Expected games[GAMES + 2];  // game id = 번호 (1부터), GAMES + 1은 턴을 남기지 않는 게임
+
+static uint64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void start_game(Checkpointer *w, uint32_t id) {
+    Expected *e = &games[id];
+    test_game_start(&e->t, id);
+    e->token[0] = (uint64_t)id << 32 | 0xAAAA;
+    e->token[1] = (uint64_t)id << 32 | 0xBBBB;
+    checkpointer_start(w, &e->t.g, e->t.name[0], e->t.name[1], e->token);
+}
+
+static void play_turn(Checkpointer *w, uint32_t id) {
+    Expected *e = &games[id];
+    GameSession *g = &e->t.g;
+    test_random_step(g, NULL);
+    // 타이머 없는 턴, 되살리기 전에 지나는 턴, 시간이 남는 턴
+    int kind = rand() % 8;
+    e->turn_ms = kind == 0 ? 0 : kind == 1 ? 1 : 60000 + (uint32_t)(rand() % 5000);
+    e->before = e->saved;
+    e->saved = *g;
+    e->saves++;
+    e->saved_ms = wall_ms();
+    checkpointer_save(w, g, e->turn_ms);
+}
+
+static uint32_t slot_of_game(const Checkpoint *ck, uint32_t id) {
+    for (uint32_t i = 0; i < ck->hdr->capacity; i++) {
+        if (ck->slots[i].game_id == id) return i;
+    }
+    return UINT32_MAX;
+}
+
+static void same_turn(const CheckpointGame *game, const GameSession *g) {
+    CHECK(game->board.red == g->red && game->board.blue == g->blue && game->board.blocked == g->blocked);
+    CHECK(game->board.turn == g->turn);
+    CHECK(game->board.pass_count == g->pass_count);
+    CHECK(game->board.seq == g->seq);
+}
+
+static void on_restore(const CheckpointGame *game, void *arg) {
+    Checkpointer *w = (Checkpointer *)arg;
+    CHECK(game->game_id >= 1 && game->game_id <= GAMES);
+    if (game->game_id < 1 || game->game_id > GAMES) return;
+    Expected *e = &games[game->game_id];
+    CHECK(!e->finished && !e->restored);
+    e->restored = 1;
+    CHECK(strcmp(game->name[0], e->t.name[0]) == 0 && strcmp(game->name[1], e->t.name[1]) == 0);
+    CHECK(game->token[0] == e->token[0] && game->token[1] == e->token[1]);
+    if (e->torn) {
+        same_turn(game, &e->before);
+    } else {
+        same_turn(game, &e->saved);
+        CHECK(game->timed == (e->turn_ms != 0));
+        uint64_t elapsed = wall_ms() - e->saved_ms;
+        if (e->turn_ms <= 1) CHECK(game->turn_ms == 0);
+        else CHECK(game->turn_ms <= e->turn_ms && game->turn_ms + elapsed + 1 >= e->turn_ms);
+    }
+    // 되살린 게임을 이어서 두고 끝낸다
+    e->t.g = game->board;
+    e->t.g.id = game->game_id;
+    checkpointer_adopt(w, &e->t.g, game->slot);
+    play_turn(w, game->game_id);
+    checkpointer_finish(w, &e->t.g);
+}
+
+int main(void) {
+    char path[] = "/tmp/checkpoint_testXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    srand(1);
+
+    Checkpoint *ck = checkpoint_open(path);
+    CHECK(ck != NULL);
+    if (!ck) return test_report("checkpoint_test");
+    uint32_t capacity = ck->hdr->capacity;
+    CHECK(ck->free_count == capacity);
+    Checkpointer w;
+    checkpointer_init(&w, ck);
+
+    for (uint32_t id = 1; id <= GAMES; id++) start_game(&w, id);
+    CHECK(ck->free_count == capacity - GAMES);
+    for (int turn = 0; turn < 40; turn++) {
+        for (uint32_t id = 1; id <= GAMES; id++) {
+            Expected *e = &games[id];
+            if (e->finished || (turn > 0 && rand() % 4 == 0)) continue;
+            play_turn(&w, id);
+            if (test_game_over(&e->t.g) || rand() % 50 == 0) {
+                checkpointer_finish(&w, &e->t.g);
+                e->finished = 1;
+            }
+        }
+    }
+    // 방금 돌려받은 슬롯을 다시 받는 새 게임: 예전 게임의 사본이 지워져서 되살아나지 않아야 한다
+    uint32_t victim = 1;
+    while (victim < GAMES && games[victim].finished) victim++;
+    uint32_t reused = slot_of_game(ck, victim);
+    CHECK(!games[victim].finished && games[victim].saves > 0);
+    checkpointer_finish(&w, &games[victim].t.g);
+    games[victim].finished = 1;
+    start_game(&w, GAMES + 1);
+    CHECK(ck->slots[reused].game_id == GAMES + 1);
+
+    // 살아 있는 게임 하나는 마지막 턴을 쓰다가 죽은 것으로 만든다
+    int live = 0;
+    for (uint32_t id = 1; id <= GAMES; id++) {
+        Expected *e = &games[id];
+        if (e->finished) continue;
+        if (live++ == 0) {
+            CheckpointSlot *s = &ck->slots[slot_of_game(ck, id)];
+            int newest = s->state[1].gen > s->state[0].gen;
+            s->state[newest].check ^= 2;
+            CHECK(e->saves >= 2);
+            e->torn = 1;
+        }
+    }
+    CHECK(live > 0 && live < GAMES);
+    checkpointer_close(&w);
+    checkpoint_close(ck);
+    usleep(10000);                     // 1ms 턴은 되살릴 때 이미 지났다
+
+    // 다시 띄운 서버: 살아 있던 게임만 되살아난다
+    ck = checkpoint_open(path);
+    CHECK(ck != NULL);
+    if (!ck) return test_report("checkpoint_test");
+    CHECK(ck->free_count == capacity - (uint32_t)live - 1);
+    checkpointer_init(&w, ck);
+    CHECK(checkpoint_restore(ck, on_restore, &w) == live);
+    for (uint32_t id = 1; id <= GAMES; id++) CHECK(games[id].restored == !games[id].finished);
+    CHECK(ck->slots[reused].game_id == 0);
+    CHECK(ck->free_count == capacity);
+    checkpointer_close(&w);
+    checkpoint_close(ck);
+
+    // 모두 끝났으니 남은 게임이 없다
+    ck = checkpoint_open(path);
+    CHECK(ck != NULL);
+    if (ck) {
+        CHECK(ck->free_count == capacity);
+        CHECK(checkpoint_restore(ck, on_restore, NULL) == 0);
+        checkpoint_close(ck);
+    }
+
+    unlink(path);
+    return test_report("checkpoint_test");
+}
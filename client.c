@@ -2,6 +2,13 @@
 #include "../include/game.h"
 #include "../libs/cJSON.h"
 #include "../include/json.h"
+#include "../include/arena.h"
+#include "../include/session.h"
+#include "../include/delta.h"
+#include "../include/wire.h"
+#include "../include/shm.h"
+#include "../include/posdb.h"
+#include "../include/trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,10 +16,25 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <errno.h>
 
 #define SIMULATION_TIME 3.0
+#define CLIENT_RECONNECT_TRIES 5   // 게임 중 끊겼을 때 다시 접속해 볼 횟수 (0.2s부터 두 배씩 쉰다)
+#define CLIENT_SHM_SPIN_US 50   // 링에서 서버 응답을 기다리며 돌 시간 (코어가 하나면 돌지 않는다)
+#define CLIENT_THINK_MS 2000    // 수를 두기 전에 쉬는 기본 시간 (LED로 진행을 볼 수 있게)
+
+static const char *unix_path;   // -U: TCP 대신 이 unix 소켓으로 접속
+static int use_shm;             // -m: 접속 후 입출력을 공유 메모리 링으로 옮긴다
+static int use_combined;        // -c: 결과 메시지가 your_turn을 겸하도록 요청 (JSON)
+static int use_premove;         // -P: 상대 차례 동안 상대 수를 예상해 premove를 보낸다 (JSON)
+static ShmLink *shm_link;
+static PosDb pos_db;            // -D: 열려 있으면 (hdr != NULL) 수를 고를 때 먼저 찾아본다
+static int think_ms = CLIENT_THINK_MS;   // --think
 
 int count_flips(char board[BOARD_SIZE][BOARD_SIZE], int r, int c, char player_color) {
     int flip_count = 0;
@@ -35,11 +57,24 @@ int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color, int *ou
 static int connect_to_server(const char *ip, const char *port);
 int client_run(const char *ip, const char *port, const char *username);
 
-int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color,
-                  int *out_r1, int *out_c1, int *out_r2, int *out_c2) {
-                    sleep(2);
+// generate_move의 탐색 부분. -P에서 상대의 다음 수를 예상할 때는 생각하는 시간 없이 이것만 쓴다
+static int pick_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color,
+                     int *out_r1, int *out_c1, int *out_r2, int *out_c2) {
     int best_score = -1;
 
+    // 탐색한 best 수이거나 실제로 이긴 게임에서 나온 수만 믿는다
+    if (pos_db.hdr) {
+        GameSession g;
+        uint16_t mv;
+        int color = player_color == 'B';
+        session_from_board(&g, board);
+        const PosDbEntry *e = posdb_lookup(&pos_db, &g, color, &mv);
+        if (e && mv != POSDB_NO_MOVE && (e->best_depth > 0 || e->best_score > 0)) {
+            wire_move_coords(mv, out_r1, out_c1, out_r2, out_c2);
+            if (session_is_valid_move(&g, color, *out_r1, *out_c1, *out_r2, *out_c2)) return 1;
+        }
+    }
+
     for (int r = 0; r < BOARD_SIZE; ++r) {
         for (int c = 0; c < BOARD_SIZE; ++c) {
             if (board[r][c] != player_color) continue;
@@ -82,6 +117,15 @@ int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color,
     return 1;
 }
 
+int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color,
+                  int *out_r1, int *out_c1, int *out_r2, int *out_c2) {
+    uint64_t t0 = trace_begin();
+    if (think_ms > 0) usleep((useconds_t)think_ms * 1000);
+    int ret = pick_move(board, player_color, out_r1, out_c1, out_r2, out_c2);
+    trace_end("generate_move", t0);
+    return ret;
+}
+
 /*
 
 int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color, int *out_r1, int *out_c1, int *out_r2, int *out_c2) {
@@ -117,7 +161,39 @@ int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color, int *ou
 }
     
 */
+void client_set_transport(const char *path, int shm) {
+    unix_path = path;
+    use_shm = shm;
+}
+void client_set_combined(int on) {
+    use_combined = on;
+}
+void client_set_premove(int on) {
+    use_premove = on;
+}
+void client_set_think_ms(int ms) {
+    think_ms = ms;
+}
+int client_set_posdb(const char *path) {
+    return posdb_open(&pos_db, path, 0);
+}
+static int connect_unix(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof addr.sun_path) return -1;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    int sockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sockfd < 0) return -1;
+    if (connect(sockfd, (struct sockaddr *)&addr, sizeof addr) < 0) {
+        perror("connect");
+        close(sockfd);
+        return -1;
+    }
+    return sockfd;
+}
 static int connect_to_server(const char *ip, const char *port) {
+    if (unix_path) return connect_unix(unix_path);
     struct addrinfo hints, *res, *p;
     int sockfd;
     memset(&hints, 0, sizeof hints);
@@ -138,48 +214,188 @@ static int connect_to_server(const char *ip, const char *port) {
         fprintf(stderr, "Failed to connect to %s:%s\n", ip, port);
         return -1;
     }
+    // premove 뒤에 바로 move를 보내는 것처럼 답 없는 작은 쓰기가 이어져도 Nagle에 묶이지 않게
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
     return sockfd;
 }
 
+/* ---- delta 모드: 서버가 보내는 변경분을 쌓아서 보드를 직접 들고 있는다 (적용과 해시 확인은 delta.c) ---- */
+static void read_board(const cJSON *jbarr, char board[BOARD_SIZE][BOARD_SIZE]) {
+    int nrows = cJSON_GetArraySize(jbarr);
+    for (int i = 0; i < nrows && i < BOARD_SIZE; i++) {
+        const cJSON *jrow = cJSON_GetArrayItem(jbarr, i);
+        if (jrow && jrow->valuestring) memcpy(board[i], jrow->valuestring, BOARD_SIZE);
+    }
+}
+// 수 하나를 판에 둔다 (서버의 session_move와 같은 규칙: 복제/점프 후 주변 상대 말을 뒤집음). 좌표는 0부터
+static void play_on(char board[BOARD_SIZE][BOARD_SIZE], int r1, int c1, int r2, int c2) {
+    char me = board[r1][c1];
+    char opp = me == 'R' ? 'B' : 'R';
+    board[r2][c2] = me;
+    if (abs(r1 - r2) == 2 || abs(c1 - c2) == 2) board[r1][c1] = '.';
+    for (int d = 0; d < 8; d++) {
+        int r = r2 + directions[d][0], c = c2 + directions[d][1];
+        if (r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE && board[r][c] == opp) board[r][c] = me;
+    }
+}
+// -P: 내 수를 둔 뒤의 판(seq)에서 상대가 둘 수를 같은 휴리스틱으로 예상하고,
+// 상대가 정말 그 수를 두면 서버가 왕복 없이 바로 둘 내 수를 보낸다
+static int send_premove(int sockfd, char board[BOARD_SIZE][BOARD_SIZE], char my_color, int seq) {
+    char next[BOARD_SIZE][BOARD_SIZE];
+    int o[4], m[4], cond[4], mv[4];
+    memcpy(next, board, sizeof next);
+    int opp_moves = pick_move(next, my_color == 'R' ? 'B' : 'R', &o[0], &o[1], &o[2], &o[3]);
+    if (opp_moves) play_on(next, o[0], o[1], o[2], o[3]);
+    int has_move = pick_move(next, my_color, &m[0], &m[1], &m[2], &m[3]);
+    for (int i = 0; i < 4; i++) {
+        cond[i] = opp_moves ? o[i] + 1 : 0;     // 모두 0이면 상대가 pass
+        mv[i] = has_move ? m[i] + 1 : 0;
+    }
+    cJSON *pm = cJSON_CreateObject();
+    cJSON_AddStringToObject(pm, "type", "premove");
+    cJSON_AddNumberToObject(pm, "seq", seq);
+    cJSON_AddNumberToObject(pm, "sx", mv[0]);
+    cJSON_AddNumberToObject(pm, "sy", mv[1]);
+    cJSON_AddNumberToObject(pm, "tx", mv[2]);
+    cJSON_AddNumberToObject(pm, "ty", mv[3]);
+    cJSON_AddItemToObject(pm, "if", cJSON_CreateIntArray(cond, 4));
+    int rc = send_json(sockfd, pm);
+    cJSON_Delete(pm);
+    return rc;
+}
+
 int client_run(const char *ip, const char *port, const char *username) {
+    return client_run_delta(ip, port, username, 0);
+}
+
+/* register 요청. resume_token이 있으면 끊기기 전에 앉아 있던 게임으로 돌아간다 */
+static int send_register(int sockfd, const char *username, int delta, const char *resume_token) {
+    cJSON *reg = cJSON_CreateObject();
+    cJSON_AddStringToObject(reg, "type", "register");
+    cJSON_AddStringToObject(reg, "username", username);
+    if (delta) cJSON_AddTrueToObject(reg, "delta");
+    if (use_combined) cJSON_AddTrueToObject(reg, "combined");
+    if (resume_token && resume_token[0]) cJSON_AddStringToObject(reg, "resume_token", resume_token);
+    int rc = send_json(sockfd, reg);
+    cJSON_Delete(reg);
+    return rc;
+}
+
+/* 게임 중에 연결이 끊겼을 때: 잠깐씩 쉬면서 다시 접속해 resume_token으로 register한다 */
+static int reconnect_game(const char *ip, const char *port, const char *username, int delta, const char *resume_token) {
+    for (int attempt = 0; attempt < CLIENT_RECONNECT_TRIES; attempt++) {
+        usleep((useconds_t)(200000u << attempt));   // 0.2s, 0.4s, ...
+        int sockfd = connect_to_server(ip, port);
+        if (sockfd < 0) continue;
+        if (send_register(sockfd, username, delta, resume_token) == 0) return sockfd;
+        close(sockfd);
+    }
+    return -1;
+}
+
+int client_run_delta(const char *ip, const char *port, const char *username, int delta) {
     int sockfd = connect_to_server(ip, port);
     if (sockfd < 0) {
         fprintf(stderr, "Failed to connect to %s:%s\n", ip, port);
         return EXIT_FAILURE;
     }
     /* 1) register request */
-    {
-        cJSON *reg = cJSON_CreateObject();
-        cJSON_AddStringToObject(reg, "type", "register");
-        cJSON_AddStringToObject(reg, "username", username);
-        if (send_json(sockfd, reg) < 0) {
-            fprintf(stderr, "Failed to send register message\n");
-            cJSON_Delete(reg);
-            close(sockfd);
-            return EXIT_FAILURE;
-        }
-        cJSON_Delete(reg);
+    if (send_register(sockfd, username, delta, NULL) < 0) {
+        fprintf(stderr, "Failed to send register message\n");
+        close(sockfd);
+        return EXIT_FAILURE;
     }
 
+    char resume_token[17] = "";           // register_ack로 받는다
+    int in_game = 0;
     int waiting_for_result = 0;
+    int combined = use_combined;
+    int seq = 0;                          // 보드 버전 (premove에 붙인다)
+    char state[BOARD_SIZE][BOARD_SIZE];   // delta 모드에서 쌓아가는 보드
+    int in_sync = 0;
+    memset(state, '.', sizeof state);
     /* 2) from server */
+    char my_color = 'B';
     while (1) {
-        char my_color;
-
+        /* 메시지 하나를 처리하는 동안의 cJSON 할당은 arena에서 */
+        arena_begin();
         cJSON *msg = recv_json(sockfd);
         if (!msg) {
-            /* server error */
-            break;
+            arena_end();
+            if (!in_game || !resume_token[0]) break;   /* server error */
+            // 게임 중에 끊겼다: 서버가 자리를 지키는 동안 다시 앉는다
+            close(sockfd);
+            printf("Connection lost, resuming game\n");
+            sockfd = reconnect_game(ip, port, username, delta, resume_token);
+            if (sockfd < 0) {
+                fprintf(stderr, "Failed to reconnect to %s:%s\n", ip, port);
+                return EXIT_FAILURE;
+            }
+            waiting_for_result = 0;
+            in_sync = 0;
+            continue;
         }
         cJSON *jtype = cJSON_GetObjectItem(msg, "type");
         if (!jtype || !jtype->valuestring) {
             cJSON_Delete(msg);
+            arena_end();
             continue;
         }
+        /* 2-4) move_ok, invalid_move, pass */
+        int turn = strcmp(jtype->valuestring, "your_turn") == 0;
+        if (strcmp(jtype->valuestring, "move_ok") == 0 ||
+            strcmp(jtype->valuestring, "invalid_move") == 0 ||
+            strcmp(jtype->valuestring, "pass") == 0)
+        {
+            // premove로 둔 내 수의 결과는 your_turn 없이 온다
+            const cJSON *jpre = cJSON_GetObjectItem(msg, "premove");
+            int mine = waiting_for_result
+                       || (cJSON_IsString(jpre) && strcmp(jpre->valuestring, username) == 0);
+            int move_ok = strcmp(jtype->valuestring, "move_ok") == 0;
+            if (mine) {
+                printf("Move result: %s%s\n", jtype->valuestring, waiting_for_result ? "" : " (premove)");
+                printf("Next player's turn\n");
+                waiting_for_result = 0;
+            }
+            if (strcmp(jtype->valuestring, "invalid_move") != 0) {
+                const cJSON *jseq = cJSON_GetObjectItem(msg, "seq");
+                seq = cJSON_IsNumber(jseq) ? jseq->valueint : seq + 1;
+            }
+            if (delta && move_ok) {
+                if (!delta_apply(state, msg) || !delta_in_sync(state, msg)) in_sync = 0;
+            }
+            // combined: 내 차례를 여는 결과에는 timeout이 붙어 오고, 그대로 your_turn으로 처리한다
+            turn = combined && cJSON_GetObjectItem(msg, "timeout") != NULL;
+            if (use_premove && mine && move_ok && !turn) {
+                cJSON *jboard = cJSON_GetObjectItem(msg, "board");
+                char after[BOARD_SIZE][BOARD_SIZE];
+                int known = 1;
+                if (cJSON_IsArray(jboard)) read_board(jboard, after);
+                else if (delta && in_sync) memcpy(after, state, sizeof after);
+                else known = 0;
+                if (known && send_premove(sockfd, after, my_color, seq) < 0) {
+                    cJSON_Delete(msg);
+                    arena_end();
+                    break;
+                }
+            }
+            if (!turn) {
+                cJSON_Delete(msg);
+                arena_end();
+                continue;
+            }
+        }
         /* 2-1) register_ack */
         if (strcmp(jtype->valuestring, "register_ack") == 0) {
             printf("Registered: %s\n", username);
+            // 서버가 delta를 모르면 (ack에 표시가 없으면) 보드 전체를 받는 기존 방식 그대로
+            if (delta && !cJSON_IsTrue(cJSON_GetObjectItem(msg, "delta"))) delta = 0;
+            if (combined && !cJSON_IsTrue(cJSON_GetObjectItem(msg, "combined"))) combined = 0;
+            const cJSON *jtoken = cJSON_GetObjectItem(msg, "resume_token");
+            if (cJSON_IsString(jtoken)) snprintf(resume_token, sizeof resume_token, "%s", jtoken->valuestring);
             cJSON_Delete(msg);
+            arena_end();
             continue;
         }
         /* 2-2) register_nack */
@@ -191,11 +407,14 @@ int client_run(const char *ip, const char *port, const char *username) {
                 printf("Register failed (unknown reason)\n");
             }
             cJSON_Delete(msg);
+            arena_end();
             break; 
         }
         /* 2-3) game_start */
         else if (strcmp(jtype->valuestring, "game_start") == 0) {
-            printf("Game started\n");
+            int resumed = cJSON_IsTrue(cJSON_GetObjectItem(msg, "resumed"));
+            printf(resumed ? "Game resumed\n" : "Game started\n");
+            in_game = 1;
             cJSON *jplayers = cJSON_GetObjectItem(msg, "players");
             if (jplayers && cJSON_IsArray(jplayers)) {
                 const cJSON *p0 = cJSON_GetArrayItem(jplayers, 0);
@@ -206,11 +425,19 @@ int client_run(const char *ip, const char *port, const char *username) {
                     my_color = 'B';
                 }
             }
+            cJSON *jboard = cJSON_GetObjectItem(msg, "board");
+            if (delta && cJSON_IsArray(jboard)) {
+                read_board(jboard, state);
+                in_sync = 1;
+            }
+            const cJSON *jseq = cJSON_GetObjectItem(msg, "seq");
+            seq = cJSON_IsNumber(jseq) ? jseq->valueint : 0;
             cJSON_Delete(msg);
+            arena_end();
             continue;
         }
         /* 2-3) your_turn */
-        else if (strcmp(jtype->valuestring, "your_turn") == 0) {
+        else if (turn) {
             /* 2-3-1) board */
             cJSON *jbarr = cJSON_GetObjectItem(msg, "board");
             if (jbarr && cJSON_IsArray(jbarr)) {
@@ -241,6 +468,19 @@ int client_run(const char *ip, const char *port, const char *username) {
                         memcpy(board[i], jrow->valuestring, BOARD_SIZE);
                     }
                 }
+            } else if (delta) {
+                // 보드 대신 해시가 왔다: 들고 있는 보드가 어긋났으면 전체 보드를 다시 받는다
+                if (!in_sync || !delta_in_sync(state, msg)) {
+                    cJSON *sync = cJSON_CreateObject();
+                    cJSON_AddStringToObject(sync, "type", "sync");
+                    int rc = send_json(sockfd, sync);
+                    cJSON_Delete(sync);
+                    cJSON_Delete(msg);
+                    arena_end();
+                    if (rc < 0) break;
+                    continue;
+                }
+                memcpy(board, state, sizeof board);
             }
             /* 2-3-4) generate_move */
             printf("Your turn\n");
@@ -268,25 +508,25 @@ int client_run(const char *ip, const char *port, const char *username) {
                 fprintf(stderr, "Failed to send move/pass message\n");
                 cJSON_Delete(mv);
                 cJSON_Delete(msg);
+                arena_end();
                 break;
             }
             waiting_for_result = 1;
             cJSON_Delete(mv);
             cJSON_Delete(msg);
+            arena_end();
             continue;
         }
 
-        /* 2-4) move_ok, invalid_move, pass */
-        else if (strcmp(jtype->valuestring, "move_ok") == 0 ||
-                 strcmp(jtype->valuestring, "invalid_move") == 0 ||
-                 strcmp(jtype->valuestring, "pass") == 0)
-        {
-            if (waiting_for_result) {
-                printf("Move result: %s\n", jtype->valuestring);
-                printf("Next player's turn\n");
-                waiting_for_result = 0;
+        /* 2-5) board: sync 요청에 대한 전체 보드 (delta 모드) */
+        else if (strcmp(jtype->valuestring, "board") == 0) {
+            cJSON *jboard = cJSON_GetObjectItem(msg, "board");
+            if (cJSON_IsArray(jboard)) {
+                read_board(jboard, state);
+                in_sync = 1;
             }
             cJSON_Delete(msg);
+            arena_end();
             continue;
         }
         else if (strcmp(jtype->valuestring, "game_over") == 0) {
@@ -323,10 +563,171 @@ int client_run(const char *ip, const char *port, const char *username) {
                 }
             }
             cJSON_Delete(msg);
+            arena_end();
             break;
         }
         cJSON_Delete(msg);
+        arena_end();
+    }
+    close(sockfd);
+    return EXIT_SUCCESS;
+}
+
+/* ---- 바이너리 프로토콜 (--binary): 첫 바이트 WIRE_MAGIC 뒤로 길이 접두 프레임을 주고받는다 ---- */
+// -m: 소켓 대신 링으로. 링이 가득 차거나 비면 서버가 깨워줄 때까지 기다린다
+static int shm_send_all(const void *buf, size_t len) {
+    struct iovec iov;
+    iov.iov_base = (void *)buf;
+    iov.iov_len = len;
+    while (iov.iov_len > 0) {
+        size_t n = shm_writev(shm_link, &iov, 1);
+        iov.iov_base = (char *)iov.iov_base + n;
+        iov.iov_len -= n;
+        if (iov.iov_len > 0 && shm_wait(shm_link, 1) < 0) return -1;
+    }
+    return 0;
+}
+static int shm_recv_all(void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = shm_read(shm_link, p, len);
+        if (n < 0) return -1;
+        if (n == 0) {
+            if (shm_wait(shm_link, 0) < 0) return -1;
+            continue;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+static int send_all(int sockfd, const void *buf, size_t len) {
+    if (shm_link) return shm_send_all(buf, len);
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t n = send(sockfd, p, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+static int recv_all(int sockfd, void *buf, size_t len) {
+    if (shm_link) return shm_recv_all(buf, len);
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = recv(sockfd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+// 프레임 하나를 읽어서 m에 푼다. 연결이 끊기거나 형식이 틀리면 -1
+static int recv_wire(int sockfd, WireMsg *m) {
+    uint8_t hdr[2], body[WIRE_FRAME_MAX];
+    if (recv_all(sockfd, hdr, sizeof hdr) < 0) return -1;
+    size_t len = (size_t)((hdr[0] << 8) | hdr[1]);
+    if (len > sizeof body || recv_all(sockfd, body, len) < 0) return -1;
+    return wire_decode(body, len, m);
+}
+static int send_wire(int sockfd, const WireMsg *m) {
+    uint8_t buf[WIRE_FRAME_MAX];
+    size_t len = wire_encode(buf, sizeof buf, m);
+    return len ? send_all(sockfd, buf, len) : -1;
+}
+static void print_board(const char *title, char board[BOARD_SIZE][BOARD_SIZE]) {
+    printf("%s\n", title);
+    for (int i = 0; i < BOARD_SIZE; i++) printf("%.*s\n", BOARD_SIZE, board[i]);
+}
+
+int client_run_binary(const char *ip, const char *port, const char *username) {
+    int sockfd = connect_to_server(ip, port);
+    if (sockfd < 0) {
+        fprintf(stderr, "Failed to connect to %s:%s\n", ip, port);
+        return EXIT_FAILURE;
+    }
+    /* 0) -m: 링을 만들어 넘기고, 이후 바이트는 모두 링으로 (소켓은 끊김 감지용) */
+    ShmLink link;
+    if (use_shm) {
+        int spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? CLIENT_SHM_SPIN_US : 0;
+        if (shm_link_connect(&link, sockfd, spin) < 0) {
+            fprintf(stderr, "Failed to set up shared memory ring\n");
+            close(sockfd);
+            return EXIT_FAILURE;
+        }
+        shm_link = &link;
+    }
+    /* 1) 프로토콜 선택 + register */
+    WireMsg m;
+    uint8_t magic = WIRE_MAGIC;
+    wire_msg_init(&m, WIRE_REGISTER);
+    strncpy(m.name[0], username, WIRE_NAME_MAX - 1);
+    if (send_all(sockfd, &magic, 1) < 0 || send_wire(sockfd, &m) < 0) {
+        fprintf(stderr, "Failed to send register message\n");
+        if (shm_link) shm_link_close(shm_link);
+        shm_link = NULL;
+        close(sockfd);
+        return EXIT_FAILURE;
+    }
+
+    static const char *const results[] = { "move_ok", "invalid_move", "pass" };
+    static const char *const reasons[] = { "unknown reason", "invalid register", "username exists", "server busy" };
+    char players[MAX_CLIENTS][WIRE_NAME_MAX] = { "", "" };
+    char my_color = 'B';
+    int waiting_for_result = 0;
+    /* 2) from server */
+    while (recv_wire(sockfd, &m) == 0) {
+        char board[BOARD_SIZE][BOARD_SIZE];
+        if (m.type == WIRE_REGISTER_ACK) {
+            printf("Registered: %s\n", username);
+        }
+        else if (m.type == WIRE_REGISTER_NACK) {
+            printf("Register failed: %s\n", reasons[m.reason < 4 ? m.reason : 0]);
+            break;
+        }
+        else if (m.type == WIRE_GAME_START) {
+            printf("Game started\n");
+            memcpy(players, m.name, sizeof players);
+            my_color = strcmp(username, players[0]) == 0 ? 'R' : 'B';
+        }
+        else if (m.type == WIRE_YOUR_TURN) {
+            wire_unpack_board(m.board, board);
+            print_board("Current board:", board);
+            printf("Timeout: %.1f s\n", (double)m.timeout);
+            printf("Your turn\n");
+            int r1, c1, r2, c2;
+            int has_move = generate_move(board, my_color, &r1, &c1, &r2, &c2);
+            wire_msg_init(&m, WIRE_MOVE);
+            m.move = has_move ? wire_move(r1, c1, r2, c2) : WIRE_MOVE_PASS;
+            if (send_wire(sockfd, &m) < 0) {
+                fprintf(stderr, "Failed to send move/pass message\n");
+                break;
+            }
+            waiting_for_result = 1;
+        }
+        else if (m.type == WIRE_MOVE_OK || m.type == WIRE_INVALID_MOVE || m.type == WIRE_PASS) {
+            if (waiting_for_result) {
+                printf("Move result: %s\n", results[m.type - WIRE_MOVE_OK]);
+                printf("Next player's turn\n");
+                waiting_for_result = 0;
+            }
+        }
+        else if (m.type == WIRE_GAME_OVER) {
+            printf("Game Over\n");
+            wire_unpack_board(m.board, board);
+            print_board("Final board:", board);
+            printf("Final scores:\n");
+            for (int i = 0; i < MAX_CLIENTS; i++) printf("  %s: %d\n", players[i], m.score[i]);
+            break;
+        }
     }
+    if (shm_link) shm_link_close(shm_link);
+    shm_link = NULL;
     close(sockfd);
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -6,5 +6,19 @@
 int generate_move(char board[BOARD_SIZE][BOARD_SIZE], char player_color, int *out_r1, int *out_c1, int *out_r2, int *out_c2);
 static int connect_to_server(const char *ip, const char *port);
 int client_run(const char *ip, const char *port, const char *username);
+// delta가 1이면 register에서 delta 업데이트를 요청하고 보드를 직접 쌓아간다
+int client_run_delta(const char *ip, const char *port, const char *username, int delta);
+// JSON 대신 바이너리 프레임으로 접속한다 (wire.h)
+int client_run_binary(const char *ip, const char *port, const char *username);
+// path가 있으면 TCP 대신 unix 소켓으로 접속. shm이면 바이너리 클라이언트가 공유 메모리 링을 쓴다 (shm.h)
+void client_set_transport(const char *path, int shm);
+// on이면 register에서 combined를 요청한다: 내 차례를 여는 move_ok/invalid_move/pass가 your_turn을 겸한다
+void client_set_combined(int on);
+// on이면 내 수를 둔 뒤 상대 수를 예상해 조건부 premove를 보낸다 (JSON)
+void client_set_premove(int on);
+// 위치 DB(posdb.h)를 읽기 전용으로 연다. 이후 수를 고를 때 DB에 있는 국면이면 그 best 수를 쓴다
+int client_set_posdb(const char *path);
+// generate_move가 수를 고르기 전에 쉬는 시간 (기본 CLIENT_THINK_MS, 0이면 바로 둔다)
+void client_set_think_ms(int ms);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "../include/delta.h"
+
+#include <stdlib.h>
+
+cJSON *delta_msg(const GameSession *g, const char *type) {
+    cJSON *d = cJSON_CreateObject();
+    cJSON_AddStringToObject(d, "type", type);
+    cJSON_AddNumberToObject(d, "seq", g->seq);
+    return d;
+}
+
+// 가끔 해시를 붙여 관전자도 어긋남을 알 수 있게 한다
+cJSON *delta_update(const GameSession *g, const char *type, const char *next_player) {
+    cJSON *d = delta_msg(g, type);
+    cJSON_AddStringToObject(d, "next_player", next_player);
+    if (g->seq % DELTA_HASH_INTERVAL == 0) cJSON_AddNumberToObject(d, "hash", session_hash(g));
+    return d;
+}
+
+void delta_add_move(cJSON *d, int r1, int c1, int r2, int c2, uint64_t flipped) {
+    int mv[4] = { r1 + 1, c1 + 1, r2 + 1, c2 + 1 };
+    cJSON_AddItemToObject(d, "move", cJSON_CreateIntArray(mv, 4));
+    cJSON *flips = cJSON_AddArrayToObject(d, "flipped");
+    while (flipped) {
+        int bit = __builtin_ctzll(flipped);
+        int sq[2] = { bit / BOARD_SIZE + 1, bit % BOARD_SIZE + 1 };
+        cJSON_AddItemToArray(flips, cJSON_CreateIntArray(sq, 2));
+        flipped &= flipped - 1;
+    }
+}
+
+uint32_t delta_board_hash(char board[BOARD_SIZE][BOARD_SIZE]) {
+    uint32_t h = BOARD_HASH_INIT;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) h = board_hash_step(h, board[r][c]);
+    }
+    return h;
+}
+
+// 배열의 i번째 좌표 (1부터)를 0부터로. 숫자가 아니거나 판 밖이면 -1
+static int delta_coord(const cJSON *arr, int i) {
+    const cJSON *j = cJSON_GetArrayItem(arr, i);
+    if (!cJSON_IsNumber(j) || j->valueint < 1 || j->valueint > BOARD_SIZE) return -1;
+    return j->valueint - 1;
+}
+
+int delta_apply(char board[BOARD_SIZE][BOARD_SIZE], const cJSON *msg) {
+    const cJSON *jmove = cJSON_GetObjectItem(msg, "move");
+    if (cJSON_GetArraySize(jmove) != 4) return 0;
+    int r1 = delta_coord(jmove, 0), c1 = delta_coord(jmove, 1);
+    int r2 = delta_coord(jmove, 2), c2 = delta_coord(jmove, 3);
+    if (r1 < 0 || c1 < 0 || r2 < 0 || c2 < 0) return 0;
+    char mover = board[r1][c1];
+    board[r2][c2] = mover;
+    if (abs(r1 - r2) == 2 || abs(c1 - c2) == 2) board[r1][c1] = '.';   // 점프
+    const cJSON *jflips = cJSON_GetObjectItem(msg, "flipped");
+    for (const cJSON *f = jflips ? jflips->child : NULL; f; f = f->next) {
+        int r = delta_coord(f, 0), c = delta_coord(f, 1);
+        if (r < 0 || c < 0) return 0;
+        board[r][c] = mover;
+    }
+    return 1;
+}
+
+int delta_in_sync(char board[BOARD_SIZE][BOARD_SIZE], const cJSON *msg) {
+    const cJSON *jhash = cJSON_GetObjectItem(msg, "hash");
+    return !cJSON_IsNumber(jhash) || (uint32_t)jhash->valuedouble == delta_board_hash(board);
+}
@@ -0,0 +1,31 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdint.h>
+#include "../libs/cJSON.h"
+#include "session.h"
+
+/*
+ * delta 모드 ("delta": true로 register한 플레이어, 한 게임의 관전자): 보드 전체 대신 변경분만 보낸다.
+ *   move_ok  "move" [sx,sy,tx,ty] + "flipped" [[x,y],...]   (좌표는 move 요청과 같이 1부터)
+ *   board    sync 요청에 대한 보드 전체
+ * 메시지마다 "seq"가 붙고, 보드가 바뀐 뒤 seq가 DELTA_HASH_INTERVAL의 배수면 "hash"(session_hash)도 붙는다.
+ * 서버는 메시지를 만들고, 클라이언트는 받은 변경분을 자기 char 보드에 쌓아가며 해시로 어긋남을 확인한다.
+ */
+#define DELTA_HASH_INTERVAL 8
+
+// 서버: type과 seq만 있는 메시지
+cJSON *delta_msg(const GameSession *g, const char *type);
+// 보드가 바뀐 뒤 (move_ok/pass) 변경분 메시지의 공통 부분
+cJSON *delta_update(const GameSession *g, const char *type, const char *next_player);
+// move_ok에 둔 수와 뒤집힌 칸을 붙인다. 좌표는 0부터, flipped는 session_move가 준 비트
+void delta_add_move(cJSON *d, int r1, int c1, int r2, int c2, uint64_t flipped);
+
+// 클라이언트: session_hash와 같은 해시를 char 보드로
+uint32_t delta_board_hash(char board[BOARD_SIZE][BOARD_SIZE]);
+// move_ok의 변경분을 보드에 쌓는다. 형식이 어긋나면 0 (보드가 일부만 바뀌었을 수 있으니 sync로 다시 받는다)
+int delta_apply(char board[BOARD_SIZE][BOARD_SIZE], const cJSON *msg);
+// 메시지에 해시가 있으면 보드와 비교. 없으면 맞는 것으로 본다
+int delta_in_sync(char board[BOARD_SIZE][BOARD_SIZE], const cJSON *msg);
+
+#endif
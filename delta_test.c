@@ -0,0 +1,112 @@
+#include "../include/delta.h"
+#include "../include/test.h"
+#include "../include/test_game.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * delta.c: 서버가 만든 변경분을 JSON 문자열로 보냈다가 받아서 클라이언트 보드에 쌓았을 때
+ * 서버 보드와 같은지, 해시가 DELTA_HASH_INTERVAL마다 붙고 맞는지, 변경분 하나를 놓치면
+ * 다음 해시에서 어긋남이 드러나는지, 형식이 틀린 변경분은 0인지 본다.
+ */
+#define GAMES 300
+
+// 서버에서 클라이언트로 가는 길: 문자열로 바꿨다가 다시 파싱
+static cJSON *over_the_wire(cJSON *msg) {
+    char *text = cJSON_PrintUnformatted(msg);
+    cJSON *back = cJSON_Parse(text);
+    cJSON_free(text);
+    cJSON_Delete(msg);
+    return back;
+}
+
+// 한 판을 끝까지 두면서 변경분을 쌓는 클라이언트 둘: 모두 받는 쪽과 하나를 놓친 쪽. 놓친 쪽을 잡아냈으면 1
+static int play_game(uint32_t id) {
+    TestGame t;
+    GameSession *g = &t.g;
+    char state[BOARD_SIZE][BOARD_SIZE], lagging[BOARD_SIZE][BOARD_SIZE];
+    test_game_start(&t, id);
+    session_to_board(g, state);
+    memcpy(lagging, state, sizeof lagging);
+    CHECK(delta_board_hash(state) == session_hash(g));
+
+    int drop_at = rand() % 40, caught = 0, ply = 0;
+    while (!test_game_over(g)) {
+        uint64_t flipped = 0;
+        uint16_t mv = test_random_step(g, &flipped);
+        const char *next = g->turn ? "Blue" : "Red";
+        cJSON *msg;
+        if (mv == TEST_MOVE_PASS) {
+            msg = over_the_wire(delta_update(g, "pass", next));
+            CHECK(cJSON_GetObjectItem(msg, "move") == NULL);
+        } else {
+            int from = mv >> 6, to = mv & 63;
+            cJSON *d = delta_update(g, "move_ok", next);
+            delta_add_move(d, from / 8, from % 8, to / 8, to % 8, flipped);
+            msg = over_the_wire(d);
+            CHECK(delta_apply(state, msg));
+            if (ply != drop_at) CHECK(delta_apply(lagging, msg));
+        }
+        CHECK(cJSON_GetObjectItem(msg, "seq")->valueint == g->seq);
+        CHECK(test_same_board(g, state));
+
+        const cJSON *jhash = cJSON_GetObjectItem(msg, "hash");
+        CHECK((jhash != NULL) == (g->seq % DELTA_HASH_INTERVAL == 0));
+        if (jhash) CHECK((uint32_t)jhash->valuedouble == session_hash(g));
+        CHECK(delta_in_sync(state, msg));
+
+        // 해시가 온 메시지에서만 판단할 수 있다. 잡아낸 뒤로는 sync를 받은 것처럼 다시 맞춘다
+        int lag_ok = memcmp(lagging, state, sizeof state) == 0;
+        if (jhash) CHECK(delta_in_sync(lagging, msg) == lag_ok);
+        if (!delta_in_sync(lagging, msg)) {
+            caught = 1;
+            memcpy(lagging, state, sizeof lagging);
+        }
+        cJSON_Delete(msg);
+        ply++;
+    }
+    return caught;
+}
+
+static int apply_text(const char *text) {
+    char board[BOARD_SIZE][BOARD_SIZE];
+    memset(board, '.', sizeof board);
+    board[0][0] = 'R';
+    cJSON *msg = cJSON_Parse(text);
+    int ok = delta_apply(board, msg);
+    cJSON_Delete(msg);
+    return ok;
+}
+
+static void test_malformed(void) {
+    CHECK(apply_text("{\"move\":[1,1,2,2],\"flipped\":[]}"));
+    CHECK(apply_text("{\"move\":[1,1,2,2]}"));
+    CHECK(!apply_text("{}"));
+    CHECK(!apply_text("{\"move\":[1,1,2]}"));
+    CHECK(!apply_text("{\"move\":[1,1,2,2,3]}"));
+    CHECK(!apply_text("{\"move\":[0,1,2,2]}"));
+    CHECK(!apply_text("{\"move\":[1,1,9,2]}"));
+    CHECK(!apply_text("{\"move\":[1,\"1\",2,2]}"));
+    CHECK(!apply_text("{\"move\":\"1122\"}"));
+    CHECK(!apply_text("{\"move\":[1,1,2,2],\"flipped\":[[3]]}"));
+    CHECK(!apply_text("{\"move\":[1,1,2,2],\"flipped\":[[3,-1]]}"));
+    CHECK(!apply_text("{\"move\":[1,1,2,2],\"flipped\":[5]}"));
+
+    char board[BOARD_SIZE][BOARD_SIZE];
+    memset(board, '.', sizeof board);
+    cJSON *msg = cJSON_CreateObject();
+    CHECK(delta_in_sync(board, msg));                  // 해시가 없으면 맞는 것으로
+    cJSON_AddNumberToObject(msg, "hash", delta_board_hash(board) ^ 1);
+    CHECK(!delta_in_sync(board, msg));
+    cJSON_Delete(msg);
+}
+
+int main(void) {
+    srand(1);
+    int caught = 0;
+    for (uint32_t i = 1; i <= GAMES; i++) caught += play_game(i);
+    CHECK(caught > GAMES / 2);
+    test_malformed();
+    return test_report("delta_test");
+}
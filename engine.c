@@ -0,0 +1,65 @@
+#include "../include/engine.h"
+#include "../include/wire.h"
+
+static int final_score(const GameSession *g, int color) {
+    int d = session_count(g, color) - session_count(g, 1 - color);
+    if (d > 0) return ENGINE_WIN + d;
+    if (d < 0) return -ENGINE_WIN + d;
+    return 0;
+}
+
+void engine_play(GameSession *g, uint16_t mv) {
+    if (mv == WIRE_MOVE_PASS) return;
+    int r1, c1, r2, c2;
+    wire_move_coords(mv, &r1, &c1, &r2, &c2);
+    session_move(g, r1, c1, r2, c2, NULL);
+}
+
+// 한 수 뒤 말 수 차이가 큰 순으로 (가지치기가 잘 되도록). 깊이가 남은 곳에서만 쓴다
+static void order_moves(const GameSession *g, int color, uint16_t *moves, int n) {
+    int score[SESSION_MAX_MOVES];
+    for (int i = 0; i < n; i++) {
+        GameSession next = *g;
+        uint16_t mv = moves[i];
+        engine_play(&next, mv);
+        int s = session_count(&next, color) - session_count(&next, 1 - color);
+        // 삽입 정렬: 수가 수십 개라 충분하다
+        int j = i;
+        for (; j > 0 && score[j - 1] < s; j--) {
+            score[j] = score[j - 1];
+            moves[j] = moves[j - 1];
+        }
+        score[j] = s;
+        moves[j] = mv;
+    }
+}
+
+static int negamax(const GameSession *g, int color, int depth, int alpha, int beta, uint16_t *best) {
+    uint16_t moves[SESSION_MAX_MOVES];
+    if (best) *best = WIRE_MOVE_PASS;
+    if (session_is_over(g)) return final_score(g, color);
+    if (depth <= 0) return session_count(g, color) - session_count(g, 1 - color);
+    int n = session_moves(g, color, moves);
+    if (n == 0) {
+        if (!session_has_valid_move(g, 1 - color)) return final_score(g, color);
+        return -negamax(g, 1 - color, depth - 1, -beta, -alpha, NULL);
+    }
+    if (depth >= 2) order_moves(g, color, moves, n);
+    int value = -ENGINE_INF;
+    for (int i = 0; i < n; i++) {
+        GameSession next = *g;
+        engine_play(&next, moves[i]);
+        int v = -negamax(&next, 1 - color, depth - 1, -beta, -alpha, NULL);
+        if (v > value) {
+            value = v;
+            if (best) *best = moves[i];
+        }
+        if (v > alpha) alpha = v;
+        if (alpha >= beta) break;
+    }
+    return value;
+}
+
+int engine_search(const GameSession *g, int color, int depth, uint16_t *best) {
+    return negamax(g, color, depth, -ENGINE_INF, ENGINE_INF, best);
+}
@@ -0,0 +1,20 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include "session.h"
+
+/*
+ * 고정 깊이 alpha-beta 탐색 (분석 도구용). 점수는 둘 차례인 쪽 기준 말 수 차이,
+ * 끝난 판은 이기면 ENGINE_WIN + 차이, 지면 -ENGINE_WIN + 차이.
+ * 둘 수 없으면 pass로 한 수를 쓰고, 둘 다 둘 수 없으면 끝난 판으로 본다 (서버의 연속 pass 종료와 같음).
+ */
+#define ENGINE_WIN  1000
+#define ENGINE_INF  1000000
+
+// color가 둘 차례인 g를 depth 수 앞까지 본 점수. best가 NULL이 아니면 고른 수 (둘 게 없으면 pass = 0xFFFF)
+int engine_search(const GameSession *g, int color, int depth, uint16_t *best);
+// g에 wire 형식 수 하나를 둔다 (pass면 그대로)
+void engine_play(GameSession *g, uint16_t mv);
+
+#endif
@@ -0,0 +1,529 @@
+#include "../include/gamelog.h"
+#include "../include/wire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define WRITER_IOV 64
+
+// 진행 중인 게임: 레코드 머리 바로 뒤에 수를 쌓아서, 끝나면 통째로 chunk에 복사한다
+struct GameRecording {
+    uint64_t start_mono;       // duration 계산용 (CLOCK_MONOTONIC ms)
+    uint32_t cap;              // rec 뒤에 들어갈 수 있는 수 개수
+    uint32_t pad;
+    GameLogRecord rec;
+};
+
+static inline uint16_t *recording_moves(GameRecording *gr) {
+    return (uint16_t *)(&gr->rec + 1);
+}
+
+static inline char *chunk_data(GameLogChunk *c) {
+    return (char *)(c + 1);
+}
+
+static uint64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* ---- writer ---- */
+
+// 실패하면 -1 (남은 바이트는 버린다)
+static int write_all(int fd, struct iovec *iov, int n) {
+    while (n > 0) {
+        ssize_t w = writev(fd, iov, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (n > 0 && (size_t)w >= iov->iov_len) {
+            w -= (ssize_t)iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char *)iov->iov_base + w;
+            iov->iov_len -= (size_t)w;
+        }
+    }
+    return 0;
+}
+
+static void write_chunks(GameLog *log, GameLogChunk *list) {
+    struct iovec iov[WRITER_IOV];
+    while (list) {
+        GameLogChunk *batch = list;
+        size_t bytes = 0;
+        int n = 0;
+        for (; list && n < WRITER_IOV; list = list->next, n++) {
+            iov[n].iov_base = chunk_data(list);
+            iov[n].iov_len = list->len;
+            bytes += list->len;
+        }
+        if (write_all(log->fd, iov, n) < 0) {
+            perror("game log write");
+            // 일부만 쓰였을 수 있다: 잘린 레코드 뒤에 덧붙이면 읽는 쪽이 거기서 멈추므로 되돌린다
+            if (ftruncate(log->fd, (off_t)log->end) < 0) perror("game log ftruncate");
+            lseek(log->fd, (off_t)log->end, SEEK_SET);
+            pthread_mutex_lock(&log->lock);
+            log->dropped_bytes += bytes;
+            pthread_mutex_unlock(&log->lock);
+        } else {
+            log->written_bytes += bytes;
+            log->end += bytes;
+        }
+        while (batch != list) {
+            GameLogChunk *next = batch->next;
+            free(batch);
+            batch = next;
+        }
+    }
+}
+
+static void *writer_main(void *arg) {
+    GameLog *log = (GameLog *)arg;
+    uint64_t last_sync = timer_now_ms();
+    int dirty = 0;
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (!log->head && !log->stop) {
+            if (log->sync != GAMELOG_SYNC_INTERVAL || !dirty) {
+                pthread_cond_wait(&log->cond, &log->lock);
+                continue;
+            }
+            // 쓴 게 남아 있으면 sync 시점에 맞춰 깬다
+            uint64_t due = last_sync + (uint64_t)log->sync_ms;
+            if (timer_now_ms() >= due) break;
+            struct timespec ts;
+            ts.tv_sec = (time_t)(due / 1000);
+            ts.tv_nsec = (long)(due % 1000) * 1000000L;
+            pthread_cond_timedwait(&log->cond, &log->lock, &ts);
+        }
+        GameLogChunk *list = log->head;
+        int stop = log->stop;
+        log->head = log->tail = NULL;
+        log->pending = 0;
+        pthread_mutex_unlock(&log->lock);
+
+        if (list) {
+            write_chunks(log, list);
+            dirty = 1;
+        }
+        uint64_t now = timer_now_ms();
+        if (dirty && log->sync != GAMELOG_SYNC_NONE
+            && (log->sync == GAMELOG_SYNC_BATCH || stop || now - last_sync >= (uint64_t)log->sync_ms)) {
+            if (fdatasync(log->fd) < 0) perror("game log fdatasync");
+            log->syncs++;
+            dirty = 0;
+            last_sync = now;
+        }
+
+        pthread_mutex_lock(&log->lock);
+        if (stop && !log->head) break;
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+// 새 파일이면 헤더를 쓰고, 있던 파일이면 형식을 확인하고 끝의 잘린 레코드를 잘라낸다
+static int prepare_file(int fd, const char *path) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(path);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        GameLogFileHeader h;
+        memset(&h, 0, sizeof h);
+        memcpy(h.magic, GAMELOG_FILE_MAGIC, sizeof h.magic);
+        h.version = 1;
+        h.record_size = sizeof(GameLogRecord);
+        struct iovec iov;
+        iov.iov_base = &h;
+        iov.iov_len = sizeof h;
+        if (write_all(fd, &iov, 1) < 0) {
+            perror(path);
+            if (ftruncate(fd, 0) < 0) perror(path);
+            return -1;
+        }
+        return 0;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    size_t valid = gamelog_valid_length((const uint8_t *)p, (size_t)st.st_size);
+    munmap(p, (size_t)st.st_size);
+    if (valid == 0) {
+        fprintf(stderr, "%s: not a game log\n", path);
+        return -1;
+    }
+    if (valid < (size_t)st.st_size) {
+        // 쓰다 만 레코드 (크래시). 그 뒤에 덧붙이면 읽는 쪽이 거기서 멈추므로 잘라낸다
+        fprintf(stderr, "%s: dropping %lld bytes of torn records\n", path, (long long)st.st_size - (long long)valid);
+        if (ftruncate(fd, (off_t)valid) < 0) {
+            perror(path);
+            return -1;
+        }
+    }
+    lseek(fd, 0, SEEK_END);
+    return 0;
+}
+
+GameLog *gamelog_open(const char *path, int sync, int sync_ms) {
+    GameLog *log = (GameLog *)calloc(1, sizeof *log);
+    if (!log) return NULL;
+    log->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (log->fd < 0) {
+        perror(path);
+        free(log);
+        return NULL;
+    }
+    if (prepare_file(log->fd, path) < 0) {
+        close(log->fd);
+        free(log);
+        return NULL;
+    }
+    log->end = (uint64_t)lseek(log->fd, 0, SEEK_END);
+    log->sync = sync;
+    log->sync_ms = sync_ms > 0 ? sync_ms : 1000;
+    pthread_mutex_init(&log->lock, NULL);
+    // timedwait를 timer_now_ms와 같은 시계로
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&log->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&log->thread, NULL, writer_main, log) != 0) {
+        perror("pthread_create");
+        pthread_cond_destroy(&log->cond);
+        pthread_mutex_destroy(&log->lock);
+        close(log->fd);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+void gamelog_close(GameLog *log) {
+    if (!log) return;
+    pthread_mutex_lock(&log->lock);
+    log->stop = 1;
+    pthread_cond_signal(&log->cond);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+    printf("Game log: %llu bytes written, %llu syncs, %llu bytes dropped\n",
+           (unsigned long long)log->written_bytes, (unsigned long long)log->syncs,
+           (unsigned long long)log->dropped_bytes);
+    pthread_cond_destroy(&log->cond);
+    pthread_mutex_destroy(&log->lock);
+    close(log->fd);
+    free(log);
+}
+
+/* ---- recorder ---- */
+
+static inline size_t slot_of(const GameRecorder *r, uint32_t id) {
+    return (size_t)(id * 2654435761u) & r->mask;
+}
+
+// id가 있는 칸, 없으면 -1
+static long find_slot(const GameRecorder *r, uint32_t id) {
+    if (!r->slots) return -1;
+    for (size_t i = slot_of(r, id);; i = (i + 1) & r->mask) {
+        if (!r->slots[i]) return -1;
+        if (r->slots[i]->rec.game_id == id) return (long)i;
+    }
+}
+
+static void insert_slot(GameRecorder *r, GameRecording *gr) {
+    size_t i = slot_of(r, gr->rec.game_id);
+    while (r->slots[i]) i = (i + 1) & r->mask;
+    r->slots[i] = gr;
+    r->count++;
+}
+
+// 빈 칸 뒤에서 자기 자리를 지나쳐 온 항목을 당겨온다 (tombstone 없이 지우기)
+static void remove_slot(GameRecorder *r, size_t hole) {
+    r->slots[hole] = NULL;
+    r->count--;
+    for (size_t i = (hole + 1) & r->mask; r->slots[i]; i = (i + 1) & r->mask) {
+        size_t home = slot_of(r, r->slots[i]->rec.game_id);
+        if (((i - home) & r->mask) >= ((i - hole) & r->mask)) {
+            r->slots[hole] = r->slots[i];
+            r->slots[i] = NULL;
+            hole = i;
+        }
+    }
+}
+
+static int grow_slots(GameRecorder *r) {
+    size_t old_size = r->slots ? r->mask + 1 : 0;
+    size_t size = old_size ? old_size * 2 : 64;
+    GameRecording **old = r->slots;
+    r->slots = (GameRecording **)calloc(size, sizeof *r->slots);
+    if (!r->slots) {
+        r->slots = old;
+        return -1;
+    }
+    r->mask = size - 1;
+    r->count = 0;
+    for (size_t i = 0; i < old_size; i++) {
+        if (old[i]) insert_slot(r, old[i]);
+    }
+    free(old);
+    return 0;
+}
+
+// 덜 찬 chunk라도 writer에게 넘긴다
+static void hand_off(GameRecorder *r) {
+    GameLogChunk *c = r->chunk;
+    GameLog *log = r->log;
+    timer_cancel(&r->flush_timer);
+    r->chunk = NULL;
+    if (!c) return;
+    c->next = NULL;
+    pthread_mutex_lock(&log->lock);
+    if (log->pending + c->len > GAMELOG_MAX_PENDING) {
+        // writer가 못 따라옴: 게임 스레드를 세우지 않고 버린다
+        log->dropped_bytes += c->len;
+        pthread_mutex_unlock(&log->lock);
+        free(c);
+        return;
+    }
+    if (log->tail) log->tail->next = c;
+    else log->head = c;
+    log->tail = c;
+    log->pending += c->len;
+    pthread_cond_signal(&log->cond);
+    pthread_mutex_unlock(&log->lock);
+}
+
+static void on_flush_timer(Timer *t, void *arg) {
+    (void)t;
+    hand_off((GameRecorder *)arg);
+}
+
+// 레코드를 chunk에 붙인다
+static void emit(GameRecorder *r, GameRecording *gr) {
+    size_t body = (size_t)gr->rec.move_count * 2;
+    size_t size = gamelog_record_size(gr->rec.move_count);
+    if (r->chunk && r->chunk->cap - r->chunk->len < size) hand_off(r);
+    if (!r->chunk) {
+        size_t cap = size > GAMELOG_CHUNK_SIZE ? size : GAMELOG_CHUNK_SIZE;
+        r->chunk = (GameLogChunk *)malloc(sizeof(GameLogChunk) + cap);
+        if (!r->chunk) {
+            perror("game log chunk");
+            return;
+        }
+        r->chunk->next = NULL;
+        r->chunk->len = 0;
+        r->chunk->cap = cap;
+        timer_arm(r->wheel, &r->flush_timer, GAMELOG_FLUSH_MS);
+    }
+    char *p = chunk_data(r->chunk) + r->chunk->len;
+    memcpy(p, &gr->rec, sizeof gr->rec + body);
+    memset(p + sizeof gr->rec + body, 0, size - sizeof gr->rec - body);
+    r->chunk->len += size;
+    r->games++;
+}
+
+void recorder_init(GameRecorder *r, GameLog *log, TimerWheel *wheel) {
+    memset(r, 0, sizeof *r);
+    r->log = log;
+    r->wheel = wheel;
+    timer_init(&r->flush_timer, on_flush_timer, r);
+}
+
+void recorder_close(GameRecorder *r) {
+    if (!r->log) return;
+    uint64_t now = timer_now_ms();
+    for (size_t i = 0; r->slots && i <= r->mask; i++) {
+        GameRecording *gr = r->slots[i];
+        if (!gr) continue;
+        // 마지막 보드는 수를 다시 두어 보면 나온다 (점수는 0으로 둔다)
+        gr->rec.result = GAMELOG_UNFINISHED;
+        gr->rec.duration_ms = (uint32_t)(now - gr->start_mono);
+        emit(r, gr);
+        free(gr);
+    }
+    free(r->slots);
+    r->slots = NULL;
+    r->count = 0;
+    hand_off(r);
+}
+
+void recorder_start(GameRecorder *r, const GameSession *g, const char *red, const char *blue) {
+    if (!r->log) return;
+    if ((r->count + 1) * 2 > (r->slots ? r->mask + 1 : 0) && grow_slots(r) < 0) return;
+    uint32_t cap = 64;
+    GameRecording *gr = (GameRecording *)malloc(sizeof *gr + cap * sizeof(uint16_t));
+    if (!gr) return;
+    memset(gr, 0, sizeof *gr);
+    gr->start_mono = timer_now_ms();
+    gr->cap = cap;
+    gr->rec.magic = GAMELOG_RECORD_MAGIC;
+    gr->rec.game_id = g->id;
+    gr->rec.start_ms = wall_ms();
+    gr->rec.red = g->red;
+    gr->rec.blue = g->blue;
+    gr->rec.blocked = g->blocked;
+    gr->rec.turn = (uint8_t)g->turn;
+    gr->rec.start_seq = (uint16_t)g->seq;
+    strncpy(gr->rec.name[0], red, GAMELOG_NAME_MAX - 1);
+    strncpy(gr->rec.name[1], blue, GAMELOG_NAME_MAX - 1);
+    insert_slot(r, gr);
+}
+
+void recorder_resume(GameRecorder *r, const GameSession *g, const char *red, const char *blue) {
+    recorder_start(r, g, red, blue);
+    long i = find_slot(r, g->id);
+    if (i >= 0) r->slots[i]->rec.flags |= GAMELOG_CONTINUED;
+}
+
+void recorder_move(GameRecorder *r, const GameSession *g, uint16_t mv) {
+    long i = find_slot(r, g->id);
+    if (i < 0) return;
+    GameRecording *gr = r->slots[i];
+    if (gr->rec.move_count == gr->cap) {
+        uint32_t cap = gr->cap * 2;
+        GameRecording *bigger = (GameRecording *)realloc(gr, sizeof *gr + cap * sizeof(uint16_t));
+        if (!bigger) {
+            // 수가 빠진 레코드는 다시 둬 볼 수 없으므로 이 게임은 남기지 않는다
+            perror("game log recording");
+            remove_slot(r, (size_t)i);
+            free(gr);
+            return;
+        }
+        gr = r->slots[i] = bigger;
+        gr->cap = cap;
+    }
+    recording_moves(gr)[gr->rec.move_count++] = mv;
+}
+
+void recorder_finish(GameRecorder *r, const GameSession *g, int result) {
+    long i = find_slot(r, g->id);
+    if (i < 0) return;
+    GameRecording *gr = r->slots[i];
+    gr->rec.result = (uint8_t)result;
+    gr->rec.score[0] = (uint8_t)session_count(g, 0);
+    gr->rec.score[1] = (uint8_t)session_count(g, 1);
+    gr->rec.duration_ms = (uint32_t)(timer_now_ms() - gr->start_mono);
+    emit(r, gr);
+    remove_slot(r, (size_t)i);
+    free(gr);
+}
+
+/* ---- reader ---- */
+
+size_t gamelog_valid_length(const uint8_t *base, size_t len) {
+    const GameLogFileHeader *h = (const GameLogFileHeader *)base;
+    if (len < sizeof *h || memcmp(h->magic, GAMELOG_FILE_MAGIC, sizeof h->magic) != 0
+        || h->version != 1 || h->record_size != sizeof(GameLogRecord)) {
+        return 0;
+    }
+    GameLogReader rd;
+    rd.base = base;
+    rd.len = len;
+    rd.off = sizeof *h;
+    while (gamelog_reader_next(&rd)) {
+    }
+    return rd.off;
+}
+
+int gamelog_reader_open(GameLogReader *rd, const char *path) {
+    memset(rd, 0, sizeof *rd);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(GameLogFileHeader)) {
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    rd->base = (const uint8_t *)p;
+    rd->len = (size_t)st.st_size;
+    if (gamelog_valid_length(rd->base, sizeof(GameLogFileHeader)) == 0) {
+        gamelog_reader_close(rd);
+        return -1;
+    }
+    rd->off = sizeof(GameLogFileHeader);
+    return 0;
+}
+
+void gamelog_reader_close(GameLogReader *rd) {
+    if (rd->base) munmap((void *)rd->base, rd->len);
+    memset(rd, 0, sizeof *rd);
+}
+
+const GameLogRecord *gamelog_reader_next(GameLogReader *rd) {
+    size_t left = rd->len - rd->off;
+    if (left < sizeof(GameLogRecord)) return NULL;
+    const GameLogRecord *rec = (const GameLogRecord *)(rd->base + rd->off);
+    if (rec->magic != GAMELOG_RECORD_MAGIC) return NULL;
+    // 32비트에서 크기 계산이 넘치지 않게 먼저 본다
+    if (rec->move_count > (left - sizeof *rec) / 2) return NULL;
+    size_t size = gamelog_record_size(rec->move_count);
+    if (size > left) return NULL;
+    rd->off += size;
+    return rec;
+}
+
+static const char *result_name(int result) {
+    switch (result) {
+    case GAMELOG_FINISHED:   return "finished";
+    case GAMELOG_ABANDONED:  return "abandoned";
+    case GAMELOG_UNFINISHED: return "unfinished";
+    default:                 return "?";
+    }
+}
+
+int gamelog_dump(const char *path, int verbose) {
+    GameLogReader rd;
+    if (gamelog_reader_open(&rd, path) < 0) {
+        fprintf(stderr, "%s: cannot open game log\n", path);
+        return -1;
+    }
+    unsigned long long games = 0, moves = 0;
+    const GameLogRecord *rec;
+    while ((rec = gamelog_reader_next(&rd)) != NULL) {
+        printf("game %u  %s vs %s  %s  %u-%u  %u moves  %u ms", rec->game_id, rec->name[0], rec->name[1],
+               result_name(rec->result), rec->score[0], rec->score[1], rec->move_count, rec->duration_ms);
+        if (rec->flags & GAMELOG_CONTINUED) printf("  (continued after seq %u)", rec->start_seq);
+        printf("\n");
+        if (verbose) {
+            // 번호는 seq (이어 쓴 레코드는 start_seq 다음부터)
+            const uint16_t *mv = gamelog_moves(rec);
+            for (uint32_t i = 0; i < rec->move_count; i++) {
+                uint32_t seq = rec->start_seq + i + 1;
+                int r1, c1, r2, c2;
+                if (mv[i] == WIRE_MOVE_PASS) {
+                    printf("  %u pass\n", seq);
+                    continue;
+                }
+                wire_move_coords(mv[i], &r1, &c1, &r2, &c2);
+                printf("  %u (%d,%d)->(%d,%d)\n", seq, r1 + 1, c1 + 1, r2 + 1, c2 + 1);
+            }
+        }
+        if (!(rec->flags & GAMELOG_CONTINUED)) games++;
+        moves += rec->move_count;
+    }
+    if (rd.off < rd.len) printf("(stopped at torn record, offset %zu of %zu)\n", rd.off, rd.len);
+    printf("%llu games, %llu moves\n", games, moves);
+    gamelog_reader_close(&rd);
+    return 0;
+}
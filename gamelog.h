@@ -0,0 +1,151 @@
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "session.h"
+#include "timer.h"
+
+/*
+ * 게임 기록을 덧붙이기만 하는 바이너리 로그 (-l <path>).
+ *
+ *   파일:   [GameLogFileHeader 16B] [게임 레코드]...
+ *   레코드: [GameLogRecord 120B] [수 u16 x move_count] [0으로 채워 8바이트 경계까지]
+ *   수:     wire.h와 같은 u16 (출발 칸 << 6 | 도착 칸, WIRE_MOVE_PASS = pass). 보드가 바뀐
+ *           사건(move_ok, pass, 시간 초과 pass)마다 하나라서 move_count는 마지막 seq - start_seq와 같다
+ *
+ * 체크포인트에서 되살린 게임은 되살린 보드에서 새 레코드를 시작한다 (GAMELOG_CONTINUED).
+ * 그 앞의 수는 서버가 멈출 때 남긴 GAMELOG_UNFINISHED 레코드에 있다 (죽었으면 없다).
+ *
+ * 정수는 호스트 바이트 순서 그대로 쓴다 (x86-64, 라즈베리 파이 모두 little endian).
+ * 레코드가 8바이트 정렬이라 읽는 쪽은 mmap한 파일을 복사 없이 구조체로 바로 본다.
+ *
+ * 게임 스레드(shard)는 진행 중인 게임의 수를 자기 GameRecorder에 모으다가 게임이 끝나면
+ * 레코드를 자기 chunk에 붙인다. chunk가 차거나 GAMELOG_FLUSH_MS가 지나면 writer 스레드에
+ * 넘기고, 파일 쓰기와 fdatasync는 모두 writer가 한다 (게임 스레드는 넘길 때 락 한 번).
+ * 디스크가 밀려 GAMELOG_MAX_PENDING을 넘으면 게임을 멈추는 대신 그 chunk를 버리고 센다.
+ */
+#define GAMELOG_FILE_MAGIC   "HW3GLOG1"
+#define GAMELOG_RECORD_MAGIC 0x43455247u   // "GREC"
+#define GAMELOG_NAME_MAX     32            // '\0' 포함 (REGISTRY_NAME_MAX와 같게)
+#define GAMELOG_CHUNK_SIZE   (64 * 1024)
+#define GAMELOG_FLUSH_MS     100           // 덜 찬 chunk도 이 시간 안에는 writer로 넘긴다
+#define GAMELOG_MAX_PENDING  (64u * 1024 * 1024)
+
+// GameLogRecord.result
+enum {
+    GAMELOG_FINISHED = 1,      // 규칙대로 끝남 (두 번 연속 pass 또는 둘 곳 없음)
+    GAMELOG_ABANDONED,         // 한쪽 연결이 끊겨서 끝남
+    GAMELOG_UNFINISHED,        // 서버가 멈출 때 진행 중이었음
+};
+
+// GameLogRecord.flags
+#define GAMELOG_CONTINUED 0x01     // 체크포인트에서 되살린 게임의 나머지 (새 게임이 아니다)
+
+// fdatasync 시점
+enum {
+    GAMELOG_SYNC_NONE,         // 커널 writeback에 맡긴다
+    GAMELOG_SYNC_BATCH,        // writer가 한 번 쓸 때마다
+    GAMELOG_SYNC_INTERVAL,     // 마지막 sync 후 sync_ms가 지났을 때 (쓴 게 있으면)
+};
+
+typedef struct {
+    char magic[8];             // GAMELOG_FILE_MAGIC
+    uint32_t version;          // 1
+    uint32_t record_size;      // sizeof(GameLogRecord)
+} GameLogFileHeader;
+
+typedef struct {
+    uint32_t magic;            // GAMELOG_RECORD_MAGIC
+    uint32_t game_id;
+    uint64_t start_ms;         // 시작 시각 (UNIX epoch ms)
+    uint32_t duration_ms;
+    uint32_t move_count;       // 뒤따르는 수 기록 수
+    uint64_t red, blue, blocked;   // 시작 보드 (blocked가 장애물 배치)
+    uint8_t result;            // GAMELOG_*
+    uint8_t score[2];          // 끝났을 때 Red, Blue 말 수
+    uint8_t flags;             // GAMELOG_CONTINUED
+    uint8_t turn;              // 시작 보드에서 둘 차례 (0 = Red)
+    uint8_t reserved;
+    uint16_t start_seq;        // 시작 보드의 seq (첫 수는 start_seq + 1)
+    char name[2][GAMELOG_NAME_MAX];    // Red(선공), Blue
+} GameLogRecord;
+
+static inline size_t gamelog_record_size(uint32_t move_count) {
+    return sizeof(GameLogRecord) + (((size_t)move_count * 2 + 7) & ~(size_t)7);
+}
+static inline const uint16_t *gamelog_moves(const GameLogRecord *rec) {
+    return (const uint16_t *)(rec + 1);
+}
+
+/* ---- 파일과 writer 스레드 (프로세스에 하나) ---- */
+typedef struct GameLogChunk {
+    struct GameLogChunk *next;
+    size_t len, cap;
+} GameLogChunk;
+
+typedef struct GameLog {
+    int fd;
+    int sync;                  // GAMELOG_SYNC_*
+    int sync_ms;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    GameLogChunk *head, *tail; // writer가 쓸 chunk (lock으로 보호)
+    size_t pending;            // head..tail의 바이트 수
+    int stop;
+    uint64_t end;              // 마지막으로 온전히 쓴 위치 (writer만 쓴다)
+    // 통계 (writer가 쓰고 close 후에 읽는다. dropped만 게임 스레드가 lock 안에서 올린다)
+    uint64_t written_bytes, syncs, dropped_bytes;
+} GameLog;
+
+// 파일을 열고(없으면 만든다) 끝에 잘린 레코드가 있으면 잘라낸 뒤 writer를 띄운다. 실패하면 NULL
+GameLog *gamelog_open(const char *path, int sync, int sync_ms);
+// 넘겨받은 chunk를 모두 쓰고 sync한 뒤 스레드와 파일을 닫는다
+void gamelog_close(GameLog *log);
+
+/* ---- 게임 스레드 쪽 (shard마다 하나, 그 스레드에서만 쓴다) ---- */
+typedef struct GameRecording GameRecording;
+
+typedef struct GameRecorder {
+    GameLog *log;              // NULL이면 아무것도 하지 않는다
+    GameRecording **slots;     // game id → 진행 중인 게임 (open addressing)
+    size_t mask, count;
+    GameLogChunk *chunk;       // 끝난 게임 레코드를 모으는 중
+    Timer flush_timer;
+    TimerWheel *wheel;
+    uint64_t games;            // 레코드로 만든 게임 수
+} GameRecorder;
+
+void recorder_init(GameRecorder *r, GameLog *log, TimerWheel *wheel);
+// 진행 중인 게임을 GAMELOG_UNFINISHED로 남기고 chunk를 writer에 넘긴다 (gamelog_close 전에)
+void recorder_close(GameRecorder *r);
+// 시작 보드와 이름을 기억해 둔다
+void recorder_start(GameRecorder *r, const GameSession *g, const char *red, const char *blue);
+// 체크포인트에서 되살린 게임: 지금 보드, 차례, seq에서 GAMELOG_CONTINUED 레코드를 시작한다
+void recorder_resume(GameRecorder *r, const GameSession *g, const char *red, const char *blue);
+// 보드가 바뀔 때마다: mv는 wire 형식 (pass는 WIRE_MOVE_PASS). 수를 더 담을 메모리가 없으면 그 게임은 버린다
+void recorder_move(GameRecorder *r, const GameSession *g, uint16_t mv);
+// 게임 레코드를 chunk에 붙이고 잊는다
+void recorder_finish(GameRecorder *r, const GameSession *g, int result);
+
+/* ---- 읽기: 파일 전체를 mmap하고 레코드를 제자리에서 돌려준다 ---- */
+typedef struct {
+    const uint8_t *base;
+    size_t len;                // 매핑한 길이
+    size_t off;                // 다음 레코드 위치
+} GameLogReader;
+
+// 파일이 없거나 형식이 다르면 -1
+int gamelog_reader_open(GameLogReader *rd, const char *path);
+void gamelog_reader_close(GameLogReader *rd);
+// 다음 게임 (수는 gamelog_moves). 끝이거나 잘린 레코드를 만나면 NULL
+const GameLogRecord *gamelog_reader_next(GameLogReader *rd);
+// base[0..len)에서 온전한 레코드가 끝나는 위치 (파일 헤더 포함)
+size_t gamelog_valid_length(const uint8_t *base, size_t len);
+
+// hw3 log <file> [-v]: 게임마다 한 줄 (-v면 수까지)
+int gamelog_dump(const char *path, int verbose);
+
+#endif
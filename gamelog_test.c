@@ -0,0 +1,337 @@
+#include "../include/gamelog.h"
+#include "../include/wire.h"
+#include "../include/test.h"
+#include "../include/test_game.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+/*
+ * gamelog.c: 여러 게임을 번갈아 두면서 recorder에 남기고, 몇 판은 끝나지 않은 채로 닫은 뒤
+ * 파일을 다시 읽어 id, 이름, 시작 보드, 수, 결과, 점수가 그대로인지 본다 (끝난 게임은 수를
+ * 다시 두어 점수까지). 끝에 잘린 레코드가 붙은 파일은 읽는 쪽이 무시하고 다시 열 때 잘라내는지도 본다.
+ * 파일 크기 제한(RLIMIT_FSIZE)으로 쓰기를 중간에 실패시키면 writer가 잘린 부분을 되돌려서
+ * 그 뒤에 쓴 게임을 읽을 수 있는지도 본다.
+ * 서버가 멈출 때 남긴 레코드 뒤에 되살린 게임을 이어 쓰면, 이어 쓴 레코드가 GAMELOG_CONTINUED와
+ * 되살린 보드의 차례, seq를 갖고 그 차례부터 다시 두면 마지막 보드가 나오는지도 본다.
+ */
+#define GAMES      300
+#define LIVE       20              // 동시에 진행하는 게임 수
+#define MAX_MOVES  1024
+#define RESUMED    20              // 중간에 서버를 다시 띄우는 게임 수
+
+typedef struct {
+    TestGame t;
+    uint16_t moves[MAX_MOVES];
+    uint32_t count;
+    int result;                    // 0이면 아직 진행 중
+    int seen;
+} Expected;
+
+static Expected games[GAMES + 1];  // game id = 번호 (1부터)
+
+static void start_game(GameRecorder *r, uint32_t id) {
+    Expected *e = &games[id];
+    test_game_start(&e->t, id);
+    if (id % 7 == 0) {
+        // 너무 긴 이름은 GAMELOG_NAME_MAX - 1자로 잘린다
+        const char *long_name = "abcdefghijklmnopqrstuvwxyz0123456789";
+        memcpy(e->t.name[1], long_name, GAMELOG_NAME_MAX - 1);
+        e->t.name[1][GAMELOG_NAME_MAX - 1] = '\0';
+        recorder_start(r, &e->t.g, e->t.name[0], long_name);
+    } else {
+        recorder_start(r, &e->t.g, e->t.name[0], e->t.name[1]);
+    }
+}
+
+// 한 수 둔다. 끝났으면 1
+static int step_game(GameRecorder *r, uint32_t id) {
+    Expected *e = &games[id];
+    uint16_t mv = test_random_step(&e->t.g, NULL);
+    recorder_move(r, &e->t.g, mv);
+    e->moves[e->count++] = mv;
+
+    if (test_game_over(&e->t.g)) e->result = GAMELOG_FINISHED;
+    else if (rand() % 200 == 0 || e->count == MAX_MOVES) e->result = GAMELOG_ABANDONED;
+    if (!e->result) return 0;
+    recorder_finish(r, &e->t.g, e->result);
+    return 1;
+}
+
+// first부터 count판을 하나씩 끝까지 두고 recorder를 닫는다 (chunk가 writer로 넘어간다)
+static void record_batch(GameLog *log, TimerWheel *wheel, uint32_t first, uint32_t count) {
+    GameRecorder rec;
+    recorder_init(&rec, log, wheel);
+    for (uint32_t id = first; id < first + count; id++) {
+        memset(&games[id], 0, sizeof games[id]);
+        start_game(&rec, id);
+        while (!step_game(&rec, id)) {
+        }
+    }
+    recorder_close(&rec);
+}
+
+static uint64_t dropped_bytes(GameLog *log) {
+    pthread_mutex_lock(&log->lock);
+    uint64_t n = log->dropped_bytes;
+    pthread_mutex_unlock(&log->lock);
+    return n;
+}
+
+static void record_games(const char *path) {
+    Reactor reactor;
+    TimerWheel wheel;
+    GameRecorder rec;
+    CHECK(reactor_init(&reactor) == 0);
+    CHECK(timer_wheel_init(&wheel, &reactor) == 0);
+    GameLog *log = gamelog_open(path, GAMELOG_SYNC_NONE, 0);
+    CHECK(log != NULL);
+    if (!log) return;
+    recorder_init(&rec, log, &wheel);
+
+    uint32_t live[LIVE], nlive = 0, next_id = 1;
+    while (next_id <= GAMES || nlive > 0) {
+        while (nlive < LIVE && next_id <= GAMES) {
+            start_game(&rec, next_id);
+            live[nlive++] = next_id++;
+        }
+        uint32_t i = (uint32_t)rand() % nlive;
+        if (step_game(&rec, live[i])) live[i] = live[--nlive];
+        // 마지막 몇 판은 끝내지 않고 닫는다
+        if (next_id > GAMES && nlive <= LIVE / 2) break;
+    }
+    for (uint32_t i = 0; i < nlive; i++) games[live[i]].result = GAMELOG_UNFINISHED;
+
+    recorder_close(&rec);
+    gamelog_close(log);
+    timer_wheel_close(&wheel);
+    reactor_close(&reactor);
+}
+
+static void check_record(const GameLogRecord *rec) {
+    CHECK(rec->game_id >= 1 && rec->game_id <= GAMES);
+    if (rec->game_id < 1 || rec->game_id > GAMES) return;
+    Expected *e = &games[rec->game_id];
+    CHECK(!e->seen);
+    e->seen = 1;
+    CHECK(rec->magic == GAMELOG_RECORD_MAGIC);
+    CHECK(rec->result == e->result);
+    CHECK(strcmp(rec->name[0], e->t.name[0]) == 0);
+    CHECK(strcmp(rec->name[1], e->t.name[1]) == 0);
+    CHECK(rec->red == e->t.red && rec->blue == e->t.blue && rec->blocked == e->t.blocked);
+    CHECK(rec->move_count == e->count);
+    if (rec->move_count != e->count) return;
+    CHECK(memcmp(gamelog_moves(rec), e->moves, e->count * sizeof(uint16_t)) == 0);
+
+    // 시작 보드에서 기록된 수를 다시 두면 마지막 보드가 나온다
+    GameSession g;
+    session_init(&g);
+    g.red = rec->red;
+    g.blue = rec->blue;
+    g.blocked = rec->blocked;
+    for (uint32_t i = 0; i < rec->move_count; i++) {
+        uint16_t mv = gamelog_moves(rec)[i];
+        if (mv != WIRE_MOVE_PASS) {
+            int r1, c1, r2, c2;
+            wire_move_coords(mv, &r1, &c1, &r2, &c2);
+            CHECK(session_is_valid_move(&g, g.turn, r1, c1, r2, c2));
+            session_move(&g, r1, c1, r2, c2, NULL);
+        }
+        g.turn ^= 1;
+    }
+    CHECK(g.red == e->t.g.red && g.blue == e->t.g.blue);
+    if (rec->result == GAMELOG_UNFINISHED) {
+        CHECK(rec->score[0] == 0 && rec->score[1] == 0);
+    } else {
+        CHECK(rec->score[0] == session_count(&g, 0) && rec->score[1] == session_count(&g, 1));
+    }
+}
+
+// 읽은 레코드 수
+static int read_games(const char *path) {
+    GameLogReader rd;
+    CHECK(gamelog_reader_open(&rd, path) == 0);
+    int n = 0;
+    for (const GameLogRecord *rec; (rec = gamelog_reader_next(&rd)); n++) check_record(rec);
+    CHECK(rd.off == rd.len);
+    gamelog_reader_close(&rd);
+    return n;
+}
+
+static off_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+static void test_write_error(const char *path) {
+    Reactor reactor;
+    TimerWheel wheel;
+    struct rlimit old, lim;
+    CHECK(reactor_init(&reactor) == 0);
+    CHECK(timer_wheel_init(&wheel, &reactor) == 0);
+    unlink(path);
+    GameLog *log = gamelog_open(path, GAMELOG_SYNC_NONE, 0);
+    CHECK(log != NULL);
+    if (!log) return;
+
+    // 헤더 뒤 1000바이트까지만 쓸 수 있다: 첫 묶음은 일부만 쓰이다가 EFBIG로 실패한다
+    signal(SIGXFSZ, SIG_IGN);
+    CHECK(getrlimit(RLIMIT_FSIZE, &old) == 0);
+    lim = old;
+    lim.rlim_cur = sizeof(GameLogFileHeader) + 1000;
+    CHECK(setrlimit(RLIMIT_FSIZE, &lim) == 0);
+    record_batch(log, &wheel, 1, 20);
+    for (int guard = 0; guard < 1000 && dropped_bytes(log) == 0; guard++) usleep(1000);
+    CHECK(dropped_bytes(log) > 0);
+    CHECK(setrlimit(RLIMIT_FSIZE, &old) == 0);
+    CHECK(file_size(path) == (off_t)sizeof(GameLogFileHeader));
+
+    record_batch(log, &wheel, 21, 20);
+    gamelog_close(log);
+    timer_wheel_close(&wheel);
+    reactor_close(&reactor);
+
+    // 버린 묶음의 게임은 없고, 그 뒤 묶음은 모두 읽힌다
+    CHECK(read_games(path) == 20);
+    for (uint32_t id = 1; id <= 40; id++) CHECK(games[id].seen == (id > 20));
+}
+
+// 시작 보드에서 차례 turn부터 수를 다시 둔다
+static void replay(GameSession *g, const GameLogRecord *rec) {
+    session_init(g);
+    g->red = rec->red;
+    g->blue = rec->blue;
+    g->blocked = rec->blocked;
+    g->turn = rec->turn;
+    for (uint32_t i = 0; i < rec->move_count; i++) {
+        uint16_t mv = gamelog_moves(rec)[i];
+        if (mv != WIRE_MOVE_PASS) {
+            int r1, c1, r2, c2;
+            wire_move_coords(mv, &r1, &c1, &r2, &c2);
+            CHECK(session_is_valid_move(g, g->turn, r1, c1, r2, c2));
+            session_move(g, r1, c1, r2, c2, NULL);
+        }
+        g->turn ^= 1;
+    }
+}
+
+static void test_resume(const char *path) {
+    Reactor reactor;
+    TimerWheel wheel;
+    GameRecorder rec;
+    uint32_t split[RESUMED + 1];
+    CHECK(reactor_init(&reactor) == 0);
+    CHECK(timer_wheel_init(&wheel, &reactor) == 0);
+    unlink(path);
+    GameLog *log = gamelog_open(path, GAMELOG_SYNC_NONE, 0);
+    CHECK(log != NULL);
+    if (!log) return;
+
+    // 몇 수씩 두다가 서버가 멈춘다 (홀수 수면 Blue 차례에서 되살아난다)
+    recorder_init(&rec, log, &wheel);
+    for (uint32_t id = 1; id <= RESUMED; id++) {
+        Expected *e = &games[id];
+        memset(e, 0, sizeof *e);
+        start_game(&rec, id);
+        while (e->count <= id % 7 && !test_game_over(&e->t.g)) {
+            uint16_t mv = test_random_step(&e->t.g, NULL);
+            recorder_move(&rec, &e->t.g, mv);
+            e->moves[e->count++] = mv;
+        }
+        split[id] = e->count;
+    }
+    recorder_close(&rec);
+
+    // 다시 띄운 서버가 체크포인트의 보드에서 이어서 끝까지 둔다
+    recorder_init(&rec, log, &wheel);
+    for (uint32_t id = 1; id <= RESUMED; id++) {
+        Expected *e = &games[id];
+        recorder_resume(&rec, &e->t.g, e->t.name[0], e->t.name[1]);
+        while (!test_game_over(&e->t.g) && e->count < MAX_MOVES) {
+            uint16_t mv = test_random_step(&e->t.g, NULL);
+            recorder_move(&rec, &e->t.g, mv);
+            e->moves[e->count++] = mv;
+        }
+        recorder_finish(&rec, &e->t.g, GAMELOG_FINISHED);
+    }
+    recorder_close(&rec);
+    gamelog_close(log);
+    timer_wheel_close(&wheel);
+    reactor_close(&reactor);
+
+    GameLogReader rd;
+    CHECK(gamelog_reader_open(&rd, path) == 0);
+    int before = 0, after = 0;
+    for (const GameLogRecord *r; (r = gamelog_reader_next(&rd));) {
+        CHECK(r->game_id >= 1 && r->game_id <= RESUMED);
+        if (r->game_id < 1 || r->game_id > RESUMED) continue;
+        Expected *e = &games[r->game_id];
+        uint32_t first = split[r->game_id];
+        GameSession g;
+        replay(&g, r);
+        if (!(r->flags & GAMELOG_CONTINUED)) {
+            before++;
+            CHECK(r->result == GAMELOG_UNFINISHED && r->turn == 0 && r->start_seq == 0);
+            CHECK(r->move_count == first && memcmp(gamelog_moves(r), e->moves, first * sizeof(uint16_t)) == 0);
+            CHECK(r->red == e->t.red && r->blue == e->t.blue);
+        } else {
+            after++;
+            CHECK(r->result == GAMELOG_FINISHED);
+            CHECK(r->turn == (first & 1) && r->start_seq == first);
+            CHECK(r->move_count == e->count - first);
+            CHECK(memcmp(gamelog_moves(r), e->moves + first, r->move_count * sizeof(uint16_t)) == 0);
+            CHECK(g.red == e->t.g.red && g.blue == e->t.g.blue);
+        }
+    }
+    gamelog_reader_close(&rd);
+    CHECK(before == RESUMED && after == RESUMED);
+}
+
+int main(void) {
+    char path[] = "/tmp/gamelog_testXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    srand(1);
+
+    record_games(path);
+    CHECK(read_games(path) == GAMES);
+    for (uint32_t id = 1; id <= GAMES; id++) CHECK(games[id].seen);
+
+    // 쓰다 만 레코드: 읽는 쪽은 거기서 멈추고, 다시 열면 잘라낸다
+    off_t valid = file_size(path);
+    GameLogRecord partial;
+    memset(&partial, 0, sizeof partial);
+    partial.magic = GAMELOG_RECORD_MAGIC;
+    partial.move_count = 10;
+    fd = open(path, O_WRONLY | O_APPEND);
+    CHECK(write(fd, &partial, sizeof partial) == (ssize_t)sizeof partial);
+    close(fd);
+    for (uint32_t id = 1; id <= GAMES; id++) games[id].seen = 0;
+    GameLogReader rd;
+    CHECK(gamelog_reader_open(&rd, path) == 0);
+    CHECK(gamelog_valid_length(rd.base, rd.len) == (size_t)valid);
+    int n = 0;
+    while (gamelog_reader_next(&rd)) n++;
+    CHECK(n == GAMES);
+    gamelog_reader_close(&rd);
+
+    GameLog *log = gamelog_open(path, GAMELOG_SYNC_BATCH, 0);
+    CHECK(log != NULL);
+    gamelog_close(log);
+    CHECK(file_size(path) == valid);
+    CHECK(read_games(path) == GAMES);
+
+    test_write_error(path);
+    test_resume(path);
+    unlink(path);
+    return test_report("gamelog_test");
+}
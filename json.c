@@ -1,21 +1,48 @@
 #include "../include/json.h"
+#include "../include/trace.h"
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <sys/uio.h>
 
 int send_json(int sockfd, const cJSON *json_msg)
 {
+    uint64_t t0 = trace_begin();
     char *json_str = cJSON_PrintUnformatted((cJSON*)json_msg);
     if (!json_str) return -1;
-    size_t len = strlen(json_str);
-    if (send(sockfd, json_str, len, 0) != (ssize_t)len) {
-        free(json_str);
-        return -1;
+
+    /* 본문과 '\n'을 한 번에 보내고, 부분 전송이면 남은 부분을 이어서 보낸다 */
+    struct iovec iov[2];
+    iov[0].iov_base = json_str;
+    iov[0].iov_len = strlen(json_str);
+    iov[1].iov_base = (void *)"\n";
+    iov[1].iov_len = 1;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof mh);
+    mh.msg_iov = iov;
+    mh.msg_iovlen = 2;
+
+    while (mh.msg_iovlen > 0) {
+        ssize_t n = sendmsg(sockfd, &mh, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            cJSON_free(json_str);
+            return -1;
+        }
+        while (mh.msg_iovlen > 0 && (size_t)n >= mh.msg_iov[0].iov_len) {
+            n -= mh.msg_iov[0].iov_len;
+            mh.msg_iov++;
+            mh.msg_iovlen--;
+        }
+        if (mh.msg_iovlen > 0) {
+            mh.msg_iov[0].iov_base = (char *)mh.msg_iov[0].iov_base + n;
+            mh.msg_iov[0].iov_len -= n;
+        }
     }
-    free(json_str);
-    if (send(sockfd, "\n", 1, 0) != 1)
-        return -1;
+    cJSON_free(json_str);
+    trace_end("send_json", t0);
     return 0;
 }
 
@@ -24,17 +51,21 @@ cJSON *recv_json(int sockfd)
     enum { BUF_SIZE = 4096 };
     static char buf[BUF_SIZE];
     static size_t buf_len = 0;
+    uint64_t t0 = trace_begin();   // 서버 응답을 기다린 시간까지 포함
 
     while (1) {
         char *newline = (char *)memchr(buf, '\n', buf_len);
         if (newline) {
             size_t msg_len = newline - buf;
             buf[msg_len] = '\0';
+            uint64_t t1 = trace_begin();
             cJSON *msg = cJSON_Parse(buf);
+            trace_end("parse", t1);
 
             size_t used = msg_len + 1;
             memmove(buf, buf + used, buf_len - used);
             buf_len -= used;
+            trace_end("recv_json", t0);
             return msg;
         }
 
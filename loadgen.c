@@ -0,0 +1,482 @@
+#include "../include/loadgen.h"
+#include "../include/net.h"
+#include "../include/timer.h"
+#include "../include/session.h"
+#include "../include/registry.h"
+#include "../include/wire.h"
+#include "../include/stats.h"
+#include "../include/arena.h"
+#include "../libs/cJSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+#define LOADGEN_RESUME_TRIES 6      // 서버가 끊김을 알아채기 전이면 nack: 20ms부터 두 배씩 쉬며 다시
+#define LOADGEN_RETRY_MS     20
+#define LOADGEN_RECONNECT_MS 100    // 접속 실패나 nack 뒤 새 이름으로 다시 접속하기까지
+#define LOADGEN_POLL_MS      100
+
+enum {
+    ERR_CONNECT,               // 접속 실패 (register_ack 전에 끊김 포함)
+    ERR_NACK,
+    ERR_INVALID,               // 서버가 invalid_move로 답한 수
+    ERR_TIMEOUT,               // 생각하는 동안 턴 시간이 지나 자동 pass
+    ERR_DROPPED,               // 서버가 먼저 끊음
+    ERR_RESUME,                // resume_token으로 돌아가지 못함
+    LG_ERRORS
+};
+static const char *const error_names[LG_ERRORS] = {
+    "connect", "register_nack", "invalid_move", "turn_timeout", "dropped", "resume_failed",
+};
+
+typedef struct {
+    uint64_t games;            // Red 자리에서 본 game_over (게임 하나를 한 번만 센다)
+    uint64_t turns;            // 보낸 move (pass 포함)
+    uint64_t disconnects;      // 일부러 끊은 횟수
+    uint64_t resumes;          // 그 뒤 자리에 돌아간 횟수
+    uint64_t errors[LG_ERRORS];
+} LgCounters;
+
+struct LgThread;
+
+typedef struct {
+    struct LgThread *t;
+    Conn *conn;                // 다시 접속하기를 기다리는 동안 NULL
+    Timer timer;               // 생각하는 시간, 또는 다시 접속하기까지
+    int idx;
+    unsigned gen;              // 새로 접속할 때마다 바꾸는 이름 접미사
+    char name[REGISTRY_NAME_MAX];
+    char token[17];
+    int registered;
+    int in_game;
+    int color;                 // 0 = Red
+    int thinking;              // move를 골라 두고 timer를 기다리는 중
+    int awaiting;              // move를 보내고 결과를 기다리는 중
+    int resuming;              // token으로 자리에 돌아가는 중 (tries: 그 사이 받은 nack 수)
+    int tries;
+    uint16_t move;
+    uint64_t sent_ns;
+} Bot;
+
+typedef struct LgThread {
+    pthread_t thread;
+    int id;
+    const LoadgenOptions *opt;
+    const struct sockaddr *addr;
+    socklen_t addrlen;
+    Reactor reactor;
+    TimerWheel wheel;
+    Bot *bots;
+    int nbots;
+    uint64_t rng;
+    LgCounters count;          // 이 스레드만 쓰고 주 스레드가 relaxed load로 읽는다
+    StatsHist turn;            // 스레드가 끝난 뒤에 합친다
+} LgThread;
+
+static int stopping;
+
+// 쓰는 스레드가 하나뿐이라 더해서 그대로 쓴다 (stats.c와 같은 방식)
+static inline void bump(uint64_t *p) {
+    __atomic_store_n(p, *p + 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t rng_next(LgThread *t) {
+    uint64_t x = t->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    t->rng = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+static double rng_unit(LgThread *t) {
+    return (double)(rng_next(t) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int is_clone(uint16_t mv) {
+    int src = mv >> 6, dst = mv & 63;
+    int dr = (src >> 3) - (dst >> 3), dc = (src & 7) - (dst & 7);
+    return dr >= -1 && dr <= 1 && dc >= -1 && dc <= 1;
+}
+
+// 복제를 먼저 골라 빈 칸을 채워 나가므로 게임이 끝난다 (점프만 주고받으면 끝나지 않을 수 있다)
+static uint16_t pick_move(LgThread *t, const GameSession *g, int color) {
+    uint16_t moves[SESSION_MAX_MOVES];
+    int n = session_moves(g, color, moves);
+    if (n == 0) return WIRE_MOVE_PASS;
+    int clones = 0;
+    while (clones < n && is_clone(moves[clones])) clones++;   // session_moves는 복제가 먼저
+    return moves[rng_next(t) % (uint64_t)(clones ? clones : n)];
+}
+
+/* ---- 봇 하나 ---- */
+
+static void bot_on_read(Conn *c);
+
+static void bot_close(Bot *b) {
+    timer_cancel(&b->timer);
+    if (b->conn) conn_free(b->conn);
+    b->conn = NULL;
+    b->registered = b->in_game = b->thinking = b->awaiting = 0;
+}
+
+static void bot_register(Bot *b) {
+    arena_begin();
+    cJSON *reg = cJSON_CreateObject();
+    cJSON_AddStringToObject(reg, "type", "register");
+    cJSON_AddStringToObject(reg, "username", b->name);
+    if (b->resuming) cJSON_AddStringToObject(reg, "resume_token", b->token);
+    conn_send_json(b->conn, reg);
+    cJSON_Delete(reg);
+    arena_end();
+}
+
+// non-blocking connect: register는 큐에 들어가 있다가 연결되면 EPOLLOUT에서 나간다
+static void bot_connect(Bot *b) {
+    LgThread *t = b->t;
+    if (!b->resuming) {
+        b->gen++;
+        snprintf(b->name, sizeof b->name, "lg%d-%d-%d-%u", (int)(getpid() % 100000), t->id, b->idx, b->gen);
+        b->token[0] = '\0';
+    }
+    int fd = socket(t->addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, t->addr, t->addrlen) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        fd = -1;
+    }
+    Conn *c = fd >= 0 ? conn_new(fd, &t->reactor, 0) : NULL;
+    if (!c) {
+        if (fd >= 0) close(fd);
+        bump(&t->count.errors[b->resuming ? ERR_RESUME : ERR_CONNECT]);
+        b->resuming = 0;
+        timer_arm(&t->wheel, &b->timer, LOADGEN_RECONNECT_MS);
+        return;
+    }
+    c->on_read = bot_on_read;
+    c->user = b;
+    b->conn = c;
+    bot_register(b);
+    if (c->dead) bot_on_read(c);   // 바로 거절되면 conn_send가 끊고 epoll 이벤트는 오지 않는다
+}
+
+static void bot_reconnect_later(Bot *b, uint32_t ms) {
+    bot_close(b);
+    timer_arm(&b->t->wheel, &b->timer, ms);
+}
+
+static void bot_send_move(Bot *b) {
+    int r1 = 0, c1 = 0, r2 = 0, c2 = 0;   // 모두 0이면 pass
+    if (b->move != WIRE_MOVE_PASS) {
+        wire_move_coords(b->move, &r1, &c1, &r2, &c2);
+        r1++, c1++, r2++, c2++;
+    }
+    arena_begin();
+    cJSON *mv = cJSON_CreateObject();
+    cJSON_AddStringToObject(mv, "type", "move");
+    cJSON_AddStringToObject(mv, "username", b->name);
+    cJSON_AddNumberToObject(mv, "sx", r1);
+    cJSON_AddNumberToObject(mv, "sy", c1);
+    cJSON_AddNumberToObject(mv, "tx", r2);
+    cJSON_AddNumberToObject(mv, "ty", c2);
+    b->sent_ns = stats_clock_ns();
+    conn_send_json(b->conn, mv);
+    cJSON_Delete(mv);
+    arena_end();
+    b->awaiting = 1;
+    bump(&b->t->count.turns);
+}
+
+static void bot_on_timer(Timer *tm, void *arg) {
+    Bot *b = (Bot *)arg;
+    (void)tm;
+    if (!b->conn) {
+        bot_connect(b);
+    } else if (b->thinking) {
+        b->thinking = 0;
+        bot_send_move(b);
+    }
+}
+
+// 연결을 닫았으면 -1
+static int bot_turn(Bot *b, const cJSON *msg) {
+    LgThread *t = b->t;
+    if (t->opt->disconnect > 0 && b->token[0] && rng_unit(t) < t->opt->disconnect) {
+        bump(&t->count.disconnects);
+        b->resuming = 1;
+        b->tries = 0;
+        bot_reconnect_later(b, LOADGEN_RETRY_MS);
+        return -1;
+    }
+    const cJSON *jboard = cJSON_GetObjectItem(msg, "board");
+    if (!cJSON_IsArray(jboard)) return 0;
+    char board[BOARD_SIZE][BOARD_SIZE];
+    memset(board, '.', sizeof board);
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        const cJSON *row = cJSON_GetArrayItem(jboard, i);
+        if (cJSON_IsString(row) && strlen(row->valuestring) >= BOARD_SIZE) memcpy(board[i], row->valuestring, BOARD_SIZE);
+    }
+    GameSession g;
+    session_from_board(&g, board);
+    b->move = pick_move(t, &g, b->color);
+    int think = t->opt->think_ms;
+    if (think > 0) {
+        b->thinking = 1;
+        timer_arm(&t->wheel, &b->timer, (uint32_t)(think / 2 + (int)(rng_next(t) % (uint64_t)(think + 1))));
+        return 0;
+    }
+    bot_send_move(b);
+    return 0;
+}
+
+static int bot_handle(Bot *b, const cJSON *msg) {
+    LgThread *t = b->t;
+    const cJSON *jtype = cJSON_GetObjectItem(msg, "type");
+    if (!cJSON_IsString(jtype)) return 0;
+    const char *type = jtype->valuestring;
+    if (strcmp(type, "your_turn") == 0) return bot_turn(b, msg);
+    if (strcmp(type, "move_ok") == 0 || strcmp(type, "invalid_move") == 0 || strcmp(type, "pass") == 0) {
+        if (b->awaiting) {
+            stats_hist_add(&t->turn, stats_clock_ns() - b->sent_ns);
+            b->awaiting = 0;
+            if (type[0] == 'i') bump(&t->count.errors[ERR_INVALID]);
+        } else if (b->thinking) {
+            // 내 차례에 온 결과: 생각하는 동안 턴 시간이 지나 서버가 pass시켰다
+            timer_cancel(&b->timer);
+            b->thinking = 0;
+            bump(&t->count.errors[ERR_TIMEOUT]);
+        }
+        return 0;
+    }
+    if (strcmp(type, "game_start") == 0) {
+        const cJSON *p0 = cJSON_GetArrayItem(cJSON_GetObjectItem(msg, "players"), 0);
+        b->color = cJSON_IsString(p0) && strcmp(p0->valuestring, b->name) == 0 ? 0 : 1;
+        b->in_game = 1;
+        b->awaiting = b->thinking = 0;
+        if (cJSON_IsTrue(cJSON_GetObjectItem(msg, "resumed"))) bump(&t->count.resumes);
+        b->resuming = 0;
+        return 0;
+    }
+    if (strcmp(type, "game_over") == 0) {
+        if (b->in_game && b->color == 0) bump(&t->count.games);
+        timer_cancel(&b->timer);
+        b->in_game = b->thinking = b->awaiting = 0;
+        return 0;     // 서버가 다시 대기열에 넣는다
+    }
+    if (strcmp(type, "register_ack") == 0) {
+        const cJSON *jtoken = cJSON_GetObjectItem(msg, "resume_token");
+        if (cJSON_IsString(jtoken)) snprintf(b->token, sizeof b->token, "%s", jtoken->valuestring);
+        b->registered = 1;
+        return 0;
+    }
+    if (strcmp(type, "register_nack") == 0) {
+        // 서버가 아직 끊김을 모르면 이름이 살아 있어 nack: 조금 쉬었다가 다시
+        if (b->resuming && ++b->tries < LOADGEN_RESUME_TRIES) {
+            bot_reconnect_later(b, (uint32_t)LOADGEN_RETRY_MS << b->tries);
+            return -1;
+        }
+        bump(&t->count.errors[b->resuming ? ERR_RESUME : ERR_NACK]);
+        b->resuming = 0;
+        bot_reconnect_later(b, LOADGEN_RECONNECT_MS);
+        return -1;
+    }
+    return 0;
+}
+
+static void bot_on_read(Conn *c) {
+    Bot *b = (Bot *)c->user;
+    LgThread *t = b->t;
+    cJSON *msg;
+    // 끊긴 뒤에도 이미 받은 줄(nack 등)은 먼저 처리한다
+    while ((msg = conn_next_json(c)) != NULL) {
+        arena_begin();
+        int rc = bot_handle(b, msg);
+        cJSON_Delete(msg);
+        arena_end();
+        if (rc < 0) return;
+    }
+    if (!c->dead) return;
+    if (b->resuming) {
+        bump(&t->count.errors[ERR_RESUME]);
+        b->resuming = 0;
+    } else if (!b->registered) {
+        bump(&t->count.errors[ERR_CONNECT]);
+    } else {
+        bump(&t->count.errors[ERR_DROPPED]);
+        // 게임 중이었으면 실제 클라이언트처럼 자리로 돌아가 본다
+        if (b->in_game && b->token[0]) {
+            b->resuming = 1;
+            b->tries = 0;
+            bot_reconnect_later(b, LOADGEN_RETRY_MS);
+            return;
+        }
+    }
+    bot_reconnect_later(b, LOADGEN_RECONNECT_MS);
+}
+
+/* ---- 스레드와 집계 ---- */
+
+static void *thread_main(void *arg) {
+    LgThread *t = (LgThread *)arg;
+    for (int i = 0; i < t->nbots; i++) bot_connect(&t->bots[i]);
+    while (!__atomic_load_n(&stopping, __ATOMIC_RELAXED)) reactor_poll(&t->reactor, LOADGEN_POLL_MS);
+    for (int i = 0; i < t->nbots; i++) bot_close(&t->bots[i]);
+    return NULL;
+}
+
+static void sum_counters(LgThread *ts, int n, LgCounters *sum) {
+    memset(sum, 0, sizeof *sum);
+    for (int i = 0; i < n; i++) {
+        const uint64_t *src = (const uint64_t *)&ts[i].count;
+        uint64_t *dst = (uint64_t *)sum;
+        for (size_t k = 0; k < sizeof(LgCounters) / sizeof(uint64_t); k++) dst[k] += __atomic_load_n(&src[k], __ATOMIC_RELAXED);
+    }
+}
+
+static uint64_t error_total(const LgCounters *c) {
+    uint64_t n = 0;
+    for (int e = 0; e < LG_ERRORS; e++) n += c->errors[e];
+    return n;
+}
+
+// 연결마다 fd 하나: 소프트 한도가 모자라면 하드 한도까지 올린다
+static void raise_fd_limit(int conns) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) < 0 || rl.rlim_cur >= (rlim_t)conns + 64) return;
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)conns + 64) {
+        fprintf(stderr, "loadgen: open file limit %llu is too low for %d connections\n",
+                (unsigned long long)rl.rlim_cur, conns);
+    }
+}
+
+void loadgen_options_init(LoadgenOptions *opt) {
+    opt->host = "127.0.0.1";
+    opt->port = NULL;
+    opt->conns = 100;
+    opt->threads = 0;
+    opt->seconds = 10;
+    opt->games = 0;
+    opt->think_ms = 0;
+    opt->disconnect = 0;
+    opt->seed = 1;
+}
+
+int loadgen_run(const LoadgenOptions *opt) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int rc = getaddrinfo(opt->host, opt->port, &hints, &res);
+    if (rc != 0) {
+        fprintf(stderr, "loadgen: %s:%s: %s\n", opt->host, opt->port, gai_strerror(rc));
+        return -1;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addrlen = res->ai_addrlen;
+    memcpy(&addr, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+
+    int conns = opt->conns > 0 ? opt->conns : 1;
+    int nthreads = opt->threads > 0 ? opt->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > conns) nthreads = conns;
+    raise_fd_limit(conns);
+
+    LgThread *ts = (LgThread *)calloc((size_t)nthreads, sizeof(LgThread));
+    Bot *bots = (Bot *)calloc((size_t)conns, sizeof(Bot));
+    if (!ts || !bots) {
+        free(ts);
+        free(bots);
+        return -1;
+    }
+    __atomic_store_n(&stopping, 0, __ATOMIC_RELAXED);
+    int started = 0, next_bot = 0;
+    for (int i = 0; i < nthreads; i++) {
+        LgThread *t = &ts[i];
+        t->id = i;
+        t->opt = opt;
+        t->addr = (const struct sockaddr *)&addr;
+        t->addrlen = addrlen;
+        t->rng = ((uint64_t)opt->seed + 1) * 0x9E3779B97F4A7C15ull ^ ((uint64_t)i + 1) * 0xff51afd7ed558ccdull;
+        if (t->rng == 0) t->rng = 1;
+        t->bots = bots + next_bot;
+        t->nbots = conns / nthreads + (i < conns % nthreads);
+        for (int k = 0; k < t->nbots; k++) {
+            Bot *b = &t->bots[k];
+            b->t = t;
+            b->idx = k;
+            timer_init(&b->timer, bot_on_timer, b);
+        }
+        next_bot += t->nbots;
+        if (reactor_init(&t->reactor) < 0) break;
+        if (timer_wheel_init(&t->wheel, &t->reactor) < 0) {
+            reactor_close(&t->reactor);
+            break;
+        }
+        if (pthread_create(&t->thread, NULL, thread_main, t) != 0) {
+            perror("pthread_create");
+            timer_wheel_close(&t->wheel);
+            reactor_close(&t->reactor);
+            break;
+        }
+        started++;
+    }
+    fprintf(stderr, "loadgen: %d connections on %d threads to %s:%s\n", conns, started, opt->host, opt->port);
+
+    uint64_t start = stats_clock_ns(), last = start, end = start;
+    LgCounters prev, cur;
+    memset(&prev, 0, sizeof prev);
+    while (started == nthreads) {
+        usleep(LOADGEN_POLL_MS * 1000);
+        end = stats_clock_ns();
+        sum_counters(ts, started, &cur);
+        int done = end - start >= (uint64_t)opt->seconds * 1000000000ull || (opt->games > 0 && cur.games >= (uint64_t)opt->games);
+        if (end - last >= 1000000000ull || done) {
+            double dt = (double)(end - last) / 1e9;
+            fprintf(stderr, "%6.1fs  games %llu (%.0f/s)  turns %.0f/s  disconnects %llu  errors %llu\n",
+                    (double)(end - start) / 1e9, (unsigned long long)cur.games,
+                    (double)(cur.games - prev.games) / dt, (double)(cur.turns - prev.turns) / dt,
+                    (unsigned long long)cur.disconnects, (unsigned long long)error_total(&cur));
+            prev = cur;
+            last = end;
+        }
+        if (done) break;
+    }
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELAXED);
+    StatsHist *turn = (StatsHist *)calloc(1, sizeof(StatsHist));
+    for (int i = 0; i < started; i++) {
+        pthread_join(ts[i].thread, NULL);
+        timer_wheel_close(&ts[i].wheel);
+        reactor_close(&ts[i].reactor);
+        if (turn) stats_hist_merge(turn, &ts[i].turn);
+    }
+    int ok = started == nthreads && turn;
+    if (ok) {
+        sum_counters(ts, started, &cur);
+        double secs = (double)(end - start) / 1e9;
+        printf("{\"conns\":%d,\"threads\":%d,\"seconds\":%.3f,\"games\":%llu,\"games_per_sec\":%.1f,"
+               "\"turns\":%llu,\"turns_per_sec\":%.1f,\"disconnects\":%llu,\"resumes\":%llu,",
+               conns, started, secs, (unsigned long long)cur.games, (double)cur.games / secs,
+               (unsigned long long)cur.turns, (double)cur.turns / secs,
+               (unsigned long long)cur.disconnects, (unsigned long long)cur.resumes);
+        printf("\"turn_latency_us\":{\"count\":%llu,\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f},",
+               (unsigned long long)turn->total, turn->total ? (double)turn->sum / (double)turn->total / 1e3 : 0.0,
+               (double)stats_hist_percentile(turn, 0.5) / 1e3, (double)stats_hist_percentile(turn, 0.9) / 1e3,
+               (double)stats_hist_percentile(turn, 0.99) / 1e3, (double)stats_hist_percentile(turn, 0.999) / 1e3,
+               (double)turn->max / 1e3);
+        printf("\"errors\":{");
+        for (int e = 0; e < LG_ERRORS; e++) printf("\"%s\":%llu,", error_names[e], (unsigned long long)cur.errors[e]);
+        printf("\"total\":%llu}}\n", (unsigned long long)error_total(&cur));
+    }
+    free(turn);
+    free(bots);
+    free(ts);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,31 @@
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+/*
+ * hw3 loadgen: 봇 연결 N개를 스레드(코어)마다 epoll reactor 하나에 나눠 싣고 실제 JSON 프로토콜
+ * (register → game_start → your_turn → move)로 끝없이 게임을 둔다. 게임이 끝나면 서버가 다시
+ * 대기열에 넣어 주므로 연결은 그대로 다음 게임을 받는다.
+ *
+ * 수는 bitboard로 바로 고른다 (복제가 있으면 그중 하나, 없으면 점프, 둘 다 없으면 pass).
+ * 무작위 선택은 seed로 정해지므로 같은 옵션이면 같은 수열을 둔다.
+ *
+ * 1초마다 진행 상황을 stderr에, 끝나면 한 줄 JSON 요약을 stdout에 쓴다.
+ * 턴 지연은 move를 보낸 뒤 그 결과(move_ok/invalid_move/pass)를 받을 때까지 (stats.h 히스토그램).
+ */
+typedef struct {
+    const char *host;
+    const char *port;
+    int conns;             // 동시 연결 수
+    int threads;           // 0이면 코어 수
+    int seconds;           // 이만큼 돌고 멈춘다
+    long games;            // 0이 아니면 끝난 게임이 이만큼 되면 먼저 멈춘다
+    int think_ms;          // your_turn을 받고 move를 보내기까지 평균 (0.5~1.5배 사이 무작위)
+    double disconnect;     // 차례마다 연결을 끊었다가 resume_token으로 돌아올 확률
+    unsigned seed;
+} LoadgenOptions;
+
+void loadgen_options_init(LoadgenOptions *opt);
+// 서버 주소를 못 찾거나 스레드를 못 띄우면 -1
+int loadgen_run(const LoadgenOptions *opt);
+
+#endif
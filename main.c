@@ -7,11 +7,70 @@
 #include "../include/server.h"
 #include "../include/client.h"
 #include "../include/board.h"
+#include "../include/arena.h"
+#include "../include/session.h"
+#include "../include/gamelog.h"
+#include "../include/analyze.h"
+#include "../include/posdb.h"
+#include "../include/stats.h"
+#include "../include/trace.h"
+#include "../include/loadgen.h"
+#include "../include/bench.h"
 
 static void print_usage(const char *prog) {
     printf("Usage:\n");
-    printf("  %s server -p <port>\n", prog);
-    printf("  %s client -i <ip> -p <port> -u <username> [LED options]\n\n", prog);
+    printf("  %s server -p <port> [-w <bytes>] [-b <backlog>] [-t <threads>] [-r <width>] [-U <path>] [-e epoll|io_uring] [-l <file> [--log-sync none|batch|<ms>]] [--checkpoint <file>] [--grace <sec>] [-S <path|port>] [-T <file>]\n", prog);
+    printf("  %s client (-i <ip> -p <port> | -U <path>) -u <username> [--delta] [-c] [-P] [-D <db>] [-T <file>] [--think <ms>] [--binary | -m] [LED options]\n", prog);
+    printf("  %s bench sessions [count]          게임 세션 count개(기본 100000)의 메모리 사용량 측정\n", prog);
+    printf("  %s bench turns [--games <n>] [-p <port>] [-t <threads>] [-f json|csv]\n"
+           "                                   서버와 클라이언트 둘을 한 프로세스에서 loopback으로 붙여 턴 지연을 단계별로 잰다\n", prog);
+    printf("  %s log <file> [-v]                 게임 로그를 한 게임에 한 줄씩 출력 (-v: 수까지)\n", prog);
+    printf("  %s analyze <file> [-t <threads>] [--depth <d>] [--blunder <loss>] [--top <k>] [-f jsonl|csv]\n", prog);
+    printf("  %s posdb import <db> <log>... [--depth <d>]  로그의 국면을 위치 DB에 더한다 (이미 가져온 게임은 건너뜀)\n", prog);
+    printf("  %s posdb stats <db>                항목 수, 채움률, 탐침 길이\n", prog);
+    printf("  %s posdb lookup <db> <board> R|B   board: 행 우선 64글자 (R, B, #, .)\n", prog);
+    printf("  %s stats <path|port> [json|prometheus]  서버(-S)의 지연 시간 히스토그램과 카운터를 받아 출력\n", prog);
+    printf("  %s loadgen -p <port> [-i <ip>] [-n <conns>] [-t <threads>] [--duration <sec>] [--games <n>] [--think <ms>] [-x <rate>] [--seed <n>]\n\n", prog);
+    printf("Server options:\n");
+    printf("  -w <bytes>                       연결당 출력 큐 상한, 넘으면 느린 클라이언트를 끊음 (기본 262144)\n");
+    printf("  -b <backlog>                     listen backlog (기본 4096)\n");
+    printf("  -t <threads>                     reactor 스레드 수, SO_REUSEPORT로 포트 공유 (기본: 코어 수)\n");
+    printf("  -r <width>                       register의 rating을 이 폭으로 나눈 구간끼리만 매칭 (기본 0: 구분 없음)\n");
+    printf("  -U <path>                        같은 호스트 클라이언트용 unix 소켓도 연다\n");
+    printf("  -e epoll|io_uring                이벤트 백엔드 (기본 epoll, io_uring이 안 되면 epoll로 돌아감)\n");
+    printf("  -l <file>                        게임 기록을 이 파일에 덧붙인다 (바이너리, hw3 log로 읽음)\n");
+    printf("  --log-sync none|batch|<ms>       로그 fdatasync: 안 함 | 쓸 때마다 | ms 간격 (기본 1000)\n");
+    printf("  --checkpoint <file>              진행 중인 게임을 턴마다 이 파일에 남기고, 시작할 때 되살린다\n");
+    printf("                                   (되살린 게임에는 같은 username과 resume_token으로 register하면 다시 앉는다)\n");
+    printf("  --grace <sec>                    게임 중 끊긴 플레이어가 resume_token으로 돌아올 때까지 자리를 지킨다 (기본 15, 0: 바로 끝냄)\n");
+    printf("  -S <path|port>                   지연 시간/카운터를 unix 소켓이나 127.0.0.1:port HTTP로 내준다\n");
+    printf("                                   (GET /metrics: Prometheus, GET /stats: JSON)\n");
+    printf("  -T <file>                        단계별 구간을 Chrome trace-event JSON으로 덧붙인다 (클라이언트도 같은 옵션)\n\n");
+    printf("Client options:\n");
+    printf("  --delta                          보드 전체 대신 변경분(delta)만 받는다\n");
+    printf("  -c                               차례를 여는 결과 메시지가 your_turn을 겸하게 한다 (JSON)\n");
+    printf("  -P                               상대 수를 예상해 premove를 미리 보낸다 (JSON)\n");
+    printf("  -D <db>                          위치 DB(hw3 posdb)에 있는 국면이면 그 best 수를 둔다\n");
+    printf("  -T <file>                        recv_json/parse/generate_move/send_json 구간을 trace 파일에 덧붙인다\n");
+    printf("  --think <ms>                     수를 두기 전에 쉬는 시간 (기본 2000, 0: 바로 둔다)\n");
+    printf("  --binary                         JSON 대신 바이너리 프로토콜로 접속\n");
+    printf("  -U <path>                        TCP 대신 서버의 unix 소켓으로 접속\n");
+    printf("  -m                               -U와 함께: 공유 메모리 링으로 주고받는다 (바이너리 프로토콜)\n\n");
+    printf("Analyze options:\n");
+    printf("  -t <threads>                     로그를 나눠 맡을 스레드 수 (기본: 코어 수)\n");
+    printf("  --depth <d>                      국면마다 이 깊이로 탐색해 정확도/blunder를 잰다 (기본 0: 안 함)\n");
+    printf("  --blunder <loss>                 최선 수보다 말 loss개 이상 손해면 blunder (기본 4)\n");
+    printf("  --top <k>                        많이 나온 국면을 이만큼 출력 (기본 20)\n");
+    printf("  -f jsonl|csv                     출력 형식 (기본 jsonl, 처리량은 stderr에도)\n\n");
+    printf("Loadgen options:\n");
+    printf("  -n <conns>                       동시에 게임을 두는 봇 연결 수 (기본 100)\n");
+    printf("  -t <threads>                     epoll 스레드 수 (기본: 코어 수)\n");
+    printf("  --duration <sec> / --games <n>   이만큼 돌거나 게임이 이만큼 끝나면 멈춘다 (기본 10초)\n");
+    printf("  --think <ms>                     수를 보내기 전 생각하는 시간 평균 (기본 0)\n");
+    printf("  -x <rate>                        차례마다 끊었다가 resume_token으로 돌아올 확률 (기본 0)\n");
+    printf("  --seed <n>                       수 선택 난수 seed (기본 1)\n");
+    printf("                                   (1초마다 stderr에 진행, 끝나면 stdout에 JSON 한 줄:\n");
+    printf("                                    games/s, move→결과 지연 p50/p90/p99/p999, 에러 종류별 수)\n\n");
     printf("LED options (client 모드일 때만):\n");
     printf("  --led-rows=<rows>                (예: --led-rows=64)\n");
     printf("  --led-cols=<cols>                (예: --led-cols=64)\n");
@@ -24,12 +83,22 @@ static void print_usage(const char *prog) {
     printf("\n");
 }
 
+// 모르는 옵션이나 값이 빠진 옵션은 무시하지 않고 실패한다
+static int bad_option(const char *prog, const char *opt) {
+    fprintf(stderr, "Unknown option or missing value: %s\n", opt);
+    print_usage(prog);
+    return EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[]) {
     if (argc < 2) {
         print_usage(argv[0]);
         return EXIT_FAILURE;
     }
 
+    // cJSON 할당을 스레드 로컬 arena로 돌린다 (server/client 공통)
+    arena_install_cjson_hooks();
+
     // 첫 번째 인자가 "server"인지 "client"인지 판단
     if (strcmp(argv[1], "server") == 0) {
         // ----- Server 모드 -----
@@ -37,12 +106,62 @@ int main(int argc, char *argv[]) {
             print_usage(argv[0]);
             return EXIT_FAILURE;
         }
-        const char *port_str = argv[3];
-        return server_run(port_str);
+        ServerConfig cfg;
+        server_config_init(&cfg);
+        cfg.port = argv[3];
+        for (int i = 4; i < argc; i++) {
+            if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+                cfg.out_high_water = strtoul(argv[++i], NULL, 10);
+            }
+            else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+                cfg.backlog = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+                cfg.threads = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+                cfg.rating_bucket = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-U") == 0 && i + 1 < argc) {
+                cfg.unix_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+                cfg.io_uring = strcmp(argv[++i], "io_uring") == 0;
+            }
+            else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+                cfg.log_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--log-sync") == 0 && i + 1 < argc) {
+                const char *sync = argv[++i];
+                if (strcmp(sync, "none") == 0) cfg.log_sync = GAMELOG_SYNC_NONE;
+                else if (strcmp(sync, "batch") == 0) cfg.log_sync = GAMELOG_SYNC_BATCH;
+                else {
+                    cfg.log_sync = GAMELOG_SYNC_INTERVAL;
+                    cfg.log_sync_ms = atoi(sync);
+                }
+            }
+            else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+                cfg.checkpoint_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--grace") == 0 && i + 1 < argc) {
+                cfg.resume_grace = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+                cfg.stats_addr = argv[++i];
+            }
+            else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+                cfg.trace_path = argv[++i];
+            }
+            else if (strncmp(argv[i], "--led-", 6) != 0) {
+                // LED 옵션은 클라이언트와 같은 명령줄을 쓸 수 있게 예전처럼 받아서 버린다
+                return bad_option(argv[0], argv[i]);
+            }
+        }
+        return server_run_config(&cfg);
     }
     else if (strcmp(argv[1], "client") == 0) {
         // ----- Client 모드 (LED 제어 포함) -----
-        if (argc < 8) {
+        if (argc < 6) {
             print_usage(argv[0]);
             return EXIT_FAILURE;
         }
@@ -51,6 +170,13 @@ int main(int argc, char *argv[]) {
         const char *server_ip = NULL;
         const char *server_port = NULL;
         const char *username = NULL;
+        int delta = 0;
+        int combined = 0;
+        int premove = 0;
+        int binary = 0;
+        int shm = 0;
+        const char *unix_path = NULL;
+        const char *trace_path = NULL;
         int idx = 2;
         while (idx < argc && argv[idx][0] == '-') {
             if (strcmp(argv[idx], "-i") == 0 && idx + 1 < argc) {
@@ -65,13 +191,57 @@ int main(int argc, char *argv[]) {
                 username = argv[idx + 1];
                 idx += 2;
             }
-            else {
+            else if (strcmp(argv[idx], "--delta") == 0) {
+                delta = 1;
+                idx += 1;
+            }
+            else if (strcmp(argv[idx], "-c") == 0) {
+                combined = 1;
+                idx += 1;
+            }
+            else if (strcmp(argv[idx], "-P") == 0) {
+                premove = 1;
+                idx += 1;
+            }
+            else if (strcmp(argv[idx], "-D") == 0 && idx + 1 < argc) {
+                if (client_set_posdb(argv[idx + 1]) < 0) return EXIT_FAILURE;
+                idx += 2;
+            }
+            else if (strcmp(argv[idx], "--binary") == 0) {
+                binary = 1;
+                idx += 1;
+            }
+            else if (strcmp(argv[idx], "-U") == 0 && idx + 1 < argc) {
+                unix_path = argv[idx + 1];
+                idx += 2;
+            }
+            else if (strcmp(argv[idx], "-m") == 0) {
+                shm = binary = 1;
+                idx += 1;
+            }
+            else if (strcmp(argv[idx], "-T") == 0 && idx + 1 < argc) {
+                trace_path = argv[idx + 1];
+                idx += 2;
+            }
+            else if (strcmp(argv[idx], "--think") == 0 && idx + 1 < argc) {
+                client_set_think_ms(atoi(argv[idx + 1]));
+                idx += 2;
+            }
+            else if (strncmp(argv[idx], "--led-", 6) == 0) {
                 // LED 옵션 시작 지점
                 break;
             }
+            else {
+                return bad_option(argv[0], argv[idx]);
+            }
         }
 
-        if (!server_ip || !server_port || !username) {
+        if (unix_path) {
+            // 에러 메시지에 "unix:<path>"로 보이도록
+            server_ip = "unix";
+            server_port = unix_path;
+        }
+        if (!server_ip || !server_port || !username || (shm && !unix_path)) {
             print_usage(argv[0]);
             return EXIT_FAILURE;
         }
@@ -95,12 +265,124 @@ int main(int argc, char *argv[]) {
         free(led_argv);
 
         // *** TA 서버 및 로컬 서버 대응용 게임 진행 ***
-        int ret = client_run(server_ip, server_port, username);
+        client_set_transport(unix_path, shm);
+        client_set_combined(combined);
+        client_set_premove(premove);
+        if (trace_path) {
+            char process[64];
+            snprintf(process, sizeof process, "client %s", username);
+            if (trace_open(trace_path, process) < 0) return EXIT_FAILURE;
+        }
+        int ret = binary ? client_run_binary(server_ip, server_port, username)
+                         : client_run_delta(server_ip, server_port, username, delta);
+        trace_close();
 
         // *** LED 매트릭스 자원 해제 ***
         close_led_matrix();
         return ret;
     }
+    else if (strcmp(argv[1], "bench") == 0 && argc >= 3 && strcmp(argv[2], "sessions") == 0) {
+        size_t n = argc >= 4 ? strtoul(argv[3], NULL, 10) : 100000;
+        return session_bench(n) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (strcmp(argv[1], "bench") == 0 && argc >= 3 && strcmp(argv[2], "turns") == 0) {
+        TurnBenchOptions opt;
+        turn_bench_options_init(&opt);
+        for (int i = 3; i < argc; i++) {
+            if (i + 1 >= argc) return bad_option(argv[0], argv[i]);
+            if (strcmp(argv[i], "--games") == 0) opt.games = atoi(argv[++i]);
+            else if (strcmp(argv[i], "-p") == 0) opt.port = argv[++i];
+            else if (strcmp(argv[i], "-t") == 0) opt.threads = atoi(argv[++i]);
+            else if (strcmp(argv[i], "-f") == 0) opt.csv = strcmp(argv[++i], "csv") == 0;
+            else return bad_option(argv[0], argv[i]);
+        }
+        return turn_bench_run(&opt) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (strcmp(argv[1], "log") == 0 && argc >= 3) {
+        int verbose = argc >= 4 && strcmp(argv[3], "-v") == 0;
+        if (argc > 4 || (argc == 4 && !verbose)) return bad_option(argv[0], argv[argc - 1]);
+        return gamelog_dump(argv[2], verbose) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (strcmp(argv[1], "analyze") == 0 && argc >= 3) {
+        AnalyzeOptions opt;
+        analyze_options_init(&opt);
+        for (int i = 3; i < argc; i++) {
+            if (i + 1 >= argc) return bad_option(argv[0], argv[i]);
+            if (strcmp(argv[i], "-t") == 0) opt.threads = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--depth") == 0) opt.depth = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--blunder") == 0) opt.blunder = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--top") == 0) opt.top = atoi(argv[++i]);
+            else if (strcmp(argv[i], "-f") == 0) opt.csv = strcmp(argv[++i], "csv") == 0;
+            else return bad_option(argv[0], argv[i]);
+        }
+        return analyze_run(argv[2], &opt) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (strcmp(argv[1], "posdb") == 0 && argc >= 4) {
+        PosDb db;
+        if (strcmp(argv[2], "import") == 0 && argc >= 5) {
+            int depth = 0;
+            for (int i = 4; i < argc; i++) {
+                if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) depth = atoi(argv[++i]);
+                else if (argv[i][0] == '-') return bad_option(argv[0], argv[i]);
+            }
+            if (posdb_open(&db, argv[3], 1) < 0) return EXIT_FAILURE;
+            int ret = EXIT_SUCCESS;
+            for (int i = 4; i < argc; i++) {
+                if (strcmp(argv[i], "--depth") == 0) {
+                    i++;
+                    continue;
+                }
+                long n = posdb_import(&db, argv[i], depth);
+                if (n < 0) ret = EXIT_FAILURE;
+                else printf("%s: %ld games\n", argv[i], n);
+            }
+            posdb_close(&db);
+            return ret;
+        }
+        if (strcmp(argv[2], "stats") == 0) {
+            if (posdb_open(&db, argv[3], 0) < 0) return EXIT_FAILURE;
+            posdb_print_stats(&db);
+            posdb_close(&db);
+            return EXIT_SUCCESS;
+        }
+        if (strcmp(argv[2], "lookup") == 0 && argc >= 6 && strlen(argv[4]) == BOARD_SIZE * BOARD_SIZE) {
+            char board[BOARD_SIZE][BOARD_SIZE];
+            GameSession g;
+            memcpy(board, argv[4], sizeof board);
+            session_from_board(&g, board);
+            if (posdb_open(&db, argv[3], 0) < 0) return EXIT_FAILURE;
+            int ret = posdb_print_lookup(&db, &g, argv[5][0] == 'B') == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+            posdb_close(&db);
+            return ret;
+        }
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    else if (strcmp(argv[1], "loadgen") == 0) {
+        LoadgenOptions opt;
+        loadgen_options_init(&opt);
+        for (int i = 2; i < argc; i++) {
+            if (i + 1 >= argc) return bad_option(argv[0], argv[i]);
+            if (strcmp(argv[i], "-i") == 0) opt.host = argv[++i];
+            else if (strcmp(argv[i], "-p") == 0) opt.port = argv[++i];
+            else if (strcmp(argv[i], "-n") == 0) opt.conns = atoi(argv[++i]);
+            else if (strcmp(argv[i], "-t") == 0) opt.threads = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--duration") == 0) opt.seconds = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--games") == 0) opt.games = atol(argv[++i]);
+            else if (strcmp(argv[i], "--think") == 0) opt.think_ms = atoi(argv[++i]);
+            else if (strcmp(argv[i], "-x") == 0) opt.disconnect = atof(argv[++i]);
+            else if (strcmp(argv[i], "--seed") == 0) opt.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+            else return bad_option(argv[0], argv[i]);
+        }
+        if (!opt.port) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        return loadgen_run(&opt) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (strcmp(argv[1], "stats") == 0 && argc >= 3) {
+        return stats_query(argv[2], argc >= 4 ? argv[3] : "json") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
     else {
         // "server"나 "client" 이외의 첫 번째 인자가 들어왔을 경우
         print_usage(argv[0]);
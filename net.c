@@ -0,0 +1,1279 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // accept4
+#endif
+#include "../include/net.h"
+#include "../include/uring.h"
+#include "../include/stats.h"
+#include "../include/trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define NET_MAX_EVENTS 64
+#define NET_MAX_IOV    64
+#define NETBUF_MAX     (64 * 1024)
+
+#define RING_ENTRIES   1024
+#define RING_BUFS      256            // provided buffer 수 (2의 거듭제곱)
+#define RING_BUF_SIZE  4096
+#define RING_BATCH     256            // reactor_poll 한 번에 꺼내는 완료 수
+#define CONN_SPILL_MAX (64 * 1024)    // 처리 못 한 입력이 이만큼 쌓이면 recv를 멈춘다
+
+// io_uring user_data 하위 3비트: 어떤 요청의 완료인지 (0이면 결과를 버리는 요청)
+enum { OP_NONE, OP_POLL, OP_RECV, OP_SEND, OP_KICK, OP_ACCEPT };
+#define OP_MASK 7u
+
+#if URING_AVAILABLE
+// epoll 흉내: fd마다 한 번짜리 poll 요청을 걸고, 디스패치가 끝나면 다시 건다 (level-triggered와 같다)
+// gen이 다르면 지워졌거나 다시 등록된 fd의 늦은 완료라 버린다
+typedef struct {
+    NetHandler *h;
+    uint32_t events;
+    uint32_t gen;
+    int armed;
+} PollSlot;
+
+struct ReactorRing {
+    Uring u;
+    PollSlot *slots;                  // fd로 찾는다
+    int nslots;
+    struct io_uring_cqe *batch;       // 디스패치 중인 완료 (detach가 자기 몫을 먼저 반영하고 지운다)
+    unsigned batch_len;
+    struct io_uring_cqe *stash;       // detach가 기다리는 동안 꺼낸 남의 완료 (다음 poll에서 처리)
+    unsigned stash_len, stash_cap;
+    Conn **starved;                   // provided buffer가 모자라 멈춘 recv (poll 끝에서 다시 건다)
+    int starved_len, starved_cap;
+    int zombies;                      // 해제됐지만 완료를 기다리는 연결
+};
+
+static void ring_dispatch(Reactor *r, const struct io_uring_cqe *cqe);
+static void ring_release_zombies(struct ReactorRing *rr);
+static void conn_ring_recv(Conn *c);
+static void conn_ring_kick(Conn *c);
+static int conn_ring_send(Conn *c);
+static void listener_arm(Listener *l);
+#else
+struct ReactorRing {
+    int unused;
+};
+#endif
+static void conn_on_event(NetHandler *h, uint32_t events);
+static void conn_update_events(Conn *c);
+static void conn_drop_queue(Conn *c);
+
+NetBuf *netbuf_new(size_t cap) {
+    NetBuf *b = (NetBuf *)malloc(sizeof(NetBuf) + cap);
+    if (!b) return NULL;
+    b->refcnt = 1;
+    b->len = 0;
+    b->cap = cap;
+    return b;
+}
+
+NetBuf *netbuf_from_json(const cJSON *msg) {
+    uint64_t t0 = stats_start();
+    size_t cap = 512;
+    while (cap <= NETBUF_MAX) {
+        NetBuf *b = netbuf_new(cap);
+        if (!b) return NULL;
+        // 마지막 한 바이트는 '\n' 자리로 남겨둔다
+        if (cJSON_PrintPreallocated((cJSON *)msg, netbuf_data(b), (int)cap - 1, 0)) {
+            b->len = strlen(netbuf_data(b));
+            netbuf_data(b)[b->len++] = '\n';
+            stats_since(STATS_SERIALIZATION, t0);
+            return b;
+        }
+        free(b);
+        cap *= 2;
+    }
+    return NULL;
+}
+
+void netbuf_ref(NetBuf *b) {
+    __atomic_add_fetch(&b->refcnt, 1, __ATOMIC_RELAXED);
+}
+
+void netbuf_unref(NetBuf *b) {
+    if (b && __atomic_sub_fetch(&b->refcnt, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(b);
+    }
+}
+
+int reactor_init(Reactor *r) {
+    r->batch = NULL;
+    r->batch_len = 0;
+    r->ring = NULL;
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (r->epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+    return 0;
+}
+
+void reactor_close(Reactor *r) {
+#if URING_AVAILABLE
+    if (r->ring) {
+        ring_release_zombies(r->ring);
+        uring_close(&r->ring->u);
+        free(r->ring->slots);
+        free(r->ring->stash);
+        free(r->ring->starved);
+        free(r->ring);
+        r->ring = NULL;
+    }
+#endif
+    if (r->epfd >= 0) close(r->epfd);
+    r->epfd = -1;
+}
+
+#if URING_AVAILABLE
+int reactor_init_uring(Reactor *r) {
+    r->batch = NULL;
+    r->batch_len = 0;
+    r->epfd = -1;
+    r->ring = (struct ReactorRing *)calloc(1, sizeof(struct ReactorRing));
+    if (!r->ring) return -1;
+    if (uring_init(&r->ring->u, RING_ENTRIES, RING_BUFS, RING_BUF_SIZE) < 0) {
+        free(r->ring);
+        r->ring = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static inline uint64_t poll_tag(int fd, uint32_t gen) {
+    return ((uint64_t)(uint32_t)fd << 32) | ((uint64_t)(gen & 0x1fffffffu) << 3) | OP_POLL;
+}
+
+static PollSlot *ring_slot(struct ReactorRing *rr, int fd) {
+    if (fd >= rr->nslots) {
+        int n = rr->nslots ? rr->nslots : 64;
+        while (n <= fd) n *= 2;
+        PollSlot *slots = (PollSlot *)realloc(rr->slots, (size_t)n * sizeof(PollSlot));
+        if (!slots) return NULL;
+        memset(slots + rr->nslots, 0, (size_t)(n - rr->nslots) * sizeof(PollSlot));
+        rr->slots = slots;
+        rr->nslots = n;
+    }
+    return &rr->slots[fd];
+}
+
+static int ring_arm_poll(struct ReactorRing *rr, int fd) {
+    PollSlot *slot = &rr->slots[fd];
+    struct io_uring_sqe *sqe = uring_sqe(&rr->u);
+    if (!sqe) {
+        errno = EBUSY;
+        return -1;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = slot->events | EPOLLERR | EPOLLHUP;
+    sqe->user_data = poll_tag(fd, slot->gen);
+    slot->armed = 1;
+    return 0;
+}
+
+// user_data가 같은 요청을 취소한다 (취소 결과와 취소된 요청의 완료는 버려진다)
+static void ring_cancel(struct ReactorRing *rr, uint8_t opcode, uint64_t target) {
+    struct io_uring_sqe *sqe = uring_sqe(&rr->u);
+    if (!sqe) return;
+    sqe->opcode = opcode;
+    sqe->addr = target;
+}
+
+// fd에 걸린 요청을 모두 취소한다 (연결 해제/이동, listen 소켓 닫기)
+static void ring_cancel_fd(struct ReactorRing *rr, int fd) {
+    struct io_uring_sqe *sqe = uring_sqe(&rr->u);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+}
+#else
+int reactor_init_uring(Reactor *r) {
+    (void)r;
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+int reactor_add(Reactor *r, int fd, uint32_t events, NetHandler *h) {
+#if URING_AVAILABLE
+    if (r->ring) {
+        PollSlot *slot = ring_slot(r->ring, fd);
+        if (!slot) return -1;
+        slot->h = h;
+        slot->events = events;
+        slot->gen++;
+        slot->armed = 0;
+        return ring_arm_poll(r->ring, fd);
+    }
+#endif
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = events;
+    ev.data.ptr = h;
+    return epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+int reactor_mod(Reactor *r, int fd, uint32_t events, NetHandler *h) {
+#if URING_AVAILABLE
+    if (r->ring) {
+        struct ReactorRing *rr = r->ring;
+        PollSlot *slot = fd < rr->nslots ? &rr->slots[fd] : NULL;
+        if (!slot || !slot->h) {
+            errno = ENOENT;
+            return -1;
+        }
+        slot->h = h;
+        if (slot->events == events) return 0;
+        slot->events = events;
+        // 디스패치 중이면 걸린 요청이 없다: 끝나고 새 이벤트로 다시 건다
+        if (!slot->armed) return 0;
+        ring_cancel(rr, IORING_OP_POLL_REMOVE, poll_tag(fd, slot->gen));
+        slot->gen++;
+        return ring_arm_poll(rr, fd);
+    }
+#endif
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = events;
+    ev.data.ptr = h;
+    return epoll_ctl(r->epfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void reactor_del(Reactor *r, int fd) {
+#if URING_AVAILABLE
+    if (r->ring) {
+        struct ReactorRing *rr = r->ring;
+        if (fd >= rr->nslots || !rr->slots[fd].h) return;
+        PollSlot *slot = &rr->slots[fd];
+        if (slot->armed) ring_cancel(rr, IORING_OP_POLL_REMOVE, poll_tag(fd, slot->gen));
+        slot->h = NULL;
+        slot->gen++;
+        slot->armed = 0;
+        return;
+    }
+#endif
+    epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+#if URING_AVAILABLE
+// io_uring_enter 한 번이 모아둔 SQE 제출(보낼 데이터 포함)과 완료 대기를 같이 한다
+static int ring_poll(Reactor *r, int timeout_ms) {
+    struct ReactorRing *rr = r->ring;
+    struct io_uring_cqe evs[RING_BATCH];
+    unsigned n = 0;
+    // detach가 먼저 꺼내둔 완료가 더 오래된 것이다
+    if (rr->stash_len > 0) {
+        n = rr->stash_len < RING_BATCH ? rr->stash_len : RING_BATCH;
+        memcpy(evs, rr->stash, n * sizeof evs[0]);
+        rr->stash_len -= n;
+        memmove(rr->stash, rr->stash + n, rr->stash_len * sizeof evs[0]);
+    }
+    if (uring_enter(&rr->u, n ? 0 : 1, n ? 0 : timeout_ms) < 0
+        && errno != EINTR && errno != ETIME && errno != EBUSY && errno != EAGAIN) {
+        perror("io_uring_enter");
+        return -1;
+    }
+    n += uring_reap(&rr->u, evs + n, RING_BATCH - n);
+    rr->batch = evs;
+    rr->batch_len = n;
+    for (unsigned i = 0; i < n; i++) {
+        if (evs[i].user_data) ring_dispatch(r, &evs[i]);
+    }
+    rr->batch = NULL;
+    rr->batch_len = 0;
+    // 버퍼가 모자라 멈췄던 recv: 이번 묶음에서 버퍼가 돌아왔으니 다시 건다
+    int starved = rr->starved_len;
+    rr->starved_len = 0;
+    for (int i = 0; i < starved; i++) {
+        Conn *c = rr->starved[i];
+        c->rx_armed = 0;
+        c->uring_ops--;
+        if (c->freeing) {
+            if (c->uring_ops == 0) conn_free(c);
+        } else if (!c->dead) {
+            conn_update_events(c);
+        }
+    }
+    return (int)n;
+}
+#endif
+
+int reactor_poll(Reactor *r, int timeout_ms) {
+#if URING_AVAILABLE
+    if (r->ring) return ring_poll(r, timeout_ms);
+#endif
+    struct epoll_event evs[NET_MAX_EVENTS];
+    int n = epoll_wait(r->epfd, evs, NET_MAX_EVENTS, timeout_ms);
+    if (n < 0) {
+        if (errno == EINTR) return 0;
+        perror("epoll_wait");
+        return -1;
+    }
+    // 한 이벤트의 콜백이 같은 묶음의 다른 연결을 해제할 수 있다 (reactor_forget이 지운 칸은 건너뜀)
+    r->batch = evs;
+    r->batch_len = n;
+    for (int i = 0; i < n; i++) {
+        NetHandler *h = (NetHandler *)evs[i].data.ptr;
+        if (h) h->on_event(h, evs[i].events);
+    }
+    r->batch = NULL;
+    r->batch_len = 0;
+    return n;
+}
+
+void reactor_forget(Reactor *r, NetHandler *h) {
+    // io_uring은 poll 완료를 gen으로 거르고, 직접 요청을 건 연결은 완료가 다 올 때까지 해제를 미룬다
+    if (!r || !r->batch) return;
+    struct epoll_event *evs = (struct epoll_event *)r->batch;
+    for (int i = 0; i < r->batch_len; i++) {
+        if (evs[i].data.ptr == h) evs[i].data.ptr = NULL;
+    }
+}
+
+int net_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// 출력 큐가 남아 있으면 EPOLLOUT, 입력 버퍼에 자리가 있으면 EPOLLIN
+static void conn_update_events(Conn *c) {
+#if URING_AVAILABLE
+    if (c->native) {
+        // epoll이라면 EPOLLIN이 다시 울렸을 상황: recv를 다시 걸거나, 쌓아둔 입력으로 스스로 깨운다
+        if (c->dead || c->freeing) return;
+        if (!c->rx_armed && !c->rx_eof && c->spill_len < CONN_SPILL_MAX / 2) conn_ring_recv(c);
+        if (c->spill_len > 0 && c->in_len < CONN_INBUF_SIZE - 1) conn_ring_kick(c);
+        return;
+    }
+#endif
+    if (c->shm) {
+        // 링은 eventfd가 한 번만 울리므로, 버퍼가 차서 못 읽고 남긴 입력은 스스로 다시 깨운다
+        if (!c->dead && c->in_len < CONN_INBUF_SIZE - 1 && shm_readable(c->shm)) shm_kick(c->shm);
+        return;
+    }
+    uint32_t events = 0;
+    if (c->in_len < CONN_INBUF_SIZE - 1) events |= EPOLLIN;
+    if (c->oq_count > 0) events |= EPOLLOUT;
+    if (c->events == events || c->dead) return;
+    c->events = events;
+    reactor_mod(c->reactor, c->fd, events, &c->handler);
+}
+
+static void conn_on_event(NetHandler *h, uint32_t events) {
+    Conn *c = (Conn *)h;
+    if (c->dead) return;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        // 남은 입력은 먼저 읽어둔다 (마지막 메시지 뒤에 바로 끊는 클라이언트)
+        if (events & EPOLLIN) {
+            uint64_t t0 = trace_begin();
+            conn_fill(c);
+            trace_end("recv", t0);
+        }
+        conn_kill(c);
+    } else {
+        if (events & EPOLLOUT) conn_flush(c);
+        if (!c->dead && (events & EPOLLIN)) {
+            // EOF여도 이미 읽은 줄은 conn_next_json으로 꺼낼 수 있다
+            uint64_t t0 = trace_begin();
+            int rc = conn_fill(c);
+            trace_end("recv", t0);
+            if (rc < 0) conn_kill(c);
+        }
+    }
+    if (c->close_when_drained) {
+        if (c->dead || c->oq_count == 0) conn_free(c);
+        return;
+    }
+    // 콜백이 c를 해제할 수 있으므로 맨 마지막에 호출
+    if (c->on_read) c->on_read(c);
+}
+
+// 링 쪽 eventfd: 상대가 쓰거나(입력) 읽어서 자리가 났다(출력)
+static void conn_on_shm_event(NetHandler *h, uint32_t events) {
+    Conn *c = (Conn *)((char *)h - offsetof(Conn, shm_handler));
+    (void)events;
+    shm_drain(c->shm);
+    uint32_t ready = EPOLLIN;
+    if (c->oq_count > 0) ready |= EPOLLOUT;
+    conn_on_event(&c->handler, ready);
+}
+
+// 링으로 옮긴 뒤의 소켓: 어떤 이벤트든 상대가 끊었다는 뜻이다 (링에 남은 입력은 먼저 읽는다)
+static void conn_on_shm_hup(NetHandler *h, uint32_t events) {
+    (void)events;
+    conn_on_event(h, EPOLLHUP | EPOLLIN);
+}
+
+int conn_upgrade_shm(Conn *c) {
+    if (c->shm || c->npassed != SHM_FDS || c->dead) return -1;
+    ShmLink *l = (ShmLink *)malloc(sizeof(ShmLink));
+    if (!l || shm_link_open(l, c->passed_fds) < 0) {
+        free(l);
+        return -1;
+    }
+    c->npassed = 0;
+    c->shm = l;
+    c->shm_handler.on_event = conn_on_shm_event;
+    if (reactor_add(c->reactor, l->wake_fd, EPOLLIN, &c->shm_handler) < 0) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    // 소켓은 끊김만 본다. 매직 바이트 뒤에 소켓으로 온 것은 프로토콜 위반이라 버린다
+    c->handler.on_event = conn_on_shm_hup;
+    c->events = EPOLLIN;
+    reactor_mod(c->reactor, c->fd, c->events, &c->handler);
+    c->in_off = c->in_len = 0;
+    shm_kick(l);
+    return 0;
+}
+
+// io_uring reactor에서 소켓 입출력을 직접 걸 수 있는 연결인지 (unix 소켓은 fd 전달과 공유 메모리 링 때문에 poll 경로)
+static int conn_can_ring(Conn *c, Reactor *r) {
+    int domain = 0;
+    socklen_t len = sizeof domain;
+    if (!r->ring || c->shm) return 0;
+    return getsockopt(c->fd, SOL_SOCKET, SO_DOMAIN, &domain, &len) == 0 && domain != AF_UNIX;
+}
+
+Conn *conn_new(int fd, Reactor *r, size_t high_water) {
+    Conn *c = (Conn *)calloc(1, sizeof(Conn));
+    if (!c) return NULL;
+    c->handler.on_event = conn_on_event;
+    c->fd = fd;
+    c->reactor = r;
+    c->high_water = high_water ? high_water : NET_DEFAULT_HIGH_WATER;
+    c->events = EPOLLIN;
+    net_set_nonblocking(fd);
+    // 메시지 단위 묶음은 출력 큐가 하므로 Nagle 지연은 필요 없다 (TCP가 아니면 무시됨)
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    c->native = conn_can_ring(c, r);
+    if (c->native) {
+        conn_update_events(c);
+        return c;
+    }
+    if (reactor_add(r, fd, c->events, &c->handler) < 0) {
+        perror("epoll_ctl");
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+static void conn_drop_queue(Conn *c) {
+    while (c->oq_count > 0) {
+        netbuf_unref(c->outq[c->oq_head]);
+        c->oq_head = (c->oq_head + 1) % CONN_OUTQ_SLOTS;
+        c->oq_count--;
+    }
+    c->oq_off = 0;
+    c->oq_bytes = 0;
+    c->oq_since = 0;
+}
+
+// 보낸 바이트만큼 큐를 줄인다: 다 보낸 버퍼는 빼고, 마지막 버퍼는 offset만 옮긴다
+static void conn_consume(Conn *c, size_t sent) {
+    c->oq_bytes -= sent;
+    while (sent > 0) {
+        NetBuf *b = c->outq[c->oq_head];
+        size_t left = b->len - c->oq_off;
+        if (sent < left) {
+            c->oq_off += sent;
+            break;
+        }
+        sent -= left;
+        netbuf_unref(b);
+        c->oq_head = (c->oq_head + 1) % CONN_OUTQ_SLOTS;
+        c->oq_count--;
+        c->oq_off = 0;
+    }
+    if (c->oq_count == 0 && c->oq_since) {
+        stats_since(STATS_SENDQ_DELAY, c->oq_since);
+        c->oq_since = 0;
+    }
+}
+
+#if URING_AVAILABLE
+static inline uint64_t conn_tag(Conn *c, unsigned op) {
+    return (uint64_t)(uintptr_t)c | op;
+}
+
+static void conn_ring_recv(Conn *c) {
+    struct io_uring_sqe *sqe = uring_sqe(&c->reactor->ring->u);
+    if (!sqe) {
+        conn_kill(c);
+        return;
+    }
+    // 데이터가 올 때마다 완료 하나, 버퍼는 커널이 provided ring에서 고른다
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = c->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = conn_tag(c, OP_RECV);
+    c->rx_armed = 1;
+    c->uring_ops++;
+}
+
+// 소켓 이벤트 없이 한 번 더 디스패치받는다 (inbuf에 자리가 나서 spill을 옮길 때, 다른 reactor로 옮겨왔을 때)
+static void conn_ring_kick(Conn *c) {
+    if (c->kick_busy) return;
+    struct io_uring_sqe *sqe = uring_sqe(&c->reactor->ring->u);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = conn_tag(c, OP_KICK);
+    c->kick_busy = 1;
+    c->uring_ops++;
+}
+
+// 큐 앞쪽을 sendmsg 하나로 건다. 제출은 reactor_poll의 다음 io_uring_enter에서 다른 연결 것과 한꺼번에
+static int conn_ring_send(Conn *c) {
+    if (c->tx_busy || c->oq_count == 0 || c->dead) return 0;
+    struct io_uring_sqe *sqe = uring_sqe(&c->reactor->ring->u);
+    if (!sqe) {
+        conn_kill(c);
+        return -1;
+    }
+    int n = 0;
+    unsigned idx = c->oq_head;
+    for (unsigned i = 0; i < c->oq_count && n < CONN_URING_IOV; i++) {
+        NetBuf *b = c->outq[idx];
+        size_t off = (i == 0) ? c->oq_off : 0;
+        c->tx_iov[n].iov_base = netbuf_data(b) + off;
+        c->tx_iov[n].iov_len = b->len - off;
+        n++;
+        idx = (idx + 1) % CONN_OUTQ_SLOTS;
+    }
+    memset(&c->tx_msg, 0, sizeof c->tx_msg);
+    c->tx_msg.msg_iov = c->tx_iov;
+    c->tx_msg.msg_iovlen = n;
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = c->fd;
+    sqe->addr = (uint64_t)(uintptr_t)&c->tx_msg;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = conn_tag(c, OP_SEND);
+    c->tx_busy = 1;
+    c->uring_ops++;
+    return 0;
+}
+
+// 받은 데이터는 inbuf 끝에 붙이고 (앞쪽은 처리 중일 수 있어 옮기지 않는다), 넘치면 spill에 둔다
+static int conn_take(Conn *c, const char *data, size_t len) {
+    if (c->spill_len == 0) {
+        size_t room = CONN_INBUF_SIZE - 1 - c->in_len;
+        size_t n = len < room ? len : room;
+        memcpy(c->inbuf + c->in_len, data, n);
+        c->in_len += n;
+        data += n;
+        len -= n;
+    }
+    if (len == 0) return 0;
+    if (c->spill_off > 0 && c->spill_off + c->spill_len + len > c->spill_cap) {
+        memmove(c->spill, c->spill + c->spill_off, c->spill_len);
+        c->spill_off = 0;
+    }
+    if (c->spill_len + len > c->spill_cap) {
+        size_t cap = c->spill_cap ? c->spill_cap : RING_BUF_SIZE;
+        while (cap < c->spill_len + len) cap *= 2;
+        char *p = (char *)realloc(c->spill, cap);
+        if (!p) return -1;
+        c->spill = p;
+        c->spill_cap = cap;
+    }
+    memcpy(c->spill + c->spill_off + c->spill_len, data, len);
+    c->spill_len += len;
+    return 0;
+}
+
+// 완료 하나를 연결 상태에 반영하고, epoll이었다면 울렸을 이벤트를 돌려준다
+static uint32_t conn_apply_cqe(Conn *c, unsigned op, const struct io_uring_cqe *cqe) {
+    struct ReactorRing *rr = c->reactor->ring;
+    switch (op) {
+    case OP_RECV:
+        if (cqe->flags & IORING_CQE_F_BUFFER) {
+            unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            if (cqe->res > 0 && !c->dead && !c->freeing) {
+                size_t before = c->spill_len;
+                if (conn_take(c, uring_buf(&rr->u, bid), (size_t)cqe->res) < 0) {
+                    c->rx_eof = 1;
+                } else if (before < CONN_SPILL_MAX && c->spill_len >= CONN_SPILL_MAX) {
+                    // 처리보다 빨리 들어온다: epoll에서 EPOLLIN을 끄는 것처럼 recv를 멈춘다
+                    ring_cancel(rr, IORING_OP_ASYNC_CANCEL, conn_tag(c, OP_RECV));
+                }
+            }
+            uring_buf_return(&rr->u, bid);
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            if (cqe->res == -ENOBUFS && !c->dead && !c->freeing) {
+                // 요청 수는 그대로 두고 reactor_poll 끝에서 다시 건다
+                if (rr->starved_len == rr->starved_cap) {
+                    int cap = rr->starved_cap ? rr->starved_cap * 2 : 64;
+                    Conn **list = (Conn **)realloc(rr->starved, (size_t)cap * sizeof(Conn *));
+                    if (!list) {
+                        c->rx_armed = 0;
+                        c->uring_ops--;
+                        c->rx_eof = 1;
+                        return EPOLLIN;
+                    }
+                    rr->starved = list;
+                    rr->starved_cap = cap;
+                }
+                rr->starved[rr->starved_len++] = c;
+                return 0;
+            }
+            c->rx_armed = 0;
+            c->uring_ops--;
+            if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ECANCELED)) c->rx_eof = 1;
+        }
+        return EPOLLIN;
+    case OP_SEND:
+        c->tx_busy = 0;
+        c->uring_ops--;
+        if (!c->dead) {
+            if (cqe->res > 0) {
+                conn_consume(c, (size_t)cqe->res);
+            } else if (cqe->res < 0 && cqe->res != -EAGAIN && cqe->res != -EINTR) {
+                conn_kill(c);
+            }
+        }
+        // 끊긴 연결의 큐는 커널이 다 읽은 뒤에야 버릴 수 있다
+        if (c->dead) conn_drop_queue(c);
+        return EPOLLOUT;
+    case OP_KICK:
+        c->kick_busy = 0;
+        c->uring_ops--;
+        return EPOLLIN;
+    }
+    return 0;
+}
+
+static void ring_on_conn(Conn *c, unsigned op, const struct io_uring_cqe *cqe) {
+    uint32_t events = conn_apply_cqe(c, op, cqe);
+    if (c->freeing) {
+        if (c->uring_ops == 0) conn_free(c);
+        return;
+    }
+    if (events) conn_on_event(&c->handler, events);
+}
+
+static void ring_on_accept(Listener *l, const struct io_uring_cqe *cqe) {
+    if (cqe->res >= 0) {
+        if (l->fd >= 0) l->on_accept(l, cqe->res);
+        else close(cqe->res);
+    } else if (cqe->res != -ECANCELED && cqe->res != -EAGAIN && cqe->res != -EINTR) {
+        errno = -cqe->res;
+        perror("accept");
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE) && cqe->res != -ECANCELED && l->fd >= 0) {
+        listener_arm(l);
+    }
+}
+
+static void ring_on_poll(struct ReactorRing *rr, const struct io_uring_cqe *cqe) {
+    int fd = (int)(cqe->user_data >> 32);
+    uint32_t gen = (uint32_t)(cqe->user_data >> 3) & 0x1fffffffu;
+    if (fd >= rr->nslots) return;
+    PollSlot *slot = &rr->slots[fd];
+    if (!slot->h || (slot->gen & 0x1fffffffu) != gen) return;
+    slot->armed = 0;
+    NetHandler *h = slot->h;
+    h->on_event(h, cqe->res < 0 ? (uint32_t)EPOLLERR : (uint32_t)cqe->res);
+    // 핸들러가 지우거나 바꾸지 않았으면 같은 관심 이벤트로 다시 건다 (slots는 realloc될 수 있다)
+    slot = &rr->slots[fd];
+    if (slot->h && (slot->gen & 0x1fffffffu) == gen && !slot->armed) ring_arm_poll(rr, fd);
+}
+
+static void ring_dispatch(Reactor *r, const struct io_uring_cqe *cqe) {
+    unsigned op = (unsigned)(cqe->user_data & OP_MASK);
+    void *p = (void *)(uintptr_t)(cqe->user_data & ~(uint64_t)OP_MASK);
+    switch (op) {
+    case OP_POLL:
+        ring_on_poll(r->ring, cqe);
+        break;
+    case OP_RECV:
+    case OP_SEND:
+    case OP_KICK:
+        ring_on_conn((Conn *)p, op, cqe);
+        break;
+    case OP_ACCEPT:
+        ring_on_accept((Listener *)p, cqe);
+        break;
+    }
+}
+
+static int ring_is_conn(const struct io_uring_cqe *cqe, Conn *c) {
+    unsigned op = (unsigned)(cqe->user_data & OP_MASK);
+    return (op == OP_RECV || op == OP_SEND || op == OP_KICK)
+        && (cqe->user_data & ~(uint64_t)OP_MASK) == (uint64_t)(uintptr_t)c;
+}
+
+static int ring_stash(struct ReactorRing *rr, const struct io_uring_cqe *cqe) {
+    if (rr->stash_len == rr->stash_cap) {
+        unsigned cap = rr->stash_cap ? rr->stash_cap * 2 : RING_BATCH;
+        struct io_uring_cqe *st = (struct io_uring_cqe *)realloc(rr->stash, cap * sizeof *st);
+        if (!st) return -1;
+        rr->stash = st;
+        rr->stash_cap = cap;
+    }
+    rr->stash[rr->stash_len++] = *cqe;
+    return 0;
+}
+
+// 연결에 걸린 요청을 모두 끝낸다 (다른 reactor로 넘기기 전). 그동안 온 남의 완료는 stash에 미뤄둔다
+static void ring_quiesce(struct ReactorRing *rr, Conn *c) {
+    for (int i = 0; i < rr->starved_len; i++) {
+        if (rr->starved[i] != c) continue;
+        rr->starved[i] = rr->starved[--rr->starved_len];
+        c->rx_armed = 0;
+        c->uring_ops--;
+        break;
+    }
+    if (c->uring_ops == 0) return;
+    ring_cancel_fd(rr, c->fd);
+    // 이미 꺼냈지만 아직 디스패치 안 한 완료 중 이 연결 몫은 지금 반영한다
+    for (unsigned i = 0; i < rr->batch_len; i++) {
+        if (!ring_is_conn(&rr->batch[i], c)) continue;
+        conn_apply_cqe(c, (unsigned)(rr->batch[i].user_data & OP_MASK), &rr->batch[i]);
+        rr->batch[i].user_data = 0;
+    }
+    unsigned kept = 0;
+    for (unsigned i = 0; i < rr->stash_len; i++) {
+        if (ring_is_conn(&rr->stash[i], c)) conn_apply_cqe(c, (unsigned)(rr->stash[i].user_data & OP_MASK), &rr->stash[i]);
+        else rr->stash[kept++] = rr->stash[i];
+    }
+    rr->stash_len = kept;
+    while (c->uring_ops > 0) {
+        struct io_uring_cqe evs[64];
+        if (uring_enter(&rr->u, 1, -1) < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+            perror("io_uring_enter");
+            return;
+        }
+        unsigned n = uring_reap(&rr->u, evs, 64);
+        for (unsigned i = 0; i < n; i++) {
+            if (ring_is_conn(&evs[i], c)) conn_apply_cqe(c, (unsigned)(evs[i].user_data & OP_MASK), &evs[i]);
+            else if (evs[i].user_data && ring_stash(rr, &evs[i]) < 0) perror("io_uring stash");
+        }
+    }
+}
+
+// reactor를 닫기 전에: 해제를 미룬 연결들의 남은 완료를 받아 마저 해제한다 (다른 완료는 버린다)
+static void ring_zombie_cqe(const struct io_uring_cqe *cqe) {
+    unsigned op = (unsigned)(cqe->user_data & OP_MASK);
+    Conn *c = (Conn *)(uintptr_t)(cqe->user_data & ~(uint64_t)OP_MASK);
+    if ((op == OP_RECV || op == OP_SEND || op == OP_KICK) && c->freeing) ring_on_conn(c, op, cqe);
+}
+static void ring_release_zombies(struct ReactorRing *rr) {
+    for (int i = 0; i < rr->starved_len; i++) {
+        Conn *c = rr->starved[i];
+        c->rx_armed = 0;
+        c->uring_ops--;
+        if (c->freeing && c->uring_ops == 0) conn_free(c);
+    }
+    rr->starved_len = 0;
+    for (unsigned i = 0; i < rr->stash_len; i++) ring_zombie_cqe(&rr->stash[i]);
+    rr->stash_len = 0;
+    while (rr->zombies > 0) {
+        struct io_uring_cqe evs[64];
+        if (uring_enter(&rr->u, 1, 1000) < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) return;
+        unsigned n = uring_reap(&rr->u, evs, 64);
+        if (n == 0) return;
+        for (unsigned i = 0; i < n; i++) ring_zombie_cqe(&evs[i]);
+    }
+}
+#endif
+
+void conn_kill(Conn *c) {
+    if (c->dead) return;
+    c->dead = 1;
+    if (c->native) {
+        // 걸린 recv/send는 shutdown으로 끝난다. 날아가는 중인 버퍼는 send 완료 때 버린다
+        if (!c->tx_busy) conn_drop_queue(c);
+        shutdown(c->fd, SHUT_RDWR);
+        return;
+    }
+    conn_drop_queue(c);
+    reactor_del(c->reactor, c->fd);
+    if (c->shm) reactor_del(c->reactor, c->shm->wake_fd);
+    shutdown(c->fd, SHUT_RDWR);
+}
+
+void conn_free(Conn *c) {
+    if (!c) return;
+#if URING_AVAILABLE
+    if (c->native && c->reactor) {
+        // 커널이 아직 c의 버퍼와 msghdr를 쓰고 있다: 요청을 취소하고 마지막 완료에서 다시 불린다
+        struct ReactorRing *rr = c->reactor->ring;
+        if (c->uring_ops > 0) {
+            if (!c->freeing) {
+                c->freeing = 1;
+                c->on_read = NULL;
+                rr->zombies++;
+                ring_cancel_fd(rr, c->fd);
+            }
+            return;
+        }
+        if (c->freeing) rr->zombies--;
+    }
+#endif
+    reactor_forget(c->reactor, &c->handler);
+    reactor_forget(c->reactor, &c->shm_handler);
+    if (!c->dead) reactor_del(c->reactor, c->fd);
+    conn_drop_queue(c);
+    if (c->shm) {
+        if (!c->dead) reactor_del(c->reactor, c->shm->wake_fd);
+        shm_link_close(c->shm);
+        free(c->shm);
+    }
+    for (int i = 0; i < c->npassed; i++) close(c->passed_fds[i]);
+    close(c->fd);
+    free(c->spill);
+    free(c);
+}
+
+void conn_detach(Conn *c) {
+#if URING_AVAILABLE
+    if (c->native) {
+        ring_quiesce(c->reactor->ring, c);
+        c->reactor = NULL;
+        return;
+    }
+#endif
+    reactor_forget(c->reactor, &c->handler);
+    reactor_forget(c->reactor, &c->shm_handler);
+    if (!c->dead) {
+        reactor_del(c->reactor, c->fd);
+        if (c->shm) reactor_del(c->reactor, c->shm->wake_fd);
+    }
+    c->reactor = NULL;
+}
+int conn_attach(Conn *c, Reactor *r) {
+    c->reactor = r;
+    if (c->dead) return 0;
+    c->native = conn_can_ring(c, r);
+#if URING_AVAILABLE
+    if (c->native) {
+        conn_update_events(c);
+        if (c->oq_count > 0) conn_ring_send(c);
+        // epoll이라면 소켓에 남아 있었을 입력: 새 주인이 한 번 읽게 한다
+        if (c->in_len > c->in_off) conn_ring_kick(c);
+        return 0;
+    }
+#endif
+    if (reactor_add(r, c->fd, c->events, &c->handler) < 0
+        || (c->shm && reactor_add(r, c->shm->wake_fd, EPOLLIN, &c->shm_handler) < 0)) {
+        perror("epoll_ctl");
+        conn_kill(c);
+        return -1;
+    }
+    // 떼어져 있는 동안 링에 들어온 입력이나 생긴 자리를 놓치지 않도록
+    if (c->shm) shm_kick(c->shm);
+    return 0;
+}
+void conn_close_when_drained(Conn *c) {
+    c->on_read = NULL;
+    if (c->dead || c->oq_count == 0) {
+        conn_free(c);
+        return;
+    }
+    c->close_when_drained = 1;
+}
+
+int conn_flush(Conn *c) {
+#if URING_AVAILABLE
+    if (c->native) return conn_ring_send(c);
+#endif
+    while (c->oq_count > 0) {
+        struct iovec iov[NET_MAX_IOV];
+        int n = 0;
+        unsigned idx = c->oq_head;
+        for (unsigned i = 0; i < c->oq_count && n < NET_MAX_IOV; i++) {
+            NetBuf *b = c->outq[idx];
+            size_t off = (i == 0) ? c->oq_off : 0;
+            iov[n].iov_base = netbuf_data(b) + off;
+            iov[n].iov_len = b->len - off;
+            n++;
+            idx = (idx + 1) % CONN_OUTQ_SLOTS;
+        }
+        ssize_t sent;
+        if (c->shm) {
+            // 링이 가득 차면 상대가 읽은 뒤 wake_fd로 깨워준다
+            if (__atomic_load_n(&c->shm->rx->closed, __ATOMIC_ACQUIRE)) {
+                conn_kill(c);
+                return -1;
+            }
+            sent = (ssize_t)shm_writev(c->shm, iov, n);
+            if (sent == 0) break;
+        } else {
+            struct msghdr mh;
+            memset(&mh, 0, sizeof mh);
+            mh.msg_iov = iov;
+            mh.msg_iovlen = n;
+            sent = sendmsg(c->fd, &mh, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            conn_kill(c);
+            return -1;
+        }
+        conn_consume(c, (size_t)sent);
+    }
+    conn_update_events(c);
+    return 0;
+}
+
+int conn_send(Conn *c, NetBuf *b) {
+    if (c->dead) return -1;
+    // 느린 클라이언트: 큐가 상한을 넘으면 게임 전체를 붙잡지 않도록 끊어버린다
+    if (c->oq_count == CONN_OUTQ_SLOTS || c->oq_bytes + b->len > c->high_water) {
+        fprintf(stderr, "conn %d: output queue over high-water mark, dropping\n", c->fd);
+        conn_kill(c);
+        return -1;
+    }
+    netbuf_ref(b);
+    if (c->oq_count == 0) c->oq_since = stats_start();
+    c->outq[(c->oq_head + c->oq_count) % CONN_OUTQ_SLOTS] = b;
+    c->oq_count++;
+    c->oq_bytes += b->len;
+    if (c->corked) return 0;
+    return conn_flush(c);
+}
+
+void conn_cork(Conn *c) {
+    c->corked++;
+}
+
+void conn_uncork(Conn *c) {
+    if (c->corked > 0 && --c->corked == 0 && !c->dead && c->oq_count > 0) conn_flush(c);
+}
+
+int conn_send_json(Conn *c, const cJSON *msg) {
+    uint64_t t0 = trace_begin();
+    NetBuf *b = netbuf_from_json(msg);
+    if (!b) return -1;
+    int ret = conn_send(c, b);
+    trace_end("send_json", t0);
+    netbuf_unref(b);
+    return ret;
+}
+
+// unix 소켓이면 같이 온 fd(SCM_RIGHTS)도 받아둔다. 연결당 SHM_FDS개까지, 나머지는 닫는다
+static ssize_t conn_recv(Conn *c, size_t room) {
+    struct iovec iov;
+    struct msghdr mh;
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * SHM_FDS)];
+        struct cmsghdr align;
+    } cbuf;
+    iov.iov_base = c->inbuf + c->in_len;
+    iov.iov_len = room;
+    memset(&mh, 0, sizeof mh);
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = cbuf.buf;
+    mh.msg_controllen = sizeof cbuf.buf;
+    ssize_t n = recvmsg(c->fd, &mh, MSG_CMSG_CLOEXEC);
+    if (n <= 0 || mh.msg_controllen == 0) return n;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        int cnt = (int)((cm->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < cnt; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof fd);
+            if (c->npassed < SHM_FDS) c->passed_fds[c->npassed++] = fd;
+            else close(fd);
+        }
+    }
+    return n;
+}
+
+int conn_fill(Conn *c) {
+    int total = 0;
+    if (c->in_off > 0) {
+        memmove(c->inbuf, c->inbuf + c->in_off, c->in_len - c->in_off);
+        c->in_len -= c->in_off;
+        c->in_off = 0;
+    }
+    if (c->spill_len > 0) {
+        // io_uring recv가 inbuf에 못 넣고 남긴 입력부터
+        size_t room = CONN_INBUF_SIZE - 1 - c->in_len;
+        size_t n = c->spill_len < room ? c->spill_len : room;
+        memcpy(c->inbuf + c->in_len, c->spill + c->spill_off, n);
+        c->in_len += n;
+        c->spill_off += n;
+        c->spill_len -= n;
+        if (c->spill_len == 0) c->spill_off = 0;
+        total += (int)n;
+    }
+    if (c->native) {
+        conn_update_events(c);
+        return c->rx_eof && c->spill_len == 0 ? -1 : total;
+    }
+    for (;;) {
+        size_t room = CONN_INBUF_SIZE - 1 - c->in_len;
+        if (room == 0) {
+            // 아직 처리 안 된 줄로 가득 참: 소비될 때까지 EPOLLIN을 끈다
+            conn_update_events(c);
+            return total;
+        }
+        ssize_t n;
+        if (c->shm) {
+            n = shm_read(c->shm, c->inbuf + c->in_len, room);
+            if (n == 0) return total;
+        } else {
+            n = conn_recv(c, room);
+        }
+        if (n > 0) {
+            c->in_len += (size_t)n;
+            total += (int)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return total;
+        return -1;
+    }
+}
+
+// last(줄 끝)까지 읽은 것으로 친다. 다 읽었으면 버퍼를 비우고 다시 읽기를 건다
+static void conn_advance(Conn *c, const char *last) {
+    stats_add(STATS_MESSAGES, 1);
+    c->in_off = (size_t)(last - c->inbuf) + 1;
+    if (c->in_off == c->in_len) {
+        c->in_off = c->in_len = 0;
+        conn_update_events(c);
+    }
+}
+
+cJSON *conn_next_json(Conn *c) {
+    while (c->in_off < c->in_len) {
+        char *start = c->inbuf + c->in_off;
+        char *newline = (char *)memchr(start, '\n', c->in_len - c->in_off);
+        if (!newline) {
+            if (c->in_off > 0) {
+                // 덜 들어온 줄을 앞으로 당겨 읽기 공간을 다시 만든다
+                memmove(c->inbuf, start, c->in_len - c->in_off);
+                c->in_len -= c->in_off;
+                c->in_off = 0;
+                conn_update_events(c);
+            } else if (c->in_len == CONN_INBUF_SIZE - 1) {
+                // 줄바꿈 없이 버퍼가 가득 참 → 프로토콜 에러
+                conn_kill(c);
+            }
+            return NULL;
+        }
+        *newline = '\0';
+        conn_advance(c, newline);
+        uint64_t t0 = trace_begin();
+        cJSON *msg = cJSON_Parse(start);
+        trace_end("parse", t0);
+        if (msg) return msg;
+    }
+    return NULL;
+}
+
+cJSON *conn_peek_json(Conn *c) {
+    char *start = c->inbuf + c->in_off;
+    char *newline = (char *)memchr(start, '\n', c->in_len - c->in_off);
+    if (!newline) return NULL;
+    // cJSON_Parse가 '\0'까지 읽으므로 잠깐 줄 끝을 막았다가 되돌린다
+    *newline = '\0';
+    cJSON *msg = cJSON_Parse(start);
+    *newline = '\n';
+    return msg;
+}
+
+void conn_skip_json(Conn *c) {
+    char *newline = (char *)memchr(c->inbuf + c->in_off, '\n', c->in_len - c->in_off);
+    if (newline) conn_advance(c, newline);
+}
+
+int conn_next_frame(Conn *c, const uint8_t **frame, size_t *len) {
+    size_t avail = c->in_len - c->in_off;
+    const uint8_t *start = (const uint8_t *)c->inbuf + c->in_off;
+    size_t n = avail >= 2 ? (size_t)((start[0] << 8) | start[1]) : 0;
+    if (avail < 2 || avail - 2 < n) {
+        if (avail >= 2 && n + 2 > CONN_INBUF_SIZE - 1) {
+            // 버퍼보다 큰 프레임 → 프로토콜 에러
+            conn_kill(c);
+        } else if (c->in_off > 0) {
+            // 덜 들어온 프레임을 앞으로 당겨 읽기 공간을 다시 만든다
+            memmove(c->inbuf, start, avail);
+            c->in_len = avail;
+            c->in_off = 0;
+            conn_update_events(c);
+        }
+        return 0;
+    }
+    *frame = start + 2;
+    *len = n;
+    stats_add(STATS_MESSAGES, 1);
+    c->in_off += n + 2;
+    if (c->in_off == c->in_len) {
+        c->in_off = c->in_len = 0;
+        conn_update_events(c);
+    }
+    return 1;
+}
+
+int conn_peek_frame(Conn *c, const uint8_t **frame, size_t *len) {
+    size_t avail = c->in_len - c->in_off;
+    const uint8_t *start = (const uint8_t *)c->inbuf + c->in_off;
+    size_t n = avail >= 2 ? (size_t)((start[0] << 8) | start[1]) : 0;
+    if (avail < 2 || avail - 2 < n) return 0;
+    *frame = start + 2;
+    *len = n;
+    return 1;
+}
+
+static void listener_on_event(NetHandler *h, uint32_t events) {
+    Listener *l = (Listener *)h;
+    (void)events;
+    // 한 번 깨어날 때 쌓인 연결을 모두 받아서 접속 폭주를 바로 흡수한다
+    for (;;) {
+        int fd = accept4(l->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept4");
+            return;
+        }
+        l->on_accept(l, fd);
+    }
+}
+
+#if URING_AVAILABLE
+// multishot accept: 연결마다 완료 하나, 새 fd는 처음부터 non-blocking
+static void listener_arm(Listener *l) {
+    struct io_uring_sqe *sqe = uring_sqe(&l->reactor->ring->u);
+    if (!sqe) {
+        fprintf(stderr, "listener %d: io_uring submission queue full\n", l->fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = l->fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = (uint64_t)(uintptr_t)l | OP_ACCEPT;
+}
+#endif
+
+int listener_init(Listener *l, Reactor *r, int fd,
+                  void (*on_accept)(Listener *l, int fd), void *user) {
+    l->handler.on_event = listener_on_event;
+    l->fd = fd;
+    l->reactor = r;
+    l->on_accept = on_accept;
+    l->user = user;
+    net_set_nonblocking(fd);
+#if URING_AVAILABLE
+    if (r->ring) {
+        listener_arm(l);
+        return 0;
+    }
+#endif
+    if (reactor_add(r, fd, EPOLLIN, &l->handler) < 0) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    return 0;
+}
+
+void listener_close(Listener *l) {
+    if (l->fd < 0) return;
+#if URING_AVAILABLE
+    if (l->reactor->ring) {
+        // 취소는 fd로 찾으므로 닫기 전에 바로 제출한다
+        ring_cancel_fd(l->reactor->ring, l->fd);
+        uring_enter(&l->reactor->ring->u, 0, 0);
+        close(l->fd);
+        l->fd = -1;
+        return;
+    }
+#endif
+    reactor_del(l->reactor, l->fd);
+    close(l->fd);
+    l->fd = -1;
+}
+
+static void mailbox_drain(Mailbox *mb) {
+    // 스택으로 쌓인 메시지를 한 번에 떼어내 도착 순서로 뒤집는다
+    MailMsg *m = __atomic_exchange_n(&mb->head, (MailMsg *)NULL, __ATOMIC_ACQUIRE);
+    MailMsg *fifo = NULL;
+    while (m) {
+        MailMsg *next = m->next;
+        m->next = fifo;
+        fifo = m;
+        m = next;
+    }
+    while (fifo) {
+        MailMsg *next = fifo->next;
+        mb->on_msg(mb, fifo);
+        fifo = next;
+    }
+}
+
+static void mailbox_on_event(NetHandler *h, uint32_t events) {
+    Mailbox *mb = (Mailbox *)h;
+    uint64_t v;
+    (void)events;
+    while (read(mb->efd, &v, sizeof v) > 0) {
+    }
+    mailbox_drain(mb);
+}
+
+int mailbox_init(Mailbox *mb, Reactor *r,
+                 void (*on_msg)(Mailbox *mb, MailMsg *m), void *user) {
+    mb->handler.on_event = mailbox_on_event;
+    mb->reactor = r;
+    mb->head = NULL;
+    mb->on_msg = on_msg;
+    mb->user = user;
+    mb->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mb->efd < 0) {
+        perror("eventfd");
+        return -1;
+    }
+    if (reactor_add(r, mb->efd, EPOLLIN, &mb->handler) < 0) {
+        perror("epoll_ctl");
+        close(mb->efd);
+        mb->efd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void mailbox_close(Mailbox *mb) {
+    if (mb->efd < 0) return;
+    mailbox_drain(mb);
+    reactor_del(mb->reactor, mb->efd);
+    close(mb->efd);
+    mb->efd = -1;
+}
+
+void mailbox_post(Mailbox *mb, MailMsg *m) {
+    MailMsg *old = __atomic_load_n(&mb->head, __ATOMIC_RELAXED);
+    do {
+        m->next = old;
+    } while (!__atomic_compare_exchange_n(&mb->head, &old, m, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    // 비어 있던 큐에 처음 넣은 쪽만 깨운다
+    if (!old) {
+        uint64_t one = 1;
+        if (write(mb->efd, &one, sizeof one) < 0 && errno != EAGAIN) perror("eventfd write");
+    }
+}
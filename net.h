@@ -0,0 +1,171 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include "../libs/cJSON.h"
+#include "shm.h"
+
+#define CONN_INBUF_SIZE        4096
+#define CONN_OUTQ_SLOTS        256
+#define NET_DEFAULT_HIGH_WATER (256 * 1024)   // 출력 큐 기본 상한 (바이트)
+#define CONN_URING_IOV         16             // io_uring sendmsg 한 번에 묶는 버퍼 수
+
+// 여러 연결이 함께 참조하는 직렬화된 메시지 (refcount)
+typedef struct NetBuf {
+    int refcnt;
+    size_t len;
+    size_t cap;
+} NetBuf;
+
+static inline char *netbuf_data(NetBuf *b) { return (char *)(b + 1); }
+
+NetBuf *netbuf_new(size_t cap);
+// cJSON 메시지를 한 번 직렬화해서 '\n'까지 붙인 버퍼를 만든다
+NetBuf *netbuf_from_json(const cJSON *msg);
+void netbuf_ref(NetBuf *b);
+void netbuf_unref(NetBuf *b);
+
+// epoll에 등록되는 모든 fd는 이 핸들러를 첫 멤버로 가진다
+typedef struct NetHandler {
+    void (*on_event)(struct NetHandler *h, uint32_t events);
+} NetHandler;
+
+typedef struct Reactor {
+    int epfd;
+    void *batch;            // reactor_poll이 디스패치 중인 epoll 이벤트 배열 (그 밖에서는 NULL)
+    int batch_len;
+    struct ReactorRing *ring;   // io_uring 백엔드 (NULL이면 epoll)
+} Reactor;
+
+int reactor_init(Reactor *r);
+// io_uring 백엔드: 커널이나 빌드가 지원하지 않으면 -1 (호출자가 reactor_init으로 되돌아간다)
+// reactor_add/mod/del은 같은 의미로 동작하고 (poll 요청으로 흉내), TCP 연결과 listen 소켓은
+// multishot recv/accept와 한꺼번에 제출되는 sendmsg로 직접 돌린다
+int reactor_init_uring(Reactor *r);
+void reactor_close(Reactor *r);
+int reactor_add(Reactor *r, int fd, uint32_t events, NetHandler *h);
+int reactor_mod(Reactor *r, int fd, uint32_t events, NetHandler *h);
+void reactor_del(Reactor *r, int fd);
+// 핸들러를 해제하거나 다른 reactor로 넘기기 전에 호출: 디스패치 중인 이벤트 중 아직 안 본 것을 버린다
+void reactor_forget(Reactor *r, NetHandler *h);
+// epoll_wait 한 번 + 이벤트 디스패치. 처리한 이벤트 수, 에러면 -1
+int reactor_poll(Reactor *r, int timeout_ms);
+
+typedef struct Conn {
+    NetHandler handler;
+    int fd;
+    Reactor *reactor;
+    uint32_t events;        // 현재 epoll 관심 이벤트
+    int dead;               // 끊겼거나 high-water 초과로 버려진 연결
+    size_t high_water;      // oq_bytes가 이 값을 넘으면 연결을 끊는다
+
+    size_t in_off, in_len;
+    char inbuf[CONN_INBUF_SIZE];
+
+    NetBuf *outq[CONN_OUTQ_SLOTS];
+    unsigned oq_head, oq_count;
+    size_t oq_off;          // outq[oq_head]에서 이미 보낸 바이트
+    size_t oq_bytes;        // 아직 못 보낸 총 바이트
+    uint64_t oq_since;      // stats: 빈 큐에 처음 넣은 시각 (ns, 재지 않으면 0)
+    int close_when_drained; // 큐를 다 보내면 스스로 해제
+    int corked;             // 0보다 크면 conn_send는 큐에만 넣는다 (conn_uncork에서 한 번에 보냄)
+    int binary;             // 길이 접두 바이너리 프레임을 쓰는 연결 (소유자가 첫 바이트를 보고 정한다)
+
+    ShmLink *shm;           // 공유 메모리 링으로 옮긴 연결 (소켓은 끊김 감지용으로만 남는다)
+    NetHandler shm_handler; // shm->wake_fd 이벤트
+    int passed_fds[SHM_FDS];// unix 소켓으로 같이 넘어온 fd (conn_upgrade_shm이 가져간다)
+    int npassed;
+
+    // io_uring 백엔드에서 소켓 입출력을 직접 요청으로 거는 연결 (unix 소켓은 poll로 흉내 낸 epoll 경로)
+    int native;
+    int uring_ops;          // 완료를 기다리는 요청 수. 0이 될 때까지 해제를 미룬다
+    int rx_armed;           // multishot recv가 걸려 있음
+    int rx_eof;
+    int tx_busy;            // sendmsg가 날아가는 중 (그동안 outq 앞쪽 버퍼는 커널이 읽는다)
+    int kick_busy;
+    int freeing;            // conn_free가 불렸고 남은 완료를 기다리는 중
+    char *spill;            // 받았지만 inbuf에 자리가 없어 따로 둔 입력
+    size_t spill_off, spill_len, spill_cap;
+    struct iovec tx_iov[CONN_URING_IOV];
+    struct msghdr tx_msg;
+
+    // 입력이 들어오거나 연결이 끊기면 호출 (NULL이면 소유자가 직접 꺼내 읽음)
+    // 콜백 안에서 conn_free 해도 된다
+    void (*on_read)(struct Conn *c);
+    struct Conn *prev, *next;   // 소유자가 쓰는 리스트 링크
+    void *user;
+} Conn;
+
+int net_set_nonblocking(int fd);
+
+// fd를 non-blocking으로 바꾸고 reactor에 EPOLLIN으로 등록
+Conn *conn_new(int fd, Reactor *r, size_t high_water);
+// 큐를 비우고 fd를 닫은 뒤 해제
+void conn_free(Conn *c);
+// 큐에 넣고 가능한 만큼 바로 보낸다. 남으면 EPOLLOUT에서 마저 보냄
+int conn_send(Conn *c, NetBuf *b);
+int conn_send_json(Conn *c, const cJSON *msg);
+// 큐에 쌓인 데이터를 보낼 수 있는 만큼 보낸다 (부분 전송 처리)
+int conn_flush(Conn *c);
+// 한 번에 여러 메시지를 보낼 때: cork 동안 쌓인 큐를 마지막 uncork에서 writev 한 번으로 보낸다 (중첩 가능)
+void conn_cork(Conn *c);
+void conn_uncork(Conn *c);
+// 소켓에서 읽을 수 있는 만큼 inbuf로 읽는다. EOF/에러면 -1
+int conn_fill(Conn *c);
+// inbuf에 완성된 한 줄이 있으면 파싱해서 돌려준다
+cJSON *conn_next_json(Conn *c);
+// inbuf에 완성된 [길이 u16 BE][본문] 프레임이 있으면 본문 위치를 돌려주고 1
+// 본문은 inbuf 안을 가리키므로 다음 conn_fill 전까지만 유효하다
+int conn_next_frame(Conn *c, const uint8_t **frame, size_t *len);
+// 차례가 아닌 쪽의 입력을 미리 볼 때 (premove): 꺼내지 않는다. 꺼내려면 conn_skip_json / conn_next_frame
+cJSON *conn_peek_json(Conn *c);
+void conn_skip_json(Conn *c);
+int conn_peek_frame(Conn *c, const uint8_t **frame, size_t *len);
+// 넘겨받은 fd로 입출력을 공유 메모리 링으로 옮긴다. 소켓에 남은 입력은 버린다. 실패하면 -1
+int conn_upgrade_shm(Conn *c);
+// 연결을 끊긴 상태로 표시하고 큐를 버린다 (해제는 소유자가)
+void conn_kill(Conn *c);
+// 다른 reactor 스레드로 넘길 때: 떼어낸 뒤에는 받는 쪽에서 attach 할 때까지 건드리지 않는다
+// 입출력 버퍼는 그대로 따라간다
+void conn_detach(Conn *c);
+int conn_attach(Conn *c, Reactor *r);
+// 남은 큐를 다 보낸 뒤 닫고 해제한다 (거절 응답 후 끊을 때)
+void conn_close_when_drained(Conn *c);
+
+// non-blocking listen 소켓: 읽기 가능해지면 accept4를 EAGAIN까지 반복
+typedef struct Listener {
+    NetHandler handler;
+    int fd;
+    Reactor *reactor;
+    void (*on_accept)(struct Listener *l, int fd);
+    void *user;
+} Listener;
+
+int listener_init(Listener *l, Reactor *r, int fd,
+                  void (*on_accept)(Listener *l, int fd), void *user);
+void listener_close(Listener *l);
+
+// 다른 스레드에서 reactor로 메시지를 넘기는 lock-free MPSC 큐 + eventfd
+typedef struct MailMsg {
+    struct MailMsg *next;
+} MailMsg;
+
+typedef struct Mailbox {
+    NetHandler handler;
+    int efd;
+    Reactor *reactor;
+    MailMsg *head;           // 생산자들이 CAS로 push하는 스택
+    void (*on_msg)(struct Mailbox *mb, MailMsg *m);   // 소유 스레드에서 도착 순서대로 호출
+    void *user;
+} Mailbox;
+
+int mailbox_init(Mailbox *mb, Reactor *r,
+                 void (*on_msg)(Mailbox *mb, MailMsg *m), void *user);
+// 남은 메시지를 on_msg로 넘긴 뒤 닫는다
+void mailbox_close(Mailbox *mb);
+// 아무 스레드에서나 호출 가능
+void mailbox_post(Mailbox *mb, MailMsg *m);
+
+#endif
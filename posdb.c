@@ -0,0 +1,384 @@
+#include "../include/posdb.h"
+#include "../include/gamelog.h"
+#include "../include/engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define POSDB_INITIAL_CAPACITY (1u << 16)
+
+/* ---- 대칭 ---- */
+
+// 행 뒤집기 (r → 7 - r)
+static inline uint64_t flip_rows(uint64_t x) {
+    return __builtin_bswap64(x);
+}
+// 열 뒤집기 (c → 7 - c): 바이트마다 비트 순서를 뒤집는다
+static inline uint64_t flip_cols(uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+    x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+    return x;
+}
+// 대각선 뒤집기 ((r, c) → (c, r))
+static inline uint64_t transpose(uint64_t x) {
+    uint64_t t;
+    t = 0x0F0F0F0F00000000ull & (x ^ (x << 28));
+    x ^= t ^ (t >> 28);
+    t = 0x3333000033330000ull & (x ^ (x << 14));
+    x ^= t ^ (t >> 14);
+    t = 0x5500550055005500ull & (x ^ (x << 7));
+    x ^= t ^ (t >> 7);
+    return x;
+}
+
+// sym 비트: 1 = 행 뒤집기, 2 = 열 뒤집기, 4 = 대각선 뒤집기 (이 순서로 적용)
+static inline uint64_t sym_board(uint64_t x, int sym) {
+    if (sym & 1) x = flip_rows(x);
+    if (sym & 2) x = flip_cols(x);
+    if (sym & 4) x = transpose(x);
+    return x;
+}
+
+static int sym_square(int sq, int sym, int inverse) {
+    int r = sq >> 3, c = sq & 7, t;
+    if (inverse && (sym & 4)) {
+        t = r;
+        r = c;
+        c = t;
+    }
+    if (sym & 1) r = 7 - r;
+    if (sym & 2) c = 7 - c;
+    if (!inverse && (sym & 4)) {
+        t = r;
+        r = c;
+        c = t;
+    }
+    return r * 8 + c;
+}
+
+static uint16_t sym_move(uint16_t mv, int sym, int inverse) {
+    if (mv == POSDB_NO_MOVE) return mv;
+    return (uint16_t)((sym_square(mv >> 6, sym, inverse) << 6) | sym_square(mv & 63, sym, inverse));
+}
+
+typedef struct {
+    uint64_t key;
+    uint64_t mine, theirs, blocked;
+    int sym;                           // 원래 보드 → 정규화한 보드
+} PosKey;
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// 둘 차례 기준으로 바꾸고 8가지 대칭 중 (blocked, mine, theirs)가 가장 작은 것을 고른다
+static void canonicalize(const GameSession *g, int color, PosKey *k) {
+    uint64_t mine = color ? g->blue : g->red;
+    uint64_t theirs = color ? g->red : g->blue;
+    for (int sym = 0; sym < 8; sym++) {
+        uint64_t b = sym_board(g->blocked, sym), m = sym_board(mine, sym), t = sym_board(theirs, sym);
+        if (sym == 0 || b < k->blocked || (b == k->blocked && (m < k->mine || (m == k->mine && t < k->theirs)))) {
+            k->blocked = b;
+            k->mine = m;
+            k->theirs = t;
+            k->sym = sym;
+        }
+    }
+    k->key = mix64(k->mine ^ mix64(k->theirs ^ mix64(k->blocked)));
+    if (k->key == 0) k->key = 1;
+}
+
+/* ---- 표 ---- */
+
+// 같은 국면의 칸, 없으면 그 국면이 들어갈 빈 칸 (*found = 0)
+static PosDbEntry *probe(const PosDb *db, const PosKey *k, int *found) {
+    uint64_t mask = db->hdr->capacity - 1;
+    for (uint64_t i = k->key & mask;; i = (i + 1) & mask) {
+        PosDbEntry *e = &db->entries[i];
+        if (e->key == 0) {
+            *found = 0;
+            return e;
+        }
+        if (e->key == k->key && e->mine == k->mine && e->theirs == k->theirs && e->blocked == k->blocked) {
+            *found = 1;
+            return e;
+        }
+    }
+}
+
+static size_t file_size(uint64_t capacity) {
+    return POSDB_HEADER_SIZE + (size_t)capacity * sizeof(PosDbEntry);
+}
+
+static int map_file(PosDb *db, int fd, size_t len, int writable) {
+    void *p = mmap(NULL, len, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return -1;
+    // 조회는 흩어져 있으므로 미리 읽기를 끈다
+    madvise(p, len, MADV_RANDOM);
+    db->hdr = (PosDbHeader *)p;
+    db->entries = (PosDbEntry *)((char *)p + POSDB_HEADER_SIZE);
+    db->map_len = len;
+    db->fd = fd;
+    return 0;
+}
+
+// 빈 DB 파일 (ftruncate로 잡아 두면 항목은 0 = 빈 칸)
+static int create_file(const char *path, int flags, uint64_t capacity, PosDb *db) {
+    int fd = open(path, flags, 0644);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, (off_t)file_size(capacity)) < 0 || map_file(db, fd, file_size(capacity), 1) < 0) {
+        close(fd);
+        return -1;
+    }
+    memcpy(db->hdr->magic, POSDB_MAGIC, sizeof db->hdr->magic);
+    db->hdr->version = 1;
+    db->hdr->entry_size = sizeof(PosDbEntry);
+    db->hdr->capacity = capacity;
+    return 0;
+}
+
+int posdb_open(PosDb *db, const char *path, int writable) {
+    memset(db, 0, sizeof *db);
+    db->fd = -1;
+    db->writable = writable;
+    db->path = strdup(path);
+    if (!db->path) return -1;
+    int fd = open(path, writable ? O_RDWR | O_CLOEXEC : O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && writable) {
+        if (create_file(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, POSDB_INITIAL_CAPACITY, db) == 0) return 0;
+    }
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || (size_t)st.st_size < POSDB_HEADER_SIZE
+        || map_file(db, fd, (size_t)st.st_size, writable) < 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        posdb_close(db);
+        return -1;
+    }
+    const PosDbHeader *h = db->hdr;
+    if (memcmp(h->magic, POSDB_MAGIC, sizeof h->magic) != 0 || h->version != 1
+        || h->entry_size != sizeof(PosDbEntry) || h->capacity == 0 || (h->capacity & (h->capacity - 1))
+        || file_size(h->capacity) != (size_t)st.st_size) {
+        fprintf(stderr, "%s: not a position database\n", path);
+        posdb_close(db);
+        return -1;
+    }
+    return 0;
+}
+
+void posdb_close(PosDb *db) {
+    if (db->hdr) {
+        if (db->writable) msync(db->hdr, db->map_len, MS_SYNC);
+        munmap(db->hdr, db->map_len);
+    }
+    if (db->fd >= 0) close(db->fd);
+    free(db->path);
+    memset(db, 0, sizeof *db);
+    db->fd = -1;
+}
+
+// 용량을 두 배로: 옆 파일에 다시 넣은 뒤 rename으로 바꿔 끼운다 (중간에 죽어도 원래 파일은 그대로)
+static int grow(PosDb *db) {
+    size_t plen = strlen(db->path);
+    char *tmp = (char *)malloc(plen + 5);
+    if (!tmp) return -1;
+    memcpy(tmp, db->path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+    PosDb next;
+    memset(&next, 0, sizeof next);
+    if (create_file(tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, db->hdr->capacity * 2, &next) < 0) {
+        perror(tmp);
+        free(tmp);
+        return -1;
+    }
+    uint64_t capacity = next.hdr->capacity;
+    memcpy(next.hdr, db->hdr, sizeof *db->hdr);
+    next.hdr->capacity = capacity;
+    for (uint64_t i = 0; i < db->hdr->capacity; i++) {
+        const PosDbEntry *e = &db->entries[i];
+        if (!e->key) continue;
+        uint64_t j = e->key & (capacity - 1);
+        while (next.entries[j].key) j = (j + 1) & (capacity - 1);
+        next.entries[j] = *e;
+    }
+    int ok = msync(next.hdr, next.map_len, MS_SYNC) == 0 && rename(tmp, db->path) == 0;
+    free(tmp);
+    if (!ok) {
+        perror("posdb grow");
+        munmap(next.hdr, next.map_len);
+        close(next.fd);
+        return -1;
+    }
+    munmap(db->hdr, db->map_len);
+    close(db->fd);
+    db->fd = next.fd;
+    db->hdr = next.hdr;
+    db->entries = next.entries;
+    db->map_len = next.map_len;
+    return 0;
+}
+
+const PosDbEntry *posdb_lookup(const PosDb *db, const GameSession *g, int color, uint16_t *best) {
+    PosKey k;
+    int found;
+    canonicalize(g, color, &k);
+    const PosDbEntry *e = probe(db, &k, &found);
+    if (best) *best = found ? sym_move(e->best_move, k.sym, 1) : POSDB_NO_MOVE;
+    return found ? e : NULL;
+}
+
+/* ---- 가져오기 ---- */
+
+// 새 게임이면 1 (되살린 게임의 나머지는 국면만 더하고 0)
+static int import_game(PosDb *db, const GameLogRecord *rec, int depth) {
+    GameSession g;
+    session_init(&g);
+    g.red = rec->red;
+    g.blue = rec->blue;
+    g.blocked = rec->blocked;
+    // 0 = Red 승, 1 = Blue 승, 2 = 무승부, -1 = 끝나지 않은 게임
+    int outcome = -1;
+    if (rec->result == GAMELOG_FINISHED) {
+        outcome = rec->score[0] > rec->score[1] ? 0 : rec->score[1] > rec->score[0] ? 1 : 2;
+    }
+    const uint16_t *mv = gamelog_moves(rec);
+    for (uint32_t i = 0; i < rec->move_count; i++) {
+        int color = (int)((rec->turn + i) & 1);
+        PosKey k;
+        int found;
+        canonicalize(&g, color, &k);
+        PosDbEntry *e = probe(db, &k, &found);
+        if (!found) {
+            memset(e, 0, sizeof *e);
+            e->key = k.key;
+            e->mine = k.mine;
+            e->theirs = k.theirs;
+            e->blocked = k.blocked;
+            e->best_move = POSDB_NO_MOVE;
+            db->hdr->count++;
+        }
+        e->occurrences++;
+        if (outcome == 2) e->draws++;
+        else if (outcome == color) e->wins++;
+        else if (outcome >= 0) e->losses++;
+        if (depth > e->best_depth) {
+            uint16_t b;
+            int score = engine_search(&g, color, depth, &b);
+            e->best_move = sym_move(b, k.sym, 0);
+            e->best_score = (int16_t)(score > 32767 ? 32767 : score < -32767 ? -32767 : score);
+            e->best_depth = (uint8_t)(depth > 255 ? 255 : depth);
+        } else if (e->best_depth == 0 && outcome >= 0) {
+            // 탐색한 적이 없으면 실제 게임에서 가장 크게 이긴 수를 남긴다
+            int margin = rec->score[color] - rec->score[1 - color];
+            if (e->best_move == POSDB_NO_MOVE || margin > e->best_score) {
+                e->best_move = sym_move(mv[i], k.sym, 0);
+                e->best_score = (int16_t)margin;
+            }
+        }
+        if (!session_apply(&g, color, mv[i])) break;
+    }
+    return !(rec->flags & GAMELOG_CONTINUED);
+}
+
+// 같은 로그인지 알아보는 값: 첫 레코드의 게임 번호, 시작 시각, 보드
+static uint64_t log_ident(const GameLogRecord *first) {
+    return mix64(first->start_ms ^ mix64(first->game_id ^ mix64(first->blocked)));
+}
+
+long posdb_import(PosDb *db, const char *log_path, int depth) {
+    GameLogReader rd;
+    if (gamelog_reader_open(&rd, log_path) < 0) {
+        fprintf(stderr, "%s: cannot open game log\n", log_path);
+        return -1;
+    }
+    size_t start = rd.off;
+    const GameLogRecord *first = gamelog_reader_next(&rd);
+    if (!first) {
+        gamelog_reader_close(&rd);
+        return 0;
+    }
+    // 지난번에 어디까지 가져왔는지
+    uint64_t ident = log_ident(first);
+    PosDbHeader *h = db->hdr;
+    PosDbSource *src = NULL;
+    for (int i = 0; i < POSDB_SOURCES; i++) {
+        if (h->sources[i].ident == ident) src = &h->sources[i];
+    }
+    if (!src) {
+        src = &h->sources[h->next_source];
+        h->next_source = (h->next_source + 1) % POSDB_SOURCES;
+        src->ident = ident;
+        src->offset = start;
+    }
+    rd.off = src->offset <= rd.len ? (size_t)src->offset : start;
+
+    long games = 0;
+    const GameLogRecord *rec;
+    while ((rec = gamelog_reader_next(&rd)) != NULL) {
+        // 이 게임의 국면이 다 새것이어도 채움률을 넘지 않게 미리 늘린다
+        while ((double)(db->hdr->count + rec->move_count) > POSDB_MAX_LOAD * (double)db->hdr->capacity) {
+            if (grow(db) < 0) {
+                gamelog_reader_close(&rd);
+                return -1;
+            }
+        }
+        games += import_game(db, rec, depth);
+    }
+    // 항목을 먼저 디스크에 내리고 나서 위치를 옮긴다 (그 사이에 죽으면 다음에 다시 가져온다)
+    msync(db->hdr, db->map_len, MS_SYNC);
+    h = db->hdr;
+    for (int i = 0; i < POSDB_SOURCES; i++) {
+        if (h->sources[i].ident == ident) h->sources[i].offset = rd.off;
+    }
+    h->games += (uint64_t)games;
+    msync(db->hdr, POSDB_HEADER_SIZE, MS_SYNC);
+    gamelog_reader_close(&rd);
+    return games;
+}
+
+void posdb_print_stats(const PosDb *db) {
+    const PosDbHeader *h = db->hdr;
+    uint64_t mask = h->capacity - 1, lines = 0, worst = 0, searched = 0;
+    for (uint64_t i = 0; i < h->capacity; i++) {
+        const PosDbEntry *e = &db->entries[i];
+        if (!e->key) continue;
+        uint64_t d = ((i - (e->key & mask)) & mask) + 1;
+        lines += d;
+        if (d > worst) worst = d;
+        if (e->best_depth) searched++;
+    }
+    printf("positions:   %llu\n", (unsigned long long)h->count);
+    printf("games:       %llu\n", (unsigned long long)h->games);
+    printf("capacity:    %llu (%.1f%% full, %zu MB)\n", (unsigned long long)h->capacity,
+           100.0 * (double)h->count / (double)h->capacity, db->map_len >> 20);
+    printf("probe lines: %.3f avg, %llu max\n", h->count ? (double)lines / (double)h->count : 0.0,
+           (unsigned long long)worst);
+    printf("searched:    %llu\n", (unsigned long long)searched);
+}
+
+int posdb_print_lookup(const PosDb *db, const GameSession *g, int color) {
+    uint16_t best;
+    const PosDbEntry *e = posdb_lookup(db, g, color, &best);
+    if (!e) {
+        printf("{\"found\":false}\n");
+        return -1;
+    }
+    printf("{\"found\":true,\"occurrences\":%u,\"wins\":%u,\"draws\":%u,\"losses\":%u",
+           e->occurrences, e->wins, e->draws, e->losses);
+    if (best == POSDB_NO_MOVE) printf(",\"best\":null");
+    // 프로토콜의 move(sx, sy, tx, ty)처럼 1부터 센다
+    else printf(",\"best\":[%d,%d,%d,%d]", (best >> 6) / 8 + 1, (best >> 6) % 8 + 1, (best & 63) / 8 + 1, (best & 63) % 8 + 1);
+    printf(",\"score\":%d,\"depth\":%u}\n", e->best_score, e->best_depth);
+    return 0;
+}
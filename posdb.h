@@ -0,0 +1,82 @@
+#ifndef POSDB_H
+#define POSDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "session.h"
+
+/*
+ * 게임에 나온 모든 국면을 한 번씩만 담는 위치 DB (파일 하나를 통째로 mmap).
+ *
+ *   파일: [PosDbHeader 4096B] [PosDbEntry 64B x capacity]     capacity는 2의 거듭제곱
+ *
+ * 국면은 둘 차례 기준으로 (mine, theirs, blocked)로 바꾼 뒤 보드의 대칭 8가지 중 가장 작은
+ * 것으로 정규화한다. 그래서 색만 바뀌었거나 돌리고 뒤집은 국면은 같은 항목에 모인다.
+ * 키는 정규화한 보드의 64비트 해시, 자리는 key & (capacity - 1)에서 시작하는 linear probing.
+ * 항목 하나가 캐시 라인 하나라서 채움률 POSDB_MAX_LOAD 이하에서는 보통 첫 줄에서 찾는다.
+ *
+ * 통계(승/무/패, best 수)는 둘 차례인 쪽 기준이고, best 수도 정규화한 방향으로 저장한다
+ * (posdb_lookup이 호출자의 방향으로 되돌려 준다).
+ * 가져오기는 로그마다 읽은 위치를 헤더에 남겨서, 같은 로그를 다시 주면 새 게임만 더한다.
+ */
+#define POSDB_MAGIC        "HW3POSDB"
+#define POSDB_HEADER_SIZE  4096
+#define POSDB_SOURCES      128         // 기억하는 로그 수 (넘치면 가장 오래된 칸을 다시 쓴다)
+#define POSDB_MAX_LOAD     0.7
+#define POSDB_NO_MOVE      0xFFFFu     // best 수 없음 (= WIRE_MOVE_PASS: 둘 수 없는 국면)
+
+typedef struct {
+    uint64_t key;                      // 정규화한 보드의 해시, 0이면 빈 칸
+    uint64_t mine, theirs, blocked;    // 정규화한 보드 (mine = 둘 차례인 쪽)
+    uint32_t occurrences;
+    uint32_t wins, draws, losses;      // 끝난 게임에서 둘 차례인 쪽의 결과
+    uint16_t best_move;                // wire 형식, 정규화한 방향
+    int16_t best_score;                // best_depth > 0: 탐색 점수, 0: 그 수를 둔 게임의 최종 말 수 차이
+    uint8_t best_depth;                // best_move를 찾은 탐색 깊이 (0이면 실제 게임에서 가장 잘 된 수)
+    uint8_t reserved[11];
+} PosDbEntry;
+
+typedef struct {
+    uint64_t ident;                    // 로그 파일을 알아보는 값 (첫 레코드에서 만든다)
+    uint64_t offset;                   // 여기까지 가져왔다
+} PosDbSource;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;                  // 1
+    uint32_t entry_size;               // sizeof(PosDbEntry)
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t games;                    // 가져온 게임 수
+    uint32_t next_source;              // sources가 다 찼을 때 다시 쓸 칸
+    uint32_t pad;
+    PosDbSource sources[POSDB_SOURCES];
+} PosDbHeader;
+
+typedef struct {
+    int fd;
+    int writable;
+    char *path;
+    PosDbHeader *hdr;                  // 매핑 시작
+    PosDbEntry *entries;
+    size_t map_len;
+} PosDb;
+
+// writable이면 없을 때 만든다. 실패하면 -1
+int posdb_open(PosDb *db, const char *path, int writable);
+void posdb_close(PosDb *db);
+
+// color가 둘 차례인 g를 찾는다 (탐침 한 줄로 끝나는 게 보통). 없으면 NULL
+// best가 NULL이 아니면 항목의 best 수를 g의 방향으로 돌려서 넣는다 (없으면 POSDB_NO_MOVE)
+const PosDbEntry *posdb_lookup(const PosDb *db, const GameSession *g, int color, uint16_t *best);
+
+// 로그에서 지난번 이후의 게임을 더한다. depth > 0이면 처음 보는 국면마다 그 깊이로 best 수를 찾는다
+// 더한 게임 수 (되살린 게임의 나머지 레코드는 국면만 더하고 세지 않는다), 실패하면 -1
+long posdb_import(PosDb *db, const char *log_path, int depth);
+
+// hw3 posdb stats: 항목 수, 채움률, 평균 탐침 줄 수
+void posdb_print_stats(const PosDb *db);
+// hw3 posdb lookup: 국면 하나의 항목을 JSON 한 줄로. 없으면 -1
+int posdb_print_lookup(const PosDb *db, const GameSession *g, int color);
+
+#endif
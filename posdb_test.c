@@ -0,0 +1,238 @@
+#include "../include/posdb.h"
+#include "../include/gamelog.h"
+#include "../include/wire.h"
+#include "../include/test.h"
+#include "../include/test_game.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * posdb.c: 알려진 게임들을 로그에 남긴 뒤 가져와서, 국면마다 나온 횟수와 승/무/패가
+ * 여기서 따로 센 것(대칭 8가지와 색 바꿈을 같은 국면으로 본다)과 같은지 본다.
+ * 장애물 없는 게임을 섞어서 시작 국면과 대칭인 첫 수들이 한 항목에 모이게 한다.
+ * 같은 로그를 다시 가져오면 아무것도 더하지 않고, 다시 열어도 그대로여야 한다.
+ * 몇 게임은 중간에 끊고(GAMELOG_UNFINISHED) 되살린 게임처럼 이어 쓴다: 이어 쓴 레코드는 게임 수에
+ * 들지 않고, 그 국면은 되살린 차례의 색으로 센다.
+ */
+#define GAMES     60
+#define MAX_PLIES 600
+#define MAX_POS   (GAMES * MAX_PLIES)
+
+typedef struct {
+    uint64_t mine, theirs, blocked;    // 정규화한 보드 (이 시험 나름의 순서로 가장 작은 것)
+    GameSession g;                     // 이 국면이 나온 보드 하나
+    int color;
+    uint32_t occurrences, wins, draws, losses;
+} Position;
+
+static Position positions[MAX_POS];
+static int npositions;
+
+// t의 비트 0: 행/열 바꿈, 1: 위아래 뒤집기, 2: 좌우 뒤집기
+static uint64_t transform(uint64_t bits, int t) {
+    uint64_t out = 0;
+    for (int i = 0; i < 64; i++) {
+        if (!(bits >> i & 1)) continue;
+        int r = i / 8, c = i % 8;
+        if (t & 1) {
+            int tmp = r;
+            r = c;
+            c = tmp;
+        }
+        if (t & 2) r = 7 - r;
+        if (t & 4) c = 7 - c;
+        out |= 1ull << (r * 8 + c);
+    }
+    return out;
+}
+
+static Position *find_or_add(const GameSession *g, int color) {
+    uint64_t mine = color ? g->blue : g->red, theirs = color ? g->red : g->blue;
+    uint64_t best[3] = { 0, 0, 0 };
+    for (int t = 0; t < 8; t++) {
+        uint64_t k[3] = { transform(mine, t), transform(theirs, t), transform(g->blocked, t) };
+        if (t == 0 || k[0] < best[0] || (k[0] == best[0] && (k[1] < best[1] || (k[1] == best[1] && k[2] < best[2])))) {
+            memcpy(best, k, sizeof best);
+        }
+    }
+    for (int i = 0; i < npositions; i++) {
+        Position *p = &positions[i];
+        if (p->mine == best[0] && p->theirs == best[1] && p->blocked == best[2]) return p;
+    }
+    Position *p = &positions[npositions++];
+    memset(p, 0, sizeof *p);
+    p->mine = best[0];
+    p->theirs = best[1];
+    p->blocked = best[2];
+    p->g = *g;
+    p->color = color;
+    return p;
+}
+
+// 게임 하나를 두면서 (수를 두기 전 국면마다) 센다. 끝까지 가지 못한 게임은 결과를 세지 않는다
+static void play_game(GameRecorder *rec, uint32_t id) {
+    TestGame t;
+    GameSession *g = &t.g;
+    Position *seen[MAX_PLIES];
+    int plies = 0, result = GAMELOG_ABANDONED;
+    int split = id % 5 == 0 ? (int)(id % 9) + 1 : -1;    // 이 수 앞에서 서버가 다시 뜬다
+    int resumed = 0;                   // 앞 레코드에 들어간 국면 수
+    test_game_start(&t, id);
+    if (id % 2 == 0) {
+        session_init(g);               // 장애물 없음: 시작 국면이 모두 같다
+        g->id = id;
+    }
+    recorder_start(rec, g, t.name[0], t.name[1]);
+    while (plies < MAX_PLIES) {
+        if (test_game_over(g)) {
+            result = GAMELOG_FINISHED;
+            break;
+        }
+        if (plies == split) {
+            recorder_finish(rec, g, GAMELOG_UNFINISHED);
+            recorder_resume(rec, g, t.name[0], t.name[1]);
+            resumed = plies;
+        }
+        seen[plies++] = find_or_add(g, g->turn);
+        recorder_move(rec, g, test_random_step(g, NULL));
+    }
+    recorder_finish(rec, g, result);
+
+    // 0 = Red 승, 1 = Blue 승, 2 = 무승부
+    int red = session_count(g, 0), blue = session_count(g, 1);
+    int outcome = red > blue ? 0 : blue > red ? 1 : 2;
+    for (int i = 0; i < plies; i++) {
+        Position *p = seen[i];
+        int color = i & 1;
+        p->occurrences++;
+        if (result != GAMELOG_FINISHED || i < resumed) continue;    // 앞 레코드는 끝나지 않은 게임
+        if (outcome == 2) p->draws++;
+        else if (outcome == color) p->wins++;
+        else p->losses++;
+    }
+}
+
+static void record_games(const char *path) {
+    Reactor reactor;
+    TimerWheel wheel;
+    GameRecorder rec;
+    CHECK(reactor_init(&reactor) == 0);
+    CHECK(timer_wheel_init(&wheel, &reactor) == 0);
+    GameLog *log = gamelog_open(path, GAMELOG_SYNC_NONE, 0);
+    CHECK(log != NULL);
+    if (!log) return;
+    recorder_init(&rec, log, &wheel);
+    for (uint32_t id = 1; id <= GAMES; id++) play_game(&rec, id);
+    recorder_close(&rec);
+    gamelog_close(log);
+    timer_wheel_close(&wheel);
+    reactor_close(&reactor);
+}
+
+static void check_db(const PosDb *db) {
+    CHECK(db->hdr->games == GAMES);
+    CHECK(db->hdr->count == (uint64_t)npositions);
+    for (int i = 0; i < npositions; i++) {
+        Position *p = &positions[i];
+        uint16_t best = 0;
+        const PosDbEntry *e = posdb_lookup(db, &p->g, p->color, &best);
+        CHECK(e != NULL);
+        if (!e) continue;
+        CHECK(e->occurrences == p->occurrences);
+        CHECK(e->wins == p->wins && e->draws == p->draws && e->losses == p->losses);
+        // best 수는 물어본 보드의 방향으로 돌아와서 그 보드에서 둘 수 있어야 한다
+        if (best != POSDB_NO_MOVE) {
+            int r1, c1, r2, c2;
+            wire_move_coords(best, &r1, &c1, &r2, &c2);
+            CHECK(session_is_valid_move(&p->g, p->color, r1, c1, r2, c2));
+        }
+        // 색을 바꾼 국면도 같은 항목이다
+        GameSession swapped = p->g;
+        swapped.red = p->g.blue;
+        swapped.blue = p->g.red;
+        CHECK(posdb_lookup(db, &swapped, 1 - p->color, NULL) == e);
+    }
+}
+
+// posdb_print_lookup이 찍는 best는 프로토콜 move처럼 1부터 센 좌표다
+static void check_print(const PosDb *db) {
+    const Position *p = NULL;
+    uint16_t best = POSDB_NO_MOVE;
+    for (int i = 0; i < npositions && best == POSDB_NO_MOVE; i++) {
+        p = &positions[i];
+        posdb_lookup(db, &p->g, p->color, &best);
+    }
+    CHECK(best != POSDB_NO_MOVE);
+    if (best == POSDB_NO_MOVE) return;
+    FILE *f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(f), STDOUT_FILENO);
+    CHECK(posdb_print_lookup(db, &p->g, p->color) == 0);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    char line[256] = "";
+    rewind(f);
+    CHECK(fgets(line, sizeof line, f) != NULL);
+    fclose(f);
+    int r1, c1, r2, c2, got[4] = { 0, 0, 0, 0 };
+    const char *b = strstr(line, "\"best\":[");
+    CHECK(b && sscanf(b, "\"best\":[%d,%d,%d,%d]", &got[0], &got[1], &got[2], &got[3]) == 4);
+    wire_move_coords(best, &r1, &c1, &r2, &c2);
+    CHECK(got[0] == r1 + 1 && got[1] == c1 + 1 && got[2] == r2 + 1 && got[3] == c2 + 1);
+}
+
+int main(void) {
+    char log_path[] = "/tmp/posdb_test_logXXXXXX";
+    char db_path[] = "/tmp/posdb_test_dbXXXXXX";
+    int fd = mkstemp(log_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    fd = mkstemp(db_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        unlink(log_path);
+        return 1;
+    }
+    close(fd);
+    unlink(db_path);                   // posdb_open이 새로 만든다
+    srand(1);
+
+    record_games(log_path);
+    Position *start = NULL;
+    for (int i = 0; i < npositions; i++) {
+        if (positions[i].occurrences >= GAMES / 2) start = &positions[i];
+    }
+    CHECK(start != NULL);              // 장애물 없는 게임의 시작 국면
+
+    PosDb db;
+    CHECK(posdb_open(&db, db_path, 1) == 0);
+    CHECK(posdb_import(&db, log_path, 0) == GAMES);
+    check_db(&db);
+    CHECK(posdb_import(&db, log_path, 0) == 0);     // 이미 가져온 로그
+    check_db(&db);
+    posdb_close(&db);
+
+    CHECK(posdb_open(&db, db_path, 0) == 0);
+    check_db(&db);
+    check_print(&db);
+    GameSession empty;
+    session_init(&empty);
+    empty.red = empty.blue = 0;
+    CHECK(posdb_lookup(&db, &empty, 0, NULL) == NULL);
+    posdb_close(&db);
+
+    unlink(log_path);
+    unlink(db_path);
+    return test_report("posdb_test");
+}
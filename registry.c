@@ -0,0 +1,253 @@
+#include "../include/registry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define REG_STRIPES      (1u << REGISTRY_STRIPE_BITS)
+#define REG_INITIAL_CAP  64            // stripe당 초기 슬롯 수 (2의 거듭제곱)
+#define REG_NAMES_CHUNK  256           // 이름 셀을 한 번에 할당하는 개수
+
+typedef struct {
+    uint64_t hash;
+    const char *name;                  // NULL이면 빈 슬롯
+    uint64_t value;
+} RegSlot;
+
+// 고정 크기 이름 셀. 비어 있으면 next로 free list를 이룬다
+typedef union NameCell {
+    union NameCell *next;
+    char name[REGISTRY_NAME_MAX];
+} NameCell;
+
+typedef struct NameChunk {
+    struct NameChunk *next;
+    NameCell cells[REG_NAMES_CHUNK];
+} NameChunk;
+
+typedef struct {
+    pthread_mutex_t lock;
+    RegSlot *slots;
+    size_t cap, count;
+    NameCell *free_names;
+    NameChunk *chunks;
+} __attribute__((aligned(64))) RegStripe;   // stripe끼리 캐시 라인을 나눠 쓰지 않게
+
+struct Registry {
+    RegStripe stripes[REG_STRIPES];
+};
+
+static uint64_t name_hash(const char *name) {
+    // FNV-1a 뒤에 비트를 한 번 더 섞어서 상위 비트(stripe)와 하위 비트(slot)를 둘 다 쓴다
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+static const char *intern_name(RegStripe *st, const char *name) {
+    if (!st->free_names) {
+        NameChunk *c = (NameChunk *)malloc(sizeof(NameChunk));
+        if (!c) return NULL;
+        c->next = st->chunks;
+        st->chunks = c;
+        for (int i = REG_NAMES_CHUNK - 1; i >= 0; i--) {
+            c->cells[i].next = st->free_names;
+            st->free_names = &c->cells[i];
+        }
+    }
+    NameCell *cell = st->free_names;
+    st->free_names = cell->next;
+    // strncpy는 짧은 이름 뒤를 셀 끝까지 0으로 채운다. 길이를 재서 그만큼만 복사한다
+    size_t len = strnlen(name, REGISTRY_NAME_MAX - 1);
+    memcpy(cell->name, name, len);
+    cell->name[len] = '\0';
+    return cell->name;
+}
+
+static void release_name(RegStripe *st, const char *name) {
+    NameCell *cell = (NameCell *)(void *)name;
+    cell->next = st->free_names;
+    st->free_names = cell;
+}
+
+static RegStripe *stripe_of(Registry *reg, uint64_t h) {
+    return &reg->stripes[h >> (64 - REGISTRY_STRIPE_BITS)];
+}
+
+// 이름이 있는 슬롯, 없으면 넣을 빈 슬롯의 인덱스
+static size_t probe(const RegStripe *st, uint64_t h, const char *name) {
+    size_t mask = st->cap - 1;
+    size_t i = (size_t)h & mask;
+    while (st->slots[i].name) {
+        if (st->slots[i].hash == h && strcmp(st->slots[i].name, name) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int stripe_grow(RegStripe *st) {
+    size_t ncap = st->cap ? st->cap * 2 : REG_INITIAL_CAP;
+    RegSlot *ns = (RegSlot *)calloc(ncap, sizeof(RegSlot));
+    if (!ns) return -1;
+    for (size_t i = 0; i < st->cap; i++) {
+        if (!st->slots[i].name) continue;
+        size_t j = (size_t)st->slots[i].hash & (ncap - 1);
+        while (ns[j].name) j = (j + 1) & (ncap - 1);
+        ns[j] = st->slots[i];
+    }
+    free(st->slots);
+    st->slots = ns;
+    st->cap = ncap;
+    return 0;
+}
+
+Registry *registry_new(void) {
+    Registry *reg = NULL;
+    if (posix_memalign((void **)&reg, 64, sizeof(Registry)) != 0) return NULL;
+    memset(reg, 0, sizeof(Registry));
+    for (unsigned i = 0; i < REG_STRIPES; i++) {
+        pthread_mutex_init(&reg->stripes[i].lock, NULL);
+    }
+    return reg;
+}
+
+void registry_free(Registry *reg) {
+    if (!reg) return;
+    for (unsigned i = 0; i < REG_STRIPES; i++) {
+        RegStripe *st = &reg->stripes[i];
+        NameChunk *c = st->chunks;
+        while (c) {
+            NameChunk *next = c->next;
+            free(c);
+            c = next;
+        }
+        free(st->slots);
+        pthread_mutex_destroy(&st->lock);
+    }
+    free(reg);
+}
+
+int registry_insert(Registry *reg, const char *name, uint64_t value, const char **interned) {
+    uint64_t h = name_hash(name);
+    RegStripe *st = stripe_of(reg, h);
+    int ret = 0;
+
+    pthread_mutex_lock(&st->lock);
+    // 적재율 3/4를 넘기 전에 늘린다
+    if ((st->count + 1) * 4 > st->cap * 3 && stripe_grow(st) < 0) {
+        ret = -2;
+    } else {
+        size_t i = probe(st, h, name);
+        if (st->slots[i].name) {
+            ret = -1;
+        } else {
+            const char *copy = intern_name(st, name);
+            if (!copy) {
+                ret = -2;
+            } else {
+                st->slots[i].hash = h;
+                st->slots[i].name = copy;
+                st->slots[i].value = value;
+                st->count++;
+                if (interned) *interned = copy;
+            }
+        }
+    }
+    pthread_mutex_unlock(&st->lock);
+    return ret;
+}
+
+int registry_remove(Registry *reg, const char *name) {
+    uint64_t h = name_hash(name);
+    RegStripe *st = stripe_of(reg, h);
+    int ret = -1;
+
+    pthread_mutex_lock(&st->lock);
+    if (st->cap) {
+        size_t mask = st->cap - 1;
+        size_t i = probe(st, h, name);
+        if (st->slots[i].name) {
+            release_name(st, st->slots[i].name);
+            st->slots[i].name = NULL;
+            st->count--;
+            ret = 0;
+            // tombstone 없이 뒤에 이어진 항목을 제자리 쪽으로 당긴다 (backward shift)
+            size_t j = i;
+            for (;;) {
+                j = (j + 1) & mask;
+                if (!st->slots[j].name) break;
+                size_t home = (size_t)st->slots[j].hash & mask;
+                // home이 (i, j] 구간 밖이면 i로 옮겨도 탐색 경로가 끊기지 않는다
+                if (((j - home) & mask) >= ((j - i) & mask)) {
+                    st->slots[i] = st->slots[j];
+                    st->slots[j].name = NULL;
+                    i = j;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&st->lock);
+    return ret;
+}
+
+int registry_lookup(Registry *reg, const char *name, uint64_t *value) {
+    uint64_t h = name_hash(name);
+    RegStripe *st = stripe_of(reg, h);
+    int ret = -1;
+
+    pthread_mutex_lock(&st->lock);
+    if (st->cap) {
+        size_t i = probe(st, h, name);
+        if (st->slots[i].name) {
+            if (value) *value = st->slots[i].value;
+            ret = 0;
+        }
+    }
+    pthread_mutex_unlock(&st->lock);
+    return ret;
+}
+
+int registry_visit(Registry *reg, const char *name, void (*fn)(uint64_t value, void *arg), void *arg) {
+    uint64_t h = name_hash(name);
+    RegStripe *st = stripe_of(reg, h);
+    int ret = -1;
+
+    pthread_mutex_lock(&st->lock);
+    if (st->cap) {
+        size_t i = probe(st, h, name);
+        if (st->slots[i].name) {
+            fn(st->slots[i].value, arg);
+            ret = 0;
+        }
+    }
+    pthread_mutex_unlock(&st->lock);
+    return ret;
+}
+
+size_t registry_count(Registry *reg) {
+    size_t total = 0;
+    for (unsigned i = 0; i < REG_STRIPES; i++) {
+        pthread_mutex_lock(&reg->stripes[i].lock);
+        total += reg->stripes[i].count;
+        pthread_mutex_unlock(&reg->stripes[i].lock);
+    }
+    return total;
+}
+
+void registry_foreach(Registry *reg, void (*fn)(const char *name, uint64_t value, void *arg), void *arg) {
+    for (unsigned i = 0; i < REG_STRIPES; i++) {
+        RegStripe *st = &reg->stripes[i];
+        pthread_mutex_lock(&st->lock);
+        for (size_t j = 0; j < st->cap; j++) {
+            if (st->slots[j].name) fn(st->slots[j].name, st->slots[j].value, arg);
+        }
+        pthread_mutex_unlock(&st->lock);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 접속 중인 사용자 이름 → 세션 핸들. 이름 해시 상위 비트로 stripe를 고르고
+// stripe마다 락 하나 + open addressing 테이블을 둔다 (여러 reactor 스레드에서 동시 사용)
+#define REGISTRY_NAME_MAX 32           // '\0' 포함
+#define REGISTRY_STRIPE_BITS 6         // 64 stripes
+
+typedef struct Registry Registry;
+
+Registry *registry_new(void);
+void registry_free(Registry *reg);
+
+// 새 이름이면 등록하고 0, 이미 있으면 -1, 메모리 부족이면 -2
+// interned가 NULL이 아니면 registry가 가진 이름 사본을 돌려준다 (remove 전까지 유효)
+int registry_insert(Registry *reg, const char *name, uint64_t value, const char **interned);
+// 있으면 지우고 0, 없으면 -1
+int registry_remove(Registry *reg, const char *name);
+// 있으면 *value에 넣고 0, 없으면 -1
+int registry_lookup(Registry *reg, const char *name, uint64_t *value);
+// 있으면 stripe 락을 잡은 채로 fn(value, arg)를 부르고 0, 없으면 -1
+// (fn이 도는 동안에는 그 항목이 지워지지 않는다)
+int registry_visit(Registry *reg, const char *name, void (*fn)(uint64_t value, void *arg), void *arg);
+size_t registry_count(Registry *reg);
+// 모든 항목에 대해 fn 호출 (stripe 락을 잡은 채로 호출하므로 fn 안에서 registry를 건드리지 말 것)
+void registry_foreach(Registry *reg, void (*fn)(const char *name, uint64_t value, void *arg), void *arg);
+
+#endif
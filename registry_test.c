@@ -0,0 +1,169 @@
+#include "../include/registry.h"
+#include "../include/test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * registry.c: 이름을 잔뜩 넣어 stripe마다 긴 탐침 구간을 만든 뒤 무작위 순서로 지우면서,
+ * 지울 때마다 남은 이름이 모두 그대로 찾아지는지 본다 (backward shift가 탐색 경로를 끊으면 여기서 걸린다).
+ * 스레드 여럿이 각자 이름을 넣고 지우고 찾는 것도 돌린다.
+ */
+#define NAMES    4000
+#define THREADS  4
+#define OPS      200000
+
+static char names[NAMES][REGISTRY_NAME_MAX];
+static int present[NAMES];
+
+static void make_names(void) {
+    for (int i = 0; i < NAMES; i++) snprintf(names[i], sizeof names[i], "user%d", i * 7919);
+}
+
+static void shuffle(int *a, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand() % (i + 1), t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+// 모델과 같은지: 있는 이름은 값까지, 지운 이름은 없어야 한다
+static void check_all(Registry *reg) {
+    size_t live = 0;
+    for (int i = 0; i < NAMES; i++) {
+        uint64_t v = 0;
+        int r = registry_lookup(reg, names[i], &v);
+        CHECK(r == (present[i] ? 0 : -1));
+        if (present[i]) {
+            CHECK(v == (uint64_t)i);
+            live++;
+        }
+    }
+    CHECK(registry_count(reg) == live);
+}
+
+static void count_entry(const char *name, uint64_t value, void *arg) {
+    size_t *n = (size_t *)arg;
+    CHECK(value < NAMES && strcmp(name, names[value]) == 0);
+    (*n)++;
+}
+
+static void test_backward_shift(void) {
+    Registry *reg = registry_new();
+    CHECK(reg != NULL);
+    if (!reg) return;
+    int order[NAMES];
+    for (int i = 0; i < NAMES; i++) order[i] = i;
+
+    for (int round = 0; round < 3; round++) {
+        shuffle(order, NAMES);
+        for (int k = 0; k < NAMES; k++) {
+            int i = order[k];
+            const char *interned = NULL;
+            if (present[i]) {
+                CHECK(registry_insert(reg, names[i], 0, NULL) == -1);
+                continue;
+            }
+            CHECK(registry_insert(reg, names[i], (uint64_t)i, &interned) == 0);
+            CHECK(interned && interned != names[i] && strcmp(interned, names[i]) == 0);
+            present[i] = 1;
+        }
+        check_all(reg);
+        size_t seen = 0;
+        registry_foreach(reg, count_entry, &seen);
+        CHECK(seen == NAMES);
+
+        // 지울 때마다 전부 다시 찾아본다 (마지막 라운드는 일부만 남긴다)
+        shuffle(order, NAMES);
+        int keep = round == 2 ? NAMES / 3 : 0;
+        for (int k = 0; k < NAMES - keep; k++) {
+            int i = order[k];
+            CHECK(registry_remove(reg, names[i]) == 0);
+            CHECK(registry_remove(reg, names[i]) == -1);
+            present[i] = 0;
+            if (k % 16 == 0 || k > NAMES - keep - 64) check_all(reg);
+        }
+        check_all(reg);
+    }
+
+    // 긴 이름은 REGISTRY_NAME_MAX - 1자로 잘린 사본이 남는다 (서버는 넣기 전에 잘라서 찾는다)
+    char long_name[REGISTRY_NAME_MAX * 2];
+    memset(long_name, 'x', sizeof long_name - 1);
+    long_name[sizeof long_name - 1] = '\0';
+    const char *interned = NULL;
+    CHECK(registry_insert(reg, long_name, 1, &interned) == 0);
+    CHECK(interned && strlen(interned) == REGISTRY_NAME_MAX - 1);
+    CHECK(strncmp(interned, long_name, REGISTRY_NAME_MAX - 1) == 0);
+    registry_free(reg);
+}
+
+typedef struct {
+    Registry *reg;
+    int id;
+    int errors;
+} Worker;
+
+// 스레드마다 자기 이름만 다루므로 자기 모델과 항상 같아야 한다
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    enum { MINE = 1000 };
+    char mine[MINE][REGISTRY_NAME_MAX];
+    int here[MINE];
+    unsigned seed = (unsigned)w->id + 1;
+    for (int i = 0; i < MINE; i++) {
+        snprintf(mine[i], sizeof mine[i], "t%d-%d", w->id, i);
+        here[i] = 0;
+    }
+    for (int op = 0; op < OPS; op++) {
+        int i = (int)(rand_r(&seed) % MINE);
+        uint64_t v = 0;
+        switch (rand_r(&seed) % 3) {
+        case 0:
+            if (registry_insert(w->reg, mine[i], (uint64_t)i, NULL) != (here[i] ? -1 : 0)) w->errors++;
+            here[i] = 1;
+            break;
+        case 1:
+            if (registry_remove(w->reg, mine[i]) != (here[i] ? 0 : -1)) w->errors++;
+            here[i] = 0;
+            break;
+        default:
+            if (registry_lookup(w->reg, mine[i], &v) != (here[i] ? 0 : -1)) w->errors++;
+            if (here[i] && v != (uint64_t)i) w->errors++;
+            break;
+        }
+    }
+    for (int i = 0; i < MINE; i++) {
+        if (here[i] && registry_remove(w->reg, mine[i]) != 0) w->errors++;
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    Registry *reg = registry_new();
+    CHECK(reg != NULL);
+    if (!reg) return;
+    pthread_t tid[THREADS];
+    Worker w[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        w[i].reg = reg;
+        w[i].id = i;
+        w[i].errors = 0;
+        pthread_create(&tid[i], NULL, worker_main, &w[i]);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(tid[i], NULL);
+        CHECK(w[i].errors == 0);
+    }
+    CHECK(registry_count(reg) == 0);
+    registry_free(reg);
+}
+
+int main(void) {
+    srand(1);
+    make_names();
+    test_backward_shift();
+    test_threads();
+    return test_report("registry_test");
+}
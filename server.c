@@ -1,8 +1,22 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // pthread_setaffinity_np
+#endif
 #include "../include/client.h"
-#include "../include/game.h"
 #include "../libs/cJSON.h"
 #include "../include/json.h"
 #include "../include/board.h"
+#include "../include/arena.h"
+#include "../include/net.h"
+#include "../include/timer.h"
+#include "../include/registry.h"
+#include "../include/session.h"
+#include "../include/delta.h"
+#include "../include/watch.h"
+#include "../include/wire.h"
+#include "../include/gamelog.h"
+#include "../include/checkpoint.h"
+#include "../include/stats.h"
+#include "../include/trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,59 +24,368 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <pthread.h>
+#include <sched.h>
+#include <sys/random.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <signal.h>
 
-static GameState game;
-static int global_listen_fd;
-
-void init_game(GameState *game);
-void broadcast_json(const cJSON *msg);
-void send_to_client(int sockfd, const cJSON *msg);
-static cJSON *board_to_json(const GameState *game);
-static int create_listen_socket(const char *port);
-static void *reject_late_clients(void *arg);
-static int accept_and_register(int listen_fd);
-static void game_loop(void);
+/* shard mailbox로 오가는 메시지의 공통 머리 */
+typedef struct {
+    MailMsg mail;
+    int kind;                   // SHARD_MSG_*
+} ShardMsg;
+
+/* reactor 스레드 하나가 맡는 몫: listen 소켓, epoll, 타이머 휠, 게임들을 각자 가진다 */
+typedef struct Shard {
+    int id;
+    pthread_t thread;
+    Reactor reactor;
+    TimerWheel wheel;
+    Listener listener;
+    Listener unix_listener;     // shard 0만: 같은 호스트 클라이언트용 unix 소켓 (-U)
+    Mailbox mailbox;            // lobby 배정, 다른 shard에서 넘겨받는 플레이어, 관전 이벤트
+    SessionPool sessions;       // 이 shard에서 돌아가는 게임들 (수는 제한 없음)
+    Conn *pending_conns;        // accept 했지만 아직 register 전인 연결
+    WatchTable watchers;        // 이 shard에 접속한 관전자
+    size_t watching;            // watchers.count (다른 shard가 fan-out 여부를 볼 때 atomic으로 읽음)
+    ShardMsg flush_msg;         // 관전자 전송을 나눠서 이어가기 위해 자기 mailbox에 넣는 메시지
+    int flush_posted;
+    GameRecorder recorder;      // 이 shard 게임들의 기록 (-l 없으면 아무것도 안 함)
+    Checkpointer checkpointer;  // 이 shard 게임들의 체크포인트 (--checkpoint 없으면 아무것도 안 함)
+    ShardMsg stop_msg;          // server_stop이 넣는다
+    int stopping;
+} Shard;
+
+/* 등록을 마친 사용자. 연결이 끊길 때까지 lobby와 게임 사이를 오간다 */
+typedef struct LobbyEntry {
+    ShardMsg msg;               // shard 사이 이동 메시지 (한 번에 하나만 오간다)
+    struct Shard *target;       // 매칭된 게임의 shard
+    struct LobbyEntry *partner; // SHARD_MSG_MATCH: 상대
+    GameSession *game;          // 앉아 있는(혹은 가는 중인) 게임
+    int seat;
+    struct LobbyEntry *prev, *next;          // 매칭 대기열 (bucket별 FIFO)
+    Shard *home;                // conn을 소유한 shard
+    uint32_t game_id;           // 진행 중인 게임 (없으면 0). 관전 요청이 registry를 통해 읽는다
+    Conn *conn;
+    uint32_t id;                // 사용자 테이블 인덱스 (GameSession.player에 들어감)
+    const char *username;       // registry에 intern된 이름
+    int rating;
+    int bucket;
+    int queued;                 // 대기열에 있으면 1 (lobby.lock으로 보호)
+    int delta;                  // register에서 "delta": true → 보드 대신 변경분을 받는다
+    int combined;               // register에서 "combined": true → 자기 차례를 여는 결과 메시지가 your_turn을 겸한다
+    uint16_t premove;           // 상대 차례에 미리 보낸 수 (wire 형식, PREMOVE_NONE이면 없음)
+    uint16_t premove_if;        // 상대가 이 수를 두면 premove를 둔다 (WIRE_MOVE_ANY면 무엇이든)
+    int premove_armed;          // 차례가 왔고 조건이 맞음 → your_turn 없이 session_run이 바로 둔다
+    int resuming;               // 연결 없이 자리만 지키는 중: 같은 이름과 token의 register로 다시 앉는다
+    uint64_t token;             // resume token (register_ack로 알려준다)
+    Timer grace_timer;          // resuming일 때: 만료되면 게임을 끝낸다
+    uint64_t turn_ns;           // stats: 차례를 알린 시각 (재지 않으면 0)
+} LobbyEntry;
+
+#define LOBBY_BUCKETS 64
+
+/* 매칭 대기열. register/게임 종료 때만 잡는 락이라 게임 진행과는 무관 */
+typedef struct {
+    pthread_mutex_t lock;
+    LobbyEntry *head[LOBBY_BUCKETS], *tail[LOBBY_BUCKETS];
+    int count[LOBBY_BUCKETS];
+} Lobby;
+
+typedef struct {
+    LobbyEntry *player[MAX_CLIENTS];
+} Match;
+
+/* user id → LobbyEntry. 4096개 단위 chunk라 한 번 만든 칸의 주소는 바뀌지 않는다.
+   빈 칸은 (다음 빈 id << 1 | 1)을 담아 free list를 이룬다. id 0은 쓰지 않는다 */
+#define USER_CHUNK_BITS 12
+#define USER_CHUNK_SIZE (1u << USER_CHUNK_BITS)
+#define USER_CHUNKS     1024
+typedef struct {
+    pthread_mutex_t lock;
+    uintptr_t *chunk[USER_CHUNKS];
+    uint32_t next_id;           // 한 번도 쓰지 않은 가장 작은 id
+    uint32_t free_head;         // 반환된 id 목록 (0이면 없음)
+} UserTable;
+
+/* 관전자. 접속한 shard에 그대로 두고, 게임 shard가 보내는 fan-out 메시지로 이벤트를 받는다 */
+typedef struct {
+    ShardMsg msg;               // 게임 shard에 스냅샷 요청 → 응답
+    Watcher watch;              // watch.conn이 NULL이면 응답을 기다리는 중에 연결이 끊긴 것
+    Shard *home;
+    char player[REGISTRY_NAME_MAX];
+    NetBuf *snapshot;           // 게임 shard가 채운 spectate_ack (NULL이면 게임이 없음)
+} Spectator;
+
+/* 게임 이벤트 하나를 다른 shard의 관전자들에게. 버퍼는 모든 shard가 같이 참조한다 */
+typedef struct {
+    ShardMsg msg;
+    uint32_t game;
+    int final;                  // game_over: 보낸 뒤 그 게임의 관전자 연결을 닫는다
+    NetBuf *buf;
+    NetBuf *delta;              // 변경분 버전 (없으면 NULL)
+} FanoutMsg;
+
+/* 비어 있는 자리의 이름으로 들어온 register: 연결째 게임 shard로 넘긴다 */
+typedef struct {
+    ShardMsg msg;
+    Conn *conn;
+    char name[REGISTRY_NAME_MAX];
+    int delta, combined;
+    uint64_t token;
+} ResumeMsg;
+
+/* ShardMsg.kind
+   MATCH:    0번 자리 사용자의 home shard에 게임을 열어달라고 요청 (그 shard가 게임을 맡는다)
+   MOVE:     상대의 home shard에 게임 shard로 옮겨달라고 요청
+   HANDOFF:  게임 shard에 연결을 넘김
+   RESUME:   되살린 게임의 빈 자리에 새 연결을 앉힘
+   SNAPSHOT: 관전 시작 (관전자 shard → 게임 shard → 관전자 shard)
+   FANOUT:   관전자에게 보낼 게임 이벤트
+   FLUSH:    관전자 전송 이어가기 (자기 자신에게) */
+enum { SHARD_MSG_MATCH, SHARD_MSG_MOVE, SHARD_MSG_HANDOFF,
+       SHARD_MSG_SNAPSHOT, SHARD_MSG_SNAPSHOT_DONE, SHARD_MSG_FANOUT, SHARD_MSG_FLUSH,
+       SHARD_MSG_RESUME, SHARD_MSG_STOP };
+
+#define FANOUT_BUDGET 256       // reactor 이벤트 한 번에 관전자에게 보내는 최대 횟수
+#define WATCH_ALL_MAX 16        // shard마다 모든 게임을 보는 관전자 수 상한 (이벤트마다 전부에게 바로 보낸다)
+#define PREMOVE_NONE 0xFFFDu    // wire 수로 쓰이지 않는 값 (WIRE_MOVE_PASS, WIRE_MOVE_ANY와도 다름)
+
+static ServerConfig config;
+static Shard *shards;
+static int shard_count;
+static Lobby lobby;
+static Registry *users;        // 접속 중인 사용자 이름 → user id
+static GameLog *game_log;      // -l: 끝난 게임을 덧붙이는 로그 (없으면 NULL)
+static Checkpoint *checkpoint;  // --checkpoint: 진행 중인 게임의 체크포인트 파일 (없으면 NULL)
+static UserTable user_table = { PTHREAD_MUTEX_INITIALIZER, { NULL }, 1, 0 };
+
+static int signal_fd = -1;     // SIGINT/SIGTERM → shard 0의 reactor에서 server_stop
+static NetHandler signal_handler;
+static int stop_posted;        // server_stop은 stop_msg를 한 번만 넣는다
+
+static GameSession *led_game;  // LED 매트릭스는 하나뿐이라 한 게임만 그린다
+static uint32_t next_game_id;
+
+static void broadcast_json(const GameSession *g, cJSON *msg, cJSON *delta, int to_spectators, int skip);
+static cJSON *board_to_json(const GameSession *g);
+static int create_listen_socket(const char *port, int backlog);
+static int create_unix_socket(const char *path, int backlog);
+static void reject_client(Conn *c, const char *type, const char *reason);
+static void on_accept(Listener *l, int fd);
+static void on_pending_read(Conn *c);
+static void on_queued_read(Conn *c);
+static void register_client(Shard *s, Conn *c, cJSON *req);
+static void register_user(Shard *s, Conn *c, const char *username, int rating, int delta, int combined, uint64_t token);
+static void resume_seat(Shard *s, ResumeMsg *rm);
+static void send_your_turn(const GameSession *g, LobbyEntry *e, int timeout);
+
+typedef struct {
+    LobbyEntry *e;
+    Shard *home;
+    uint32_t game;
+} PlayerRef;
+static int lookup_player(const char *name, PlayerRef *ref);
+static void spectate_client(Shard *s, Conn *c, cJSON *req);
+static void lobby_enqueue(Shard *s, LobbyEntry *e);
+static void on_player_read(Conn *c);
+static void on_shard_msg(Mailbox *mb, MailMsg *m);
+static void on_turn_timeout(Timer *t, void *arg);
+static void session_start(Shard *s, GameSession *g);
+static void session_run(Shard *s, GameSession *g);
+static void hold_seat(Shard *s, LobbyEntry *e, uint32_t ms);
+static void on_grace_timeout(Timer *t, void *arg);
 int server_run(const char *port);
 
 
-void init_game(GameState *game) {
-    game->current_turn = 0; // Red's turn
-    memset(game->board, '.', sizeof(game->board));
-    game->board[0][0] = 'R';
-    game->board[0][BOARD_SIZE - 1] = 'B';
-    game->board[BOARD_SIZE - 1][0] = 'B';
-    game->board[BOARD_SIZE - 1][BOARD_SIZE - 1] = 'R';
+static uint32_t user_attach(LobbyEntry *e) {
+    uint32_t id = 0;
+    pthread_mutex_lock(&user_table.lock);
+    if (user_table.free_head) {
+        id = user_table.free_head;
+        user_table.free_head = (uint32_t)(user_table.chunk[id >> USER_CHUNK_BITS][id & (USER_CHUNK_SIZE - 1)] >> 1);
+    } else if (user_table.next_id < USER_CHUNK_SIZE * USER_CHUNKS) {
+        uint32_t ci = user_table.next_id >> USER_CHUNK_BITS;
+        if (!user_table.chunk[ci]) {
+            user_table.chunk[ci] = (uintptr_t *)calloc(USER_CHUNK_SIZE, sizeof(uintptr_t));
+        }
+        if (user_table.chunk[ci]) id = user_table.next_id++;
+    }
+    if (id) user_table.chunk[id >> USER_CHUNK_BITS][id & (USER_CHUNK_SIZE - 1)] = (uintptr_t)e;
+    pthread_mutex_unlock(&user_table.lock);
+    return id;
+}
+static void user_detach(uint32_t id) {
+    pthread_mutex_lock(&user_table.lock);
+    user_table.chunk[id >> USER_CHUNK_BITS][id & (USER_CHUNK_SIZE - 1)] = ((uintptr_t)user_table.free_head << 1) | 1;
+    user_table.free_head = id;
+    pthread_mutex_unlock(&user_table.lock);
+}
+/* 락 없이 읽는다: 세션에 id가 들어간 뒤로는 그 사용자가 나갈 때까지 칸이 바뀌지 않는다 */
+static LobbyEntry *user_get(uint32_t id) {
+    if (id == SESSION_NO_USER) return NULL;
+    uintptr_t v = user_table.chunk[id >> USER_CHUNK_BITS][id & (USER_CHUNK_SIZE - 1)];
+    return (v & 1) ? NULL : (LobbyEntry *)v;
+}
+static Conn *seat_conn(const GameSession *g, int seat) {
+    LobbyEntry *e = user_get(g->player[seat]);
+    return e ? e->conn : NULL;
+}
+/* 한 턴에 나가는 결과, your_turn (게임이 끝나면 game_over까지)을 연결마다 write 한 번으로 모은다 */
+static void seats_cork(const GameSession *g) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        Conn *c = seat_conn(g, i);
+        if (c) conn_cork(c);
+    }
+}
+static void seats_uncork(const GameSession *g) {
     for (int i = 0; i < MAX_CLIENTS; i++) {
-        game->players[i].socket = -1;
-        game->players[i].username[0] = '\0';
-        game->players[i].color = (i == 0 ? 'R' : 'B');
-        game->players[i].registered = 0;
+        Conn *c = seat_conn(g, i);
+        if (c) conn_uncork(c);
     }
 }
-void broadcast_json(const cJSON *msg) {
+static const char *seat_name(const GameSession *g, int seat) {
+    LobbyEntry *e = user_get(g->player[seat]);
+    return e ? e->username : "";
+}
+static int spectated(void) {
+    for (int i = 0; i < shard_count; i++) {
+        if (__atomic_load_n(&shards[i].watching, __ATOMIC_RELAXED) != 0) return 1;
+    }
+    return 0;
+}
+/* delta 버전 메시지를 만들 필요가 있는지: delta 플레이어나 관전자가 있을 때만 */
+static int wants_delta(const GameSession *g) {
     for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (send_json(game.players[i].socket, msg) < 0) {
+        LobbyEntry *e = user_get(g->player[i]);
+        if (e && e->delta) return 1;
+    }
+    return spectated();
+}
+/* 바이너리 연결끼리의 게임은 cJSON 메시지를 아예 만들지 않는다 */
+static int wants_json(const GameSession *g) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        Conn *c = seat_conn(g, i);
+        if (c && !c->binary) return 1;
+    }
+    return spectated();
+}
+static int wants_wire(const GameSession *g) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        Conn *c = seat_conn(g, i);
+        if (c && c->binary) return 1;
+    }
+    return 0;
+}
+static void wire_board(const GameSession *g, WireMsg *m) {
+    wire_pack_bits(m->board, g->red, g->blue, g->blocked);
+}
+static NetBuf *netbuf_from_wire(const WireMsg *m) {
+    uint64_t t0 = stats_start();
+    NetBuf *b = netbuf_new(WIRE_FRAME_MAX);
+    if (!b) return NULL;
+    b->len = wire_encode((uint8_t *)netbuf_data(b), b->cap, m);
+    if (b->len == 0) {
+        netbuf_unref(b);
+        return NULL;
+    }
+    stats_since(STATS_SERIALIZATION, t0);
+    return b;
+}
+static void send_wire(Conn *c, const WireMsg *m) {
+    NetBuf *b = netbuf_from_wire(m);
+    if (!b) return;
+    conn_send(c, b);
+    netbuf_unref(b);
+}
+/* 바이너리 플레이어에게 같은 프레임 하나를 보낸다 (관전자는 JSON만 받는다) */
+static void broadcast_wire(const GameSession *g, const WireMsg *m) {
+    NetBuf *b = NULL;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        Conn *c = seat_conn(g, i);
+        if (!c || !c->binary) continue;
+        if (!b && !(b = netbuf_from_wire(m))) return;
+        conn_send(c, b);
+    }
+    netbuf_unref(b);
+}
+/* msg: 보드 전체를 담은 기존 형식, delta: 변경분만 담은 형식 (NULL이면 모두 msg를 받는다)
+   skip: 이미 따로 받은 자리 (send_turn_result, 없으면 -1) */
+static void broadcast_json(const GameSession *g, cJSON *msg, cJSON *delta, int to_spectators, int skip) {
+    /* 형식마다 한 번만 직렬화해서 각 연결의 출력 큐에 같은 버퍼를 넣는다 */
+    uint64_t t0 = trace_begin();
+    NetBuf *buf = NULL, *dbuf = NULL;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (i == skip) continue;
+        LobbyEntry *e = user_get(g->player[i]);
+        if (!e || !e->conn || e->conn->binary) continue;
+        int use_delta = delta && e->delta;
+        NetBuf **slot = use_delta ? &dbuf : &buf;
+        if (!*slot) *slot = netbuf_from_json(use_delta ? delta : msg);
+        if (*slot) conn_send(e->conn, *slot);
+    }
+    netbuf_unref(buf);
+    netbuf_unref(dbuf);
+    trace_end("send_json", t0);
+    if (!to_spectators) return;
+
+    /* 플레이어에게 먼저 보낸 뒤, 관전자가 있는 shard마다 game 번호를 붙인 버퍼를 넘긴다.
+       실제 전송은 각 shard가 나눠서 하므로 이 게임의 진행을 막지 않는다 */
+    NetBuf *sbuf = NULL, *sdelta = NULL;
+    cJSON *jtype = cJSON_GetObjectItem(msg, "type");
+    int final = jtype && strcmp(jtype->valuestring, "game_over") == 0;
+    for (int i = 0; i < shard_count; i++) {
+        if (__atomic_load_n(&shards[i].watching, __ATOMIC_RELAXED) == 0) continue;
+        if (!sbuf) {
+            cJSON_AddNumberToObject(msg, "game", g->id);
+            cJSON_AddNumberToObject(msg, "seq", g->seq);
+            sbuf = netbuf_from_json(msg);
+            if (!sbuf) return;
+            if (delta) {
+                cJSON_AddNumberToObject(delta, "game", g->id);
+                sdelta = netbuf_from_json(delta);
+            }
         }
+        FanoutMsg *f = (FanoutMsg *)malloc(sizeof(FanoutMsg));
+        if (!f) break;
+        f->msg.kind = SHARD_MSG_FANOUT;
+        f->game = g->id;
+        f->final = final;
+        netbuf_ref(sbuf);
+        f->buf = sbuf;
+        if (sdelta) netbuf_ref(sdelta);
+        f->delta = sdelta;
+        mailbox_post(&shards[i].mailbox, &f->msg.mail);
     }
+    netbuf_unref(sbuf);
+    netbuf_unref(sdelta);
 }
-void send_to_client(int sockfd, const cJSON *msg) {
-    if (send_json(sockfd, msg) < 0) {
-        perror("send_json");
+static void show_board(const GameSession *g) {
+    if (__atomic_load_n(&led_game, __ATOMIC_RELAXED) == g) {
+        char board[BOARD_SIZE][BOARD_SIZE];
+        session_to_board(g, board);
+        update_led_matrix(board);
     }
 }
-static cJSON *board_to_json(const GameState *game) {
+static cJSON *board_to_json(const GameSession *g) {
+    uint64_t t0 = trace_begin();
+    char rows[BOARD_SIZE][BOARD_SIZE + 1];
+    session_render(g, rows);
     cJSON *arr = cJSON_CreateArray();
     for (int i = 0; i < BOARD_SIZE; i++) {
-        cJSON *row = cJSON_CreateString(game->board[i]);
+        cJSON *row = cJSON_CreateString(rows[i]);
         cJSON_AddItemToArray(arr, row);
     }
+    trace_end("board_to_json", t0);
     return arr;
 }
 
-static int create_listen_socket(const char *port) {
+static int create_listen_socket(const char *port, int backlog) {
     struct addrinfo hints, *res, *p;
     int listen_fd, yes = 1;
 
@@ -79,295 +402,1581 @@ static int create_listen_socket(const char *port) {
         listen_fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
         if (listen_fd < 0) continue;
         setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+        // reactor마다 같은 포트로 listen하고 커널이 연결을 나눠준다
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof yes);
         if (bind(listen_fd, p->ai_addr, p->ai_addrlen) == 0) break;
         close(listen_fd);
     }
     freeaddrinfo(res);
     if (!p) return -1;
-    if (listen(listen_fd, MAX_CLIENTS) < 0) {
+    if (listen(listen_fd, backlog) < 0) {
         perror("listen");
         close(listen_fd);
         return -1;
     }
     return listen_fd;
 }
-static int accept_and_register(int listen_fd) {
-    int registered = 0;
-    while (registered < MAX_CLIENTS) {
-        struct sockaddr_storage addr;
-        socklen_t addrlen = sizeof(addr);
-        int client_fd = accept(global_listen_fd, (struct sockaddr*)&addr, &addrlen);
-        if (client_fd < 0) {
-            perror("accept");
-            continue;
-        }
+static int create_unix_socket(const char *path, int backlog) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof addr.sun_path) {
+        fprintf(stderr, "unix socket path too long: %s\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);   // 이전 실행이 남긴 소켓 파일
+    if (bind(fd, (struct sockaddr *)&addr, sizeof addr) < 0 || listen(fd, backlog) < 0) {
+        perror("unix socket");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+static void pending_unlink(Shard *s, Conn *c) {
+    if (c->prev) c->prev->next = c->next;
+    else if (s->pending_conns == c) s->pending_conns = c->next;
+    if (c->next) c->next->prev = c->prev;
+    c->prev = c->next = NULL;
+}
+static void reject_client(Conn *c, const char *type, const char *reason) {
+    arena_begin();
+    cJSON *nack = cJSON_CreateObject();
+    cJSON_AddStringToObject(nack, "type", type);
+    cJSON_AddStringToObject(nack, "reason", reason);
+    conn_send_json(c, nack);
+    cJSON_Delete(nack);
+    arena_end();
+    conn_close_when_drained(c);
+}
+static void reject_register(Conn *c, int reason) {
+    static const char *const reasons[] = { "", "invalid register", "username exists", "server busy" };
+    if (c->binary) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_REGISTER_NACK);
+        m.reason = (uint8_t)reason;
+        send_wire(c, &m);
+        conn_close_when_drained(c);
+        return;
+    }
+    reject_client(c, "register_nack", reasons[reason]);
+}
 
-        /* 이미 최대치 도달했으면 곧장 NACK */
-        if (registered >= MAX_CLIENTS) {
-            cJSON *nack = cJSON_CreateObject();
-            cJSON_AddStringToObject(nack, "type", "register_nack");
-            cJSON_AddStringToObject(nack, "reason", "game is already running");
-            send_to_client(client_fd, nack);
-            cJSON_Delete(nack);
-            close(client_fd);
-            continue;
-        }
+/* ---- lobby: 아래 *_locked 함수는 lobby.lock을 잡은 채로 호출 ---- */
+static void queue_push_locked(LobbyEntry *e) {
+    int b = e->bucket;
+    e->next = NULL;
+    e->prev = lobby.tail[b];
+    if (lobby.tail[b]) lobby.tail[b]->next = e;
+    else lobby.head[b] = e;
+    lobby.tail[b] = e;
+    lobby.count[b]++;
+    e->queued = 1;
+}
+static LobbyEntry *queue_pop_locked(int b) {
+    LobbyEntry *e = lobby.head[b];
+    if (!e) return NULL;
+    lobby.head[b] = e->next;
+    if (e->next) e->next->prev = NULL;
+    else lobby.tail[b] = NULL;
+    e->prev = e->next = NULL;
+    lobby.count[b]--;
+    e->queued = 0;
+    return e;
+}
+static void queue_unlink_locked(LobbyEntry *e) {
+    int b = e->bucket;
+    if (e->prev) e->prev->next = e->next;
+    else lobby.head[b] = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else lobby.tail[b] = e->prev;
+    e->prev = e->next = NULL;
+    lobby.count[b]--;
+    e->queued = 0;
+}
+/* bucket에 두 명 이상 있고 빈 shard가 있으면 먼저 온 두 명을 짝짓는다 */
+static int lobby_pair_locked(int b, Match *m) {
+    if (lobby.count[b] < MAX_CLIENTS) return 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) m->player[i] = queue_pop_locked(b);
+    return 1;
+}
+static int rating_bucket(int rating) {
+    if (config.rating_bucket <= 0 || rating <= 0) return 0;
+    int b = rating / config.rating_bucket;
+    return b < LOBBY_BUCKETS ? b : LOBBY_BUCKETS - 1;
+}
 
-        /* 클라이언트로부터 JSON 한 줄을 읽는다 */
-        cJSON *req = recv_json(client_fd);
-        if (!req) {
-            close(client_fd);
-            continue;
-        }
+static void seat_player(Shard *s, GameSession *g, LobbyEntry *e, int seat) {
+    /* 자리에 앉은 뒤의 입력은 session_run이 차례에 맞춰 꺼내 읽는다 */
+    g->player[seat] = e->id;
+    g->seated++;
+    e->game = g;
+    e->seat = seat;
+    e->premove = PREMOVE_NONE;
+    e->premove_armed = 0;
+    if (e->conn) {
+        e->conn->on_read = on_player_read;
+        e->conn->user = e;
+    }
+    if (g->seated == MAX_CLIENTS) {
+        seats_cork(g);
+        session_start(s, g);
+        seats_uncork(g);
+        session_run(s, g);      // 대기 중에 이미 들어온 입력이 있으면 바로 처리
+    }
+}
+/* 사용자를 게임 shard로 보낸다. e->home 스레드에서만 호출 */
+static void move_to_game(Shard *s, LobbyEntry *e, Shard *target, GameSession *g, int seat) {
+    if (e->conn && e->conn->dead) {
+        conn_free(e->conn);     // 상대는 바로 game_over 후 다시 대기열로 돌아간다
+        e->conn = NULL;
+    }
+    if (target == s) {
+        seat_player(s, g, e, seat);
+        return;
+    }
+    /* Conn째로 넘긴다: 버퍼는 그대로, 받는 쪽에서 epoll에만 다시 등록 */
+    if (e->conn) conn_detach(e->conn);
+    __atomic_store_n(&e->home, target, __ATOMIC_RELAXED);
+    e->msg.kind = SHARD_MSG_HANDOFF;
+    e->target = target;
+    e->game = g;
+    e->seat = seat;
+    mailbox_post(&target->mailbox, &e->msg.mail);
+}
+/* 0번 자리 사용자의 shard에 게임을 연다. a->home == s인 스레드에서 호출 */
+static void open_game(Shard *s, LobbyEntry *a, LobbyEntry *b) {
+    GameSession *g = session_alloc(&s->sessions);
+    if (!g) {
+        perror("session_alloc");
+        lobby_enqueue(s, a);
+        return;
+    }
+    g->shard = (unsigned)s->id;
+    do {
+        g->id = __atomic_add_fetch(&next_game_id, 1, __ATOMIC_RELAXED);
+    } while (g->id == WATCH_ALL);
+    timer_init(&g->turn_timer, on_turn_timeout, g);
+    move_to_game(s, a, s, g, 0);
+    if (b->home == s) {
+        move_to_game(s, b, s, g, 1);
+        return;
+    }
+    /* 상대 연결은 그 스레드가 직접 떼어서 넘기도록 부탁한다 */
+    b->msg.kind = SHARD_MSG_MOVE;
+    b->target = s;
+    b->game = g;
+    b->seat = 1;
+    mailbox_post(&b->home->mailbox, &b->msg.mail);
+}
+static void dispatch_match(Shard *s, const Match *m) {
+    LobbyEntry *a = m->player[0];
+    if (a->home == s) {
+        open_game(s, a, m->player[1]);
+        return;
+    }
+    a->msg.kind = SHARD_MSG_MATCH;
+    a->partner = m->player[1];
+    mailbox_post(&a->home->mailbox, &a->msg.mail);
+}
+/* 대기열에 넣고 바로 짝이 맞는지 본다. e->home == s인 스레드에서 호출 */
+static void lobby_enqueue(Shard *s, LobbyEntry *e) {
+    Match m;
+    int paired;
+    e->game = NULL;
+    if (e->conn) {
+        e->conn->on_read = on_queued_read;
+        e->conn->user = e;
+    }
+    pthread_mutex_lock(&lobby.lock);
+    queue_push_locked(e);
+    paired = lobby_pair_locked(e->bucket, &m);
+    pthread_mutex_unlock(&lobby.lock);
+    if (paired) dispatch_match(s, &m);
+}
+static void lobby_drop(LobbyEntry *e) {
+    pthread_mutex_lock(&lobby.lock);
+    if (e->queued) queue_unlink_locked(e);
+    pthread_mutex_unlock(&lobby.lock);
+    registry_remove(users, e->username);   // intern된 이름도 여기서 반환
+    user_detach(e->id);
+    timer_cancel(&e->grace_timer);
+    if (e->conn) conn_free(e->conn);
+    free(e);
+}
 
-        /* “type” 과 “username” 필드 검사 */
-        cJSON *jtype = cJSON_GetObjectItem(req, "type");
-        cJSON *juser = cJSON_GetObjectItem(req, "username");
-        cJSON *resp = NULL;
-
-        if (jtype && jtype->valuestring
-            && strcmp(jtype->valuestring, "register") == 0
-            && juser && juser->valuestring)
-        {
-            /* 중복 검사 */
-            int dup = 0;
-            for (int i = 0; i < registered; i++) {
-                if (strcmp(game.players[i].username,
-                           juser->valuestring) == 0)
-                {
-                    dup = 1;  break;
-                }
+static void on_accept(Listener *l, int fd) {
+    Shard *s = (Shard *)l->user;
+    Conn *c = conn_new(fd, &s->reactor, config.out_high_water);
+    if (!c) {
+        close(fd);
+        return;
+    }
+    c->user = s;
+    c->on_read = on_pending_read;
+    c->next = s->pending_conns;
+    if (s->pending_conns) s->pending_conns->prev = c;
+    s->pending_conns = c;
+}
+static void on_pending_read(Conn *c) {
+    Shard *s = (Shard *)c->user;
+    if (c->dead) {
+        pending_unlink(s, c);
+        conn_free(c);
+        return;
+    }
+    /* unix 소켓 클라이언트는 SHM_MAGIC과 함께 공유 메모리 링을 넘길 수 있다. 이후 입출력은 링으로 */
+    if (!c->binary && !c->shm && c->in_off < c->in_len && (uint8_t)c->inbuf[c->in_off] == SHM_MAGIC) {
+        if (conn_upgrade_shm(c) < 0) {
+            pending_unlink(s, c);
+            conn_free(c);
+        }
+        return;   // 링에 쌓인 입력은 conn_upgrade_shm이 울린 eventfd로 다시 들어온다
+    }
+    /* 첫 바이트로 프로토콜을 정한다: WIRE_MAGIC이면 이후 모두 바이너리 프레임, 아니면 JSON 한 줄 */
+    if (!c->binary && c->in_off < c->in_len && (uint8_t)c->inbuf[c->in_off] == WIRE_MAGIC) {
+        c->binary = 1;
+        c->in_off++;
+    }
+    if (c->binary) {
+        const uint8_t *frame;
+        size_t len;
+        WireMsg m;
+        if (!conn_next_frame(c, &frame, &len)) {
+            if (c->dead) {
+                pending_unlink(s, c);
+                conn_free(c);
             }
+            return;
+        }
+        pending_unlink(s, c);
+        // 바이너리 연결은 플레이어 등록(또는 끊긴 게임으로 돌아가기)만 받는다
+        if (wire_decode(frame, len, &m) < 0 || (m.type != WIRE_REGISTER && m.type != WIRE_RESUME) || !m.name[0][0]) {
+            reject_register(c, WIRE_NACK_INVALID);
+            return;
+        }
+        register_user(s, c, m.name[0], m.rating, 0, 0, m.type == WIRE_RESUME ? m.token : 0);
+        return;
+    }
+    /* 클라이언트로부터 JSON 한 줄을 읽는다 (요청/응답은 arena에서 할당) */
+    arena_begin();
+    cJSON *req = conn_next_json(c);
+    if (req) {
+        pending_unlink(s, c);
+        cJSON *jtype = cJSON_GetObjectItem(req, "type");
+        if (jtype && jtype->valuestring && strcmp(jtype->valuestring, "spectate") == 0) {
+            spectate_client(s, c, req);
+        } else {
+            register_client(s, c, req);
+        }
+        cJSON_Delete(req);
+    }
+    arena_end();
+}
+static void on_queued_read(Conn *c) {
+    LobbyEntry *e = (LobbyEntry *)c->user;
+    /* 대기 중에 들어온 입력은 게임이 시작될 때까지 버퍼에 남겨둔다 */
+    if (!c->dead) return;
+    pthread_mutex_lock(&lobby.lock);
+    int queued = e->queued;
+    if (queued) queue_unlink_locked(e);
+    pthread_mutex_unlock(&lobby.lock);
+    /* 이미 매칭되어 메시지가 오가는 중이면 move_to_game에서 정리한다 */
+    if (queued) {
+        registry_remove(users, e->username);
+        user_detach(e->id);
+        conn_free(c);
+        free(e);
+    }
+}
+static void register_client(Shard *s, Conn *c, cJSON *req) {
+    /* “type” 과 “username” 필드 검사 */
+    cJSON *jtype = cJSON_GetObjectItem(req, "type");
+    cJSON *juser = cJSON_GetObjectItem(req, "username");
+    cJSON *jrating = cJSON_GetObjectItem(req, "rating");
 
-            if (dup) {
-                /* 이미 존재하는 사용자 이름 */
-                resp = cJSON_CreateObject();
-                cJSON_AddStringToObject(resp, "type", "register_nack");
-                cJSON_AddStringToObject(resp, "reason", "username exists");
-            }
-            else {
-                /* 정상 등록 */
-                game.players[registered].socket = client_fd;
-                strncpy(game.players[registered].username,
-                        juser->valuestring,
-                        sizeof(game.players[0].username)-1);
-                game.players[registered].username[sizeof(game.players[0].username)-1] = '\0';
-                game.players[registered].registered  = 1;
-                registered++;
-
-                resp = cJSON_CreateObject();
-                cJSON_AddStringToObject(resp, "type", "register_ack");
+    if (!(jtype && jtype->valuestring
+          && strcmp(jtype->valuestring, "register") == 0
+          && juser && juser->valuestring))
+    {
+        reject_register(c, WIRE_NACK_INVALID);
+        return;
+    }
+    cJSON *jtoken = cJSON_GetObjectItem(req, "resume_token");
+    register_user(s, c, juser->valuestring,
+                  cJSON_IsNumber(jrating) ? jrating->valueint : 0,
+                  cJSON_IsTrue(cJSON_GetObjectItem(req, "delta")),
+                  cJSON_IsTrue(cJSON_GetObjectItem(req, "combined")),
+                  cJSON_IsString(jtoken) ? strtoull(jtoken->valuestring, NULL, 16) : 0);
+}
+static uint64_t new_token(void) {
+    uint64_t t = 0;
+    if (getrandom(&t, sizeof t, 0) != (ssize_t)sizeof t) t = timer_now_ms() * 0x9E3779B97F4A7C15ull ^ (uintptr_t)&t;
+    return t ? t : 1;
+}
+/* register_ack (JSON): 받아들인 옵션과 resume token */
+static void send_register_ack(Conn *c, const LobbyEntry *e, int resumed) {
+    if (c->binary) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_REGISTER_ACK);
+        m.token = e->token;
+        send_wire(c, &m);
+        return;
+    }
+    char token[17];
+    snprintf(token, sizeof token, "%016llx", (unsigned long long)e->token);
+    arena_begin();
+    cJSON *resp = cJSON_CreateObject();
+    cJSON_AddStringToObject(resp, "type", "register_ack");
+    if (e->delta) cJSON_AddTrueToObject(resp, "delta");   // 요청을 받아들였다는 표시
+    if (e->combined) cJSON_AddTrueToObject(resp, "combined");
+    cJSON_AddStringToObject(resp, "resume_token", token);
+    if (resumed) cJSON_AddTrueToObject(resp, "resumed");
+    conn_send_json(c, resp);
+    cJSON_Delete(resp);
+    arena_end();
+}
+/* JSON/바이너리 register 공통: 사용자를 만들고 이름을 등록한 뒤 대기열에 넣는다.
+   이름이 이미 있고 그 자리가 비어 있으면 token을 확인해 그 게임으로 돌려보낸다 */
+static void register_user(Shard *s, Conn *c, const char *username, int rating, int delta, int combined, uint64_t token) {
+    LobbyEntry *e = (LobbyEntry *)calloc(1, sizeof(LobbyEntry));
+    if (!e) {
+        reject_register(c, WIRE_NACK_BUSY);
+        return;
+    }
+    e->home = s;
+    e->conn = c;
+    e->rating = rating;
+    e->delta = delta;
+    e->combined = combined;
+    e->premove = PREMOVE_NONE;
+    e->bucket = rating_bucket(e->rating);
+    e->token = new_token();
+    timer_init(&e->grace_timer, on_grace_timeout, e);
+
+    e->id = user_attach(e);
+    if (e->id == SESSION_NO_USER) {
+        free(e);
+        reject_register(c, WIRE_NACK_BUSY);
+        return;
+    }
+
+    /* 중복 검사 겸 등록: 접속 중인 모든 사용자 대상, O(1) */
+    char name[REGISTRY_NAME_MAX];
+    strncpy(name, username, sizeof(name)-1);
+    name[sizeof(name)-1] = '\0';
+    int rc = registry_insert(users, name, e->id, &e->username);
+    if (rc < 0) {
+        user_detach(e->id);
+        free(e);
+        /* 이미 존재하는 사용자 이름: 되살린 게임에서 이 이름을 기다리는 자리가 있으면 그리로 */
+        PlayerRef ref;
+        ResumeMsg *rm;
+        if (rc == -1 && lookup_player(name, &ref) == 0 && (rm = (ResumeMsg *)calloc(1, sizeof(ResumeMsg))) != NULL) {
+            rm->msg.kind = SHARD_MSG_RESUME;
+            rm->conn = c;
+            memcpy(rm->name, name, sizeof rm->name);
+            rm->delta = delta;
+            rm->combined = combined;
+            rm->token = token;
+            if (ref.home == s) {
+                resume_seat(s, rm);
+            } else {
+                conn_detach(c);
+                mailbox_post(&ref.home->mailbox, &rm->msg.mail);
             }
+            return;
         }
-        else {
-            resp = cJSON_CreateObject();
-            cJSON_AddStringToObject(resp, "type", "register_nack");
-            cJSON_AddStringToObject(resp, "reason", "invalid register");
+        reject_register(c, rc == -1 ? WIRE_NACK_EXISTS : WIRE_NACK_BUSY);
+        return;
+    }
+
+    send_register_ack(c, e, 0);
+    lobby_enqueue(s, e);
+}
+
+/* ---- 끊긴 자리로 돌아오기 ---- */
+/* 턴 타이머에 남은 시간 (초, 올림) */
+static int turn_time_left(const GameSession *g) {
+    const Timer *t = &g->turn_timer;
+    if (!timer_pending(t)) return TIMEOUT;
+    uint64_t now = timer_now_ms() - t->wheel->base_ms;
+    uint64_t left = t->expires > now ? t->expires - now : 0;
+    return left ? (int)((left + 999) / 1000) : 1;
+}
+/* 다시 앉은 플레이어에게: 선수 이름과 지금 보드를 담은 game_start, 자기 차례면 your_turn (타이머는 그대로) */
+static void send_resume(const GameSession *g, LobbyEntry *e) {
+    Conn *c = e->conn;
+    send_register_ack(c, e, 1);
+    if (c->binary) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_GAME_START);
+        m.seq = (uint16_t)g->seq;
+        wire_board(g, &m);
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            strncpy(m.name[i], seat_name(g, i), WIRE_NAME_MAX - 1);
         }
-        send_to_client(client_fd, resp);
-        cJSON_Delete(resp);
-        cJSON_Delete(req);
+        send_wire(c, &m);
+    } else {
+        arena_begin();
+        cJSON *start = cJSON_CreateObject();
+        cJSON_AddStringToObject(start, "type", "game_start");
+        cJSON *players = cJSON_AddArrayToObject(start, "players");
+        cJSON_AddItemToArray(players, cJSON_CreateString(seat_name(g, 0)));
+        cJSON_AddItemToArray(players, cJSON_CreateString(seat_name(g, 1)));
+        cJSON_AddStringToObject(start, "first_player", seat_name(g, 0));
+        cJSON_AddStringToObject(start, "next_player", seat_name(g, g->turn));
+        cJSON_AddTrueToObject(start, "resumed");
+        cJSON_AddNumberToObject(start, "seq", g->seq);
+        cJSON_AddItemToObject(start, "board", board_to_json(g));
+        conn_send_json(c, start);
+        cJSON_Delete(start);
+        arena_end();
     }
-    return 0;
+    if (g->turn == e->seat) send_your_turn(g, e, turn_time_left(g));
 }
-static void *reject_late_clients(void *arg) {
-    while (1) {
-        sleep(1);
-        if (global_listen_fd < 0) break; // server stopped
-        struct sockaddr_storage addr;
-        socklen_t addrlen = sizeof(addr);
-        int client_fd = accept(global_listen_fd, (struct sockaddr*)&addr, &addrlen);
-        if (client_fd < 0) continue; // no new clients
-        cJSON *nack = cJSON_CreateObject();
-        cJSON_AddStringToObject(nack, "type", "register_nack");
-        cJSON_AddStringToObject(nack, "reason", "game is already running");
-        send_to_client(client_fd, nack);
-        cJSON_Delete(nack);
-        close(client_fd);
+/* 게임 shard에서: 이름의 자리가 비어 있고 token이 맞으면 연결을 앉힌다. 아니면 중복 이름으로 거절
+   (token이 0인 자리는 token 없이 만든 체크포인트에서 되살린 것이라 이름만 본다) */
+static void resume_seat(Shard *s, ResumeMsg *rm) {
+    Conn *c = rm->conn;
+    PlayerRef ref;
+    if (lookup_player(rm->name, &ref) < 0 || ref.home != s || !ref.e->resuming || !ref.e->game
+        || (ref.e->token && ref.e->token != rm->token)) {
+        free(rm);
+        reject_register(c, WIRE_NACK_EXISTS);
+        return;
     }
-    return NULL;
+    LobbyEntry *e = ref.e;
+    GameSession *g = e->game;
+    e->conn = c;
+    e->delta = rm->delta;
+    e->combined = rm->combined;
+    e->resuming = 0;
+    e->premove = PREMOVE_NONE;
+    e->premove_armed = 0;
+    timer_cancel(&e->grace_timer);
+    c->on_read = on_player_read;
+    c->user = e;
+    free(rm);
+    conn_cork(c);
+    send_resume(g, e);
+    conn_uncork(c);
+    session_run(s, g);          // 기다리는 동안 들어온 입력이 있으면 바로 처리
+}
+
+/* ---- 관전 ---- */
+static void read_player(uint64_t value, void *arg) {
+    PlayerRef *ref = (PlayerRef *)arg;
+    ref->e = user_get((uint32_t)value);
+    if (!ref->e) return;
+    ref->game = __atomic_load_n(&ref->e->game_id, __ATOMIC_ACQUIRE);
+    ref->home = __atomic_load_n(&ref->e->home, __ATOMIC_RELAXED);
+}
+/* 이름으로 사용자가 지금 있는 게임과 그 shard를 찾는다. registry 락 안에서 읽으므로 그 사이에 해제되지 않는다 */
+static int lookup_player(const char *name, PlayerRef *ref) {
+    memset(ref, 0, sizeof *ref);
+    if (registry_visit(users, name, read_player, ref) < 0 || !ref->e) return -1;
+    return ref->game ? 0 : -1;
+}
+static void shard_update_watching(Shard *s) {
+    __atomic_store_n(&s->watching, s->watchers.count, __ATOMIC_RELAXED);
+}
+static void spectator_free(Spectator *sp) {
+    if (sp->snapshot) netbuf_unref(sp->snapshot);
+    free(sp);
+}
+/* 관전 목록에서 빼고 (보낼 것이 남았으면 다 보낸 뒤) 연결을 닫는다 */
+static void spectator_close(Shard *s, Spectator *sp) {
+    Conn *c = sp->watch.conn;
+    watch_remove(&s->watchers, &sp->watch);
+    shard_update_watching(s);
+    sp->watch.conn = NULL;
+    if (c) conn_close_when_drained(c);
+    // 스냅샷 응답이 아직 오는 중이면 해제는 응답을 받은 쪽에서
+    if (!sp->watch.pending) spectator_free(sp);
+}
+static void on_spectator_read(Conn *c) {
+    Spectator *sp = (Spectator *)c->user;
+    if (!c->dead) {
+        /* 관전자는 보낼 것이 없다: 들어온 줄은 버린다 */
+        arena_begin();
+        cJSON *req;
+        while ((req = conn_next_json(c)) != NULL) cJSON_Delete(req);
+        arena_end();
+        return;
+    }
+    spectator_close(sp->home, sp);
+}
+static void spectate_client(Shard *s, Conn *c, cJSON *req) {
+    cJSON *juser = cJSON_GetObjectItem(req, "username");
+    PlayerRef ref;
+    memset(&ref, 0, sizeof ref);
+    /* username이 없으면 모든 게임, 있으면 그 플레이어가 지금 두고 있는 게임 */
+    if (juser && juser->valuestring && lookup_player(juser->valuestring, &ref) < 0) {
+        reject_client(c, "spectate_nack", "game not found");
+        return;
+    }
+    if (ref.game == WATCH_ALL && s->watchers.all_count >= WATCH_ALL_MAX) {
+        reject_client(c, "spectate_nack", "too many watchers");
+        return;
+    }
+    Spectator *sp = (Spectator *)calloc(1, sizeof(Spectator));
+    if (!sp) {
+        reject_client(c, "spectate_nack", "server busy");
+        return;
+    }
+    sp->home = s;
+    sp->watch.conn = c;
+    sp->watch.pending = ref.game != WATCH_ALL;
+    sp->watch.delta = ref.game != WATCH_ALL && cJSON_IsTrue(cJSON_GetObjectItem(req, "delta"));
+    if (watch_add(&s->watchers, &sp->watch, ref.game) < 0) {
+        free(sp);
+        reject_client(c, "spectate_nack", "server busy");
+        return;
+    }
+    shard_update_watching(s);
+    c->on_read = on_spectator_read;
+    c->user = sp;
+
+    if (ref.game == WATCH_ALL) {
+        // 모든 게임: 이벤트마다 보드와 game 번호가 들어 있으므로 스냅샷 없이 바로 받는다
+        arena_begin();
+        cJSON *ack = cJSON_CreateObject();
+        cJSON_AddStringToObject(ack, "type", "spectate_ack");
+        conn_send_json(c, ack);
+        cJSON_Delete(ack);
+        arena_end();
+        return;
+    }
+    /* 게임 shard에 현재 보드를 받아온다. 그 전에 도착하는 이벤트는 스냅샷에 이미 반영돼 있으므로 버린다 */
+    strncpy(sp->player, juser->valuestring, sizeof(sp->player) - 1);
+    sp->msg.kind = SHARD_MSG_SNAPSHOT;
+    mailbox_post(&ref.home->mailbox, &sp->msg.mail);
+}
+/* 게임 shard에서: 요청한 게임이 아직 여기서 진행 중이면 spectate_ack 스냅샷을 만든다 */
+static void spectate_snapshot(Shard *s, Spectator *sp) {
+    PlayerRef ref;
+    if (lookup_player(sp->player, &ref) == 0 && ref.home == s && ref.game == sp->watch.game
+        && ref.e->game && ref.e->game->state == SESSION_AWAIT_MOVE) {
+        const GameSession *g = ref.e->game;
+        arena_begin();
+        cJSON *ack = cJSON_CreateObject();
+        cJSON_AddStringToObject(ack, "type", "spectate_ack");
+        cJSON_AddNumberToObject(ack, "game", g->id);
+        cJSON *players = cJSON_AddArrayToObject(ack, "players");
+        cJSON_AddItemToArray(players, cJSON_CreateString(seat_name(g, 0)));
+        cJSON_AddItemToArray(players, cJSON_CreateString(seat_name(g, 1)));
+        cJSON_AddItemToObject(ack, "board", board_to_json(g));
+        cJSON_AddStringToObject(ack, "next_player", seat_name(g, g->turn));
+        cJSON_AddNumberToObject(ack, "seq", g->seq);
+        sp->snapshot = netbuf_from_json(ack);
+        cJSON_Delete(ack);
+        arena_end();
+    }
+    sp->msg.kind = SHARD_MSG_SNAPSHOT_DONE;
+    mailbox_post(&sp->home->mailbox, &sp->msg.mail);
+}
+static void spectate_ready(Shard *s, Spectator *sp) {
+    sp->watch.pending = 0;
+    if (!sp->watch.conn) {
+        // 기다리는 동안 연결이 끊겼다
+        spectator_free(sp);
+        return;
+    }
+    if (!sp->snapshot) {
+        Conn *c = sp->watch.conn;
+        watch_remove(&s->watchers, &sp->watch);
+        shard_update_watching(s);
+        spectator_free(sp);
+        reject_client(c, "spectate_nack", "game not found");
+        return;
+    }
+    // 스냅샷이 지금까지 받은 이벤트를 모두 반영하므로 그룹의 현재 메시지는 건너뛴다
+    if (sp->watch.group) sp->watch.seq = sp->watch.group->seq;
+    conn_send(sp->watch.conn, sp->snapshot);
+}
+static void spectator_send(Watcher *w, NetBuf *buf) {
+    Spectator *sp = (Spectator *)((char *)w - offsetof(Spectator, watch));
+    // 못 따라오는 관전자는 high-water에서 끊긴다
+    if (conn_send(w->conn, buf) < 0) spectator_close(sp->home, sp);
+}
+static void spectator_group_done(WatchGroup *grp) {
+    /* game_over까지 다 보냈다: 마지막 관전자가 빠지면 그룹도 해제되므로 수를 먼저 센다 */
+    size_t n = grp->count;
+    Watcher *w = grp->head;
+    while (n--) {
+        Watcher *next = w->next;
+        Spectator *sp = (Spectator *)((char *)w - offsetof(Spectator, watch));
+        spectator_close(sp->home, sp);
+        w = next;
+    }
+}
+/* 남은 관전자 전송은 자기 mailbox를 거쳐 다음 reactor 이벤트로 미룬다 (그 사이 플레이어 입력 처리) */
+static void fanout_flush(Shard *s) {
+    s->flush_posted = 0;
+    if (watch_flush(&s->watchers, FANOUT_BUDGET, spectator_send, spectator_group_done)) {
+        s->flush_posted = 1;
+        mailbox_post(&s->mailbox, &s->flush_msg.mail);
+    }
+}
+static void on_fanout(Shard *s, FanoutMsg *f) {
+    /* 모든 게임을 보는 관전자는 이벤트를 하나도 건너뛰지 않는다 (모니터링용, WATCH_ALL_MAX명까지).
+       기준이 되는 스냅샷이 없으므로 늘 보드 전체를 받는다 */
+    for (Watcher *w = s->watchers.all, *next; w; w = next) {
+        next = w->next;
+        spectator_send(w, f->buf);
+    }
+    WatchGroup *grp = watch_find(&s->watchers, f->game);
+    if (grp) {
+        // 버퍼 참조는 그룹으로 넘어간다
+        watch_publish(&s->watchers, grp, f->buf, f->delta, f->final);
+        if (!s->flush_posted) fanout_flush(s);
+    } else {
+        netbuf_unref(f->buf);
+        netbuf_unref(f->delta);
+    }
+    free(f);
 }
-static void game_loop(void) {
 
-    update_led_matrix(game.board);
- 
-    int countPass = 0;
+static void on_shard_msg(Mailbox *mb, MailMsg *m) {
+    Shard *s = (Shard *)mb->user;
+    LobbyEntry *e = (LobbyEntry *)m;
+    switch (((ShardMsg *)m)->kind) {
+    case SHARD_MSG_MATCH:
+        open_game(s, e, e->partner);
+        break;
+    case SHARD_MSG_MOVE:
+        move_to_game(s, e, e->target, e->game, e->seat);
+        break;
+    case SHARD_MSG_HANDOFF:
+        if (e->conn) conn_attach(e->conn, &s->reactor);
+        seat_player(s, e->game, e, e->seat);
+        break;
+    case SHARD_MSG_SNAPSHOT:
+        spectate_snapshot(s, (Spectator *)m);
+        break;
+    case SHARD_MSG_SNAPSHOT_DONE:
+        spectate_ready(s, (Spectator *)m);
+        break;
+    case SHARD_MSG_FANOUT:
+        on_fanout(s, (FanoutMsg *)m);
+        break;
+    case SHARD_MSG_FLUSH:
+        fanout_flush(s);
+        break;
+    case SHARD_MSG_RESUME:
+        conn_attach(((ResumeMsg *)m)->conn, &s->reactor);
+        resume_seat(s, (ResumeMsg *)m);
+        break;
+    case SHARD_MSG_STOP:
+        s->stopping = 1;
+        break;
+    }
+}
+
+/*
+ * 게임 진행은 세션마다 상태만 들고 있는 state machine이다.
+ *   SEATING → (둘 다 앉음) session_start → AWAIT_MOVE ─┬─ move/pass/invalid → AWAIT_MOVE
+ *                                                      ├─ 타이머 만료(자동 pass) → AWAIT_MOVE
+ *                                                      └─ 종료 조건 → OVER → 세션 반환
+ * 이벤트(입력, 타이머, handoff)가 올 때마다 session_run이 더 진행할 수 없을 때까지 돌고
+ * 돌아온다. 스레드나 스택을 게임마다 잡고 있지 않으므로 한 shard에서 게임 수천 개가 섞여 돈다.
+ */
+static void session_finish(GameSession *g) {
+    // Game over 처리 (이전 답변에서 보드와 점수 전송 예시처럼)
+    if (wants_json(g)) {
+        arena_begin();
+        cJSON *over = cJSON_CreateObject();
+        cJSON_AddStringToObject(over, "type", "game_over");
+        cJSON *final_board = board_to_json(g);
+        cJSON_AddItemToObject(over, "board", final_board);
+        cJSON *scores = cJSON_CreateObject();
+        cJSON_AddNumberToObject(scores, seat_name(g, 0),
+                                session_count(g, 0));
+        cJSON_AddNumberToObject(scores, seat_name(g, 1),
+                                session_count(g, 1));
+        cJSON_AddItemToObject(over, "scores", scores);
+        broadcast_json(g, over, NULL, 1, -1);
+        cJSON_Delete(over);
+        arena_end();
+    }
+    if (wants_wire(g)) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_GAME_OVER);
+        m.score[0] = (uint8_t)session_count(g, 0);
+        m.score[1] = (uint8_t)session_count(g, 1);
+        wire_board(g, &m);
+        broadcast_wire(g, &m);
+    }
+    // 규칙대로 끝나지 않았으면 누군가 나간 것
+    int result = g->pass_count == 2 || session_is_over(g) ? GAMELOG_FINISHED : GAMELOG_ABANDONED;
+    recorder_finish(&shards[g->shard].recorder, g, result);
+    checkpointer_finish(&shards[g->shard].checkpointer, g);
+    timer_cancel(&g->turn_timer);
+    g->state = SESSION_OVER;
+    stats_add(STATS_GAMES_ACTIVE, -1);
+}
+static void send_your_turn(const GameSession *g, LobbyEntry *e, int timeout) {
+    if (!e || !e->conn) return;
+    if (e->conn->binary) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_YOUR_TURN);
+        m.seq = (uint16_t)g->seq;
+        m.timeout = (uint8_t)timeout;
+        wire_board(g, &m);
+        send_wire(e->conn, &m);
+        return;
+    }
+    arena_begin();
+    cJSON *your_turn = cJSON_CreateObject();
+    cJSON_AddStringToObject(your_turn, "type", "your_turn");
+    if (e->delta) {
+        // 보드 대신 seq와 해시: 클라이언트가 쌓아온 보드와 다르면 sync를 보내온다
+        cJSON_AddNumberToObject(your_turn, "seq", g->seq);
+        cJSON_AddNumberToObject(your_turn, "hash", session_hash(g));
+    } else {
+        cJSON_AddItemToObject(your_turn, "board", board_to_json(g));
+    }
+    cJSON_AddNumberToObject(your_turn, "timeout", timeout);
+    conn_send_json(e->conn, your_turn);
+    cJSON_Delete(your_turn);
+    arena_end();
+}
+/* notified: 차례인 플레이어가 결과 메시지로 이미 차례를 알았다 (combined) */
+static void begin_turn(Shard *s, GameSession *g, int notified) {
+    if (session_is_over(g)) {
+        session_finish(g);
+        return;
+    }
+    // 1) your_turn 메시지 전송 (기존과 동일)
+    LobbyEntry *e = user_get(g->player[g->turn]);
+    if (e && e->premove_armed) {
+        // 미리 받아둔 수를 session_run이 바로 두므로 알리지도, 타이머를 걸지도 않는다
+        g->state = SESSION_AWAIT_MOVE;
+        checkpointer_save(&s->checkpointer, g, 0);
+        return;
+    }
+    if (!notified) send_your_turn(g, e, TIMEOUT);   // notified면 결과 메시지에 timeout이 붙어 갔다
+    if (e) e->turn_ns = stats_start();
+
+    // 2) 턴 타이머를 걸고 메시지를 기다림 (자동 pass는 타이머 휠에서 on_turn_timeout이 처리)
+    timer_arm(&s->wheel, &g->turn_timer, TIMEOUT * 1000);
+    g->state = SESSION_AWAIT_MOVE;
+    checkpointer_save(&s->checkpointer, g, TIMEOUT * 1000);
+}
+static void session_start(Shard *s, GameSession *g) {
+    GameSession *none = NULL;
+    __atomic_compare_exchange_n(&led_game, &none, g, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    show_board(g);
+    recorder_start(&s->recorder, g, seat_name(g, 0), seat_name(g, 1));
+    uint64_t tokens[MAX_CLIENTS];
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        LobbyEntry *e = user_get(g->player[i]);
+        tokens[i] = e ? e->token : 0;
+    }
+    checkpointer_start(&s->checkpointer, g, seat_name(g, 0), seat_name(g, 1), tokens);
 
     // --- game_start 메시지 보내는 부분은 이전과 동일 ---
-    cJSON *game_start = cJSON_CreateObject();
-    cJSON_AddStringToObject(game_start, "type", "game_start");
-    cJSON *players = cJSON_AddArrayToObject(game_start, "players");
-    cJSON_AddItemToArray(players, cJSON_CreateString(game.players[0].username));
-    cJSON_AddItemToArray(players, cJSON_CreateString(game.players[1].username));
-    cJSON_AddStringToObject(game_start, "first_player", game.players[0].username);
-    broadcast_json(game_start);
-    cJSON_Delete(game_start);
-
-    int turn = 0; // 0: Red, 1: Black
-
-    while (!isGameOver(game.board)) {
-        // 1) your_turn 메시지 전송 (기존과 동일)
-        cJSON *your_turn = cJSON_CreateObject();
-        cJSON_AddStringToObject(your_turn, "type", "your_turn");
-        cJSON_AddItemToObject(your_turn, "board", board_to_json(&game));
-        cJSON_AddNumberToObject(your_turn, "timeout", TIMEOUT);
-        send_to_client(game.players[turn].socket, your_turn);
-        cJSON_Delete(your_turn);
-
-        // 2) 소켓이 읽기 가능한지 select()로 감시
-        int client_fd = game.players[turn].socket;
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(client_fd, &readfds);
-
-        struct timeval tv;
-        tv.tv_sec = TIMEOUT;     // TIMEOUT 초 동안 대기
-        tv.tv_usec = 0;
-
-        int sel = select(client_fd + 1, &readfds, NULL, NULL, &tv);
-
-        // select() 리턴 처리
-        if (sel < 0) {
-            // select 호출 에러 (진단 차원으로 perror 찍고, 그냥 종료)
-            perror("select");
-            break;
+    if (wants_json(g)) {
+        arena_begin();
+        cJSON *game_start = cJSON_CreateObject();
+        cJSON_AddStringToObject(game_start, "type", "game_start");
+        cJSON *players = cJSON_AddArrayToObject(game_start, "players");
+        cJSON_AddItemToArray(players, cJSON_CreateString(seat_name(g, 0)));
+        cJSON_AddItemToArray(players, cJSON_CreateString(seat_name(g, 1)));
+        cJSON_AddStringToObject(game_start, "first_player", seat_name(g, 0));
+        // delta 클라이언트는 여기서 받은 보드에 변경분을 쌓아간다
+        cJSON *delta = NULL;
+        if (wants_delta(g)) {
+            delta = cJSON_Duplicate(game_start, 1);
+            cJSON_AddNumberToObject(delta, "seq", g->seq);
+            cJSON_AddItemToObject(delta, "board", board_to_json(g));
         }
+        broadcast_json(g, game_start, delta, 1, -1);
+        cJSON_Delete(delta);
+        cJSON_Delete(game_start);
+        arena_end();
+    }
+    if (wants_wire(g)) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_GAME_START);
+        m.seq = (uint16_t)g->seq;
+        wire_board(g, &m);
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            strncpy(m.name[i], seat_name(g, i), WIRE_NAME_MAX - 1);
+        }
+        broadcast_wire(g, &m);
+    }
 
-        if (sel == 0) {
-            // 타임아웃 발생: TIMEOUT 초 동안 아무 데이터도 안 들어옴 → 자동 pass 처리
-            cJSON *resp = cJSON_CreateObject();
-            countPass++;
-            cJSON_AddStringToObject(resp, "type", "pass");
-            // pass 이후에도 보드는 변하지 않으므로, 그대로 최종 보드 다시 전송
-            cJSON_AddItemToObject(resp, "board", board_to_json(&game));
-            // 다음 플레이어로 턴 변경
-            cJSON_AddStringToObject(resp, "next_player", game.players[1 - turn].username);
-            broadcast_json(resp);
-            cJSON_Delete(resp);
-
-            if (countPass == 2) {
-                // 양쪽 다 pass → 게임 종료 조건
-                break;
-            }
-            if (isGameOver(game.board)) {
-                break;
+    stats_add(STATS_GAMES_ACTIVE, 1);
+    // 이제부터 이 플레이어 이름으로 관전 요청을 받을 수 있다
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        LobbyEntry *e = user_get(g->player[i]);
+        if (e) __atomic_store_n(&e->game_id, g->id, __ATOMIC_RELEASE);
+    }
+
+    g->turn = 0; // 0: Red, 1: Black
+    begin_turn(s, g, 0);
+}
+/* delta 클라이언트가 해시가 맞지 않는다고 알려오면 보드 전체를 다시 보낸다 */
+static void send_sync(const GameSession *g) {
+    Conn *c = seat_conn(g, g->turn);
+    if (!c) return;
+    cJSON *sync = delta_msg(g, "board");
+    cJSON_AddItemToObject(sync, "board", board_to_json(g));
+    conn_send_json(c, sync);
+    cJSON_Delete(sync);
+}
+/* premove로 둔 수의 결과에는 둔 사람 이름을 붙인다 (그 클라이언트는 your_turn 없이 결과만 받는다) */
+static void mark_premove(const GameSession *g, int seat, int premove, cJSON *msg, cJSON *delta) {
+    if (!premove) return;
+    cJSON_AddStringToObject(msg, "premove", seat_name(g, seat));
+    if (delta) cJSON_AddStringToObject(delta, "premove", seat_name(g, seat));
+}
+/* 차례가 seat에게 넘어갈 때: 상대가 방금 둔 수(last)가 premove 조건과 맞고 지금 판에서 둘 수 있으면
+   무장하고, 아니면 버린다 (조건이 빗나간 premove는 알리지 않고 평소처럼 your_turn) */
+static void premove_resolve(const GameSession *g, int seat, uint16_t last) {
+    LobbyEntry *e = user_get(g->player[seat]);
+    if (!e || e->premove == PREMOVE_NONE) return;
+    int ok = e->premove_if == WIRE_MOVE_ANY || e->premove_if == last;
+    if (ok && e->premove == WIRE_MOVE_PASS) {
+        ok = !session_has_valid_move(g, seat);
+    } else if (ok) {
+        int r1, c1, r2, c2;
+        wire_move_coords(e->premove, &r1, &c1, &r2, &c2);
+        ok = session_is_valid_move(g, seat, r1, c1, r2, c2);
+    }
+    if (ok) e->premove_armed = 1;
+    else e->premove = PREMOVE_NONE;
+}
+/* combined 플레이어에게는 자기 차례를 여는 결과 메시지에 timeout을 붙여 your_turn 대신 보낸다
+   (delta면 your_turn처럼 해시도). 보냈으면 seat, 아니면 -1 (broadcast_json의 skip으로 넘긴다) */
+static int send_turn_result(const GameSession *g, int seat, cJSON *msg, cJSON *delta) {
+    LobbyEntry *e = user_get(g->player[seat]);
+    if (!e || !e->combined || e->premove_armed || !e->conn || e->conn->binary || session_is_over(g)) return -1;
+    cJSON *m = delta && e->delta ? delta : msg;
+    int add_hash = e->delta && !cJSON_GetObjectItem(m, "hash");
+    if (add_hash) cJSON_AddNumberToObject(m, "hash", session_hash(g));
+    cJSON_AddNumberToObject(m, "timeout", TIMEOUT);
+    conn_send_json(e->conn, m);
+    // 같은 객체를 나머지에게도 보내므로 붙인 필드는 다시 뗀다
+    cJSON_DeleteItemFromObject(m, "timeout");
+    if (add_hash) cJSON_DeleteItemFromObject(m, "hash");
+    return seat;
+}
+/* pass를 모두에게 알린다. g->turn은 아직 pass한 쪽. next_turn이면 상대 차례가 이어진다.
+   상대가 결과 메시지로 차례를 알았으면 1 */
+static int announce_pass(GameSession *g, int next_turn, int premove) {
+    int next = 1 - g->turn;
+    int notified = -1;
+    if (wants_json(g)) {
+        arena_begin();
+        cJSON *resp = cJSON_CreateObject();
+        cJSON *delta = NULL;
+        cJSON_AddStringToObject(resp, "type", "pass");
+        // pass 이후에도 보드는 변하지 않으므로, 그대로 최종 보드 다시 전송
+        cJSON_AddItemToObject(resp, "board", board_to_json(g));
+        cJSON_AddStringToObject(resp, "next_player", seat_name(g, next));
+        if (wants_delta(g)) delta = delta_update(g, "pass", seat_name(g, next));
+        mark_premove(g, g->turn, premove, resp, delta);
+        if (next_turn) notified = send_turn_result(g, next, resp, delta);
+        broadcast_json(g, resp, delta, 1, notified);
+        cJSON_Delete(delta);
+        cJSON_Delete(resp);
+        arena_end();
+    }
+    if (wants_wire(g)) {
+        WireMsg m;
+        wire_msg_init(&m, WIRE_PASS);
+        m.seq = (uint16_t)g->seq;
+        m.seat = (uint8_t)next;
+        wire_board(g, &m);
+        broadcast_wire(g, &m);
+    }
+    return notified >= 0;
+}
+/* move_ok(moved) 또는 invalid_move를 알린다. move_ok면 g->turn은 이미 넘어가 있다.
+   다음 차례(g->turn)가 결과 메시지로 차례를 알았으면 1 */
+static int announce_move(GameSession *g, int moved, int r1, int c1, int r2, int c2, uint64_t flipped,
+                         int premove) {
+    int notified = -1;
+    if (wants_json(g)) {
+        arena_begin();
+        cJSON *resp = cJSON_CreateObject();
+        cJSON *delta = NULL;
+        cJSON_AddStringToObject(resp, "type", moved ? "move_ok" : "invalid_move");
+        // move_ok 또는 invalid_move 일 때 board와 next_player 필드를 추가하여 브로드캐스트
+        cJSON_AddItemToObject(resp, "board", board_to_json(g));
+        cJSON_AddStringToObject(resp, "next_player", seat_name(g, 1 - g->turn));
+        if (wants_delta(g)) {
+            if (moved) {
+                // 보드 대신 둔 수와 뒤집힌 칸 (좌표는 move 요청과 같이 1부터)
+                delta = delta_update(g, "move_ok", seat_name(g, 1 - g->turn));
+                delta_add_move(delta, r1, c1, r2, c2, flipped);
+            } else {
+                delta = delta_msg(g, "invalid_move");
+                cJSON_AddStringToObject(delta, "next_player", seat_name(g, 1 - g->turn));
             }
-            // 턴 넘기기
-            turn = 1 - turn;
-            // 루프 처음으로 돌아가서 다음 턴으로 진행
-            continue;
         }
+        if (moved) mark_premove(g, 1 - g->turn, premove, resp, delta);
+        notified = send_turn_result(g, g->turn, resp, delta);
+        // invalid_move는 관전자에게 보내지 않는다 (보드가 그대로)
+        broadcast_json(g, resp, delta, moved, notified);
+        cJSON_Delete(delta);
+        cJSON_Delete(resp);
+        arena_end();
+    }
+    if (wants_wire(g)) {
+        WireMsg m;
+        wire_msg_init(&m, moved ? WIRE_MOVE_OK : WIRE_INVALID_MOVE);
+        m.seq = (uint16_t)g->seq;
+        m.seat = (uint8_t)(1 - g->turn);
+        if (moved) {
+            m.move = wire_move(r1, c1, r2, c2);
+            wire_board(g, &m);
+        }
+        broadcast_wire(g, &m);
+    }
+    return notified >= 0;
+}
+/* 차례인 플레이어의 수 하나를 적용하고 다음 상태로 넘긴다. 좌표가 모두 -1이면 pass 요청 */
+/* premove: 미리 받아둔 수 (결과에 표시만 다르다) */
+static void session_play(Shard *s, GameSession *g, int r1, int c1, int r2, int c2, int premove) {
+    int moved = 0;
+    uint64_t flipped = 0;
 
-        // sel > 0이면, 분명히 읽을 데이터가 들어와 있다는 의미 → recv_json 호출
-        cJSON *req = recv_json(client_fd);
-        if (!req) {
-            // 연결 끊김 또는 파싱 에러
-            break;
+    g->pass_count = 0;  // 패스 카운트 초기화
+    // 만약 (0,0,0,0)이 넘어오면 “진짜 pass”가 아닌, “move 좌표가 유효하지 않을 때”로 간주
+    int pass = r1 == -1 && c1 == -1 && r2 == -1 && c2 == -1;
+    uint64_t t0 = stats_start(), span = trace_begin();
+    // 클라이언트가 좌표를 모두 0으로 보냈다는 것은 “move 못 해서 pass”
+    // 하지만 이 때, 실제로 놓을 수 있는 move가 존재하면 invalid_move
+    int valid = pass ? !session_has_valid_move(g, g->turn) : session_is_valid_move(g, g->turn, r1, c1, r2, c2);
+    stats_since(STATS_VALIDATION, t0);
+    trace_end("isValidMove", span);
+    if (!valid) stats_add(STATS_INVALID_MOVES, 1);
+    if (pass) {
+        if (valid) {
+            // 정말 패스가 가능한 상황
+            g->pass_count++;
+            g->seq++;
+            recorder_move(&s->recorder, g, WIRE_MOVE_PASS);
+            if (g->pass_count < 2) premove_resolve(g, 1 - g->turn, WIRE_MOVE_PASS);
+            int notified = announce_pass(g, g->pass_count < 2, premove);
+            if (g->pass_count == 2 || session_is_over(g)) {
+                // 양쪽 다 pass → 게임 종료
+                session_finish(g);
+                return;
+            }
+            g->turn = 1 - g->turn;
+            begin_turn(s, g, notified);
+            return;
         }
+    }
+    else if (valid) {
+        // 실제로 유효한 move라면
+        span = trace_begin();
+        session_move(g, r1, c1, r2, c2, &flipped);
+        trace_end("Move", span);
+        g->seq++;
+        recorder_move(&s->recorder, g, wire_move(r1, c1, r2, c2));
+        moved = 1;
+        show_board(g);
+        g->turn = 1 - g->turn;
+        premove_resolve(g, g->turn, wire_move(r1, c1, r2, c2));
+    }
+    // 그 밖에는 move 좌표가 올바르지 않으므로 invalid_move
+    begin_turn(s, g, announce_move(g, moved, r1, c1, r2, c2, flipped, premove));
+}
+static void session_play_wire(Shard *s, GameSession *g, uint16_t mv, int premove) {
+    if (mv == WIRE_MOVE_PASS) {
+        session_play(s, g, -1, -1, -1, -1, premove);
+        return;
+    }
+    int r1, c1, r2, c2;
+    wire_move_coords(mv, &r1, &c1, &r2, &c2);
+    session_play(s, g, r1, c1, r2, c2, premove);
+}
+/* stats: 차례를 알린 뒤 그 플레이어의 답이 오기까지 */
+static void turn_answered(const GameSession *g) {
+    LobbyEntry *e = user_get(g->player[g->turn]);
+    if (!e || !e->turn_ns) return;
+    stats_since(STATS_TURN_LATENCY, e->turn_ns);
+    e->turn_ns = 0;
+}
+/* 없거나 정수가 아닌 필드는 -1 (좌표로는 판 밖) */
+static int json_int(const cJSON *obj, const char *key) {
+    const cJSON *j = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsNumber(j) && j->valuedouble == (double)j->valueint ? j->valueint : -1;
+}
+/* 차례인 플레이어가 보낸 JSON 요청 하나를 처리하고 다음 상태로 넘긴다 */
+static void session_handle(Shard *s, GameSession *g, cJSON *req) {
+    cJSON *jtype = cJSON_GetObjectItem(req, "type");
+    if (cJSON_IsString(jtype) && strcmp(jtype->valuestring, "premove") == 0) {
+        // 차례가 온 뒤에 도착한 premove: your_turn을 받은 클라이언트가 곧 move를 보내므로 버린다 (타이머는 그대로)
+        return;
+    }
+    turn_answered(g);
+    timer_cancel(&g->turn_timer);
 
-        cJSON *jtype = cJSON_GetObjectItem(req, "type");
-        cJSON *resp = cJSON_CreateObject();
+    if (cJSON_IsString(jtype) && strcmp(jtype->valuestring, "move") == 0) {
+        // 정상적인 move 요청. 좌표가 빠졌거나 정수가 아니면 -1 → 판 밖이라 invalid_move로 간다
+        int sx = json_int(req, "sx"), sy = json_int(req, "sy");
+        int tx = json_int(req, "tx"), ty = json_int(req, "ty");
+        session_play(s, g, sx - 1, sy - 1, tx - 1, ty - 1, 0);
+    }
+    else if (cJSON_IsString(jtype) && strcmp(jtype->valuestring, "sync") == 0) {
+        // delta 클라이언트의 재동기화 요청: 보드 전체를 보내고 다시 your_turn
+        send_sync(g);
+        begin_turn(s, g, 0);
+    }
+    else {
+        // type이 “move”가 아닌 경우(예: 잘못된 요청), 무시하고 다음 턴
+        begin_turn(s, g, 0);
+    }
+}
+/* 바이너리 요청: move 프레임만 받는다 (보드가 매번 같이 가므로 sync는 필요 없다) */
+static void session_handle_wire(Shard *s, GameSession *g, const WireMsg *m) {
+    if (m->type == WIRE_PREMOVE) return;    // 차례가 온 뒤에 도착한 premove (session_handle 참고)
+    turn_answered(g);
+    timer_cancel(&g->turn_timer);
 
-        if (jtype && strcmp(jtype->valuestring, "move") == 0) {
-            // 정상적인 move 요청
-            countPass = 0;  // 패스 카운트 초기화
-            int r1 = cJSON_GetObjectItem(req, "sx")->valueint - 1;
-            int c1 = cJSON_GetObjectItem(req, "sy")->valueint - 1;
-            int r2 = cJSON_GetObjectItem(req, "tx")->valueint - 1;
-            int c2 = cJSON_GetObjectItem(req, "ty")->valueint - 1;
-
-            // 만약 (0,0,0,0)이 넘어오면 “진짜 pass”가 아닌, “move 좌표가 유효하지 않을 때”로 간주
-            if (r1 == -1 && c1 == -1 && r2 == -1 && c2 == -1) {
-                // 클라이언트가 좌표를 모두 0으로 보냈다는 것은 “move 못 해서 pass”  
-                // 하지만 이 때, 실제로 놓을 수 있는 move가 존재하면 invalid_move
-                if (hasValidMove(game.board, game.players[turn].color)) {
-                    cJSON_AddStringToObject(resp, "type", "invalid_move");
-                } else {
-                    // 정말 패스가 가능한 상황
-                    countPass++;
-                    cJSON_AddStringToObject(resp, "type", "pass");
-                    cJSON_AddItemToObject(resp, "board", board_to_json(&game));
-                    cJSON_AddStringToObject(resp, "next_player", game.players[1 - turn].username);
-                    broadcast_json(resp);
-                    cJSON_Delete(resp);
-                    cJSON_Delete(req);
-
-                    if (countPass == 2) {
-                        // 양쪽 다 pass → 게임 종료
-                        break;
-                    }
-                    if (isGameOver(game.board)) {
-                        break;
-                    }
-                    turn = 1 - turn;
-                    
-                    continue;
-                }
-            }
-            else if (isValidInput(game.board, r1, c1, r2, c2) &&
-                     isValidMove(game.board, game.players[turn].color, r1, c1, r2, c2)) {
-                // 실제로 유효한 move라면
-                Move(game.board, turn, r1, c1, r2, c2);
-		update_led_matrix(game.board);
-                cJSON_AddStringToObject(resp, "type", "move_ok");
-                turn = 1 - turn;
-            } else {
-                // move 좌표가 올바르지 않다면 invalid_move
-                cJSON_AddStringToObject(resp, "type", "invalid_move");
-            }
+    if (m->type != WIRE_MOVE) {
+        begin_turn(s, g, 0);
+        return;
+    }
+    session_play_wire(s, g, m->move, 0);
+}
+/* JSON 좌표(1부터, 모두 0이면 pass)를 wire 수로. 판 밖이면 PREMOVE_NONE */
+static uint16_t json_move(int sx, int sy, int tx, int ty) {
+    if (sx == 0 && sy == 0 && tx == 0 && ty == 0) return WIRE_MOVE_PASS;
+    if (sx < 1 || sx > BOARD_SIZE || sy < 1 || sy > BOARD_SIZE
+        || tx < 1 || tx > BOARD_SIZE || ty < 1 || ty > BOARD_SIZE) return PREMOVE_NONE;
+    return wire_move(sx - 1, sy - 1, tx - 1, ty - 1);
+}
+/* {"type":"premove", "seq", "sx","sy","tx","ty", "if":[sx,sy,tx,ty]} 이면 1 ("if"가 없으면 무조건) */
+static int json_premove(const cJSON *req, int *seq, uint16_t *mv, uint16_t *cond) {
+    const cJSON *jtype = cJSON_GetObjectItem(req, "type");
+    if (!cJSON_IsString(jtype) || strcmp(jtype->valuestring, "premove") != 0) return 0;
+    *seq = json_int(req, "seq");
+    *mv = json_move(json_int(req, "sx"), json_int(req, "sy"), json_int(req, "tx"), json_int(req, "ty"));
+    *cond = WIRE_MOVE_ANY;
+    const cJSON *jif = cJSON_GetObjectItem(req, "if");
+    if (cJSON_GetArraySize(jif) == 4) {
+        int v[4];
+        for (int i = 0; i < 4; i++) {
+            const cJSON *j = cJSON_GetArrayItem(jif, i);
+            v[i] = cJSON_IsNumber(j) ? j->valueint : -1;
         }
-        else {
-            // type이 “move”가 아닌 경우(예: 잘못된 요청), 무시하고 다음 턴
-            cJSON_Delete(resp);
+        *cond = json_move(v[0], v[1], v[2], v[3]);
+    }
+    return 1;
+}
+/* 차례가 아닌 플레이어가 보낸 premove를 꺼내 둔다 (새로 온 것이 앞의 것을 바꾼다).
+   premove가 아닌 요청을 만나면 멈추고, 그 뒤는 자기 차례까지 버퍼에 남긴다 */
+static void take_premoves(GameSession *g, int seat) {
+    LobbyEntry *e = user_get(g->player[seat]);
+    Conn *c = e ? e->conn : NULL;
+    if (!c || c->dead) return;
+    for (;;) {
+        int seq;
+        uint16_t mv, cond;
+        if (c->binary) {
+            const uint8_t *frame;
+            size_t len;
+            WireMsg m;
+            if (!conn_peek_frame(c, &frame, &len) || wire_decode(frame, len, &m) < 0 || m.type != WIRE_PREMOVE) return;
+            conn_next_frame(c, &frame, &len);
+            seq = m.seq;
+            mv = m.move;
+            cond = m.cond;
+        } else {
+            arena_begin();
+            cJSON *req = conn_peek_json(c);
+            int ok = req && json_premove(req, &seq, &mv, &cond);
             cJSON_Delete(req);
-            continue;
+            arena_end();
+            if (!ok) return;
+            conn_skip_json(c);
+        }
+        // 지난 판이나 이미 지나간 보드를 보고 만든 premove는 버린다 (JSON은 seq를 생략할 수 있다)
+        if (mv != PREMOVE_NONE && cond != PREMOVE_NONE && (seq < 0 || seq == (int)g->seq)) {
+            e->premove = mv;
+            e->premove_if = cond;
         }
+    }
+}
+/* 게임이 끝났으면 살아 있는 플레이어는 다시 대기열로, 끊긴 쪽은 정리하고 세션을 반환 */
+static void session_release(Shard *s, GameSession *g) {
+    LobbyEntry *seated[MAX_CLIENTS];
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        seated[i] = user_get(g->player[i]);
+        if (seated[i]) __atomic_store_n(&seated[i]->game_id, 0u, __ATOMIC_RELEASE);
+    }
+    GameSession *self = g;
+    __atomic_compare_exchange_n(&led_game, &self, (GameSession *)NULL, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    session_free(&s->sessions, g);
 
-        // move_ok 또는 invalid_move 일 때 board와 next_player 필드를 추가하여 브로드캐스트
-        cJSON_AddItemToObject(resp, "board", board_to_json(&game));
-        cJSON_AddStringToObject(resp, "next_player", game.players[1 - turn].username);
-        broadcast_json(resp);
-        cJSON_Delete(resp);
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        LobbyEntry *e = seated[i];
+        if (!e) continue;
+        if (e->conn && !e->conn->dead) lobby_enqueue(s, e);
+        else lobby_drop(e);
+    }
+}
+/* 더 진행할 수 없을 때까지 상태를 넘긴다: 차례인 플레이어의 버퍼에 요청이 남아 있으면 계속 처리 */
+static void session_run(Shard *s, GameSession *g) {
+    seats_cork(g);
+    while (g->state == SESSION_AWAIT_MOVE) {
+        Conn *c = seat_conn(g, g->turn);
+        if (!c || c->dead) {
+            LobbyEntry *held = user_get(g->player[g->turn]);
+            if (c && config.resume_grace > 0) {
+                hold_seat(s, held, (uint32_t)config.resume_grace * 1000);
+                c = NULL;
+            }
+            if (!c && held && held->resuming) break;   // 다시 접속하거나 턴 타이머가 갈 때까지 기다린다
+            // 연결 끊김
+            session_finish(g);
+            break;
+        }
+        // 방금 차례를 넘긴 쪽이 결과를 기다리지 않고 보낸 premove도 꺼내 둔다
+        take_premoves(g, 1 - g->turn);
+        LobbyEntry *e = user_get(g->player[g->turn]);
+        if (e->premove_armed) {
+            // 조건이 맞은 premove: 왕복 없이 바로 둔다
+            uint16_t mv = e->premove;
+            e->premove_armed = 0;
+            e->premove = PREMOVE_NONE;
+            session_play_wire(s, g, mv, 1);
+            continue;
+        }
+        if (c->binary) {
+            const uint8_t *frame;
+            size_t len;
+            WireMsg m;
+            if (!conn_next_frame(c, &frame, &len)) break;
+            uint64_t t0 = trace_begin();
+            if (wire_decode(frame, len, &m) < 0) m.type = 0;   // 모르는 요청으로 처리
+            trace_end("parse", t0);
+            t0 = trace_begin();
+            session_handle_wire(s, g, &m);
+            trace_end("handle", t0);
+            continue;
+        }
+        // 한 요청 동안 만드는 cJSON 메시지는 모두 arena에서 할당하고 끝에 한 번에 해제
+        arena_begin();
+        cJSON *req = conn_next_json(c);
+        if (!req) {
+            arena_end();
+            break;      // 다음 입력이나 타이머를 기다린다
+        }
+        uint64_t t0 = trace_begin();
+        session_handle(s, g, req);
+        trace_end("handle", t0);
         cJSON_Delete(req);
+        arena_end();
+    }
+    seats_uncork(g);
+    if (g->state == SESSION_OVER) session_release(s, g);
+}
+static void on_player_read(Conn *c) {
+    LobbyEntry *e = (LobbyEntry *)c->user;
+    GameSession *g = e->game;
+    /* 차례가 아닌 쪽 입력은 premove만 꺼내고 나머지는 자기 차례가 올 때까지 버퍼에 남겨둔다 */
+    if (g->state != SESSION_AWAIT_MOVE) return;
+    if (c->dead && config.resume_grace > 0) {
+        // 차례와 상관없이 바로 자리를 잡아 둔다. 턴 타이머는 그대로 간다
+        hold_seat(e->home, e, (uint32_t)config.resume_grace * 1000);
+        return;
     }
+    if (g->turn != e->seat) {
+        take_premoves(g, e->seat);
+        return;
+    }
+    session_run(e->home, g);
+}
+/* 연결이 끊긴 플레이어의 자리를 ms 동안 지킨다 (연결은 바로 닫는다) */
+static void hold_seat(Shard *s, LobbyEntry *e, uint32_t ms) {
+    if (e->conn) conn_free(e->conn);
+    e->conn = NULL;
+    e->resuming = 1;
+    e->premove = PREMOVE_NONE;
+    e->premove_armed = 0;
+    timer_arm(&s->wheel, &e->grace_timer, ms);
+}
+/* 끊긴 플레이어가 제때 돌아오지 않았다: 연결이 끊긴 것과 같이 게임을 끝낸다 */
+static void on_grace_timeout(Timer *t, void *arg) {
+    LobbyEntry *e = (LobbyEntry *)arg;
+    GameSession *g = e->game;
+    (void)t;
+    if (!e->resuming || !g || g->state != SESSION_AWAIT_MOVE) return;
+    seats_cork(g);
+    session_finish(g);
+    seats_uncork(g);
+    session_run(e->home, g);    // OVER: 세션을 반환하고 이 자리는 정리된다
+}
+static void on_turn_timeout(Timer *t, void *arg) {
+    GameSession *g = (GameSession *)arg;
+    Shard *s = &shards[g->shard];
+    int turn = g->turn;
+    (void)t;
 
-    // Game over 처리 (이전 답변에서 보드와 점수 전송 예시처럼)
-    cJSON *over = cJSON_CreateObject();
-    cJSON_AddStringToObject(over, "type", "game_over");
-    cJSON *final_board = board_to_json(&game);
-    cJSON_AddItemToObject(over, "board", final_board);
-    cJSON *scores = cJSON_CreateObject();
-    cJSON_AddNumberToObject(scores, game.players[0].username,
-                            countR(game.board));
-    cJSON_AddNumberToObject(scores, game.players[1].username,
-                            countB(game.board));
-    cJSON_AddItemToObject(over, "scores", scores);
-    broadcast_json(over);
-    cJSON_Delete(over);
+    // 타임아웃: TIMEOUT 초 동안 아무 데이터도 안 들어옴 → 자동 pass 처리
+    stats_add(STATS_TIMEOUTS, 1);
+    seats_cork(g);
+    g->pass_count++;
+    g->seq++;
+    recorder_move(&s->recorder, g, WIRE_MOVE_PASS);
+    if (g->pass_count < 2) premove_resolve(g, 1 - turn, WIRE_MOVE_PASS);
+    int notified = announce_pass(g, g->pass_count < 2, 0);
+
+    // 다음 플레이어로 턴 변경
+    g->turn = 1 - turn;
+    if (g->pass_count == 2) {
+        // 양쪽 다 pass → 게임 종료 조건
+        session_finish(g);
+    } else {
+        begin_turn(s, g, notified);
+    }
+    seats_uncork(g);
+    session_run(s, g);
+}
+
+void server_config_init(ServerConfig *cfg) {
+    cfg->port = NULL;
+    cfg->out_high_water = NET_DEFAULT_HIGH_WATER;
+    cfg->backlog = SERVER_DEFAULT_BACKLOG;
+    cfg->threads = 0;
+    cfg->rating_bucket = 0;
+    cfg->unix_path = NULL;
+    cfg->io_uring = 0;
+    cfg->log_path = NULL;
+    cfg->log_sync = GAMELOG_SYNC_INTERVAL;
+    cfg->log_sync_ms = 1000;
+    cfg->checkpoint_path = NULL;
+    cfg->resume_grace = SERVER_DEFAULT_RESUME_GRACE;
+    cfg->stats_addr = NULL;
+    cfg->trace_path = NULL;
 }
 
 int server_run(const char *port) {
-    int listen_fd = create_listen_socket(port);
+    ServerConfig cfg;
+    server_config_init(&cfg);
+    cfg.port = port;
+    return server_run_config(&cfg);
+}
+
+static void *shard_main(void *arg) {
+    Shard *s = (Shard *)arg;
+    char name[32];
+    snprintf(name, sizeof name, "shard %d", s->id);
+    trace_thread_name(name);
+    /* accept/register/매칭/handoff/게임 진행 모두 reactor 이벤트로 처리된다 */
+    while (!s->stopping && reactor_poll(&s->reactor, -1) >= 0) {
+    }
+    return NULL;
+}
+static void free_watcher(Watcher *w) {
+    Spectator *sp = (Spectator *)((char *)w - offsetof(Spectator, watch));
+    if (w->conn) conn_free(w->conn);
+    // 스냅샷 응답을 기다리던 관전자는 mailbox를 닫을 때 이미 처리됐다
+    spectator_free(sp);
+}
+static void shard_close(Shard *s) {
+    mailbox_close(&s->mailbox);
+    watch_destroy(&s->watchers, free_watcher);
+    while (s->pending_conns) {
+        Conn *c = s->pending_conns;
+        pending_unlink(s, c);
+        conn_free(c);
+    }
+    recorder_close(&s->recorder);   // 진행 중이던 게임도 남긴다 (세션 풀을 비우기 전에)
+    checkpointer_close(&s->checkpointer);   // 진행 중이던 게임의 슬롯은 다음 실행이 되살린다
+    session_pool_destroy(&s->sessions);
+    listener_close(&s->listener);
+    if (s->unix_listener.fd >= 0) {
+        listener_close(&s->unix_listener);
+        unlink(config.unix_path);
+    }
+    timer_wheel_close(&s->wheel);
+    reactor_close(&s->reactor);
+}
+static void collect_user(const char *name, uint64_t value, void *arg) {
+    LobbyEntry ***out = (LobbyEntry ***)arg;
+    (void)name;
+    *(*out)++ = user_get((uint32_t)value);
+}
+static void drop_all_users(void) {
+    size_t n = registry_count(users);
+    LobbyEntry **list = (LobbyEntry **)malloc((n ? n : 1) * sizeof(LobbyEntry *));
+    if (!list) return;
+    LobbyEntry **end = list;
+    registry_foreach(users, collect_user, &end);
+    for (LobbyEntry **it = list; it < end; it++) lobby_drop(*it);
+    free(list);
+}
+static int shard_init(Shard *s, int id) {
+    memset(s, 0, sizeof *s);
+    s->id = id;
+    s->listener.fd = -1;
+    s->unix_listener.fd = -1;
+    s->mailbox.efd = -1;
+    s->wheel.tfd = -1;
+    session_pool_init(&s->sessions);
+    recorder_init(&s->recorder, game_log, &s->wheel);
+    checkpointer_init(&s->checkpointer, checkpoint);
+    s->flush_msg.kind = SHARD_MSG_FLUSH;
+    s->stop_msg.kind = SHARD_MSG_STOP;
+    if (watch_init(&s->watchers) < 0) return -1;
+    int listen_fd = create_listen_socket(config.port, config.backlog);
     if (listen_fd < 0) {
-        fprintf(stderr, "Failed to create listen socket on port %s\n", port);
+        fprintf(stderr, "Failed to create listen socket on port %s\n", config.port);
+        return -1;
+    }
+    int reactor_ok;
+    if (config.io_uring) {
+        reactor_ok = reactor_init_uring(&s->reactor);
+        if (reactor_ok < 0) {
+            // 커널이나 빌드가 지원하지 않으면 모든 shard를 epoll로
+            perror("io_uring unavailable, falling back to epoll");
+            config.io_uring = 0;
+            reactor_ok = reactor_init(&s->reactor);
+        }
+    } else {
+        reactor_ok = reactor_init(&s->reactor);
+    }
+    if (reactor_ok < 0) {
+        close(listen_fd);
+        return -1;
+    }
+    if (timer_wheel_init(&s->wheel, &s->reactor) < 0
+        || mailbox_init(&s->mailbox, &s->reactor, on_shard_msg, s) < 0
+        || listener_init(&s->listener, &s->reactor, listen_fd, on_accept, s) < 0) {
+        if (s->listener.fd < 0) close(listen_fd);
+        shard_close(s);
+        return -1;
+    }
+    // unix 소켓은 연결이 적고 짧게 붙는 쪽이라 shard 0 하나가 받는다 (게임은 매칭된 shard로 옮겨간다)
+    if (id == 0 && config.unix_path) {
+        int unix_fd = create_unix_socket(config.unix_path, config.backlog);
+        if (unix_fd < 0
+            || listener_init(&s->unix_listener, &s->reactor, unix_fd, on_accept, s) < 0) {
+            if (unix_fd >= 0 && s->unix_listener.fd < 0) close(unix_fd);
+            shard_close(s);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* 체크포인트의 게임 하나를 shard에 나눠 되살린다. 두 자리는 이름만 등록된 채 연결 없이 기다린다.
+   shard 스레드를 띄우기 전에 호출 */
+static void restore_game(const CheckpointGame *cg, void *arg) {
+    int *next_shard = (int *)arg;
+    Shard *s = &shards[(*next_shard)++ % shard_count];
+    GameSession *g = session_alloc(&s->sessions);
+    if (!g) {
+        checkpoint_discard(checkpoint, cg->slot);
+        return;
+    }
+    g->red = cg->board.red;
+    g->blue = cg->board.blue;
+    g->blocked = cg->board.blocked;
+    g->turn = cg->board.turn;
+    g->pass_count = cg->board.pass_count;
+    g->seq = cg->board.seq;
+    g->shard = (unsigned)s->id;
+    g->id = cg->game_id;
+    if (g->id > next_game_id) next_game_id = g->id;
+    timer_init(&g->turn_timer, on_turn_timeout, g);
+    for (int seat = 0; seat < MAX_CLIENTS; seat++) {
+        LobbyEntry *e = (LobbyEntry *)calloc(1, sizeof(LobbyEntry));
+        if (e) {
+            e->home = s;
+            e->premove = PREMOVE_NONE;
+            e->token = cg->token[seat];
+            timer_init(&e->grace_timer, on_grace_timeout, e);
+            e->id = user_attach(e);
+        }
+        if (!e || e->id == SESSION_NO_USER || registry_insert(users, cg->name[seat], e->id, &e->username) < 0) {
+            fprintf(stderr, "checkpoint: cannot restore game %u (%s vs %s)\n", cg->game_id, cg->name[0], cg->name[1]);
+            if (e && e->id != SESSION_NO_USER) user_detach(e->id);
+            free(e);
+            if (seat == 1) lobby_drop(user_get(g->player[0]));
+            session_free(&s->sessions, g);
+            checkpoint_discard(checkpoint, cg->slot);
+            return;
+        }
+        g->player[seat] = e->id;
+        g->seated++;
+        e->game = g;
+        e->seat = seat;
+        e->game_id = g->id;
+    }
+    // 다시 접속할 시간을 주고, 그동안 안 오는 쪽이 있으면 게임을 끝낸다
+    uint32_t grace = CHECKPOINT_RESTORE_MS + (uint32_t)config.resume_grace * 1000;
+    for (int seat = 0; seat < MAX_CLIENTS; seat++) hold_seat(s, user_get(g->player[seat]), grace);
+    g->state = SESSION_AWAIT_MOVE;
+    recorder_resume(&s->recorder, g, cg->name[0], cg->name[1]);
+    stats_add(STATS_GAMES_ACTIVE, 1);
+    checkpointer_adopt(&s->checkpointer, g, cg->slot);
+    // 남은 턴 시간에 다시 접속할 시간을 더 준다 (premove를 두려던 턴은 새 턴으로)
+    timer_arm(&s->wheel, &g->turn_timer, (cg->timed ? cg->turn_ms : TIMEOUT * 1000) + CHECKPOINT_RESTORE_MS);
+}
+
+void server_stop(void) {
+    if (!shards || __atomic_exchange_n(&stop_posted, 1, __ATOMIC_ACQ_REL)) return;
+    for (int i = 0; i < shard_count; i++) mailbox_post(&shards[i].mailbox, &shards[i].stop_msg.mail);
+}
+static void on_signal(NetHandler *h, uint32_t events) {
+    struct signalfd_siginfo si;
+    (void)h;
+    (void)events;
+    while (read(signal_fd, &si, sizeof si) == (ssize_t)sizeof si) {
+        if (!stop_posted) printf("Stopping (%s)...\n", strsignal((int)si.ssi_signo));
+    }
+    server_stop();
+}
+
+static int run_shards(void) {
+    shard_count = config.threads;
+    if (shard_count <= 0) shard_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (shard_count <= 0) shard_count = 1;
+    if (shard_count > SESSION_MAX_SHARDS) shard_count = SESSION_MAX_SHARDS;
+    if (config.log_path) {
+        game_log = gamelog_open(config.log_path, config.log_sync, config.log_sync_ms);
+        if (!game_log) return EXIT_FAILURE;
+    }
+    if (config.checkpoint_path) {
+        checkpoint = checkpoint_open(config.checkpoint_path);
+        if (!checkpoint) {
+            gamelog_close(game_log);
+            game_log = NULL;
+            return EXIT_FAILURE;
+        }
+    }
+    shards = (Shard *)calloc((size_t)shard_count, sizeof(Shard));
+    if (!shards) {
+        checkpoint_close(checkpoint);
+        checkpoint = NULL;
+        gamelog_close(game_log);
+        game_log = NULL;
         return EXIT_FAILURE;
     }
-    printf("Server started on port %s\n", port);
-    global_listen_fd = listen_fd;
-    init_game(&game);
-    update_led_matrix(game.board);
-    accept_and_register(listen_fd);
-    pthread_t reject_thread;
-    pthread_create(&reject_thread, NULL, reject_late_clients, NULL);
-    game_loop();
 
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (game.players[i].socket >= 0) {
-            close(game.players[i].socket);
+    for (int i = 0; i < shard_count; i++) {
+        if (shard_init(&shards[i], i) < 0) {
+            while (--i >= 0) shard_close(&shards[i]);
+            free(shards);
+            shards = NULL;
+            checkpoint_close(checkpoint);
+            checkpoint = NULL;
+            gamelog_close(game_log);
+            game_log = NULL;
+            return EXIT_FAILURE;
         }
     }
-    close(listen_fd);
-    global_listen_fd = -1; // Mark server as stopped
+    if (signal_fd >= 0) {
+        signal_handler.on_event = on_signal;
+        if (reactor_add(&shards[0].reactor, signal_fd, EPOLLIN, &signal_handler) < 0) perror("epoll_ctl");
+    }
+    pthread_mutex_init(&lobby.lock, NULL);
+    users = registry_new();
+    if (!users) {
+        for (int i = 0; i < shard_count; i++) shard_close(&shards[i]);
+        free(shards);
+        shards = NULL;
+        checkpoint_close(checkpoint);
+        checkpoint = NULL;
+        gamelog_close(game_log);
+        game_log = NULL;
+        return EXIT_FAILURE;
+    }
+    printf("Server started on port %s (%d reactors, %s)\n", config.port, shard_count,
+           config.io_uring ? "io_uring" : "epoll");
+    if (config.unix_path) printf("Listening on unix socket %s\n", config.unix_path);
+    if (config.log_path) printf("Logging games to %s\n", config.log_path);
+    // 되살리는 게임부터 세도록 체크포인트보다 먼저 켠다. 안 열리면 계측/추적 없이 계속한다
+    if (config.stats_addr && stats_serve(config.stats_addr) == 0) printf("Serving stats on %s\n", config.stats_addr);
+    if (config.trace_path && trace_open(config.trace_path, "server") == 0) printf("Tracing to %s\n", config.trace_path);
+    if (checkpoint) {
+        uint64_t t0 = timer_now_ms();
+        int next_shard = 0;
+        int restored = checkpoint_restore(checkpoint, restore_game, &next_shard);
+        printf("Checkpointing games to %s (%d restored in %llu ms)\n", config.checkpoint_path, restored,
+               (unsigned long long)(timer_now_ms() - t0));
+    }
+    GameSession initial;
+    char board[BOARD_SIZE][BOARD_SIZE];
+    session_init(&initial);
+    session_to_board(&initial, board);
+    update_led_matrix(board);
+
+    /* shard마다 스레드 하나, 코어 하나. 게임 진행 중에는 shard끼리 공유하는 락이 없다 */
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int started = 0;
+    for (int i = 0; i < shard_count; i++) {
+        if (pthread_create(&shards[i].thread, NULL, shard_main, &shards[i]) != 0) {
+            perror("pthread_create");
+            break;
+        }
+        started++;
+        if (ncpu > 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET((int)(i % ncpu), &set);
+            pthread_setaffinity_np(shards[i].thread, sizeof set, &set);
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(shards[i].thread, NULL);
+    }
+
+    /* 오가던 메시지를 먼저 처리한 뒤 등록 사용자(연결 포함)를 정리 */
+    for (int i = 0; i < shard_count; i++) mailbox_close(&shards[i].mailbox);
+    if (signal_fd >= 0) reactor_del(&shards[0].reactor, signal_fd);
+    drop_all_users();
+    for (int i = 0; i < shard_count; i++) shard_close(&shards[i]);
+    registry_free(users);
+    users = NULL;
+    free(shards);
+    shards = NULL;
+    gamelog_close(game_log);   // shard가 넘긴 chunk까지 다 쓴 뒤 닫는다
+    game_log = NULL;
+    checkpoint_close(checkpoint);
+    checkpoint = NULL;
+    stats_close();
+    trace_close();
     printf("Server stopped.\n");
-    return EXIT_SUCCESS;
+    return started == shard_count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int server_run_config(const ServerConfig *cfg) {
+    /* Ctrl-C/kill에도 정리 경로(진행 중인 게임 기록, 로그/체크포인트/추적 파일 닫기)를 거치도록
+       SIGINT/SIGTERM을 signalfd로 받는다. 이후 만드는 스레드가 모두 마스크를 물려받게 맨 먼저 막는다 */
+    sigset_t mask, old;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, &old);
+    signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        perror("signalfd");     // 예전처럼 시그널에 바로 종료된다
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    config = *cfg;
+    stop_posted = 0;
+    int rc = run_shards();
+    if (signal_fd >= 0) {
+        close(signal_fd);
+        signal_fd = -1;
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    return rc;
 }
@@ -8,22 +8,32 @@
 #define BOARD_SIZE 8
 #define MAX_CLIENTS 2
 #define TIMEOUT 5
+#define SERVER_DEFAULT_BACKLOG 4096
+#define SERVER_DEFAULT_RESUME_GRACE 15   // 초
 
 typedef struct {
-    int socket;
-    char username[32];
-    char color;
-    int registered; // 1 if registered, 0 otherwise
-} Player;
+    const char *port;
+    size_t out_high_water; // 연결당 출력 큐 상한 (바이트), 넘으면 연결을 끊음
+    int backlog;           // listen() backlog (커널 somaxconn에서 잘릴 수 있음)
+    int threads;           // reactor 스레드 수, 0이면 코어 수
+    int rating_bucket;     // 매칭 rating 구간 폭, 0이면 rating 무시
+    const char *unix_path; // 같은 호스트용 unix 소켓 경로 (NULL이면 TCP만)
+    int io_uring;          // 1이면 io_uring 백엔드 (안 되면 epoll로 되돌아감)
+    const char *log_path;  // 게임 기록 로그 (NULL이면 남기지 않음)
+    int log_sync;          // GAMELOG_SYNC_* (gamelog.h)
+    int log_sync_ms;       // GAMELOG_SYNC_INTERVAL일 때 fdatasync 간격
+    const char *checkpoint_path; // 진행 중인 게임 체크포인트 (NULL이면 남기지 않음, 있으면 시작할 때 되살린다)
+    int resume_grace;      // 게임 중 끊긴 플레이어의 자리를 지키는 시간 (초), 0이면 바로 게임을 끝낸다
+    const char *stats_addr; // 계측 값을 내주는 unix 소켓 경로나 localhost HTTP 포트 (NULL이면 재지 않음)
+    const char *trace_path; // 단계별 구간을 Chrome trace-event JSON으로 덧붙일 파일 (NULL이면 끔)
+} ServerConfig;
 
-typedef struct {
-    Player players[MAX_CLIENTS];
-    int current_turn; // 0 = Red's turn, 1 = Blue's turn
-    char board[BOARD_SIZE][BOARD_SIZE];
-} GameState;
-
-void init_game_state(GameState *game);
+void server_config_init(ServerConfig *cfg);
 int server_run(const char *port);
+int server_run_config(const ServerConfig *cfg);
+// 다른 스레드에서: 모든 shard가 지금 처리 중인 이벤트까지 마치고 server_run_config가 정리 후 돌아오게 한다
+// (hw3 bench가 같은 프로세스에서 띄운 서버를 멈출 때)
+void server_stop(void);
 
 
 #endif 
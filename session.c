@@ -0,0 +1,276 @@
+#include "../include/session.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SESSION_SLAB_SIZE (64 * 1024)
+
+#define FILE_A  0x0101010101010101ull   // c == 0
+#define FILE_B  0x0202020202020202ull   // c == 1
+#define FILE_G  0x4040404040404040ull   // c == 6
+#define FILE_H  0x8080808080808080ull   // c == 7
+
+static inline uint64_t bit_at(int r, int c) {
+    return (uint64_t)1 << (r * BOARD_SIZE + c);
+}
+
+// 모든 말을 한 방향으로 한 칸 옮긴 보드 (보드 밖으로 나가는 비트는 버림)
+static inline uint64_t step_n(uint64_t b) { return b >> 8; }
+static inline uint64_t step_s(uint64_t b) { return b << 8; }
+static inline uint64_t step_e(uint64_t b) { return (b << 1) & ~FILE_A; }
+static inline uint64_t step_w(uint64_t b) { return (b >> 1) & ~FILE_H; }
+
+// 8방향으로 한 칸 떨어진 칸들
+static uint64_t ring1(uint64_t b) {
+    uint64_t ew = step_e(b) | step_w(b);
+    uint64_t row = b | ew;
+    return ew | step_n(row) | step_s(row);
+}
+
+// 8방향으로 정확히 두 칸 떨어진 칸들 (점프 도착지)
+static uint64_t ring2(uint64_t b) {
+    uint64_t e2 = (b << 2) & ~(FILE_A | FILE_B);
+    uint64_t w2 = (b >> 2) & ~(FILE_G | FILE_H);
+    uint64_t cols = b | e2 | w2;
+    return e2 | w2 | (cols >> 16) | (cols << 16);
+}
+
+static inline uint64_t pieces(const GameSession *g, int color) {
+    return color ? g->blue : g->red;
+}
+
+static inline uint64_t empty_cells(const GameSession *g) {
+    return ~(g->red | g->blue | g->blocked);
+}
+
+void session_init(GameSession *g) {
+    memset(g, 0, sizeof *g);
+    g->red = bit_at(0, 0) | bit_at(BOARD_SIZE - 1, BOARD_SIZE - 1);
+    g->blue = bit_at(0, BOARD_SIZE - 1) | bit_at(BOARD_SIZE - 1, 0);
+}
+
+char session_cell(const GameSession *g, int r, int c) {
+    uint64_t m = bit_at(r, c);
+    if (g->red & m) return 'R';
+    if (g->blue & m) return 'B';
+    if (g->blocked & m) return '#';
+    return '.';
+}
+
+void session_render(const GameSession *g, char rows[BOARD_SIZE][BOARD_SIZE + 1]) {
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) rows[r][c] = session_cell(g, r, c);
+        rows[r][BOARD_SIZE] = '\0';
+    }
+}
+
+void session_to_board(const GameSession *g, char board[BOARD_SIZE][BOARD_SIZE]) {
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) board[r][c] = session_cell(g, r, c);
+    }
+}
+
+void session_from_board(GameSession *g, char board[BOARD_SIZE][BOARD_SIZE]) {
+    session_init(g);
+    g->red = g->blue = g->blocked = 0;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            if (board[r][c] == 'R') g->red |= bit_at(r, c);
+            else if (board[r][c] == 'B') g->blue |= bit_at(r, c);
+            else if (board[r][c] == '#') g->blocked |= bit_at(r, c);
+        }
+    }
+}
+
+int session_is_valid_move(const GameSession *g, int color, int r1, int c1, int r2, int c2) {
+    if (r1 < 0 || r1 >= BOARD_SIZE || c1 < 0 || c1 >= BOARD_SIZE) return 0;
+    if (r2 < 0 || r2 >= BOARD_SIZE || c2 < 0 || c2 >= BOARD_SIZE) return 0;
+    // 출발지는 내 말, 도착지는 빈 칸
+    if (!(pieces(g, color) & bit_at(r1, c1))) return 0;
+    if (!(empty_cells(g) & bit_at(r2, c2))) return 0;
+    return 1;
+}
+
+int session_move(GameSession *g, int r1, int c1, int r2, int c2, uint64_t *flipped) {
+    uint64_t from = bit_at(r1, c1), to = bit_at(r2, c2);
+    uint64_t *mine, *theirs;
+    if (g->red & from) {
+        mine = &g->red;
+        theirs = &g->blue;
+    } else if (g->blue & from) {
+        mine = &g->blue;
+        theirs = &g->red;
+    } else {
+        return 0;
+    }
+    int dr = abs(r1 - r2), dc = abs(c1 - c2);
+    if (dr <= 1 && dc <= 1 && (dr | dc)) {
+        // 복제: 출발지 말은 그대로
+    } else if ((dr == 2 || dr == 0) && (dc == 2 || dc == 0) && (dr | dc)) {
+        // 점프: 출발지는 비운다
+        *mine &= ~from;
+    } else {
+        return 0;
+    }
+    *mine |= to;
+    // 도착지 주변의 상대 말을 뒤집는다
+    uint64_t flips = ring1(to) & *theirs;
+    *theirs &= ~flips;
+    *mine |= flips;
+    if (flipped) *flipped = flips;
+    return 1;
+}
+
+int session_has_valid_move(const GameSession *g, int color) {
+    uint64_t mine = pieces(g, color);
+    return ((ring1(mine) | ring2(mine)) & empty_cells(g)) != 0;
+}
+
+int session_moves(const GameSession *g, int color, uint16_t *out) {
+    uint64_t mine = pieces(g, color), empty = empty_cells(g);
+    int n = 0;
+    for (uint64_t to = ring1(mine) & empty; to; to &= to - 1) {
+        int dst = __builtin_ctzll(to);
+        int src = __builtin_ctzll(ring1((uint64_t)1 << dst) & mine);
+        out[n++] = (uint16_t)((src << 6) | dst);
+    }
+    for (uint64_t from = mine; from; from &= from - 1) {
+        int src = __builtin_ctzll(from);
+        for (uint64_t to = ring2((uint64_t)1 << src) & empty; to; to &= to - 1) {
+            out[n++] = (uint16_t)((src << 6) | __builtin_ctzll(to));
+        }
+    }
+    return n;
+}
+
+int session_apply(GameSession *g, int color, uint16_t mv) {
+    if (mv == 0xFFFFu) return !session_has_valid_move(g, color);
+    int r1 = (mv >> 9) & 7, c1 = (mv >> 6) & 7, r2 = (mv >> 3) & 7, c2 = mv & 7;
+    if (!session_is_valid_move(g, color, r1, c1, r2, c2)) return 0;
+    session_move(g, r1, c1, r2, c2, NULL);
+    return 1;
+}
+
+int session_is_over(const GameSession *g) {
+    int r = __builtin_popcountll(g->red);
+    int b = __builtin_popcountll(g->blue);
+    if (empty_cells(g) == 0) return 1;
+    if (r == 0 || b == 0) return 1;
+    if (g->blocked == ~(uint64_t)0) return 1;
+    if (r + b == BOARD_SIZE * BOARD_SIZE) return 1;
+    return 0;
+}
+
+int session_count(const GameSession *g, int color) {
+    return __builtin_popcountll(pieces(g, color));
+}
+
+uint32_t session_hash(const GameSession *g) {
+    uint32_t h = BOARD_HASH_INIT;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) h = board_hash_step(h, session_cell(g, r, c));
+    }
+    return h;
+}
+
+struct SessionSlab {
+    SessionSlab *next;
+    size_t pad;                    // 세션 배열을 16바이트 정렬로 맞춤
+};
+
+#define SESSIONS_PER_SLAB ((SESSION_SLAB_SIZE - sizeof(SessionSlab)) / sizeof(GameSession))
+
+void session_pool_init(SessionPool *pool) {
+    memset(pool, 0, sizeof *pool);
+}
+
+void session_pool_destroy(SessionPool *pool) {
+    SessionSlab *s = pool->slabs;
+    while (s) {
+        SessionSlab *next = s->next;
+        free(s);
+        s = next;
+    }
+    memset(pool, 0, sizeof *pool);
+}
+
+GameSession *session_alloc(SessionPool *pool) {
+    if (!pool->free_list) {
+        SessionSlab *slab = (SessionSlab *)malloc(SESSION_SLAB_SIZE);
+        if (!slab) return NULL;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->slab_count++;
+        GameSession *arr = (GameSession *)(slab + 1);
+        // free list는 세션 첫 8바이트(red 자리)에 다음 포인터를 둔다
+        for (size_t i = SESSIONS_PER_SLAB; i-- > 0; ) {
+            *(GameSession **)(void *)&arr[i] = pool->free_list;
+            pool->free_list = &arr[i];
+        }
+    }
+    GameSession *g = pool->free_list;
+    pool->free_list = *(GameSession **)(void *)g;
+    pool->live++;
+    session_init(g);
+    return g;
+}
+
+void session_free(SessionPool *pool, GameSession *g) {
+    if (!g) return;
+    timer_cancel(&g->turn_timer);
+    *(GameSession **)(void *)g = pool->free_list;
+    pool->free_list = g;
+    pool->live--;
+}
+
+static long rss_kb(void) {
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = -1;
+    fclose(f);
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int session_bench(size_t n) {
+    SessionPool pool;
+    GameSession **games = (GameSession **)malloc(n * sizeof(GameSession *));
+    if (!games) return 1;
+    session_pool_init(&pool);
+
+    long before = rss_kb();
+    for (size_t i = 0; i < n; i++) {
+        games[i] = session_alloc(&pool);
+        if (!games[i]) {
+            fprintf(stderr, "session_alloc failed at %zu\n", i);
+            n = i;
+            break;
+        }
+        games[i]->player[0] = (uint32_t)(2 * i + 1);
+        games[i]->player[1] = (uint32_t)(2 * i + 2);
+        games[i]->seated = MAX_CLIENTS;
+        // 몇 수 둬서 실제 게임처럼 값이 채워지게 한다
+        session_move(games[i], 0, 0, 1, 1, NULL);
+        session_move(games[i], 0, BOARD_SIZE - 1, 1, BOARD_SIZE - 2, NULL);
+        games[i]->turn = 0;
+        games[i]->pass_count = 0;
+    }
+    long after = rss_kb();
+
+    long delta = after - before;
+    printf("sessions:          %zu\n", n);
+    printf("sizeof(GameSession): %zu bytes\n", sizeof(GameSession));
+    printf("slabs:             %zu x %d KB (%zu sessions/slab)\n",
+           pool.slab_count, SESSION_SLAB_SIZE / 1024, (size_t)SESSIONS_PER_SLAB);
+    printf("rss before/after:  %ld KB / %ld KB\n", before, after);
+    if (n > 0 && delta >= 0) {
+        printf("rss per game:      %.1f bytes\n", (double)delta * 1024.0 / (double)n);
+    }
+
+    for (size_t i = 0; i < n; i++) session_free(&pool, games[i]);
+    session_pool_destroy(&pool);
+    free(games);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "server.h"
+#include "timer.h"
+
+/*
+ * 게임 한 판의 상태. 보드는 칸 (r*8 + c)를 비트로 둔 bitboard 3장,
+ * 플레이어는 사용자 테이블의 id, 턴/패스 같은 작은 값은 비트필드로 묶는다.
+ *
+ *   bitboard 3 x 8B            24B
+ *   player id 2 x 4B            8B
+ *   flags (turn, pass, seq ...) 4B
+ *   game id                     4B
+ *   Timer (턴 타임아웃)         56B
+ *   ---------------------------------
+ *   sizeof(GameSession)         96B / 게임  (x86-64 기준, 연결 버퍼는 별도)
+ *
+ * 예전 GameState(Player 2개 + char 보드)는 타이머까지 264B였다.
+ */
+#define SESSION_NO_USER 0u
+#define SESSION_MAX_SHARDS 256
+
+// delta 클라이언트가 동기화를 확인하는 보드 해시: 64칸 문자('R','B','#','.')를 행 우선으로 FNV-1a 32비트
+#define BOARD_HASH_INIT 2166136261u
+static inline uint32_t board_hash_step(uint32_t h, char cell) {
+    return (h ^ (unsigned char)cell) * 16777619u;
+}
+
+// GameSession.state
+enum { SESSION_SEATING, SESSION_AWAIT_MOVE, SESSION_OVER };
+
+typedef struct GameSession {
+    uint64_t red;                  // 'R'
+    uint64_t blue;                 // 'B'
+    uint64_t blocked;              // '#'
+    uint32_t player[MAX_CLIENTS];  // user id, 0이면 빈 자리 (0번 = Red, 1번 = Blue)
+    unsigned turn : 1;             // 0 = Red, 1 = Blue
+    unsigned pass_count : 2;       // 연속 pass 횟수 (2면 게임 종료)
+    unsigned seated : 2;           // 자리에 앉은 플레이어 수
+    unsigned state : 2;            // SESSION_*
+    unsigned shard : 8;            // 게임을 맡은 reactor 번호 (SESSION_MAX_SHARDS 미만)
+    unsigned seq : 16;             // 보드가 바뀐 횟수 (move_ok/pass마다 1씩, 65536에서 0으로)
+    uint32_t id;                   // 서버 전체에서 유일한 게임 번호 (관전 요청이 가리키는 값)
+    Timer turn_timer;
+} GameSession;
+
+// 초기 배치: 네 귀퉁이에 R/B
+void session_init(GameSession *g);
+// 'R', 'B', '#', '.'
+char session_cell(const GameSession *g, int r, int c);
+// 출력/JSON용: '\0'으로 끝나는 8줄
+void session_render(const GameSession *g, char rows[BOARD_SIZE][BOARD_SIZE + 1]);
+// LED 매트릭스용 8x8 char 보드
+void session_to_board(const GameSession *g, char board[BOARD_SIZE][BOARD_SIZE]);
+// 반대로: 8x8 char 보드('R', 'B', '#', 그 밖은 빈 칸)를 bitboard로. 보드 밖의 필드는 session_init 값
+void session_from_board(GameSession *g, char board[BOARD_SIZE][BOARD_SIZE]);
+
+// color: 0 = Red, 1 = Blue. 좌표는 0부터
+int session_is_valid_move(const GameSession *g, int color, int r1, int c1, int r2, int c2);
+// 복제(인접 1칸) 또는 점프(2칸) 후 주변 상대 말을 뒤집는다. 규칙에 맞는 거리가 아니면 0
+// flipped가 NULL이 아니면 뒤집힌 칸의 비트를 넣어준다
+int session_move(GameSession *g, int r1, int c1, int r2, int c2, uint64_t *flipped);
+int session_has_valid_move(const GameSession *g, int color);
+// 둘 수 있는 수를 out에 채우고 개수를 돌려준다. 수는 wire.h와 같은 u16 (출발 칸 << 6 | 도착 칸)
+// 같은 칸으로의 복제는 결과가 같으므로 하나만, 점프는 출발지마다 넣는다 (복제가 먼저)
+#define SESSION_MAX_MOVES (64 + 64 * 8)
+int session_moves(const GameSession *g, int color, uint16_t *out);
+// 기록된 수 하나(0xFFFF = pass)를 서버와 같은 판정으로 둔다: 내 말에서 빈 칸으로 가는 수면 1
+// (거리가 틀린 수는 서버처럼 보드를 그대로 두고 1), pass는 둘 곳이 없을 때만 1
+int session_apply(GameSession *g, int color, uint16_t mv);
+int session_is_over(const GameSession *g);
+int session_count(const GameSession *g, int color);
+uint32_t session_hash(const GameSession *g);
+
+/*
+ * 같은 크기 세션을 64KB slab 단위로 잘라 쓰는 풀. 해제된 세션은 free list로 재사용.
+ * reactor 스레드마다 하나씩 두고 그 스레드에서만 쓴다.
+ */
+typedef struct SessionSlab SessionSlab;
+
+typedef struct {
+    SessionSlab *slabs;
+    GameSession *free_list;
+    size_t live;                   // 사용 중인 세션 수
+    size_t slab_count;
+} SessionPool;
+
+void session_pool_init(SessionPool *pool);
+void session_pool_destroy(SessionPool *pool);
+GameSession *session_alloc(SessionPool *pool);
+void session_free(SessionPool *pool, GameSession *g);
+
+// 세션 n개를 만들어 두고 RSS를 재서 출력 (hw3 bench sessions)
+int session_bench(size_t n);
+
+#endif
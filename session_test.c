@@ -0,0 +1,148 @@
+#include "../include/session.h"
+#include "../include/game.h"
+#include "../include/test.h"
+#include "../include/test_game.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * bitboard 세션(session.c)을 예전 char 보드 규칙(game.c)과 맞대 본다.
+ * 장애물을 무작위로 깐 판에서 무작위로 끝까지 두면서, 수마다 모든 (출발, 도착) 쌍에 대해
+ * 판정과 결과 보드, 종료 판정, 말 수가 같은지 본다.
+ * delta 업데이트가 쓰는 뒤집힌 칸 비트와 보드 해시도 char 보드에서 다시 구한 것과 맞춰 본다.
+ * session_moves가 내는 수 목록은 모든 쌍을 판정해 얻은 목록과 맞춰 본다.
+ * 기록된 수를 다시 두는 session_apply와 char 보드에서 되돌리는 session_from_board도 같이 본다.
+ */
+#define GAMES 200
+#define MAX_PLIES 400
+
+// 클라이언트가 자기 char 보드로 구하는 것과 같은 해시
+static uint32_t board_hash(char board[BOARD_SIZE][BOARD_SIZE]) {
+    uint32_t h = BOARD_HASH_INIT;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) h = board_hash_step(h, board[r][c]);
+    }
+    return h;
+}
+
+// 상대 말이던 칸 중 player 말이 된 칸 (출발/도착 칸은 빈칸이었거나 자기 말이라 빠진다)
+static uint64_t flipped_cells(char before[BOARD_SIZE][BOARD_SIZE], char after[BOARD_SIZE][BOARD_SIZE], char player) {
+    char other = player == 'R' ? 'B' : 'R';
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i++) {
+        if (before[i / 8][i % 8] == other && after[i / 8][i % 8] == player) bits |= 1ull << i;
+    }
+    return bits;
+}
+
+// 지금 판에서 color가 둘 수 있는 모든 쌍을 두 구현으로 둬 본다
+static void check_all_pairs(const GameSession *g, char board[BOARD_SIZE][BOARD_SIZE], int color) {
+    char player = color ? 'B' : 'R';
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            int r1 = from / 8, c1 = from % 8, r2 = to / 8, c2 = to % 8;
+            char old_board[BOARD_SIZE][BOARD_SIZE];
+            memcpy(old_board, board, sizeof old_board);
+            int old_ok = isValidMove(old_board, player, r1, c1, r2, c2) &&
+                         Move(old_board, color, r1, c1, r2, c2);
+
+            GameSession next = *g;
+            uint64_t flipped = 0;
+            int valid = session_is_valid_move(&next, color, r1, c1, r2, c2);
+            int new_ok = valid && session_move(&next, r1, c1, r2, c2, &flipped);
+
+            // session_apply: 판정이 통과하면 1, 거리가 틀려 session_move가 안 둔 수는 보드를 그대로 둔다
+            GameSession applied = *g;
+            CHECK(session_apply(&applied, color, (uint16_t)(from << 6 | to)) == valid);
+            if (new_ok) CHECK(applied.red == next.red && applied.blue == next.blue);
+            else CHECK(applied.red == g->red && applied.blue == g->blue);
+
+            CHECK(old_ok == new_ok);
+            if (old_ok && new_ok) {
+                CHECK(test_same_board(&next, old_board));
+                CHECK(flipped == flipped_cells(board, old_board, player));
+                CHECK(session_hash(&next) == board_hash(old_board));
+            }
+        }
+    }
+}
+
+// 복제는 도착 칸마다 하나, 점프는 (출발, 도착)마다 하나, 복제가 먼저
+static void check_move_list(const GameSession *g, int color) {
+    uint16_t all[TEST_MAX_MOVES], list[SESSION_MAX_MOVES];
+    int n_all = test_legal_moves(g, color, all);
+    int n = session_moves(g, color, list);
+    uint64_t clone_to = 0, seen_to = 0;
+    int jumps = 0, listed_jumps = 0, jumped = 0;
+
+    for (int i = 0; i < n_all; i++) {
+        int from = all[i] >> 6, to = all[i] & 63;
+        if (abs(from / 8 - to / 8) <= 1 && abs(from % 8 - to % 8) <= 1) clone_to |= 1ull << to;
+        else jumps++;
+    }
+    for (int i = 0; i < n; i++) {
+        int from = list[i] >> 6, to = list[i] & 63;
+        int clone = abs(from / 8 - to / 8) <= 1 && abs(from % 8 - to % 8) <= 1;
+        CHECK(session_is_valid_move(g, color, from / 8, from % 8, to / 8, to % 8));
+        if (clone) {
+            CHECK(!jumped);
+            CHECK(!(seen_to & (1ull << to)));
+            seen_to |= 1ull << to;
+        } else {
+            jumped = 1;
+            listed_jumps++;
+            for (int k = 0; k < i; k++) CHECK(list[k] != list[i]);
+        }
+    }
+    CHECK(seen_to == clone_to);
+    CHECK(listed_jumps == jumps);
+    CHECK(n == __builtin_popcountll(clone_to) + jumps);
+}
+
+static void play_game(uint32_t id) {
+    TestGame t;
+    GameSession *g = &t.g;
+    char board[BOARD_SIZE][BOARD_SIZE];
+    test_game_start(&t, id);
+    session_to_board(g, board);
+
+    for (int ply = 0; ply < MAX_PLIES; ply++) {
+        int color = g->turn;
+        char player = color ? 'B' : 'R';
+
+        CHECK(isGameOver(board) == session_is_over(g));
+        CHECK(countR(board) == session_count(g, 0));
+        CHECK(countB(board) == session_count(g, 1));
+        CHECK(hasValidMove(board, player) == session_has_valid_move(g, color));
+        CHECK(session_hash(g) == board_hash(board));
+        GameSession from_board;
+        session_from_board(&from_board, board);
+        CHECK(from_board.red == g->red && from_board.blue == g->blue && from_board.blocked == g->blocked);
+        GameSession passed = *g;
+        CHECK(session_apply(&passed, color, TEST_MOVE_PASS) == !session_has_valid_move(g, color));
+        if (test_game_over(g)) return;
+
+        check_all_pairs(g, board, color);
+        check_move_list(g, color);
+
+        char before[BOARD_SIZE][BOARD_SIZE];
+        uint16_t seq = (uint16_t)g->seq;
+        uint64_t flipped = 0;
+        memcpy(before, board, sizeof before);
+        uint16_t mv = test_random_step(g, &flipped);
+        if (mv != TEST_MOVE_PASS) {
+            int from = mv >> 6, to = mv & 63;
+            CHECK(Move(board, color, from / 8, from % 8, to / 8, to % 8));
+        }
+        CHECK(flipped == flipped_cells(before, board, player));
+        CHECK((uint16_t)(seq + 1) == g->seq);
+        CHECK(test_same_board(g, board));
+    }
+}
+
+int main(void) {
+    srand(1);
+    for (uint32_t i = 1; i <= GAMES && !test_failures; i++) play_game(i);
+    return test_report("session_test");
+}
@@ -0,0 +1,251 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // memfd_create
+#endif
+#include "../include/shm.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+#define SHM_SEALS (F_SEAL_SHRINK | F_SEAL_GROW)   // 매핑한 뒤 크기가 바뀌지 않는다
+
+// spin 대기 중에 CPU에 알려준다 (라즈베리 파이는 ARM)
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#endif
+
+static inline uint32_t ring_used(const ShmRing *r) {
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+static void wake(int fd) {
+    uint64_t one = 1;
+    ssize_t n = write(fd, &one, sizeof one);
+    (void)n;
+}
+
+// 잠들려는 상대에게 알린다: flag를 세운 쪽과 순서가 엇갈려도 한쪽은 반드시 상대를 본다
+// flag는 기다리던 쪽이 깨어나서 내린다
+static void wake_if(uint32_t *flag, int fd) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(flag, __ATOMIC_RELAXED)) wake(fd);
+}
+
+static int map_area(ShmLink *l, int memfd) {
+    void *p = mmap(NULL, sizeof(ShmArea), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (p == MAP_FAILED) return -1;
+    l->area = (ShmArea *)p;
+    l->memfd = memfd;
+    return 0;
+}
+
+static void link_init(ShmLink *l) {
+    memset(l, 0, sizeof *l);
+    l->memfd = l->wake_fd = l->peer_fd = l->hup_fd = -1;
+}
+
+int shm_link_connect(ShmLink *l, int sock, int spin_us) {
+    link_init(l);
+    l->hup_fd = sock;
+    l->spin_us = spin_us;
+    int memfd = memfd_create("hw3-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        perror("memfd_create");
+        return -1;
+    }
+    int server_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int client_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (server_efd < 0 || client_efd < 0 || ftruncate(memfd, sizeof(ShmArea)) < 0
+        || fcntl(memfd, F_ADD_SEALS, SHM_SEALS) < 0 || map_area(l, memfd) < 0) {
+        perror("shm");
+        if (server_efd >= 0) close(server_efd);
+        if (client_efd >= 0) close(client_efd);
+        close(memfd);
+        l->memfd = -1;
+        return -1;
+    }
+    l->tx = &l->area->up;
+    l->rx = &l->area->down;
+    l->wake_fd = client_efd;
+    l->peer_fd = server_efd;
+    l->tx->reader_sleeping = 1;        // 서버는 늘 epoll에서 기다린다
+
+    int fds[SHM_FDS] = { memfd, server_efd, client_efd };
+    char magic = (char)SHM_MAGIC;
+    char cbuf[CMSG_SPACE(sizeof fds)];
+    struct iovec iov;
+    struct msghdr mh;
+    memset(cbuf, 0, sizeof cbuf);
+    memset(&mh, 0, sizeof mh);
+    iov.iov_base = &magic;
+    iov.iov_len = 1;
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = cbuf;
+    mh.msg_controllen = sizeof cbuf;
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof fds);
+    memcpy(CMSG_DATA(cm), fds, sizeof fds);
+    if (sendmsg(sock, &mh, MSG_NOSIGNAL) != 1) {
+        perror("sendmsg");
+        shm_link_close(l);
+        return -1;
+    }
+    return 0;
+}
+
+int shm_link_open(ShmLink *l, const int fds[SHM_FDS]) {
+    link_init(l);
+    // 클라이언트가 나중에 memfd를 줄이면 서버가 링을 건드리다 SIGBUS로 죽는다: 크기를 봉인한 것만 받는다
+    struct stat st;
+    int seals = fcntl(fds[0], F_GET_SEALS);
+    if (seals < 0 || (seals & SHM_SEALS) != SHM_SEALS || fstat(fds[0], &st) < 0
+        || (size_t)st.st_size < sizeof(ShmArea)) {
+        fprintf(stderr, "shm: rejecting memfd that is not sealed at ring size\n");
+        return -1;
+    }
+    // eventfd가 아닌 것(파이프 등)을 넘겨도 읽고 쓰다 reactor 스레드가 막히지 않게
+    for (int i = 1; i < SHM_FDS; i++) {
+        int flags = fcntl(fds[i], F_GETFL);
+        if (flags < 0 || fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) < 0) {
+            perror("shm fcntl");
+            return -1;
+        }
+    }
+    if (map_area(l, fds[0]) < 0) return -1;
+    l->tx = &l->area->down;
+    l->rx = &l->area->up;
+    l->wake_fd = fds[1];
+    l->peer_fd = fds[2];
+    return 0;
+}
+
+void shm_link_close(ShmLink *l) {
+    if (l->area) {
+        __atomic_store_n(&l->tx->closed, 1, __ATOMIC_RELEASE);
+        wake(l->peer_fd);
+        munmap(l->area, sizeof(ShmArea));
+        l->area = NULL;
+    }
+    if (l->memfd >= 0) close(l->memfd);
+    if (l->wake_fd >= 0) close(l->wake_fd);
+    if (l->peer_fd >= 0) close(l->peer_fd);
+    l->memfd = l->wake_fd = l->peer_fd = -1;
+}
+
+size_t shm_writev(ShmLink *l, const struct iovec *iov, int iovcnt) {
+    ShmRing *r = l->tx;
+    uint32_t head = r->head;           // 생산자는 나 하나
+    uint32_t space = SHM_RING_BYTES - (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+    size_t total = 0;
+    if (__atomic_load_n(&r->writer_waiting, __ATOMIC_RELAXED)) __atomic_store_n(&r->writer_waiting, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < iovcnt && space > 0; i++) {
+        const unsigned char *src = (const unsigned char *)iov[i].iov_base;
+        size_t len = iov[i].iov_len < space ? iov[i].iov_len : space;
+        uint32_t off = head & (SHM_RING_BYTES - 1);
+        size_t first = len < SHM_RING_BYTES - off ? len : SHM_RING_BYTES - off;
+        memcpy(r->data + off, src, first);
+        memcpy(r->data, src + first, len - first);
+        head += (uint32_t)len;
+        space -= (uint32_t)len;
+        total += len;
+    }
+    if (total > 0) {
+        __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+        wake_if(&r->reader_sleeping, l->peer_fd);
+    }
+    size_t want = 0;
+    for (int i = 0; i < iovcnt; i++) want += iov[i].iov_len;
+    if (total < want) {
+        // 가득 참: 소비자가 읽고 나서 깨우도록 표시한 뒤, 그 사이에 자리가 났는지 한 번 더 본다
+        __atomic_store_n(&r->writer_waiting, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (ring_used(r) < SHM_RING_BYTES) shm_kick(l);
+    }
+    return total;
+}
+
+ssize_t shm_read(ShmLink *l, void *buf, size_t len) {
+    ShmRing *r = l->rx;
+    uint32_t tail = r->tail;           // 소비자는 나 하나
+    uint32_t used = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - tail;
+    if (used == 0) return __atomic_load_n(&r->closed, __ATOMIC_ACQUIRE) ? -1 : 0;
+    size_t n = len < used ? len : used;
+    uint32_t off = tail & (SHM_RING_BYTES - 1);
+    size_t first = n < SHM_RING_BYTES - off ? n : SHM_RING_BYTES - off;
+    memcpy(buf, r->data + off, first);
+    memcpy((unsigned char *)buf + first, r->data, n - first);
+    __atomic_store_n(&r->tail, tail + (uint32_t)n, __ATOMIC_RELEASE);
+    wake_if(&r->writer_waiting, l->peer_fd);
+    return (ssize_t)n;
+}
+
+int shm_readable(const ShmLink *l) {
+    return ring_used(l->rx) != 0 || __atomic_load_n(&l->rx->closed, __ATOMIC_ACQUIRE);
+}
+
+void shm_drain(ShmLink *l) {
+    uint64_t v;
+    ssize_t n = read(l->wake_fd, &v, sizeof v);
+    (void)n;
+}
+
+void shm_kick(ShmLink *l) {
+    wake(l->wake_fd);
+}
+
+static int ready(const ShmLink *l, int for_write) {
+    if (for_write) return ring_used(l->tx) < SHM_RING_BYTES;
+    return shm_readable(l);
+}
+
+static long elapsed_us(const struct timespec *t0) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - t0->tv_sec) * 1000000L + (t.tv_nsec - t0->tv_nsec) / 1000;
+}
+
+int shm_wait(ShmLink *l, int for_write) {
+    // 상대가 곧 답할 때가 많으므로 잠깐은 syscall 없이 링만 본다
+    if (l->spin_us > 0) {
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        do {
+            if (ready(l, for_write)) return 0;
+            cpu_relax();
+        } while (elapsed_us(&t0) < l->spin_us);
+    }
+    uint32_t *flag = for_write ? &l->tx->writer_waiting : &l->rx->reader_sleeping;
+    for (;;) {
+        __atomic_store_n(flag, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (ready(l, for_write)) {
+            __atomic_store_n(flag, 0, __ATOMIC_RELAXED);
+            return 0;
+        }
+        struct pollfd pfd[2];
+        pfd[0].fd = l->wake_fd;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = l->hup_fd;
+        pfd[1].events = POLLIN;
+        int n = poll(pfd, l->hup_fd >= 0 ? 2 : 1, -1);
+        if (n < 0 && errno != EINTR) return -1;
+        if (n > 0 && (pfd[0].revents & POLLIN)) shm_drain(l);
+        // 링으로 옮긴 뒤 소켓이 읽힌다는 것은 서버가 끊었다는 뜻
+        if (n > 0 && l->hup_fd >= 0 && pfd[1].revents) return ready(l, for_write) ? 0 : -1;
+    }
+}
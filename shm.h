@@ -0,0 +1,73 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*
+ * 같은 호스트의 클라이언트용 전송: memfd 하나에 방향별 SPSC 바이트 링 두 개.
+ *
+ * 클라이언트가 unix 소켓으로 접속해서 SHM_MAGIC 1바이트와 함께 SCM_RIGHTS로
+ * [memfd, 서버가 기다릴 eventfd, 클라이언트가 기다릴 eventfd]를 넘기면, 그 뒤의 바이트는
+ * 소켓 대신 링으로 오간다 (안의 내용은 소켓과 같다: JSON 줄 또는 WIRE_MAGIC + 프레임).
+ * 소켓은 상대가 사라졌는지 알기 위해서만 열어둔다.
+ * memfd는 ShmArea 크기로 만든 뒤 F_SEAL_SHRINK | F_SEAL_GROW로 봉인해서 넘긴다 (서버는 봉인과 크기를 확인한다).
+ *
+ * 깨우기: 소비자는 잠들기 전에 reader_sleeping을 세우고 링을 한 번 더 본다. 생산자는
+ * head를 올린 뒤 그 플래그가 있을 때만 eventfd를 쓴다 (둘 다 seq_cst fence로 순서를 맞춤).
+ * 서버 쪽 소비자는 항상 epoll에서 기다리므로 up 링의 플래그는 처음부터 1이다.
+ * 링이 가득 찬 생산자는 writer_waiting을 세우고, 소비자가 읽은 뒤 깨워준다.
+ */
+#define SHM_MAGIC      0xA8            // WIRE_MAGIC, JSON과 겹치지 않는 첫 바이트
+#define SHM_FDS        3
+#define SHM_RING_BYTES (64 * 1024)     // 2의 거듭제곱
+
+typedef struct ShmRing {
+    uint32_t head;                     // 생산자가 쓴 총 바이트 (넘치면 0부터)
+    char pad0[60];
+    uint32_t tail;                     // 소비자가 읽은 총 바이트
+    char pad1[60];
+    uint32_t reader_sleeping;          // 소비자가 eventfd에서 기다림 → 생산자가 깨운다
+    uint32_t writer_waiting;           // 생산자가 자리를 기다림 → 소비자가 깨운다
+    uint32_t closed;                   // 생산자가 닫음 (남은 바이트를 다 읽으면 EOF)
+    char pad2[52];
+    unsigned char data[SHM_RING_BYTES];
+} ShmRing;
+
+typedef struct {
+    ShmRing up;                        // client → server
+    ShmRing down;                      // server → client
+} ShmArea;
+
+typedef struct ShmLink {
+    ShmArea *area;
+    ShmRing *tx, *rx;
+    int memfd;
+    int wake_fd;                       // 내가 기다리는 eventfd
+    int peer_fd;                       // 상대를 깨우는 eventfd
+    int hup_fd;                        // 클라이언트: 이 소켓이 끊기면 서버가 사라진 것 (서버는 -1)
+    int spin_us;                       // 클라이언트: 잠들기 전에 링을 돌며 기다리는 시간
+} ShmLink;
+
+// 클라이언트: 링을 만들어 sock으로 넘긴다 (SHM_MAGIC + fd 3개). 실패하면 -1
+int shm_link_connect(ShmLink *l, int sock, int spin_us);
+// 서버: 받은 fd로 링을 연다. 성공하면 fd는 l이 가져간다. 크기가 봉인되지 않은 memfd는 -1
+int shm_link_open(ShmLink *l, const int fds[SHM_FDS]);
+// 내 쪽 링을 닫았다고 표시하고 상대를 깨운 뒤 매핑과 fd를 정리한다
+void shm_link_close(ShmLink *l);
+
+// 쓸 수 있는 만큼 쓰고 쓴 바이트 수. 가득 차서 0이면 상대가 읽은 뒤 wake_fd가 울린다
+size_t shm_writev(ShmLink *l, const struct iovec *iov, int iovcnt);
+// 읽은 바이트 수, 비었으면 0, 상대가 닫았고 다 읽었으면 -1
+ssize_t shm_read(ShmLink *l, void *buf, size_t len);
+int shm_readable(const ShmLink *l);
+// wake_fd 카운터를 비운다 (서버: epoll에서 깬 뒤)
+void shm_drain(ShmLink *l);
+// 나를 깨운다 (서버: 입력 버퍼가 차서 못 읽은 링을 다음 이벤트에서 마저 읽도록)
+void shm_kick(ShmLink *l);
+// 클라이언트: 읽을 것(for_write면 쓸 자리)이 생길 때까지 spin 후 잔다. 상대가 사라지면 -1
+int shm_wait(ShmLink *l, int for_write);
+
+#endif
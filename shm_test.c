@@ -0,0 +1,120 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // memfd_create
+#endif
+#include "../include/shm.h"
+#include "../include/test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+/*
+ * shm.c: 클라이언트가 unix 소켓으로 넘긴 fd로 서버가 링을 열고 양쪽으로 바이트가 오가는지,
+ * 크기를 봉인하지 않았거나 ShmArea보다 작은 memfd는 서버가 거절하는지,
+ * eventfd 자리에 파이프를 넘겨도 서버 쪽 읽기가 막히지 않는지 본다.
+ */
+
+// sock에서 SHM_MAGIC과 fd 3개를 받는다
+static int recv_fds(int sock, int fds[SHM_FDS]) {
+    char magic = 0;
+    char cbuf[CMSG_SPACE(sizeof(int) * SHM_FDS)];
+    struct iovec iov;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof mh);
+    iov.iov_base = &magic;
+    iov.iov_len = 1;
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = cbuf;
+    mh.msg_controllen = sizeof cbuf;
+    if (recvmsg(sock, &mh, MSG_CMSG_CLOEXEC) != 1 || (unsigned char)magic != SHM_MAGIC) return -1;
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+    if (!cm || cm->cmsg_type != SCM_RIGHTS || cm->cmsg_len != CMSG_LEN(sizeof(int) * SHM_FDS)) return -1;
+    memcpy(fds, CMSG_DATA(cm), sizeof(int) * SHM_FDS);
+    return 0;
+}
+
+static void test_round_trip(void) {
+    int sv[2], fds[SHM_FDS];
+    ShmLink client, server;
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == 0);
+    CHECK(shm_link_connect(&client, sv[0], 0) == 0);
+    CHECK(recv_fds(sv[1], fds) == 0);
+    CHECK(shm_link_open(&server, fds) == 0);
+
+    char buf[64];
+    struct iovec iov;
+    iov.iov_base = (void *)"up\n";
+    iov.iov_len = 3;
+    CHECK(shm_writev(&client, &iov, 1) == 3);
+    CHECK(shm_read(&server, buf, sizeof buf) == 3 && memcmp(buf, "up\n", 3) == 0);
+    iov.iov_base = (void *)"down\n";
+    iov.iov_len = 5;
+    CHECK(shm_writev(&server, &iov, 1) == 5);
+    CHECK(shm_wait(&client, 0) == 0);
+    CHECK(shm_read(&client, buf, sizeof buf) == 5 && memcmp(buf, "down\n", 5) == 0);
+
+    // 한쪽이 닫으면 다른 쪽은 남은 것을 읽은 뒤 EOF
+    shm_link_close(&server);
+    CHECK(shm_read(&client, buf, sizeof buf) == -1);
+    shm_link_close(&client);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// size 크기 memfd에 seals를 걸어서 eventfd 두 개와 함께 연다. 열리면 1
+static int try_open(size_t size, int allow_sealing, int seals) {
+    int fds[SHM_FDS];
+    fds[0] = memfd_create("shm_test", MFD_CLOEXEC | (allow_sealing ? MFD_ALLOW_SEALING : 0));
+    fds[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    fds[2] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    CHECK(fds[0] >= 0 && fds[1] >= 0 && fds[2] >= 0);
+    CHECK(ftruncate(fds[0], (off_t)size) == 0);
+    if (seals) CHECK(fcntl(fds[0], F_ADD_SEALS, seals) == 0);
+    ShmLink l;
+    if (shm_link_open(&l, fds) == 0) {
+        shm_link_close(&l);
+        return 1;
+    }
+    for (int i = 0; i < SHM_FDS; i++) close(fds[i]);
+    return 0;
+}
+
+static void test_reject(void) {
+    CHECK(try_open(sizeof(ShmArea), 1, F_SEAL_SHRINK | F_SEAL_GROW));
+    CHECK(try_open(sizeof(ShmArea) * 2, 1, F_SEAL_SHRINK | F_SEAL_GROW));
+    CHECK(!try_open(sizeof(ShmArea), 0, 0));                 // 봉인할 수 없는 memfd
+    CHECK(!try_open(sizeof(ShmArea), 1, 0));                 // 봉인하지 않음
+    CHECK(!try_open(sizeof(ShmArea), 1, F_SEAL_GROW));       // 줄일 수 있다
+    CHECK(!try_open(sizeof(ShmArea) / 2, 1, F_SEAL_SHRINK | F_SEAL_GROW));
+    CHECK(!try_open(0, 1, F_SEAL_SHRINK | F_SEAL_GROW));
+}
+
+// eventfd 대신 파이프: 서버가 비어 있는 쪽을 비우려 해도 돌아와야 한다
+static void test_pipe_wake_fds(void) {
+    int p[2], fds[SHM_FDS];
+    ShmLink l;
+    CHECK(pipe(p) == 0);
+    fds[0] = memfd_create("shm_test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    CHECK(fds[0] >= 0 && ftruncate(fds[0], sizeof(ShmArea)) == 0);
+    CHECK(fcntl(fds[0], F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0);
+    fds[1] = p[0];
+    fds[2] = p[1];
+    CHECK(shm_link_open(&l, fds) == 0);
+    CHECK(fcntl(p[0], F_GETFL) & O_NONBLOCK);
+    CHECK(fcntl(p[1], F_GETFL) & O_NONBLOCK);
+    shm_drain(&l);
+    shm_link_close(&l);
+}
+
+int main(void) {
+    alarm(10);                         // 막히면 SIGALRM으로 실패한다
+    test_round_trip();
+    test_reject();
+    test_pipe_wake_fds();
+    return test_report("shm_test");
+}
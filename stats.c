@@ -0,0 +1,495 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // accept4
+#endif
+#include "../include/stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define STATS_SUB_HALF     (1u << (STATS_SUB_BITS - 1))
+#define STATS_REQ_MAX      2048
+#define STATS_IO_TIMEOUT_S 1
+#define STATS_RATE_TICK_NS 1000000000ull   // messages_per_sec 표본 간격 (응답 스레드가 찍는다)
+
+int stats_on;
+
+static StatsThread *threads;                // 기록한 적 있는 스레드들 (붙이기만 한다)
+static unsigned generation;                 // stats_close마다 올라간다
+static __thread StatsThread *self;
+static __thread unsigned self_generation;   // self를 받은 세대 (다르면 이미 풀린 것)
+
+static const char *const hist_names[STATS_HISTS] = {
+    "turn_latency", "validation", "serialization", "sendq_delay",
+};
+static const char *const hist_help[STATS_HISTS] = {
+    "your_turn sent to the player's next request",
+    "move legality check",
+    "outgoing message serialization",
+    "time from first enqueue on an empty output queue until it drains",
+};
+static const char *const counter_names[STATS_COUNTERS] = {
+    "games_active", "messages_total", "timeouts_total", "invalid_moves_total",
+};
+
+/* ---- 기록 (각 스레드가 자기 것에만 쓴다) ---- */
+
+static StatsThread *self_get(void) {
+    unsigned gen = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+    if (self && self_generation == gen) return self;
+    StatsThread *t = (StatsThread *)calloc(1, sizeof(StatsThread));
+    if (!t) return NULL;
+    t->next = __atomic_load_n(&threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&threads, &t->next, t, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    self = t;
+    self_generation = gen;
+    return t;
+}
+
+// 쓰는 스레드가 하나뿐이라 읽고 더해서 그대로 쓴다 (읽는 쪽이 찢어진 값을 보지 않게 atomic store)
+static inline void bump(uint64_t *p, uint64_t v) {
+    __atomic_store_n(p, __atomic_load_n(p, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED);
+}
+
+static inline unsigned hist_index(uint64_t v) {
+    if (v > STATS_HIST_MAX_NS) v = STATS_HIST_MAX_NS;
+    unsigned bucket = (unsigned)(64 - __builtin_clzll(v | ((1u << STATS_SUB_BITS) - 1))) - STATS_SUB_BITS;
+    unsigned sub = (unsigned)(v >> bucket);
+    return ((bucket + 1) << (STATS_SUB_BITS - 1)) + sub - STATS_SUB_HALF;
+}
+
+// 칸 i에 들어가는 가장 큰 값
+static uint64_t hist_value(unsigned i) {
+    if (i < 2 * STATS_SUB_HALF) return i;
+    unsigned bucket = (i >> (STATS_SUB_BITS - 1)) - 1;
+    uint64_t sub = (i & (STATS_SUB_HALF - 1)) + STATS_SUB_HALF;
+    return (sub << bucket) + ((1ull << bucket) - 1);
+}
+
+void stats_record_ns(int hist, uint64_t ns) {
+    StatsThread *t = self_get();
+    if (!t) return;
+    StatsHist *h = &t->hist[hist];
+    bump(&h->counts[hist_index(ns)], 1);
+    bump(&h->total, 1);
+    bump(&h->sum, ns);
+    if (ns > h->max) __atomic_store_n(&h->max, ns, __ATOMIC_RELAXED);
+}
+
+void stats_hist_add(StatsHist *h, uint64_t ns) {
+    h->counts[hist_index(ns)]++;
+    h->total++;
+    h->sum += ns;
+    if (ns > h->max) h->max = ns;
+}
+
+void stats_hist_merge(StatsHist *dst, const StatsHist *src) {
+    for (unsigned i = 0; i < STATS_HIST_COUNTS; i++) dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+void stats_count(int counter, int64_t delta) {
+    StatsThread *t = self_get();
+    if (t) bump((uint64_t *)&t->counter[counter], (uint64_t)delta);
+}
+
+/* ---- 합치기와 출력 ---- */
+
+typedef struct {
+    StatsHist hist[STATS_HISTS];
+    int64_t counter[STATS_COUNTERS];
+    int threads;
+} StatsSnapshot;
+
+static void snapshot(StatsSnapshot *s) {
+    memset(s, 0, sizeof *s);
+    for (StatsThread *t = __atomic_load_n(&threads, __ATOMIC_ACQUIRE); t; t = t->next) {
+        for (int h = 0; h < STATS_HISTS; h++) {
+            const StatsHist *src = &t->hist[h];
+            StatsHist *dst = &s->hist[h];
+            for (unsigned i = 0; i < STATS_HIST_COUNTS; i++) {
+                dst->counts[i] += __atomic_load_n(&src->counts[i], __ATOMIC_RELAXED);
+            }
+            dst->total += __atomic_load_n(&src->total, __ATOMIC_RELAXED);
+            dst->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+            uint64_t max = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+            if (max > dst->max) dst->max = max;
+        }
+        for (int c = 0; c < STATS_COUNTERS; c++) {
+            s->counter[c] += __atomic_load_n(&t->counter[c], __ATOMIC_RELAXED);
+        }
+        s->threads++;
+    }
+}
+
+void stats_collect(StatsHist hist[STATS_HISTS]) {
+    StatsSnapshot *s = (StatsSnapshot *)malloc(sizeof(StatsSnapshot));
+    if (!s) {
+        memset(hist, 0, STATS_HISTS * sizeof(StatsHist));
+        return;
+    }
+    snapshot(s);
+    memcpy(hist, s->hist, sizeof s->hist);
+    free(s);
+}
+
+uint64_t stats_hist_percentile(const StatsHist *h, double q) {
+    uint64_t total = 0;
+    for (unsigned i = 0; i < STATS_HIST_COUNTS; i++) total += h->counts[i];
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < STATS_HIST_COUNTS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t v = hist_value(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+typedef struct {
+    char *p;
+    size_t len, cap;
+} Out;
+
+static void out_printf(Out *o, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(o->p ? o->p + o->len : NULL, o->p ? o->cap - o->len : 0, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if (o->p && o->len + (size_t)n < o->cap) {
+            o->len += (size_t)n;
+            return;
+        }
+        size_t cap = o->cap ? o->cap * 2 : 4096;
+        while (cap <= o->len + (size_t)n) cap *= 2;
+        char *p = (char *)realloc(o->p, cap);
+        if (!p) return;
+        o->p = p;
+        o->cap = cap;
+    }
+}
+
+static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+static const char *const quantile_keys[] = { "p50", "p90", "p99", "p999" };
+#define QUANTILES (int)(sizeof quantiles / sizeof quantiles[0])
+
+static uint64_t start_ns;
+
+/* messages_per_sec: 응답 스레드가 틱마다 messages_total을 찍어 두고, 1초 이상 지난 표본 중
+   가장 최근 것부터 지금까지로 잰다 (지난 1~2초). 누가 얼마나 자주 묻든 같은 값이다 */
+typedef struct {
+    uint64_t ns;
+    int64_t messages;
+} RateSample;
+static RateSample rate_prev, rate_prev2;    // 최근 표본, 그 앞 표본 (응답 스레드만 쓴다)
+
+static int64_t counter_total(int counter) {
+    int64_t v = 0;
+    for (StatsThread *t = __atomic_load_n(&threads, __ATOMIC_ACQUIRE); t; t = t->next) {
+        v += __atomic_load_n(&t->counter[counter], __ATOMIC_RELAXED);
+    }
+    return v;
+}
+
+static void rate_tick(uint64_t now) {
+    if (now - rate_prev.ns < STATS_RATE_TICK_NS) return;
+    rate_prev2 = rate_prev;
+    rate_prev.ns = now;
+    rate_prev.messages = counter_total(STATS_MESSAGES);
+}
+
+static void format_json(Out *o, const StatsSnapshot *s) {
+    uint64_t now = stats_clock_ns();
+    rate_tick(now);
+    const RateSample *base = now - rate_prev.ns >= STATS_RATE_TICK_NS ? &rate_prev : &rate_prev2;
+    int64_t messages = s->counter[STATS_MESSAGES];
+    double window = (double)(now - base->ns) / 1e9;
+    double uptime = (double)(now - start_ns) / 1e9;
+
+    out_printf(o, "{\"uptime_sec\":%.3f,\"threads\":%d", uptime, s->threads);
+    for (int c = 0; c < STATS_COUNTERS; c++) {
+        out_printf(o, ",\"%s\":%lld", counter_names[c], (long long)s->counter[c]);
+    }
+    out_printf(o, ",\"messages_per_sec\":%.1f,\"messages_per_sec_lifetime\":%.1f",
+               window > 0 ? (double)(messages - base->messages) / window : 0.0,
+               uptime > 0 ? (double)messages / uptime : 0.0);
+    for (int h = 0; h < STATS_HISTS; h++) {
+        const StatsHist *hist = &s->hist[h];
+        out_printf(o, ",\"%s_us\":{\"count\":%llu,\"mean\":%.3f", hist_names[h], (unsigned long long)hist->total,
+                   hist->total ? (double)hist->sum / (double)hist->total / 1e3 : 0.0);
+        for (int q = 0; q < QUANTILES; q++) {
+            out_printf(o, ",\"%s\":%.3f", quantile_keys[q], (double)stats_hist_percentile(hist, quantiles[q]) / 1e3);
+        }
+        out_printf(o, ",\"max\":%.3f}", (double)hist->max / 1e3);
+    }
+    out_printf(o, "}\n");
+}
+
+static void format_prometheus(Out *o, const StatsSnapshot *s) {
+    for (int h = 0; h < STATS_HISTS; h++) {
+        const StatsHist *hist = &s->hist[h];
+        out_printf(o, "# HELP hw3_%s_seconds %s\n# TYPE hw3_%s_seconds summary\n",
+                   hist_names[h], hist_help[h], hist_names[h]);
+        for (int q = 0; q < QUANTILES; q++) {
+            out_printf(o, "hw3_%s_seconds{quantile=\"%g\"} %.9f\n", hist_names[h], quantiles[q],
+                       (double)stats_hist_percentile(hist, quantiles[q]) / 1e9);
+        }
+        out_printf(o, "hw3_%s_seconds_sum %.9f\nhw3_%s_seconds_count %llu\n", hist_names[h],
+                   (double)hist->sum / 1e9, hist_names[h], (unsigned long long)hist->total);
+    }
+    for (int c = 0; c < STATS_COUNTERS; c++) {
+        out_printf(o, "# TYPE hw3_%s %s\nhw3_%s %lld\n", counter_names[c],
+                   c == STATS_GAMES_ACTIVE ? "gauge" : "counter", counter_names[c], (long long)s->counter[c]);
+    }
+}
+
+/* ---- 응답 스레드 ---- */
+
+static int listen_fd = -1;
+static int stopping;
+static char *unix_path;
+static pthread_t serve_thread;
+
+static int is_port(const char *addr) {
+    if (!*addr) return 0;
+    for (const char *p = addr; *p; p++) {
+        if (!isdigit((unsigned char)*p)) return 0;
+    }
+    return 1;
+}
+
+static int stats_connect_or_listen(const char *addr, int listening) {
+    int fd;
+    if (is_port(addr)) {
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof sin);
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons((uint16_t)atoi(addr));
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // 밖으로는 열지 않는다
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        if (listening ? bind(fd, (struct sockaddr *)&sin, sizeof sin) < 0 || listen(fd, 16) < 0
+                      : connect(fd, (struct sockaddr *)&sin, sizeof sin) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    struct sockaddr_un sun;
+    if (strlen(addr) >= sizeof sun.sun_path) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset(&sun, 0, sizeof sun);
+    sun.sun_family = AF_UNIX;
+    strcpy(sun.sun_path, addr);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (listening) unlink(addr);   // 이전 실행이 남긴 소켓 파일
+    if (listening ? bind(fd, (struct sockaddr *)&sun, sizeof sun) < 0 || listen(fd, 16) < 0
+                  : connect(fd, (struct sockaddr *)&sun, sizeof sun) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int write_all(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 요청 하나: 줄 하나(unix 소켓 방식)나 HTTP 헤더 끝까지 읽고, 답하고 닫는다
+static void serve_one(int fd) {
+    struct timeval tv;
+    tv.tv_sec = STATS_IO_TIMEOUT_S;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+    char req[STATS_REQ_MAX];
+    size_t len = 0;
+    for (;;) {
+        ssize_t n = read(fd, req + len, sizeof req - 1 - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        len += (size_t)n;
+        req[len] = '\0';
+        int http = strncmp(req, "GET ", 4) == 0;
+        int done = http ? strstr(req, "\r\n\r\n") || strstr(req, "\n\n") : strchr(req, '\n') != NULL;
+        if (done || len == sizeof req - 1) break;
+    }
+    req[len] = '\0';
+
+    int http = strncmp(req, "GET ", 4) == 0;
+    int prom = 0, found = 1;
+    if (http) {
+        const char *path = req + 4;
+        size_t plen = strcspn(path, " ?\r\n");
+        if (plen == 8 && strncmp(path, "/metrics", 8) == 0) prom = 1;
+        else if (!((plen == 1 && path[0] == '/') || (plen == 6 && strncmp(path, "/stats", 6) == 0))) found = 0;
+    } else {
+        prom = strncmp(req, "prometheus", 10) == 0 || strncmp(req, "metrics", 7) == 0;
+    }
+
+    Out body;
+    memset(&body, 0, sizeof body);
+    if (found) {
+        StatsSnapshot *s = (StatsSnapshot *)malloc(sizeof(StatsSnapshot));
+        if (s) {
+            snapshot(s);
+            if (prom) format_prometheus(&body, s);
+            else format_json(&body, s);
+            free(s);
+        }
+    }
+    if (http) {
+        char head[256];
+        int n = snprintf(head, sizeof head,
+                         "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                         found ? "200 OK" : "404 Not Found",
+                         prom ? "text/plain; version=0.0.4" : "application/json", body.len);
+        if (write_all(fd, head, (size_t)n) < 0) body.len = 0;
+    }
+    if (body.p) write_all(fd, body.p, body.len);
+    free(body.p);
+    shutdown(fd, SHUT_WR);
+    close(fd);
+}
+
+static void *serve_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        // 요청이 없어도 틱마다 깨어 messages_per_sec 표본을 찍는다
+        struct pollfd pfd;
+        pfd.fd = listen_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, (int)(STATS_RATE_TICK_NS / 1000000));
+        if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) break;
+        rate_tick(stats_clock_ns());
+        if (ready <= 0) {
+            if (ready < 0 && errno != EINTR) {
+                perror("stats poll");
+                break;
+            }
+            continue;
+        }
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("stats accept");
+            break;
+        }
+        serve_one(fd);
+    }
+    return NULL;
+}
+
+int stats_serve(const char *addr) {
+    listen_fd = stats_connect_or_listen(addr, 1);
+    if (listen_fd < 0) {
+        perror(addr);
+        return -1;
+    }
+    if (!is_port(addr)) unix_path = strdup(addr);
+    start_ns = stats_clock_ns();
+    rate_prev.ns = start_ns;
+    rate_prev.messages = counter_total(STATS_MESSAGES);
+    rate_prev2 = rate_prev;
+    stats_on = 1;
+    if (pthread_create(&serve_thread, NULL, serve_main, NULL) != 0) {
+        perror("pthread_create");
+        stats_on = 0;
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void stats_close(void) {
+    if (listen_fd >= 0) {
+        __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+        shutdown(listen_fd, SHUT_RDWR);   // poll을 깨운다
+        pthread_join(serve_thread, NULL);
+        close(listen_fd);
+        listen_fd = -1;
+        if (unix_path) unlink(unix_path);
+        free(unix_path);
+        unix_path = NULL;
+    }
+    stats_on = 0;
+    StatsThread *t = __atomic_exchange_n(&threads, (StatsThread *)NULL, __ATOMIC_ACQ_REL);
+    while (t) {
+        StatsThread *next = t->next;
+        free(t);
+        t = next;
+    }
+    // 다른 스레드의 self도 풀렸다: 다음에 기록할 때 새로 받게 한다
+    __atomic_add_fetch(&generation, 1, __ATOMIC_RELEASE);
+    self = NULL;
+}
+
+int stats_query(const char *addr, const char *format) {
+    int fd = stats_connect_or_listen(addr, 0);
+    if (fd < 0) {
+        perror(addr);
+        return -1;
+    }
+    int prom = strcmp(format, "prometheus") == 0;
+    char req[64];
+    int n = is_port(addr) ? snprintf(req, sizeof req, "GET %s HTTP/1.0\r\n\r\n", prom ? "/metrics" : "/stats")
+                          : snprintf(req, sizeof req, "%s\n", prom ? "prometheus" : "json");
+    if (write_all(fd, req, (size_t)n) < 0) {
+        perror(addr);
+        close(fd);
+        return -1;
+    }
+    // HTTP면 헤더는 건너뛴다
+    int body = !is_port(addr), nl = 0;
+    char buf[4096];
+    ssize_t r;
+    while ((r = read(fd, buf, sizeof buf)) > 0) {
+        ssize_t i = 0;
+        for (; !body && i < r; i++) {
+            if (buf[i] == '\n') {
+                if (++nl == 2) body = 1;
+            } else if (buf[i] != '\r') {
+                nl = 0;
+            }
+        }
+        fwrite(buf + i, 1, (size_t)(r - i), stdout);
+    }
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * 서버 계측: 지연 시간 HDR 히스토그램과 카운터 (-S <path|port>).
+ *
+ * 기록하는 스레드마다 자기 StatsThread를 갖고 (처음 기록할 때 전역 목록에 CAS로 붙인다),
+ * 쓰는 쪽은 그 스레드 하나뿐이라 락도 원자적 RMW도 없이 relaxed store로 더한다.
+ * 읽는 쪽(stats 스레드)은 요청이 올 때마다 모든 스레드의 값을 relaxed load로 더해서
+ * JSON이나 Prometheus 텍스트로 내보낸다. 조금 어긋난 스냅샷일 수 있지만 잃는 값은 없다.
+ *
+ * 히스토그램은 HdrHistogram과 같은 log-linear 구간: 2의 거듭제곱 구간마다 64칸이라
+ * 값의 상대 오차가 1/64 이하다. 단위는 ns, STATS_HIST_MAX_NS보다 큰 값은 마지막 칸에 넣는다.
+ *
+ * -S가 없으면 stats_on이 0이라 기록 함수는 시계도 읽지 않고 돌아온다.
+ */
+#define STATS_SUB_BITS       7                      // 구간당 2^(7-1) = 64칸
+#define STATS_HIST_MAX_BITS  36                     // 2^36 ns (약 68초)
+#define STATS_HIST_COUNTS    ((STATS_HIST_MAX_BITS - STATS_SUB_BITS + 2) << (STATS_SUB_BITS - 1))
+#define STATS_HIST_MAX_NS    ((1ull << STATS_HIST_MAX_BITS) - 1)
+
+// 히스토그램
+enum {
+    STATS_TURN_LATENCY,        // your_turn을 보낸 뒤 그 플레이어의 요청이 처리되기 시작할 때까지
+    STATS_VALIDATION,          // 수(또는 pass)가 규칙에 맞는지 검사
+    STATS_SERIALIZATION,       // 보낼 메시지를 버퍼로 직렬화 (JSON 문자열, 바이너리 프레임)
+    STATS_SENDQ_DELAY,         // 빈 출력 큐에 처음 넣은 뒤 큐를 다 보낼 때까지
+    STATS_HISTS
+};
+
+// 카운터 (스레드별 합이라 게이지도 된다)
+enum {
+    STATS_GAMES_ACTIVE,        // 진행 중인 게임 (시작 +1, 끝 -1)
+    STATS_MESSAGES,            // 받은 요청 (JSON 줄, 바이너리 프레임)
+    STATS_TIMEOUTS,            // 턴 시간 초과 (자동 pass)
+    STATS_INVALID_MOVES,
+    STATS_COUNTERS
+};
+
+typedef struct {
+    uint64_t counts[STATS_HIST_COUNTS];
+    uint64_t total;
+    uint64_t sum;              // ns
+    uint64_t max;
+} StatsHist;
+
+typedef struct StatsThread {
+    StatsHist hist[STATS_HISTS];
+    int64_t counter[STATS_COUNTERS];
+    struct StatsThread *next;
+} StatsThread;
+
+extern int stats_on;
+
+void stats_record_ns(int hist, uint64_t ns);
+void stats_count(int counter, int64_t delta);
+
+static inline uint64_t stats_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+// 잴 구간의 시작. 꺼져 있으면 0 (stats_since가 무시한다)
+static inline uint64_t stats_start(void) {
+    return stats_on ? stats_clock_ns() : 0;
+}
+static inline void stats_since(int hist, uint64_t start) {
+    if (start) stats_record_ns(hist, stats_clock_ns() - start);
+}
+static inline void stats_add(int counter, int64_t delta) {
+    if (stats_on) stats_count(counter, delta);
+}
+
+// 스레드 하나가 따로 들고 쓰는 히스토그램 (hw3 loadgen처럼 서버 밖에서 같은 구간으로 잴 때)
+void stats_hist_add(StatsHist *h, uint64_t ns);
+void stats_hist_merge(StatsHist *dst, const StatsHist *src);
+// q 분위 값 (ns). 칸 단위라 그 칸의 가장 큰 값을 돌려준다 (max를 넘지는 않는다)
+uint64_t stats_hist_percentile(const StatsHist *h, double q);
+// 지금까지 모든 스레드가 기록한 히스토그램의 합 (서버를 같은 프로세스에서 띄우고 stats_on을 켠 hw3 bench)
+void stats_collect(StatsHist hist[STATS_HISTS]);
+
+// addr: 숫자만이면 127.0.0.1의 그 포트에서 HTTP (GET /metrics는 Prometheus, 나머지는 JSON),
+// 아니면 unix 소켓 경로 (한 줄 "json" 또는 "prometheus"를 보내면 답하고 닫는다. HTTP도 받는다).
+// 기록을 켜고 응답 스레드를 띄운다. 실패하면 -1
+int stats_serve(const char *addr);
+// 응답 스레드를 멈추고 스레드별 기록을 해제한다 (그동안 기록하는 스레드가 없을 때).
+// 남아 있는 스레드는 다음에 기록할 때 새로 받는다
+void stats_close(void);
+// hw3 stats: addr에 물어서 받은 것을 그대로 출력. format은 "json" 또는 "prometheus"
+int stats_query(const char *addr, const char *format);
+
+#endif
@@ -0,0 +1,139 @@
+#include "../include/stats.h"
+#include "../include/test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * stats.c 히스토그램: 분위 값이 정렬한 원래 값과 비교해 칸 너비(상대 1/64) 안에 들고
+ * 절대 작게 나오지 않는지, 128 미만은 정확한지, STATS_HIST_MAX_NS를 넘는 값과 빈 히스토그램,
+ * 나눠 모은 히스토그램을 합친 것이 한 번에 모은 것과 같은지 본다.
+ * stats_close 뒤에도 살아 있는 스레드가 다시 기록하면 풀린 것이 아니라 새 기록에 들어가는지도 본다.
+ */
+#define SAMPLES 100000
+
+static const double quantiles[] = { 0.0, 0.001, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0 };
+
+static StatsHist all, part[2];
+static uint64_t values[SAMPLES];
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// 2^0 ~ 2^36 사이에서 지수가 고르게
+static uint64_t random_ns(void) {
+    int bits = rand() % STATS_HIST_MAX_BITS;
+    uint64_t v = (uint64_t)rand() << 31 ^ (uint64_t)rand();
+    return v & ((2ull << bits) - 1);
+}
+
+// stats_hist_percentile과 같은 순위 (q * n을 반올림, 최소 1)
+static uint64_t exact_percentile(const uint64_t *sorted, size_t n, double q) {
+    uint64_t rank = (uint64_t)(q * (double)n + 0.5);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+static void test_relative_error(void) {
+    for (size_t i = 0; i < SAMPLES; i++) {
+        values[i] = random_ns();
+        stats_hist_add(&all, values[i]);
+        stats_hist_add(&part[i & 1], values[i]);
+    }
+    qsort(values, SAMPLES, sizeof values[0], cmp_u64);
+    CHECK(all.total == SAMPLES);
+    CHECK(all.max == values[SAMPLES - 1]);
+    for (size_t q = 0; q < sizeof quantiles / sizeof quantiles[0]; q++) {
+        uint64_t want = exact_percentile(values, SAMPLES, quantiles[q]);
+        uint64_t got = stats_hist_percentile(&all, quantiles[q]);
+        CHECK(got >= want);
+        CHECK(got - want <= want >> (STATS_SUB_BITS - 1));
+    }
+    CHECK(stats_hist_percentile(&all, 1.0) == all.max);
+}
+
+static void test_merge(void) {
+    StatsHist merged;
+    memset(&merged, 0, sizeof merged);
+    stats_hist_merge(&merged, &part[0]);
+    stats_hist_merge(&merged, &part[1]);
+    CHECK(memcmp(merged.counts, all.counts, sizeof all.counts) == 0);
+    CHECK(merged.total == all.total && merged.sum == all.sum && merged.max == all.max);
+}
+
+static void test_single_values(void) {
+    // 값 하나만 있으면 어느 분위든 그 값 (칸의 가장 큰 값이 max로 잘린다)
+    for (int bits = 0; bits <= STATS_HIST_MAX_BITS; bits++) {
+        uint64_t base = 1ull << bits;
+        uint64_t probes[3] = { base - 1, base, base + 1 };
+        for (int k = 0; k < 3; k++) {
+            StatsHist h;
+            memset(&h, 0, sizeof h);
+            stats_hist_add(&h, probes[k]);
+            uint64_t want = probes[k] > STATS_HIST_MAX_NS ? STATS_HIST_MAX_NS : probes[k];
+            CHECK(stats_hist_percentile(&h, 0.5) == want);
+        }
+    }
+
+    // 128 미만은 칸마다 값 하나라 정확하다
+    StatsHist h;
+    memset(&h, 0, sizeof h);
+    for (uint64_t v = 1; v <= 100; v++) stats_hist_add(&h, v);
+    CHECK(stats_hist_percentile(&h, 0.5) == 50);
+    CHECK(stats_hist_percentile(&h, 0.99) == 99);
+    CHECK(stats_hist_percentile(&h, 0.0) == 1);
+    CHECK(h.sum == 5050);
+
+    // STATS_HIST_MAX_NS를 넘는 값은 마지막 칸에 들어간다 (sum과 max는 원래 값)
+    memset(&h, 0, sizeof h);
+    stats_hist_add(&h, 1ull << 40);
+    stats_hist_add(&h, 1000);
+    CHECK(h.max == 1ull << 40);
+    CHECK(stats_hist_percentile(&h, 1.0) == STATS_HIST_MAX_NS);
+    CHECK(stats_hist_percentile(&h, 0.5) >= 1000 && stats_hist_percentile(&h, 0.5) <= 1000 + 1000 / 64);
+
+    memset(&h, 0, sizeof h);
+    CHECK(stats_hist_percentile(&h, 0.5) == 0);
+}
+
+static pthread_barrier_t barrier;
+
+// stats_close 앞뒤로 한 번씩 기록하는 스레드
+static void *recorder_main(void *arg) {
+    (void)arg;
+    stats_record_ns(STATS_TURN_LATENCY, 1000);
+    pthread_barrier_wait(&barrier);    // 여기서 main이 stats_close
+    pthread_barrier_wait(&barrier);
+    stats_record_ns(STATS_TURN_LATENCY, 2000);
+    return NULL;
+}
+
+static void test_close_reuse(void) {
+    pthread_t t;
+    StatsHist hist[STATS_HISTS];
+    pthread_barrier_init(&barrier, NULL, 2);
+    CHECK(pthread_create(&t, NULL, recorder_main, NULL) == 0);
+    pthread_barrier_wait(&barrier);
+    stats_collect(hist);
+    CHECK(hist[STATS_TURN_LATENCY].total == 1);
+    stats_close();
+    pthread_barrier_wait(&barrier);
+    pthread_join(t, NULL);
+    pthread_barrier_destroy(&barrier);
+
+    stats_collect(hist);
+    CHECK(hist[STATS_TURN_LATENCY].total == 1 && hist[STATS_TURN_LATENCY].max == 2000);
+    stats_close();
+}
+
+int main(void) {
+    srand(1);
+    test_relative_error();
+    test_merge();
+    test_single_values();
+    test_close_reuse();
+    return test_report("stats_test");
+}
@@ -0,0 +1,28 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+/*
+ * *_test.c 공용: 조건이 틀리면 위치를 찍고 실패 수를 센다. main은 test_report()를 돌려준다.
+ * 빌드와 실행 명령은 command 파일의 //tests 아래.
+ */
+static int test_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+static inline int test_report(const char *name) {
+    if (test_failures) {
+        fprintf(stderr, "%s: %d failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: OK\n", name);
+    return 0;
+}
+
+#endif
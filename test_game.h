@@ -0,0 +1,87 @@
+#ifndef TEST_GAME_H
+#define TEST_GAME_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "session.h"
+
+/*
+ * *_test.c 공용 게임: 장애물을 무작위로 깐 세션을 이름과 함께 시작하고, 둘 수 있는 수 중 하나를
+ * 무작위로 둔 뒤 (없으면 pass) 서버처럼 pass_count, seq, 차례를 넘긴다.
+ */
+#define TEST_NAME_MAX   32
+#define TEST_MAX_MOVES  (64 * 24)     // 칸마다 복제 8 + 점프 16
+#define TEST_MOVE_PASS  0xFFFFu       // 수는 (출발 칸 << 6 | 도착 칸), pass는 wire.h와 같은 값
+
+typedef struct {
+    GameSession g;
+    uint64_t red, blue, blocked;      // 시작 보드
+    char name[2][TEST_NAME_MAX];
+} TestGame;
+
+// 빈 칸의 1/8 정도에 장애물
+static inline void test_random_obstacles(GameSession *g) {
+    for (int i = 0; i < 64; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        if (!((g->red | g->blue) & bit) && rand() % 8 == 0) g->blocked |= bit;
+    }
+}
+
+// 이름은 red<id>, blue<id>
+static inline void test_game_start(TestGame *t, uint32_t id) {
+    session_init(&t->g);
+    t->g.id = id;
+    test_random_obstacles(&t->g);
+    t->red = t->g.red;
+    t->blue = t->g.blue;
+    t->blocked = t->g.blocked;
+    snprintf(t->name[0], sizeof t->name[0], "red%u", id);
+    snprintf(t->name[1], sizeof t->name[1], "blue%u", id);
+}
+
+// color가 둘 수 있는 (출발, 도착) 쌍을 모두 채우고 개수를 돌려준다 (복제 1칸, 점프 가로/세로/대각 2칸)
+static inline int test_legal_moves(const GameSession *g, int color, uint16_t *out) {
+    int n = 0;
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            int dr = abs(from / 8 - to / 8), dc = abs(from % 8 - to % 8);
+            if (dr > 2 || dc > 2 || dr + dc == 3) continue;
+            if (session_is_valid_move(g, color, from / 8, from % 8, to / 8, to % 8)) out[n++] = (uint16_t)(from << 6 | to);
+        }
+    }
+    return n;
+}
+
+// 차례인 쪽이 무작위로 한 수 둔다. 둔 수를, 둘 곳이 없어 pass했으면 TEST_MOVE_PASS를 돌려준다
+// flipped가 NULL이 아니면 뒤집힌 칸 (pass면 0)
+static inline uint16_t test_random_step(GameSession *g, uint64_t *flipped) {
+    uint16_t moves[TEST_MAX_MOVES];
+    int n = test_legal_moves(g, g->turn, moves);
+    uint16_t mv = TEST_MOVE_PASS;
+    if (flipped) *flipped = 0;
+    if (n) {
+        mv = moves[rand() % n];
+        int from = mv >> 6, to = mv & 63;
+        session_move(g, from / 8, from % 8, to / 8, to % 8, flipped);
+        g->pass_count = 0;
+    } else {
+        g->pass_count++;
+    }
+    g->seq++;
+    g->turn ^= 1;
+    return mv;
+}
+
+// 둘 다 둘 곳이 없거나 연속 pass 두 번
+static inline int test_game_over(const GameSession *g) {
+    return session_is_over(g) || g->pass_count >= 2;
+}
+
+static inline int test_same_board(const GameSession *g, char board[BOARD_SIZE][BOARD_SIZE]) {
+    char tmp[BOARD_SIZE][BOARD_SIZE];
+    session_to_board(g, tmp);
+    return memcmp(tmp, board, sizeof tmp) == 0;
+}
+
+#endif
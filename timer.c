@@ -0,0 +1,247 @@
+#include "../include/timer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#define TW_RUNNING 0xff   // 만료되어 실행 대기 리스트로 옮겨진 상태
+
+uint64_t timer_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static inline void list_init(Timer *head) {
+    head->next = head->prev = head;
+}
+
+static inline void list_add(Timer *head, Timer *t) {
+    t->prev = head->prev;
+    t->next = head;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+static inline void list_unlink(Timer *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+}
+
+static inline void bitmap_set(TimerWheel *tw, int level, int slot) {
+    tw->bitmap[level][slot >> 6] |= (uint64_t)1 << (slot & 63);
+}
+
+static inline void bitmap_clear(TimerWheel *tw, int level, int slot) {
+    tw->bitmap[level][slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+}
+
+// slot 이후(포함)로 처음 비어 있지 않은 슬롯까지의 거리, 없으면 -1
+static int bitmap_next(const TimerWheel *tw, int level, int slot) {
+    for (int i = 0; i < TW_SLOTS; ) {
+        int s = (slot + i) & TW_MASK;
+        uint64_t word = tw->bitmap[level][s >> 6] >> (s & 63);
+        if (word) return i + __builtin_ctzll(word);
+        i += 64 - (s & 63);
+    }
+    return -1;
+}
+
+static void wheel_insert(TimerWheel *tw, Timer *t) {
+    uint64_t delta = t->expires > tw->now ? t->expires - tw->now : 0;
+    int level = 0;
+    // 남은 시간이 속한 단계를 고른다: level L은 256^L tick 단위
+    while (level < TW_LEVELS - 1 && delta >= ((uint64_t)1 << (TW_BITS * (level + 1)))) {
+        level++;
+    }
+    uint64_t when = t->expires > tw->now ? t->expires : tw->now;
+    int slot = (int)((when >> (TW_BITS * level)) & TW_MASK);
+    t->level = (uint8_t)level;
+    t->slot = (uint8_t)slot;
+    list_add(&tw->slots[level][slot], t);
+    bitmap_set(tw, level, slot);
+}
+
+static void wheel_remove(TimerWheel *tw, Timer *t) {
+    int level = t->level, slot = t->slot;
+    list_unlink(t);
+    if (level == TW_RUNNING) return;
+    Timer *head = &tw->slots[level][slot];
+    if (head->next == head) bitmap_clear(tw, level, slot);
+}
+
+static void rearm_timerfd(TimerWheel *tw) {
+    uint64_t next = 0;
+    if (tw->count > 0) {
+        // 가장 가까운 비어 있지 않은 슬롯, 혹은 상위 단계가 내려오는 경계
+        int d = bitmap_next(tw, 0, (int)((tw->now + 1) & TW_MASK));
+        if (d >= 0) {
+            next = tw->now + 1 + (uint64_t)d;
+        }
+        for (int level = 1; level < TW_LEVELS; level++) {
+            uint64_t unit = (uint64_t)1 << (TW_BITS * level);
+            int from = (int)(((tw->now >> (TW_BITS * level)) + 1) & TW_MASK);
+            int dl = bitmap_next(tw, level, from);
+            if (dl < 0) continue;
+            uint64_t boundary = ((tw->now / unit) + 1 + (uint64_t)dl) * unit;
+            if (next == 0 || boundary < next) next = boundary;
+        }
+    }
+    if (next == tw->armed) return;
+    tw->armed = next;
+
+    struct itimerspec its;
+    memset(&its, 0, sizeof its);
+    if (next != 0) {
+        uint64_t abs_ms = tw->base_ms + next;
+        its.it_value.tv_sec = (time_t)(abs_ms / 1000);
+        its.it_value.tv_nsec = (long)(abs_ms % 1000) * 1000000L;
+    }
+    timerfd_settime(tw->tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void cascade(TimerWheel *tw, int level) {
+    int slot = (int)((tw->now >> (TW_BITS * level)) & TW_MASK);
+    Timer *head = &tw->slots[level][slot];
+    Timer pending;
+    if (head->next == head) return;
+    // 슬롯 전체를 떼어낸 뒤 남은 시간에 맞춰 아래 단계로 다시 넣는다
+    list_init(&pending);
+    pending.next = head->next;
+    pending.prev = head->prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    list_init(head);
+    bitmap_clear(tw, level, slot);
+    while (pending.next != &pending) {
+        Timer *t = pending.next;
+        list_unlink(t);
+        wheel_insert(tw, t);
+    }
+}
+
+static void run_slot(TimerWheel *tw) {
+    int slot = (int)(tw->now & TW_MASK);
+    Timer *head = &tw->slots[0][slot];
+    Timer expired;
+    if (head->next == head) return;
+    list_init(&expired);
+    expired.next = head->next;
+    expired.prev = head->prev;
+    expired.next->prev = &expired;
+    expired.prev->next = &expired;
+    list_init(head);
+    bitmap_clear(tw, 0, slot);
+    for (Timer *t = expired.next; t != &expired; t = t->next) t->level = TW_RUNNING;
+
+    // 콜백 안에서 다른 타이머를 걸거나 취소해도 안전하도록 하나씩 꺼내서 실행
+    while (expired.next != &expired) {
+        Timer *t = expired.next;
+        list_unlink(t);
+        t->wheel = NULL;
+        tw->count--;
+        t->cb(t, t->arg);
+    }
+}
+
+void timer_wheel_advance(TimerWheel *tw) {
+    uint64_t target = timer_now_ms() - tw->base_ms;
+    while (tw->now < target) {
+        if (tw->count == 0) {
+            tw->now = target;
+            break;
+        }
+        uint64_t next = tw->now + 1;
+        // level 0이 통째로 비어 있으면 다음 256 경계까지 건너뛴다
+        int empty0 = 1;
+        for (int w = 0; w < TW_SLOTS / 64; w++) {
+            if (tw->bitmap[0][w]) { empty0 = 0; break; }
+        }
+        if (empty0) {
+            uint64_t boundary = (tw->now | TW_MASK) + 1;
+            next = boundary < target ? boundary : target;
+        }
+        tw->now = next;
+        // 하위 단계가 한 바퀴 돌 때마다 상위 단계 슬롯을 내려보낸다
+        for (int level = 1; level < TW_LEVELS; level++) {
+            if ((tw->now & (((uint64_t)1 << (TW_BITS * level)) - 1)) != 0) break;
+            cascade(tw, level);
+        }
+        run_slot(tw);
+    }
+    rearm_timerfd(tw);
+}
+
+static void timer_wheel_on_event(NetHandler *h, uint32_t events) {
+    TimerWheel *tw = (TimerWheel *)h;
+    uint64_t expirations;
+    (void)events;
+    while (read(tw->tfd, &expirations, sizeof expirations) > 0) {
+    }
+    tw->armed = 0;
+    timer_wheel_advance(tw);
+}
+
+int timer_wheel_init(TimerWheel *tw, Reactor *r) {
+    memset(tw, 0, sizeof *tw);
+    for (int level = 0; level < TW_LEVELS; level++) {
+        for (int slot = 0; slot < TW_SLOTS; slot++) {
+            list_init(&tw->slots[level][slot]);
+        }
+    }
+    tw->handler.on_event = timer_wheel_on_event;
+    tw->reactor = r;
+    tw->base_ms = timer_now_ms();
+    tw->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tw->tfd < 0) {
+        perror("timerfd_create");
+        return -1;
+    }
+    if (reactor_add(r, tw->tfd, EPOLLIN, &tw->handler) < 0) {
+        perror("epoll_ctl");
+        close(tw->tfd);
+        tw->tfd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void timer_wheel_close(TimerWheel *tw) {
+    if (tw->tfd >= 0) {
+        reactor_del(tw->reactor, tw->tfd);
+        close(tw->tfd);
+    }
+    tw->tfd = -1;
+}
+
+void timer_init(Timer *t, void (*cb)(Timer *t, void *arg), void *arg) {
+    memset(t, 0, sizeof *t);
+    t->cb = cb;
+    t->arg = arg;
+}
+
+void timer_arm(TimerWheel *tw, Timer *t, uint32_t delay_ms) {
+    if (t->wheel) timer_cancel(t);
+    // 휠이 한동안 멈춰 있었으면 기준 tick을 현재로 당겨온다
+    uint64_t cur = timer_now_ms() - tw->base_ms;
+    if (tw->count == 0 && cur > tw->now) tw->now = cur;
+    t->expires = cur + (delay_ms ? delay_ms : 1);
+    t->wheel = tw;
+    tw->count++;
+    wheel_insert(tw, t);
+    if (tw->armed == 0 || t->expires < tw->armed) {
+        rearm_timerfd(tw);
+    }
+}
+
+void timer_cancel(Timer *t) {
+    TimerWheel *tw = t->wheel;
+    if (!tw) return;
+    wheel_remove(tw, t);
+    t->wheel = NULL;
+    tw->count--;
+}
@@ -0,0 +1,51 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include "net.h"
+
+// 4단계 x 256칸 계층형 타이머 휠 (1 tick = 1ms, 약 49일까지 표현)
+#define TW_LEVELS 4
+#define TW_BITS   8
+#define TW_SLOTS  (1 << TW_BITS)
+#define TW_MASK   (TW_SLOTS - 1)
+
+struct TimerWheel;
+
+typedef struct Timer {
+    struct Timer *next, *prev;   // 슬롯 안의 이중 연결 리스트 → O(1) 취소
+    uint64_t expires;            // 만료 tick (휠 기준 ms)
+    void (*cb)(struct Timer *t, void *arg);
+    void *arg;
+    struct TimerWheel *wheel;    // 걸려 있는 휠 (없으면 NULL)
+    uint8_t level, slot;
+} Timer;
+
+typedef struct TimerWheel {
+    NetHandler handler;          // timerfd 이벤트를 reactor에서 받는다
+    int tfd;
+    Reactor *reactor;
+    uint64_t base_ms;            // tick 0에 해당하는 CLOCK_MONOTONIC 시각
+    uint64_t now;                // 마지막으로 처리한 tick
+    uint64_t armed;              // timerfd에 걸린 tick (0이면 없음)
+    unsigned count;              // 걸려 있는 타이머 수
+    uint64_t bitmap[TW_LEVELS][TW_SLOTS / 64];   // 비어 있지 않은 슬롯 표시
+    Timer slots[TW_LEVELS][TW_SLOTS];            // 각 슬롯의 sentinel
+} TimerWheel;
+
+uint64_t timer_now_ms(void);
+
+// timerfd를 만들고 reactor에 등록한다 (reactor 스레드당 하나)
+int timer_wheel_init(TimerWheel *tw, Reactor *r);
+void timer_wheel_close(TimerWheel *tw);
+
+void timer_init(Timer *t, void (*cb)(Timer *t, void *arg), void *arg);
+// delay_ms 뒤에 cb를 호출한다. 이미 걸려 있으면 다시 건다
+void timer_arm(TimerWheel *tw, Timer *t, uint32_t delay_ms);
+void timer_cancel(Timer *t);
+static inline int timer_pending(const Timer *t) { return t->wheel != NULL; }
+
+// 현재 시각까지 만료된 타이머를 실행하고 timerfd를 다음 만료에 맞춘다
+void timer_wheel_advance(TimerWheel *tw);
+
+#endif
@@ -0,0 +1,120 @@
+#include "../include/timer.h"
+#include "../include/test.h"
+
+#include <stdlib.h>
+
+/*
+ * timer.c: 네 단계에 고루 걸친 타이머가 위 단계에서 내려오며 정확히 만료 tick에 한 번씩 터지는지,
+ * 취소한 타이머는 터지지 않는지, 콜백 안에서 다른 타이머를 취소하거나 자기를 다시 걸어도 되는지 본다.
+ * 시간은 휠의 base_ms를 당겨서 흐르게 한다 (timerfd 이벤트는 기다리지 않는다).
+ */
+#define TIMERS 3000
+
+typedef struct {
+    Timer t;
+    uint64_t expires;   // 마지막으로 건 만료 tick
+    int armed;          // 건 횟수 - 취소한 횟수 = 터져야 하는 횟수
+    int fired;
+    int rearm;          // 터지면 한 번 더 건다
+} Probe;
+
+static TimerWheel wheel;
+static Probe probes[TIMERS];
+static int late;
+
+// level 0 ~ 3 중 하나에 들어가는 지연 (level 3은 2^24 ~ 2^26 ms까지만)
+static uint32_t random_delay(void) {
+    switch (rand() % 4) {
+    case 0: return (uint32_t)(rand() % 256);
+    case 1: return 256 + (uint32_t)(rand() % (65536 - 256));
+    case 2: return 65536 + (uint32_t)(rand() % ((1 << 24) - 65536));
+    default: return (1u << 24) + (uint32_t)(rand() % (3 << 24));
+    }
+}
+
+static void arm(Probe *p, uint32_t delay) {
+    timer_arm(&wheel, &p->t, delay);
+    CHECK(timer_pending(&p->t));
+    CHECK(p->t.expires >= wheel.now + (delay ? delay : 1));
+    p->expires = p->t.expires;
+    p->armed++;
+}
+
+static void on_fire(Timer *t, void *arg) {
+    Probe *p = (Probe *)arg;
+    CHECK(t == &p->t && !timer_pending(t));
+    if (wheel.now != p->expires) late++;
+    p->fired++;
+    if (p->rearm) {
+        p->rearm = 0;
+        arm(p, random_delay());
+    }
+    // 아직 걸려 있는 다른 타이머를 콜백 안에서 취소한다
+    if (rand() % 8 == 0) {
+        Probe *q = &probes[rand() % TIMERS];
+        if (q != p && timer_pending(&q->t)) {
+            timer_cancel(&q->t);
+            CHECK(!timer_pending(&q->t));
+            q->armed--;
+        }
+    }
+}
+
+// 시간이 ms만큼 흐른 것으로 하고 밀린 tick을 처리한다
+static void elapse(uint64_t ms) {
+    wheel.base_ms -= ms;
+    timer_wheel_advance(&wheel);
+}
+
+int main(void) {
+    Reactor reactor;
+    srand(1);
+    CHECK(reactor_init(&reactor) == 0);
+    CHECK(timer_wheel_init(&wheel, &reactor) == 0);
+
+    for (int i = 0; i < TIMERS; i++) {
+        timer_init(&probes[i].t, on_fire, &probes[i]);
+        CHECK(!timer_pending(&probes[i].t));
+        probes[i].rearm = i % 5 == 0;
+        arm(&probes[i], i < 10 ? 0 : random_delay());
+    }
+    CHECK(wheel.count == TIMERS);
+
+    // 건 직후 취소, 취소한 것을 다시 취소, 걸린 것을 다시 걸기
+    for (int i = 1; i < TIMERS; i += 7) {
+        timer_cancel(&probes[i].t);
+        timer_cancel(&probes[i].t);
+        probes[i].armed--;
+    }
+    for (int i = 3; i < TIMERS; i += 11) {
+        if (timer_pending(&probes[i].t)) probes[i].armed--;
+        arm(&probes[i], random_delay());
+    }
+
+    // 잘게, 가끔은 크게 흘려보낸다 (크게 흘려도 밀린 tick은 하나씩 처리된다)
+    uint64_t steps = 0;
+    while (wheel.count > 0 && steps++ < 10000000) {
+        elapse(rand() % 16 == 0 ? (uint64_t)(rand() % (1 << 22)) : (uint64_t)(rand() % 1000));
+    }
+    CHECK(wheel.count == 0);
+    CHECK(late == 0);
+    for (int i = 0; i < TIMERS; i++) {
+        CHECK(probes[i].fired == probes[i].armed);
+        CHECK(!timer_pending(&probes[i].t));
+    }
+
+    // 다 비운 휠에 다시 건다: 멈춰 있던 동안의 tick을 건너뛰고 지금부터 센다
+    elapse(123456);
+    Probe *p = &probes[0];
+    p->fired = p->armed = 0;
+    arm(p, 1000);
+    CHECK(p->expires == wheel.now + 1000);
+    elapse(500);
+    CHECK(p->fired == 0);
+    elapse(500);
+    CHECK(p->fired == 1 && wheel.count == 0);
+
+    timer_wheel_close(&wheel);
+    reactor_close(&reactor);
+    return test_report("timer_test");
+}
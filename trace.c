@@ -0,0 +1,259 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // syscall(SYS_gettid)
+#endif
+#include "../include/trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+
+#define TRACE_NAME_MAX 32
+
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} TraceEvent;
+
+typedef struct TraceRing {
+    TraceEvent ev[TRACE_RING_SIZE];
+    uint32_t head;             // 쓰는 스레드만 올린다
+    uint32_t tail;             // flush 스레드만 올린다
+    uint64_t dropped;          // 링이 가득 차서 버린 구간 (쓰는 스레드)
+    uint64_t dropped_seen;     // 이미 파일에 알린 만큼 (flush 스레드)
+    int tid;
+    int named;                 // thread_name 메타데이터를 썼다
+    char name[TRACE_NAME_MAX]; // 이름이 바뀌면 named를 0으로 (쓰는 스레드, 다음 flush에 반영)
+    struct TraceRing *next;
+} TraceRing;
+
+int trace_on;
+
+static TraceRing *rings;
+static unsigned generation;                // trace_close마다 올라간다
+static __thread TraceRing *self;
+static __thread unsigned self_generation;  // self를 받은 세대 (다르면 이미 풀린 링)
+static int trace_fd = -1;
+static int pid;
+static char process_name[TRACE_NAME_MAX];
+static pthread_t flush_thread;
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flush_cond = PTHREAD_COND_INITIALIZER;
+static int stopping;
+
+/* ---- 기록 ---- */
+
+static TraceRing *self_get(void) {
+    unsigned gen = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+    if (self && self_generation == gen) return self;
+    TraceRing *r = (TraceRing *)calloc(1, sizeof(TraceRing));
+    if (!r) return NULL;
+    r->tid = (int)syscall(SYS_gettid);
+    snprintf(r->name, sizeof r->name, "thread %d", r->tid);
+    r->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&rings, &r->next, r, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    self = r;
+    self_generation = gen;
+    return r;
+}
+
+void trace_span(const char *name, uint64_t start_ns, uint64_t end_ns) {
+    TraceRing *r = self_get();
+    if (!r) return;
+    uint32_t head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == TRACE_RING_SIZE) {
+        __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    TraceEvent *e = &r->ev[head & (TRACE_RING_SIZE - 1)];
+    e->name = name;
+    e->start_ns = start_ns;
+    e->end_ns = end_ns;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void trace_thread_name(const char *name) {
+    TraceRing *r = trace_on ? self_get() : NULL;
+    if (!r) return;
+    pthread_mutex_lock(&flush_lock);
+    snprintf(r->name, sizeof r->name, "%s", name);
+    r->named = 0;
+    pthread_mutex_unlock(&flush_lock);
+}
+
+/* ---- flush ---- */
+
+typedef struct {
+    char *p;
+    size_t len, cap;
+} Out;
+
+static void out_printf(Out *o, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(o->p ? o->p + o->len : NULL, o->p ? o->cap - o->len : 0, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if (o->p && o->len + (size_t)n < o->cap) {
+            o->len += (size_t)n;
+            return;
+        }
+        size_t cap = o->cap ? o->cap * 2 : 64 * 1024;
+        while (cap <= o->len + (size_t)n) cap *= 2;
+        char *p = (char *)realloc(o->p, cap);
+        if (!p) return;
+        o->p = p;
+        o->cap = cap;
+    }
+}
+
+static int write_all(const char *p, size_t len) {
+    size_t off = 0;
+    while (off < len) {
+        ssize_t n = write(trace_fd, p + off, len - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("trace");
+            return -1;
+        }
+        off += (size_t)n;
+    }
+    return 0;
+}
+
+// 다른 프로세스와 섞이지 않도록 한 덩어리를 flock 안에서 덧붙인다 (o는 항목마다 ",\n"으로 끝난다).
+// 덧붙일 때마다 배열을 닫아 두므로 파일은 언제 열어도 온전한 JSON이다:
+// 끝의 TRACE_CLOSE를 떼고 ",\n" + 새 항목 + TRACE_CLOSE를 쓴다
+#define TRACE_CLOSE "\n]\n"
+static void append(const Out *o) {
+    if (o->len < 2) return;
+    flock(trace_fd, LOCK_EX);
+    off_t size = lseek(trace_fd, 0, SEEK_END);
+    const char *prefix = "";
+    char tail[sizeof TRACE_CLOSE - 1];
+    if (size == 0) {
+        prefix = "[\n";
+    } else if (size >= (off_t)sizeof tail
+               && pread(trace_fd, tail, sizeof tail, size - (off_t)sizeof tail) == (ssize_t)sizeof tail
+               && memcmp(tail, TRACE_CLOSE, sizeof tail) == 0
+               && ftruncate(trace_fd, size - (off_t)sizeof tail) == 0) {
+        prefix = ",\n";
+    }
+    // 그 밖(닫히지 않은 예전 파일)은 ",\n"으로 끝나 있으므로 그대로 잇는다
+    if (write_all(prefix, strlen(prefix)) == 0 && write_all(o->p, o->len - 2) == 0) {
+        write_all(TRACE_CLOSE, sizeof TRACE_CLOSE - 1);
+    }
+    flock(trace_fd, LOCK_UN);
+}
+
+// flush_lock 안에서 (thread_name과 엇갈리지 않게)
+static void drain(Out *o) {
+    for (TraceRing *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+        if (!r->named) {
+            out_printf(o, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+                       pid, r->tid, r->name);
+            r->named = 1;
+        }
+        uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        for (uint32_t i = r->tail; i != head; i++) {
+            const TraceEvent *e = &r->ev[i & (TRACE_RING_SIZE - 1)];
+            out_printf(o, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+                       e->name, pid, r->tid, (double)e->start_ns / 1e3, (double)(e->end_ns - e->start_ns) / 1e3);
+        }
+        __atomic_store_n(&r->tail, head, __ATOMIC_RELEASE);
+        uint64_t dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+        if (dropped != r->dropped_seen) {
+            // 버린 구간이 있었다는 표시를 그 자리에 남긴다
+            out_printf(o, "{\"name\":\"trace_dropped\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+                       "\"args\":{\"spans\":%llu}},\n",
+                       pid, r->tid, (double)trace_clock_ns() / 1e3, (unsigned long long)(dropped - r->dropped_seen));
+            r->dropped_seen = dropped;
+        }
+    }
+}
+
+static void *flush_main(void *arg) {
+    (void)arg;
+    Out o;
+    memset(&o, 0, sizeof o);
+    pthread_mutex_lock(&flush_lock);
+    while (!stopping) {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += TRACE_FLUSH_MS * 1000000L;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&flush_cond, &flush_lock, &until);
+        o.len = 0;
+        drain(&o);
+        pthread_mutex_unlock(&flush_lock);
+        append(&o);
+        pthread_mutex_lock(&flush_lock);
+    }
+    pthread_mutex_unlock(&flush_lock);
+    free(o.p);
+    return NULL;
+}
+
+int trace_open(const char *path, const char *process) {
+    trace_fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);   // 끝의 ']'를 읽고 떼야 한다
+    if (trace_fd < 0) {
+        perror(path);
+        return -1;
+    }
+    pid = (int)getpid();
+    snprintf(process_name, sizeof process_name, "%s", process);
+    Out o;
+    memset(&o, 0, sizeof o);
+    out_printf(&o, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s %d\"}},\n",
+               pid, process_name, pid);
+    append(&o);
+    free(o.p);
+    stopping = 0;
+    if (pthread_create(&flush_thread, NULL, flush_main, NULL) != 0) {
+        perror("pthread_create");
+        close(trace_fd);
+        trace_fd = -1;
+        return -1;
+    }
+    trace_on = 1;
+    return 0;
+}
+
+void trace_close(void) {
+    if (trace_fd < 0) return;
+    trace_on = 0;
+    pthread_mutex_lock(&flush_lock);
+    stopping = 1;
+    pthread_cond_signal(&flush_cond);
+    pthread_mutex_unlock(&flush_lock);
+    pthread_join(flush_thread, NULL);
+
+    Out o;
+    memset(&o, 0, sizeof o);
+    drain(&o);
+    append(&o);
+    free(o.p);
+    close(trace_fd);
+    trace_fd = -1;
+    TraceRing *r = __atomic_exchange_n(&rings, (TraceRing *)NULL, __ATOMIC_ACQ_REL);
+    while (r) {
+        TraceRing *next = r->next;
+        free(r);
+        r = next;
+    }
+    // 다른 스레드의 self도 풀렸다: 다시 열고 기록하면 새 링을 받게 한다
+    __atomic_add_fetch(&generation, 1, __ATOMIC_RELEASE);
+    self = NULL;
+}
@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * 단계별 구간을 Chrome trace-event 형식으로 남기는 추적 (server/client -T <file>).
+ *
+ * 스레드마다 링 하나 (처음 기록할 때 만들어 전역 목록에 CAS로 붙인다). 쓰는 쪽은 그 스레드,
+ * 읽는 쪽은 flush 스레드 하나뿐인 SPSC 링이라 락이 없다. 링이 가득 차면 구간을 버리고 센다.
+ * flush 스레드는 TRACE_FLUSH_MS마다 링을 비워 파일에 덧붙인다.
+ *
+ * 시각은 CLOCK_MONOTONIC이라 같은 기계의 서버와 클라이언트가 한 시간축에 놓인다.
+ * 여러 프로세스가 같은 파일을 줘도 된다: 덧붙일 때마다 flock을 잡고, 빈 파일이면 '['부터 쓴다.
+ * 덧붙인 뒤에는 늘 ']'로 닫아 두고 다음에 덧붙일 때 뗀다. 그래서 flush 사이 어느 때든,
+ * 다른 프로세스가 아직 쓰는 중이어도 온전한 JSON이다. chrome://tracing이나
+ * ui.perfetto.dev에서 바로 연다.
+ */
+#define TRACE_RING_SIZE 65536      // 스레드당 구간 수 (2의 거듭제곱)
+#define TRACE_FLUSH_MS  100
+
+extern int trace_on;
+
+static inline uint64_t trace_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// name은 문자열 상수여야 한다 (flush할 때까지 포인터만 들고 있다)
+void trace_span(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+// 구간 시작. 꺼져 있으면 0 (trace_end가 무시한다)
+static inline uint64_t trace_begin(void) {
+    return trace_on ? trace_clock_ns() : 0;
+}
+static inline void trace_end(const char *name, uint64_t start) {
+    if (start) trace_span(name, start, trace_clock_ns());
+}
+
+// 파일을 열고 flush 스레드를 띄운다. process는 타임라인에 보일 프로세스 이름. 실패하면 -1
+int trace_open(const char *path, const char *process);
+// 지금 스레드의 타임라인 이름 (shard 스레드 등)
+void trace_thread_name(const char *name);
+// 남은 구간을 다 쓰고 닫는다 (그동안 기록하는 스레드가 없을 때).
+// 남아 있는 스레드는 다시 연 뒤 기록할 때 새 링을 받는다
+void trace_close(void);
+
+#endif
@@ -0,0 +1,171 @@
+#include "../include/uring.h"
+
+#if URING_AVAILABLE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+static int sys_enter(int fd, unsigned submit, unsigned wait_nr, unsigned flags, void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, submit, wait_nr, flags, arg, argsz);
+}
+static int sys_register(int fd, unsigned op, void *arg, unsigned nr) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+// multishot recv는 6.0부터. 지원 여부를 물어볼 방법이 없어서 버전으로 본다
+static int kernel_ok(void) {
+    struct utsname un;
+    int major = 0;
+    if (uname(&un) < 0 || sscanf(un.release, "%d.", &major) != 1) return 0;
+    return major >= 6;
+}
+
+int uring_init(Uring *u, unsigned entries, unsigned nbufs, unsigned buf_size) {
+    struct io_uring_params p;
+    memset(u, 0, sizeof *u);
+    u->fd = -1;
+    if (!kernel_ok()) {
+        errno = ENOSYS;
+        return -1;
+    }
+    memset(&p, 0, sizeof p);
+    // 완료가 몰려도 버려지지 않게 CQ를 넉넉히 (FEAT_NODROP이면 넘쳐도 커널이 들고 있는다)
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    p.cq_entries = entries * 4;
+    int fd = sys_setup(entries, &p);
+    if (fd < 0 && errno == EINVAL) {
+        p.flags = IORING_SETUP_CQSIZE;
+        fd = sys_setup(entries, &p);
+    }
+    if (fd < 0) return -1;
+    u->fd = fd;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_NODROP)
+        || !(p.features & IORING_FEAT_EXT_ARG)) {
+        uring_close(u);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    size_t sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    u->ring_len = sq_len > cq_len ? sq_len : cq_len;
+    u->ring_ptr = mmap(NULL, u->ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (u->ring_ptr == MAP_FAILED) {
+        u->ring_ptr = NULL;
+        uring_close(u);
+        return -1;
+    }
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        uring_close(u);
+        return -1;
+    }
+    u->sqes = (struct io_uring_sqe *)sqes;
+    char *base = (char *)u->ring_ptr;
+    u->sq_entries = p.sq_entries;
+    u->sq_head = (unsigned *)(base + p.sq_off.head);
+    u->sq_tail = (unsigned *)(base + p.sq_off.tail);
+    u->sq_mask = *(unsigned *)(base + p.sq_off.ring_mask);
+    u->sq_local = *u->sq_tail;
+    unsigned *array = (unsigned *)(base + p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; i++) array[i] = i;
+    u->cq_head = (unsigned *)(base + p.cq_off.head);
+    u->cq_tail = (unsigned *)(base + p.cq_off.tail);
+    u->cq_mask = *(unsigned *)(base + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(base + p.cq_off.cqes);
+
+    // provided buffer ring: 링은 페이지 정렬이 필요해서 mmap으로 잡는다
+    u->br_entries = nbufs;
+    u->buf_size = buf_size;
+    u->br_len = nbufs * sizeof(struct io_uring_buf);
+    void *br = mmap(NULL, u->br_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    u->bufs = (char *)malloc((size_t)nbufs * buf_size);
+    if (br == MAP_FAILED || !u->bufs) {
+        if (br != MAP_FAILED) munmap(br, u->br_len);
+        uring_close(u);
+        errno = ENOMEM;
+        return -1;
+    }
+    u->br = (struct io_uring_buf *)br;
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof reg);
+    reg.ring_addr = (uint64_t)(uintptr_t)br;
+    reg.ring_entries = nbufs;
+    reg.bgid = 0;
+    if (sys_register(fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        uring_close(u);
+        return -1;
+    }
+    for (unsigned bid = 0; bid < nbufs; bid++) uring_buf_return(u, bid);
+    return 0;
+}
+
+void uring_close(Uring *u) {
+    if (u->br) munmap(u->br, u->br_len);
+    free(u->bufs);
+    if (u->sqes) munmap(u->sqes, u->sqes_len);
+    if (u->ring_ptr) munmap(u->ring_ptr, u->ring_len);
+    if (u->fd >= 0) close(u->fd);
+    memset(u, 0, sizeof *u);
+    u->fd = -1;
+}
+
+struct io_uring_sqe *uring_sqe(Uring *u) {
+    if (u->sq_local - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= u->sq_entries) {
+        uring_enter(u, 0, 0);
+        if (u->sq_local - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= u->sq_entries) return NULL;
+    }
+    struct io_uring_sqe *sqe = &u->sqes[u->sq_local & u->sq_mask];
+    memset(sqe, 0, sizeof *sqe);
+    u->sq_local++;
+    return sqe;
+}
+
+int uring_enter(Uring *u, unsigned wait_nr, int timeout_ms) {
+    unsigned submit = u->sq_local - *u->sq_tail;
+    __atomic_store_n(u->sq_tail, u->sq_local, __ATOMIC_RELEASE);
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    if (timeout_ms <= 0 || wait_nr == 0) {
+        if (timeout_ms == 0) wait_nr = 0;
+        return sys_enter(u->fd, submit, wait_nr, flags, NULL, 0);
+    }
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+    memset(&arg, 0, sizeof arg);
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+    return sys_enter(u->fd, submit, wait_nr, flags | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+}
+
+unsigned uring_reap(Uring *u, struct io_uring_cqe *out, unsigned max) {
+    unsigned head = *u->cq_head;
+    unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    unsigned n = 0;
+    while (head != tail && n < max) {
+        out[n++] = u->cqes[head & u->cq_mask];
+        head++;
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    return n;
+}
+
+void uring_buf_return(Uring *u, unsigned bid) {
+    struct io_uring_buf *b = &u->br[u->br_tail & (u->br_entries - 1)];
+    b->addr = (uint64_t)(uintptr_t)uring_buf(u, bid);
+    b->len = u->buf_size;
+    b->bid = (unsigned short)bid;
+    u->br_tail++;
+    __atomic_store_n(&u->br[0].resv, u->br_tail, __ATOMIC_RELEASE);
+}
+#endif
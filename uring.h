@@ -0,0 +1,61 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * liburing 없이 io_uring 시스템 호출을 직접 쓰는 얇은 래퍼 (net.c의 io_uring 백엔드용).
+ *
+ * SQE는 uring_sqe로 채워두기만 하고 uring_enter 한 번에 모아서 제출한다 (reactor 루프 한 바퀴에 한 번).
+ * 수신은 커널이 고르는 provided buffer ring(그룹 0)을 쓰고, 완료를 처리한 쪽이 바로 돌려준다.
+ * multishot accept/recv가 필요해서 커널 6.0 이상, 헤더도 그만큼 새로워야 한다.
+ */
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT) && defined(IORING_ASYNC_CANCEL_FD)
+#define URING_AVAILABLE 1
+#else
+#define URING_AVAILABLE 0
+#endif
+
+#if URING_AVAILABLE
+typedef struct Uring {
+    int fd;
+    unsigned sq_entries;
+    unsigned *sq_head, *sq_tail, sq_mask;
+    unsigned sq_local;                 // 채웠지만 아직 커널에 알리지 않은 tail
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head, *cq_tail, cq_mask;
+    struct io_uring_cqe *cqes;
+    void *ring_ptr;
+    size_t ring_len, sqes_len;
+
+    struct io_uring_buf *br;           // provided buffer ring (그룹 0). tail은 br[0].resv 자리
+                                       // (헤더의 io_uring_buf_ring은 C++에서 배치가 달라져서 쓰지 않는다)
+    size_t br_len;
+    unsigned br_entries;
+    unsigned short br_tail;
+    unsigned buf_size;
+    char *bufs;
+} Uring;
+
+// 실패하면 -1 (커널이 너무 오래됐거나 io_uring이 막혀 있음, errno 유지)
+int uring_init(Uring *u, unsigned entries, unsigned nbufs, unsigned buf_size);
+void uring_close(Uring *u);
+// 0으로 채운 SQE. SQ가 가득 차면 먼저 제출하고, 그래도 없으면 NULL
+struct io_uring_sqe *uring_sqe(Uring *u);
+// 쌓인 SQE를 제출하고 완료가 wait_nr개 생길 때까지 기다린다 (timeout_ms < 0이면 무한)
+int uring_enter(Uring *u, unsigned wait_nr, int timeout_ms);
+// 완료를 out에 최대 max개 복사하고 CQ에서 뺀다
+unsigned uring_reap(Uring *u, struct io_uring_cqe *out, unsigned max);
+
+static inline char *uring_buf(Uring *u, unsigned bid) { return u->bufs + (size_t)bid * u->buf_size; }
+void uring_buf_return(Uring *u, unsigned bid);
+#endif
+
+#endif
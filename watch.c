@@ -0,0 +1,176 @@
+#include "../include/watch.h"
+
+#include <stdlib.h>
+
+#define WATCH_BUCKETS 1024
+
+static size_t bucket_of(const WatchTable *t, uint32_t game) {
+    return (size_t)(game * 2654435761u) & (t->nbuckets - 1);
+}
+
+static void list_push(Watcher **head, Watcher *w) {
+    w->prev = NULL;
+    w->next = *head;
+    if (*head) (*head)->prev = w;
+    *head = w;
+}
+
+static void list_unlink(Watcher **head, Watcher *w) {
+    if (w->prev) w->prev->next = w->next;
+    else *head = w->next;
+    if (w->next) w->next->prev = w->prev;
+    w->prev = w->next = NULL;
+}
+
+static void group_free(WatchTable *t, WatchGroup *g) {
+    WatchGroup **pp = &t->buckets[bucket_of(t, g->game)];
+    while (*pp != g) pp = &(*pp)->next;
+    *pp = g->next;
+    if (g->latest) netbuf_unref(g->latest);
+    if (g->latest_delta) netbuf_unref(g->latest_delta);
+    free(g);
+}
+
+int watch_init(WatchTable *t) {
+    t->nbuckets = WATCH_BUCKETS;
+    t->buckets = (WatchGroup **)calloc(t->nbuckets, sizeof(WatchGroup *));
+    t->all = NULL;
+    t->all_count = 0;
+    t->count = 0;
+    t->dirty = t->dirty_tail = NULL;
+    return t->buckets ? 0 : -1;
+}
+
+void watch_destroy(WatchTable *t, void (*fn)(Watcher *w)) {
+    if (!t->buckets) return;
+    for (size_t i = 0; i < t->nbuckets; i++) {
+        WatchGroup *g = t->buckets[i];
+        while (g) {
+            WatchGroup *gnext = g->next;
+            for (Watcher *w = g->head, *next; w; w = next) {
+                next = w->next;
+                if (fn) fn(w);
+            }
+            if (g->latest) netbuf_unref(g->latest);
+            if (g->latest_delta) netbuf_unref(g->latest_delta);
+            free(g);
+            g = gnext;
+        }
+    }
+    for (Watcher *w = t->all, *next; w; w = next) {
+        next = w->next;
+        if (fn) fn(w);
+    }
+    free(t->buckets);
+    t->buckets = NULL;
+    t->all = NULL;
+    t->all_count = 0;
+    t->count = 0;
+    t->dirty = t->dirty_tail = NULL;
+}
+
+WatchGroup *watch_find(WatchTable *t, uint32_t game) {
+    WatchGroup *g = t->buckets[bucket_of(t, game)];
+    while (g && g->game != game) g = g->next;
+    return g;
+}
+
+int watch_add(WatchTable *t, Watcher *w, uint32_t game) {
+    w->game = game;
+    w->seq = 0;
+    if (game == WATCH_ALL) {
+        w->group = NULL;
+        list_push(&t->all, w);
+        t->all_count++;
+        t->count++;
+        return 0;
+    }
+    WatchGroup *g = watch_find(t, game);
+    if (!g) {
+        g = (WatchGroup *)calloc(1, sizeof(WatchGroup));
+        if (!g) return -1;
+        size_t b = bucket_of(t, game);
+        g->game = game;
+        g->next = t->buckets[b];
+        t->buckets[b] = g;
+    }
+    w->group = g;
+    w->seq = g->seq;        // 지금 있는 메시지는 이 관전자의 몫이 아니다
+    list_push(&g->head, w);
+    g->count++;
+    t->count++;
+    return 0;
+}
+
+void watch_remove(WatchTable *t, Watcher *w) {
+    WatchGroup *g = w->group;
+    t->count--;
+    if (!g) {
+        list_unlink(&t->all, w);
+        t->all_count--;
+        return;
+    }
+    if (g->cursor == w) g->cursor = w->next;
+    list_unlink(&g->head, w);
+    w->group = NULL;
+    if (--g->count == 0 && !g->scheduled) group_free(t, g);
+}
+
+void watch_publish(WatchTable *t, WatchGroup *g, NetBuf *full, NetBuf *delta, int final) {
+    if (g->latest) netbuf_unref(g->latest);
+    if (g->latest_delta) netbuf_unref(g->latest_delta);
+    g->latest = full;
+    g->latest_delta = delta;
+    g->seq++;
+    g->final = final;
+    if (g->scheduled) {
+        // 이미 보내는 중: 지금 자리부터 끝까지 간 뒤 처음부터 한 바퀴 더
+        g->again = 1;
+        return;
+    }
+    g->scheduled = 1;
+    g->again = 0;
+    g->cursor = g->head;
+    g->dirty_next = NULL;
+    if (t->dirty_tail) t->dirty_tail->dirty_next = g;
+    else t->dirty = g;
+    t->dirty_tail = g;
+}
+
+int watch_flush(WatchTable *t, int budget,
+                void (*send)(Watcher *w, NetBuf *b), void (*done)(WatchGroup *g)) {
+    while (t->dirty && budget > 0) {
+        WatchGroup *g = t->dirty;
+        t->dirty = g->dirty_next;
+        if (!t->dirty) t->dirty_tail = NULL;
+
+        while (budget > 0 && g->count > 0) {
+            Watcher *w = g->cursor;
+            if (!w) {
+                if (!g->again) break;
+                g->again = 0;
+                g->cursor = g->head;
+                continue;
+            }
+            g->cursor = w->next;
+            if (w->pending || w->seq == g->seq) continue;
+            NetBuf *b = g->latest;
+            if (w->delta && g->latest_delta && w->seq + 1 == g->seq) b = g->latest_delta;
+            w->seq = g->seq;
+            budget--;
+            send(w, b);
+        }
+        if (g->count > 0 && (g->cursor || g->again)) {
+            // 할당량을 다 썼다: 다른 그룹 뒤로 보낸다
+            g->dirty_next = NULL;
+            if (t->dirty_tail) t->dirty_tail->dirty_next = g;
+            else t->dirty = g;
+            t->dirty_tail = g;
+            continue;
+        }
+        g->scheduled = 0;
+        if (g->count == 0) group_free(t, g);
+        else if (g->final) done(g);
+    }
+    return t->dirty != NULL;
+}
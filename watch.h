@@ -0,0 +1,74 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "net.h"
+
+/*
+ * 한 reactor 스레드 안의 관전자 목록: 게임 id별 그룹 + 모든 게임을 보는 목록.
+ * 다른 스레드와 공유하지 않으므로 락이 없다.
+ *
+ * 게임 그룹에는 "가장 최근 메시지" 하나만 둔다 (이벤트마다 보드 전체가 들어 있음).
+ * watch_flush가 정해진 수만큼씩 나눠 보내고, 보내는 도중에 새 메시지가 오면
+ * 아직 못 받은 관전자는 새 것만 받는다. 관전자가 아무리 많아도 한 번에 하는 일이
+ * 제한되므로 같은 스레드의 플레이어 입력이 밀리지 않는다.
+ */
+#define WATCH_ALL 0u                   // game id 0 = 모든 게임
+
+struct WatchGroup;
+
+typedef struct Watcher {
+    struct Watcher *prev, *next;
+    struct WatchGroup *group;          // WATCH_ALL이면 NULL
+    Conn *conn;
+    uint32_t game;
+    uint32_t seq;                      // 마지막으로 받은 그룹 메시지 번호
+    int pending;                       // 첫 스냅샷을 받기 전이면 1 (이벤트를 보내지 않음)
+    int delta;                         // 직전 메시지를 받았으면 변경분만 받는다
+} Watcher;
+
+typedef struct WatchGroup {
+    struct WatchGroup *next;           // 해시 체인
+    uint32_t game;
+    size_t count;
+    Watcher *head;
+
+    NetBuf *latest;                    // 보낼 메시지, 보드 전체 (없으면 NULL)
+    NetBuf *latest_delta;              // 같은 메시지의 변경분 버전 (없으면 NULL)
+    uint32_t seq;                      // latest의 번호
+    int final;                         // latest가 마지막 메시지 (다 보내면 flush가 done 호출)
+    int scheduled;                     // 전송 대기 목록에 있으면 1
+    int again;                         // 지금 도는 중에 새 메시지가 와서 한 바퀴 더 돌아야 함
+    Watcher *cursor;                   // 다음에 볼 관전자
+    struct WatchGroup *dirty_next;
+} WatchGroup;
+
+typedef struct {
+    WatchGroup **buckets;
+    size_t nbuckets;                   // 2의 거듭제곱
+    Watcher *all;
+    size_t all_count;                  // all 목록의 관전자 수
+    size_t count;                      // 전체 관전자 수 (all 포함)
+    WatchGroup *dirty, *dirty_tail;    // 보낼 메시지가 남은 그룹 (돌아가며 보낸다)
+} WatchTable;
+
+int watch_init(WatchTable *t);
+// 남은 관전자마다 fn을 부른 뒤 (NULL이면 생략) 테이블을 해제한다
+void watch_destroy(WatchTable *t, void (*fn)(Watcher *w));
+// w->conn은 호출 전에 채워둔다. 메모리 부족이면 -1
+int watch_add(WatchTable *t, Watcher *w, uint32_t game);
+// 그룹의 마지막 관전자였으면 그룹도 지운다 (전송 중이면 flush가 끝낼 때)
+void watch_remove(WatchTable *t, Watcher *w);
+// 없으면 NULL
+WatchGroup *watch_find(WatchTable *t, uint32_t game);
+
+// 그룹의 최근 메시지를 full/delta로 바꾼다 (둘의 참조를 하나씩 가져감, delta는 NULL 가능)
+void watch_publish(WatchTable *t, WatchGroup *g, NetBuf *full, NetBuf *delta, int final);
+// 최근 메시지를 아직 못 받은 관전자에게 최대 budget번 send를 부른다. 남은 일이 있으면 1
+// 바로 앞 메시지를 받은 delta 관전자에게는 변경분을, 나머지에게는 보드 전체를 넘긴다
+// send는 현재 관전자를 watch_remove 해도 된다. final 메시지를 모두 보낸 그룹은 done을 부른다
+int watch_flush(WatchTable *t, int budget,
+                void (*send)(Watcher *w, NetBuf *b), void (*done)(WatchGroup *g));
+
+#endif
@@ -0,0 +1,177 @@
+#include "../include/watch.h"
+#include "../include/test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * watch.c: 관전자 그룹에 메시지를 몰아서 내도 관전자마다 가장 최근 것 하나만 가고,
+ * 나눠 보내는 도중에 새 메시지가 오면 아직 못 받은 쪽은 새 것만, 받은 쪽은 새 것을 한 번 더 받는지 본다.
+ * 무작위로 내고, 나눠 보내고, 들어오고 나가는 것을 섞은 뒤 다 보내고 나면 모두 마지막 메시지를 갖고 있어야 한다.
+ * 바로 앞 메시지를 받은 delta 관전자만 변경분 버전을 받는다.
+ */
+#define GAMES     16
+#define WATCHERS  800
+#define ROUNDS    40000
+#define DELTA_BIT 0x80000000u          // 메시지 번호에 붙여 변경분 버전을 표시
+
+typedef struct {
+    Watcher w;                         // 첫 멤버 (send가 받은 Watcher *를 그대로 캐스팅)
+    int active;
+    uint32_t last;                     // 마지막으로 받은 (혹은 스냅샷으로 아는) 메시지 번호
+    int sends;
+} Spectator;
+
+static WatchTable table;
+static Spectator specs[WATCHERS];
+static uint32_t published[GAMES + 1];  // game id별 마지막으로 낸 메시지 번호
+static int over[GAMES + 1];
+static int dones;
+static int drop_on_send;               // 보내다가 연결이 끊기는 관전자를 섞는다
+
+// 지난번 이후로 보낸 수
+static int total_sends(void) {
+    int n = 0;
+    for (int i = 0; i < WATCHERS; i++) {
+        n += specs[i].sends;
+        specs[i].sends = 0;
+    }
+    return n;
+}
+
+static NetBuf *make_msg(uint32_t n) {
+    NetBuf *b = netbuf_new(sizeof n);
+    memcpy(netbuf_data(b), &n, sizeof n);
+    b->len = sizeof n;
+    return b;
+}
+
+static uint32_t msg_number(NetBuf *b) {
+    uint32_t n;
+    memcpy(&n, netbuf_data(b), sizeof n);
+    return n;
+}
+
+static void join(Spectator *s, uint32_t game, int pending) {
+    memset(&s->w, 0, sizeof s->w);
+    s->w.pending = pending;
+    s->w.delta = rand() % 2;
+    CHECK(watch_add(&table, &s->w, game) == 0);
+    s->active = 1;
+    s->sends = 0;
+    s->last = published[game];         // 들어올 때 스냅샷으로 지금 보드를 받는다
+}
+
+static void leave(Spectator *s) {
+    watch_remove(&table, &s->w);
+    s->active = 0;
+}
+
+static void on_send(Watcher *w, NetBuf *b) {
+    Spectator *s = (Spectator *)w;
+    uint32_t n = msg_number(b);
+    int delta = (n & DELTA_BIT) != 0;
+    n &= ~DELTA_BIT;
+    CHECK(s->active && !w->pending);
+    CHECK(b == w->group->latest || b == w->group->latest_delta);
+    CHECK(n == published[w->game]);    // 가장 최근 메시지만
+    CHECK(n > s->last);                // 같은 메시지를 두 번 받지 않는다
+    // 변경분은 delta 관전자가 바로 앞 메시지를 가졌을 때만, 변경분이 있으면 그런 관전자는 꼭 변경분을
+    CHECK(!delta || (w->delta && s->last + 1 == n));
+    if (w->group->latest_delta && w->delta && s->last + 1 == n) CHECK(delta);
+    s->last = n;
+    s->sends++;
+    // 보내다가 연결이 끊긴 관전자
+    if (drop_on_send && rand() % 50 == 0) leave(s);
+}
+
+static void on_done(WatchGroup *g) {
+    uint32_t game = g->game;           // 마지막 관전자가 나가면 g도 해제된다
+    CHECK(over[game]);
+    dones++;
+    for (int i = 0; i < WATCHERS; i++) {
+        Spectator *s = &specs[i];
+        if (!s->active || s->w.game != game) continue;
+        if (!s->w.pending) CHECK(s->last == published[game]);
+        leave(s);                      // 게임이 끝나면 서버가 관전자를 내보낸다
+    }
+}
+
+// 남은 것을 budget씩 (0이면 무작위로) 다 보낸다
+static void flush_all(int budget) {
+    for (int guard = 0; guard < 100000; guard++) {
+        if (!watch_flush(&table, budget ? budget : 1 + rand() % 300, on_send, on_done)) break;
+    }
+    CHECK(table.dirty == NULL);
+}
+
+static void publish(uint32_t game, int final) {
+    WatchGroup *g = watch_find(&table, game);
+    if (!g) return;                    // 관전자가 없으면 서버도 내지 않는다
+    uint32_t n = ++published[game];
+    NetBuf *delta = rand() % 4 ? make_msg(n | DELTA_BIT) : NULL;
+    over[game] = final;
+    watch_publish(&table, g, make_msg(n), delta, final);
+}
+
+// 한 그룹에 한꺼번에 낸 메시지 다섯 개는 관전자마다 한 번, 마지막 것만
+static void test_coalesce(void) {
+    const uint32_t game = GAMES;
+    const int n = WATCHERS / 2;
+    for (int i = 0; i < n; i++) join(&specs[i], game, 0);
+    for (int k = 0; k < 5; k++) publish(game, 0);
+    flush_all(64);
+    CHECK(total_sends() == n);
+    for (int i = 0; i < n; i++) CHECK(specs[i].last == published[game]);
+
+    // 100명에게 보낸 뒤 새 메시지: 받은 100명은 새 것을 한 번 더, 나머지는 새 것만
+    publish(game, 0);
+    CHECK(watch_flush(&table, 100, on_send, on_done) == 1);
+    CHECK(total_sends() == 100);
+    publish(game, 1);
+    flush_all(0);
+    CHECK(total_sends() == n);
+    CHECK(dones == 1);
+    CHECK(watch_find(&table, game) == NULL && table.count == 0);
+}
+
+static void test_random(void) {
+    drop_on_send = 1;
+    for (int round = 0; round < ROUNDS; round++) {
+        int op = rand() % 10;
+        uint32_t game = 1 + (uint32_t)(rand() % GAMES);
+        if (op < 3) {
+            if (!over[game]) publish(game, rand() % 40 == 0);
+        } else if (op < 5) {
+            watch_flush(&table, 1 + rand() % 300, on_send, on_done);
+        } else if (op < 8) {
+            Spectator *s = &specs[rand() % WATCHERS];
+            if (!s->active && !over[game]) join(s, game, rand() % 10 == 0);
+        } else {
+            Spectator *s = &specs[rand() % WATCHERS];
+            if (s->active) leave(s);
+        }
+        // 끝난 게임 번호는 관전자가 모두 나가면 다시 쓴다
+        if (over[game] && !watch_find(&table, game)) over[game] = 0;
+    }
+    flush_all(0);
+
+    size_t count = 0;
+    for (int i = 0; i < WATCHERS; i++) {
+        Spectator *s = &specs[i];
+        if (!s->active) continue;
+        count++;
+        if (s->w.pending) CHECK(s->sends == 0);
+        else CHECK(s->last == published[s->w.game]);
+    }
+    CHECK(table.count == count);
+}
+
+int main(void) {
+    srand(1);
+    CHECK(watch_init(&table) == 0);
+    test_coalesce();
+    test_random();
+    watch_destroy(&table, NULL);
+    return test_report("watch_test");
+}
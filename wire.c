@@ -0,0 +1,188 @@
+#include "../include/wire.h"
+
+#include <string.h>
+
+// 메시지에 들어가는 필드 (프레임 안에서도 이 순서)
+enum {
+    F_SEQ     = 1 << 0,    // u16
+    F_MOVE    = 1 << 1,    // u16
+    F_COND    = 1 << 2,    // u16
+    F_RATING  = 1 << 3,    // u16
+    F_SEAT    = 1 << 4,    // u8
+    F_TIMEOUT = 1 << 5,    // u8
+    F_REASON  = 1 << 6,    // u8
+    F_SCORE   = 1 << 7,    // u8 x 2
+    F_BOARD   = 1 << 8,    // 16B
+    F_NAME0   = 1 << 9,    // 길이 u8 + 바이트
+    F_NAME1   = 1 << 10,
+    F_TOKEN   = 1 << 11,   // u64
+};
+
+// 모르는 type이면 -1
+static int layout_of(uint8_t type) {
+    switch (type) {
+    case WIRE_REGISTER:      return F_RATING | F_NAME0;
+    case WIRE_MOVE:          return F_MOVE;
+    case WIRE_PREMOVE:       return F_SEQ | F_MOVE | F_COND;
+    case WIRE_RESUME:        return F_TOKEN | F_NAME0;
+    case WIRE_REGISTER_ACK:  return F_TOKEN;
+    case WIRE_REGISTER_NACK: return F_REASON;
+    case WIRE_GAME_START:    return F_SEQ | F_BOARD | F_NAME0 | F_NAME1;
+    case WIRE_YOUR_TURN:     return F_SEQ | F_TIMEOUT | F_BOARD;
+    case WIRE_MOVE_OK:       return F_SEQ | F_MOVE | F_SEAT | F_BOARD;
+    case WIRE_INVALID_MOVE:  return F_SEQ | F_SEAT;
+    case WIRE_PASS:          return F_SEQ | F_SEAT | F_BOARD;
+    case WIRE_GAME_OVER:     return F_SCORE | F_BOARD;
+    default:                 return -1;
+    }
+}
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+    return p + 2;
+}
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+static inline uint8_t *put_u64(uint8_t *p, uint64_t v) {
+    p = put_u16(p, (uint16_t)(v >> 48));
+    p = put_u16(p, (uint16_t)(v >> 32));
+    p = put_u16(p, (uint16_t)(v >> 16));
+    return put_u16(p, (uint16_t)v);
+}
+static inline uint64_t get_u64(const uint8_t *p) {
+    return (uint64_t)get_u16(p) << 48 | (uint64_t)get_u16(p + 2) << 32 | (uint64_t)get_u16(p + 4) << 16 | get_u16(p + 6);
+}
+
+void wire_msg_init(WireMsg *m, uint8_t type) {
+    memset(m, 0, sizeof *m);
+    m->type = type;
+}
+
+size_t wire_encode(uint8_t *buf, size_t cap, const WireMsg *m) {
+    int layout = layout_of(m->type);
+    if (layout < 0 || cap < WIRE_FRAME_MAX) return 0;
+    uint8_t *p = buf + 2;
+    *p++ = m->type;
+    if (layout & F_SEQ) p = put_u16(p, m->seq);
+    if (layout & F_MOVE) p = put_u16(p, m->move);
+    if (layout & F_COND) p = put_u16(p, m->cond);
+    if (layout & F_RATING) p = put_u16(p, m->rating);
+    if (layout & F_TOKEN) p = put_u64(p, m->token);
+    if (layout & F_SEAT) *p++ = m->seat;
+    if (layout & F_TIMEOUT) *p++ = m->timeout;
+    if (layout & F_REASON) *p++ = m->reason;
+    if (layout & F_SCORE) {
+        *p++ = m->score[0];
+        *p++ = m->score[1];
+    }
+    if (layout & F_BOARD) {
+        memcpy(p, m->board, WIRE_BOARD_BYTES);
+        p += WIRE_BOARD_BYTES;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (!(layout & (F_NAME0 << i))) continue;
+        size_t n = strnlen(m->name[i], WIRE_NAME_MAX - 1);
+        *p++ = (uint8_t)n;
+        memcpy(p, m->name[i], n);
+        p += n;
+    }
+    put_u16(buf, (uint16_t)(p - buf - 2));
+    return (size_t)(p - buf);
+}
+
+int wire_decode(const uint8_t *frame, size_t len, WireMsg *m) {
+    if (len < 1) return -1;
+    int layout = layout_of(frame[0]);
+    if (layout < 0) return -1;
+    wire_msg_init(m, frame[0]);
+    const uint8_t *p = frame + 1, *end = frame + len;
+    // 고정 길이 부분을 한 번에 검사한다
+    size_t fixed = 2 * !!(layout & F_SEQ) + 2 * !!(layout & F_MOVE) + 2 * !!(layout & F_COND) + 2 * !!(layout & F_RATING)
+                 + !!(layout & F_SEAT) + !!(layout & F_TIMEOUT) + !!(layout & F_REASON)
+                 + 2 * !!(layout & F_SCORE) + WIRE_BOARD_BYTES * !!(layout & F_BOARD) + 8 * !!(layout & F_TOKEN);
+    if ((size_t)(end - p) < fixed) return -1;
+    if (layout & F_SEQ) { m->seq = get_u16(p); p += 2; }
+    if (layout & F_MOVE) { m->move = get_u16(p); p += 2; }
+    if (layout & F_COND) { m->cond = get_u16(p); p += 2; }
+    if (layout & F_RATING) { m->rating = get_u16(p); p += 2; }
+    if (layout & F_TOKEN) { m->token = get_u64(p); p += 8; }
+    if (layout & F_SEAT) m->seat = *p++;
+    if (layout & F_TIMEOUT) m->timeout = *p++;
+    if (layout & F_REASON) m->reason = *p++;
+    if (layout & F_SCORE) {
+        m->score[0] = *p++;
+        m->score[1] = *p++;
+    }
+    if (layout & F_BOARD) {
+        memcpy(m->board, p, WIRE_BOARD_BYTES);
+        p += WIRE_BOARD_BYTES;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (!(layout & (F_NAME0 << i))) continue;
+        if (p >= end) return -1;
+        size_t n = *p++;
+        if (n >= WIRE_NAME_MAX || (size_t)(end - p) < n) return -1;
+        memcpy(m->name[i], p, n);
+        p += n;
+    }
+    return p == end ? 0 : -1;
+}
+
+// 32비트의 각 비트 사이에 0을 하나씩 끼운다 (비트 i → 2i)
+static inline uint64_t spread32(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2))  & 0x3333333333333333ull;
+    x = (x | (x << 1))  & 0x5555555555555555ull;
+    return x;
+}
+// spread32의 반대: 짝수 비트만 모은다
+static inline uint32_t compact64(uint64_t x) {
+    x &= 0x5555555555555555ull;
+    x = (x | (x >> 1))  & 0x3333333333333333ull;
+    x = (x | (x >> 2))  & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4))  & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8))  & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+    return (uint32_t)x;
+}
+
+void wire_pack_bits(uint8_t out[WIRE_BOARD_BYTES], uint64_t red, uint64_t blue, uint64_t blocked) {
+    // 아래 비트 = R 또는 #, 위 비트 = B 또는 #
+    uint64_t lo = red | blocked, hi = blue | blocked;
+    for (int h = 0; h < 2; h++) {
+        uint64_t w = spread32((uint32_t)(lo >> (32 * h))) | (spread32((uint32_t)(hi >> (32 * h))) << 1);
+        for (int i = 0; i < 8; i++) out[8 * h + i] = (uint8_t)(w >> (8 * i));
+    }
+}
+
+void wire_unpack_bits(const uint8_t in[WIRE_BOARD_BYTES], uint64_t *red, uint64_t *blue, uint64_t *blocked) {
+    uint64_t lo = 0, hi = 0;
+    for (int h = 0; h < 2; h++) {
+        uint64_t w = 0;
+        for (int i = 0; i < 8; i++) w |= (uint64_t)in[8 * h + i] << (8 * i);
+        lo |= (uint64_t)compact64(w) << (32 * h);
+        hi |= (uint64_t)compact64(w >> 1) << (32 * h);
+    }
+    *blocked = lo & hi;
+    *red = lo & ~hi;
+    *blue = hi & ~lo;
+}
+
+void wire_pack_board(uint8_t out[WIRE_BOARD_BYTES], const char board[8][8]) {
+    memset(out, 0, WIRE_BOARD_BYTES);
+    for (int i = 0; i < 64; i++) {
+        char ch = board[i >> 3][i & 7];
+        unsigned code = (unsigned)(ch == 'R') | ((unsigned)(ch == 'B') << 1) | ((unsigned)(ch == '#') * 3);
+        out[i >> 2] |= (uint8_t)(code << (2 * (i & 3)));
+    }
+}
+
+void wire_unpack_board(const uint8_t in[WIRE_BOARD_BYTES], char board[8][8]) {
+    static const char cells[4] = { '.', 'R', 'B', '#' };
+    for (int i = 0; i < 64; i++) board[i >> 3][i & 7] = cells[(in[i >> 2] >> (2 * (i & 3))) & 3];
+}
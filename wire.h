@@ -0,0 +1,83 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * JSON 대신 쓸 수 있는 바이너리 프로토콜. 연결의 첫 바이트가 WIRE_MAGIC이면 그 연결은
+ * 끝까지 바이너리, 아니면 기존 JSON 한 줄 방식이다 (같은 포트에서 첫 바이트로 구분).
+ *
+ *   프레임: [길이 u16 BE][type u8][본문]     길이 = type + 본문 바이트 수
+ *   보드:   칸마다 2비트 ('.'=0 'R'=1 'B'=2 '#'=3), 칸 i는 16바이트 LE 수의 비트 2i..2i+1
+ *   수:     u16 BE (출발 칸 << 6 | 도착 칸), 칸 = r*8 + c.  WIRE_MOVE_PASS = 못 둬서 pass
+ *
+ * 메시지마다 들어가는 필드와 순서는 wire.c의 표 하나로 정해진다. 인코딩/디코딩은
+ * 호출자가 준 버퍼와 WireMsg만 쓰고 메모리를 할당하지 않는다.
+ */
+#define WIRE_MAGIC        0xA7         // JSON은 '{'나 공백으로 시작하므로 겹치지 않는다
+#define WIRE_HEADER       3
+#define WIRE_BOARD_BYTES  16
+#define WIRE_NAME_MAX     32           // '\0' 포함 (REGISTRY_NAME_MAX와 같게)
+#define WIRE_FRAME_MAX    128          // 가장 긴 메시지(game_start)도 이 안에 들어간다
+#define WIRE_MOVE_PASS    0xFFFFu
+#define WIRE_MOVE_ANY     0xFFFEu      // premove 조건: 상대가 무엇을 두든
+
+// client → server
+#define WIRE_REGISTER      0x01        // rating, name[0]
+#define WIRE_MOVE          0x02        // move
+#define WIRE_PREMOVE       0x03        // seq, move, cond: 상대 차례에 보내두면 상대가 cond를 둔 직후 move를 둔다
+#define WIRE_RESUME        0x04        // token, name[0]: 끊긴 게임의 자리로 돌아간다 (register 대신)
+// server → client
+#define WIRE_REGISTER_ACK  0x81        // token (다시 접속할 때 WIRE_RESUME에 넣는다)
+#define WIRE_REGISTER_NACK 0x82        // reason
+#define WIRE_GAME_START    0x83        // seq, board, name[0] (Red, 선공), name[1] (Blue)
+#define WIRE_YOUR_TURN     0x84        // seq, timeout, board
+#define WIRE_MOVE_OK       0x85        // seq, move, seat (JSON next_player와 같은 자리), board
+#define WIRE_INVALID_MOVE  0x86        // seq, seat
+#define WIRE_PASS          0x87        // seq, seat, board
+#define WIRE_GAME_OVER     0x88        // score, board
+
+// WIRE_REGISTER_NACK reason
+enum { WIRE_NACK_INVALID = 1, WIRE_NACK_EXISTS, WIRE_NACK_BUSY };
+
+typedef struct {
+    uint8_t type;
+    uint8_t seat;
+    uint8_t timeout;
+    uint8_t reason;
+    uint16_t seq;
+    uint16_t move;
+    uint16_t cond;                     // WIRE_PREMOVE: 기다리는 상대 수 (WIRE_MOVE_PASS, WIRE_MOVE_ANY 가능)
+    uint16_t rating;
+    uint64_t token;                    // resume token
+    uint8_t score[2];
+    uint8_t board[WIRE_BOARD_BYTES];
+    char name[2][WIRE_NAME_MAX];       // '\0'으로 끝남
+} WireMsg;
+
+// 쓸 필드만 채우면 된다 (나머지는 0)
+void wire_msg_init(WireMsg *m, uint8_t type);
+// 헤더를 포함한 프레임 길이. 모르는 type이거나 cap이 모자라면 0
+size_t wire_encode(uint8_t *buf, size_t cap, const WireMsg *m);
+// frame: 길이 필드 다음부터 (type + 본문), len 바이트. 형식이 틀리면 -1
+int wire_decode(const uint8_t *frame, size_t len, WireMsg *m);
+
+void wire_pack_bits(uint8_t out[WIRE_BOARD_BYTES], uint64_t red, uint64_t blue, uint64_t blocked);
+void wire_unpack_bits(const uint8_t in[WIRE_BOARD_BYTES], uint64_t *red, uint64_t *blue, uint64_t *blocked);
+// 클라이언트의 char 보드 ('R', 'B', '#', 그 외는 빈 칸)
+void wire_pack_board(uint8_t out[WIRE_BOARD_BYTES], const char board[8][8]);
+void wire_unpack_board(const uint8_t in[WIRE_BOARD_BYTES], char board[8][8]);
+
+// 좌표는 0부터
+static inline uint16_t wire_move(int r1, int c1, int r2, int c2) {
+    return (uint16_t)(((r1 * 8 + c1) << 6) | (r2 * 8 + c2));
+}
+static inline void wire_move_coords(uint16_t mv, int *r1, int *c1, int *r2, int *c2) {
+    *r1 = (mv >> 9) & 7;
+    *c1 = (mv >> 6) & 7;
+    *r2 = (mv >> 3) & 7;
+    *c2 = mv & 7;
+}
+
+#endif
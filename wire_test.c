@@ -0,0 +1,173 @@
+#include "../include/wire.h"
+#include "../include/test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * wire.c: 메시지 type마다 인코딩한 프레임을 다시 디코딩해서 wire.h에 적힌 필드가 그대로 오는지,
+ * 잘리거나 남는 바이트가 있는 프레임은 -1인지, 보드 2비트 패킹이 칸 순서대로인지 본다.
+ */
+enum { SEQ = 1, MOVE = 2, COND = 4, RATING = 8, TOKEN = 16, SEAT = 32, TIMEOUT = 64,
+       REASON = 128, SCORE = 256, BOARD = 512, NAME0 = 1024, NAME1 = 2048 };
+
+// wire.h의 type별 주석과 같은 필드
+static const struct { uint8_t type; int fields; } types[] = {
+    { WIRE_REGISTER,      RATING | NAME0 },
+    { WIRE_MOVE,          MOVE },
+    { WIRE_PREMOVE,       SEQ | MOVE | COND },
+    { WIRE_RESUME,        TOKEN | NAME0 },
+    { WIRE_REGISTER_ACK,  TOKEN },
+    { WIRE_REGISTER_NACK, REASON },
+    { WIRE_GAME_START,    SEQ | BOARD | NAME0 | NAME1 },
+    { WIRE_YOUR_TURN,     SEQ | TIMEOUT | BOARD },
+    { WIRE_MOVE_OK,       SEQ | MOVE | SEAT | BOARD },
+    { WIRE_INVALID_MOVE,  SEQ | SEAT },
+    { WIRE_PASS,          SEQ | SEAT | BOARD },
+    { WIRE_GAME_OVER,     SCORE | BOARD },
+};
+
+static uint64_t rand64(void) {
+    return (uint64_t)rand() << 62 ^ (uint64_t)rand() << 31 ^ (uint64_t)rand();
+}
+
+static void random_msg(WireMsg *m, uint8_t type) {
+    wire_msg_init(m, type);
+    m->seat = (uint8_t)rand();
+    m->timeout = (uint8_t)rand();
+    m->reason = (uint8_t)rand();
+    m->seq = (uint16_t)rand();
+    m->move = (uint16_t)rand();
+    m->cond = (uint16_t)rand();
+    m->rating = (uint16_t)rand();
+    m->token = rand64();
+    m->score[0] = (uint8_t)rand();
+    m->score[1] = (uint8_t)rand();
+    for (int i = 0; i < WIRE_BOARD_BYTES; i++) m->board[i] = (uint8_t)rand();
+    for (int i = 0; i < 2; i++) {
+        int n = rand() % WIRE_NAME_MAX;        // 0 ~ 31자
+        for (int k = 0; k < n; k++) m->name[i][k] = (char)('a' + rand() % 26);
+    }
+}
+
+static void check_fields(const WireMsg *in, const WireMsg *out, int fields) {
+    CHECK(out->type == in->type);
+    CHECK(out->seq == ((fields & SEQ) ? in->seq : 0));
+    CHECK(out->move == ((fields & MOVE) ? in->move : 0));
+    CHECK(out->cond == ((fields & COND) ? in->cond : 0));
+    CHECK(out->rating == ((fields & RATING) ? in->rating : 0));
+    CHECK(out->token == ((fields & TOKEN) ? in->token : 0));
+    CHECK(out->seat == ((fields & SEAT) ? in->seat : 0));
+    CHECK(out->timeout == ((fields & TIMEOUT) ? in->timeout : 0));
+    CHECK(out->reason == ((fields & REASON) ? in->reason : 0));
+    for (int i = 0; i < 2; i++) CHECK(out->score[i] == ((fields & SCORE) ? in->score[i] : 0));
+    for (int i = 0; i < WIRE_BOARD_BYTES; i++) CHECK(out->board[i] == ((fields & BOARD) ? in->board[i] : 0));
+    CHECK(strcmp(out->name[0], (fields & NAME0) ? in->name[0] : "") == 0);
+    CHECK(strcmp(out->name[1], (fields & NAME1) ? in->name[1] : "") == 0);
+}
+
+static void test_round_trip(void) {
+    for (size_t t = 0; t < sizeof types / sizeof types[0]; t++) {
+        for (int iter = 0; iter < 200; iter++) {
+            WireMsg in, out;
+            uint8_t buf[WIRE_FRAME_MAX + 1];
+            random_msg(&in, types[t].type);
+            size_t len = wire_encode(buf, WIRE_FRAME_MAX, &in);
+            CHECK(len >= WIRE_HEADER && len <= WIRE_FRAME_MAX);
+            CHECK((size_t)(buf[0] << 8 | buf[1]) == len - 2);
+            CHECK(buf[2] == types[t].type);
+
+            CHECK(wire_decode(buf + 2, len - 2, &out) == 0);
+            check_fields(&in, &out, types[t].fields);
+
+            // 잘린 프레임과 뒤에 바이트가 남는 프레임
+            for (size_t k = 0; k < len - 2; k++) CHECK(wire_decode(buf + 2, k, &out) == -1);
+            buf[len] = 0;
+            CHECK(wire_decode(buf + 2, len - 1, &out) == -1);
+        }
+    }
+}
+
+static void test_bad_frames(void) {
+    WireMsg m;
+    uint8_t buf[WIRE_FRAME_MAX];
+
+    // 모르는 type
+    wire_msg_init(&m, 0x7F);
+    CHECK(wire_encode(buf, sizeof buf, &m) == 0);
+    buf[0] = 0x7F;
+    CHECK(wire_decode(buf, 1, &m) == -1);
+
+    // 버퍼가 WIRE_FRAME_MAX보다 작으면 인코딩하지 않는다
+    wire_msg_init(&m, WIRE_MOVE);
+    CHECK(wire_encode(buf, WIRE_FRAME_MAX - 1, &m) == 0);
+
+    // 이름 길이가 WIRE_NAME_MAX 이상
+    uint8_t reg[3 + 1 + WIRE_NAME_MAX];
+    reg[0] = WIRE_REGISTER;
+    reg[1] = 0;
+    reg[2] = 100;
+    reg[3] = WIRE_NAME_MAX;
+    memset(reg + 4, 'a', WIRE_NAME_MAX);
+    CHECK(wire_decode(reg, sizeof reg, &m) == -1);
+    reg[3] = WIRE_NAME_MAX - 1;
+    CHECK(wire_decode(reg, sizeof reg - 1, &m) == 0);
+    CHECK(m.rating == 100 && strlen(m.name[0]) == WIRE_NAME_MAX - 1);
+
+    // 바이트 순서: [길이 BE][type][move BE]
+    wire_msg_init(&m, WIRE_MOVE);
+    m.move = 0x1234;
+    CHECK(wire_encode(buf, sizeof buf, &m) == 5);
+    CHECK(buf[0] == 0 && buf[1] == 3 && buf[2] == WIRE_MOVE && buf[3] == 0x12 && buf[4] == 0x34);
+}
+
+static void test_board_packing(void) {
+    static const char cells[4] = { '.', 'R', 'B', '#' };
+    for (int iter = 0; iter < 1000; iter++) {
+        char board[8][8], back[8][8];
+        uint64_t red = 0, blue = 0, blocked = 0;
+        uint8_t expect[WIRE_BOARD_BYTES], packed[WIRE_BOARD_BYTES];
+        memset(expect, 0, sizeof expect);
+        for (int i = 0; i < 64; i++) {
+            int code = rand() & 3;
+            board[i / 8][i % 8] = cells[code];
+            if (code == 1) red |= (uint64_t)1 << i;
+            if (code == 2) blue |= (uint64_t)1 << i;
+            if (code == 3) blocked |= (uint64_t)1 << i;
+            expect[i / 4] |= (uint8_t)(code << (2 * (i % 4)));   // 칸 i = 비트 2i..2i+1 (LE)
+        }
+
+        wire_pack_board(packed, board);
+        CHECK(memcmp(packed, expect, sizeof packed) == 0);
+        wire_pack_bits(packed, red, blue, blocked);
+        CHECK(memcmp(packed, expect, sizeof packed) == 0);
+
+        uint64_t r, b, x;
+        wire_unpack_bits(packed, &r, &b, &x);
+        CHECK(r == red && b == blue && x == blocked);
+        wire_unpack_board(packed, back);
+        CHECK(memcmp(back, board, sizeof back) == 0);
+    }
+}
+
+static void test_move_coords(void) {
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            uint16_t mv = wire_move(from / 8, from % 8, to / 8, to % 8);
+            int r1, c1, r2, c2;
+            CHECK(mv == (from << 6 | to));
+            CHECK(mv != WIRE_MOVE_PASS && mv != WIRE_MOVE_ANY);
+            wire_move_coords(mv, &r1, &c1, &r2, &c2);
+            CHECK(r1 * 8 + c1 == from && r2 * 8 + c2 == to);
+        }
+    }
+}
+
+int main(void) {
+    srand(1);
+    test_round_trip();
+    test_bad_frames();
+    test_board_packing();
+    test_move_coords();
+    return test_report("wire_test");
+}